@@ -8,11 +8,25 @@ Description : fifo GPU command buffer
 *******************************************************************************/
 #include "../globals.h"
 #include <cstdint>
+#include <cmath>
 #include <thread>
+#include <cstring>
+#include "../utils/memory/frame_arena.h"
 #include "command_buffer.h"
 using namespace command;
 
 
+/// @brief Create GPU command buffer
+/// @param[in] frameArena  Per-frame memory (see Dispatcher::getFrameArena)
+CommandBuffer::CommandBuffer(::utils::memory::FrameArena& frameArena)
+    : m_frameArena(frameArena), m_pBatches(nullptr), m_batchCount(0u), m_batchCapacity(0u), m_firstOpenBatch(0u), m_currentPrimitiveCount(0u), m_isBusy(false)
+{
+    clear();
+
+    //! ne pas vider contenu de frame avant de dessiner -> garder "restes" de la frame prcdente -> effets de tornade de certains jeux (crash 3, ff 7, ...)
+    //! ajout option pour vider frame avant dessin
+}
+
 /// @brief Set "busy" status
 void CommandBuffer::lock() noexcept
 {
@@ -27,3 +41,190 @@ void CommandBuffer::unlock() noexcept
 {
     m_isBusy = false;
 }
+
+
+/// @brief Build render state of a primitive (current drawing settings)
+/// @param[in] isTextured         Textured primitive
+/// @param[in] isSemiTransparent  Semi-transparent primitive
+/// @param[in] isLine             Line primitive
+/// @param[in] clutId             CLUT position (raw primitive value - ignored if not textured or 15-bit)
+render_state_t CommandBuffer::getRenderState(const bool isTextured, const bool isSemiTransparent, const bool isLine, const uint16_t clutId) const noexcept
+{
+    render_state_t state;
+    if (isTextured)
+    {
+        state.texpageX = static_cast<uint16_t>(m_drawSettings.texpageX());
+        state.texpageY = static_cast<uint16_t>(m_drawSettings.texpageY());
+        state.colorDepth = static_cast<uint8_t>(m_drawSettings.colorDepth());
+        state.clutId = (m_drawSettings.colorDepth() == primitive::colordepth_t::clut_4bit || m_drawSettings.colorDepth() == primitive::colordepth_t::clut_8bit) ? clutId : 0u;
+        state.textureWindow = m_drawSettings.texWindowMaskU() | (m_drawSettings.texWindowMaskV() << 8)
+                            | (m_drawSettings.texWindowOffsetU() << 16) | (m_drawSettings.texWindowOffsetV() << 24);
+    }
+    else
+    {
+        state.texpageX = state.texpageY = state.clutId = 0u;
+        state.colorDepth = 0u;
+        state.textureWindow = 0u;
+    }
+    state.semiTransparency = (isSemiTransparent) ? static_cast<uint8_t>(m_drawSettings.semiTransparency()) : RENDER_STATE_OPAQUE;
+    state.drawAreaLeft = static_cast<int16_t>(m_drawSettings.drawAreaLeft());
+    state.drawAreaTop = static_cast<int16_t>(m_drawSettings.drawAreaTop());
+    state.drawAreaRight = static_cast<int16_t>(m_drawSettings.drawAreaRight());
+    state.drawAreaBottom = static_cast<int16_t>(m_drawSettings.drawAreaBottom());
+    state.flags = ((isTextured) ? RENDER_STATE_TEXTURED : 0u) | ((isLine) ? RENDER_STATE_LINE : 0u)
+                | ((m_drawSettings.isDithered()) ? RENDER_STATE_DITHERED : 0u)
+                | ((m_drawSettings.isMaskBitForced()) ? RENDER_STATE_MASK_FORCED : 0u)
+                | ((m_drawSettings.isMaskBitChecked()) ? RENDER_STATE_MASK_CHECK : 0u);
+    return state;
+}
+
+
+// -- primitives -- ------------------------------------------------------------
+
+/// @brief Add line
+/// @param[in] vertex0  First end point
+/// @param[in] vertex1  Second end point
+/// @param[in] state    Render state (see getRenderState)
+/// @returns Success (false if buffer is full: frame must be rendered first)
+bool CommandBuffer::pushLine(const vertex_t& vertex0, const vertex_t& vertex1, const render_state_t& state)
+{
+    const index_range_t range{ m_lineBuffer.indexCount(), 2u };
+    if (m_lineBuffer.pushLine(vertex0, vertex1) == false)
+        return false;
+    addToBatch(state, getArea(&m_lineBuffer.vertices()[m_lineBuffer.size() - 2u], 2u), range);
+    return true;
+}
+
+/// @brief Add triangle
+/// @param[in] pVertices  Triangle vertices (3)
+/// @param[in] state      Render state (see getRenderState)
+/// @returns Success (false if buffer is full: frame must be rendered first)
+bool CommandBuffer::pushTriangle(const vertex_t* pVertices, const render_state_t& state)
+{
+    const index_range_t range{ m_polyBuffer.indexCount(), 3u };
+    if (m_polyBuffer.pushTriangle(pVertices) == false)
+        return false;
+    addToBatch(state, getArea(pVertices, 3u), range);
+    return true;
+}
+
+/// @brief Add quad
+/// @param[in] pVertices  Quad vertices (4: 0-1 top, 2-3 bottom)
+/// @param[in] state      Render state (see getRenderState)
+/// @returns Success (false if buffer is full: frame must be rendered first)
+bool CommandBuffer::pushQuad(const vertex_t* pVertices, const render_state_t& state)
+{
+    const index_range_t range{ m_polyBuffer.indexCount(), 6u };
+    if (m_polyBuffer.pushQuad(pVertices) == false)
+        return false;
+    addToBatch(state, getArea(pVertices, 4u), range);
+    return true;
+}
+
+/// @brief Remove all primitives and batches (after rendering them) - frame counters kept
+void CommandBuffer::flushBatches() noexcept
+{
+    m_lineBuffer.clear();
+    m_polyBuffer.clear();
+    m_pBatches = nullptr; // released with frame arena
+    m_batchCount = m_batchCapacity = m_firstOpenBatch = 0u;
+    m_currentPrimitiveCount = 0u;
+}
+
+/// @brief Remove all primitives and batches + reset frame counters (before frame arena reset)
+void CommandBuffer::clear() noexcept
+{
+    flushBatches();
+    m_stats = command_buffer_stats_t{ 0u, 0u, 0u, 0u };
+}
+
+
+// -- batches -- ---------------------------------------------------------------
+
+/// @brief Compute area covered by vertices
+draw_area_t CommandBuffer::getArea(const vertex_t* pVertices, const uint32_t vertexCount) noexcept
+{
+    float left = pVertices[0].coords.x, right = left;
+    float top = pVertices[0].coords.y, bottom = top;
+    for (uint32_t i = 1; i < vertexCount; ++i)
+    {
+        left = (pVertices[i].coords.x < left) ? pVertices[i].coords.x : left;
+        right = (pVertices[i].coords.x > right) ? pVertices[i].coords.x : right;
+        top = (pVertices[i].coords.y < top) ? pVertices[i].coords.y : top;
+        bottom = (pVertices[i].coords.y > bottom) ? pVertices[i].coords.y : bottom;
+    }
+    return draw_area_t{ static_cast<int32_t>(std::floor(left)), static_cast<int32_t>(std::floor(top)),
+                        static_cast<int32_t>(std::ceil(right)), static_cast<int32_t>(std::ceil(bottom)) };
+}
+
+/// @brief Add index range of a new primitive to a batch (merged with earlier batch if possible)
+/// @param[in] state  Primitive render state
+/// @param[in] area   Primitive area
+/// @param[in] range  Primitive index range
+void CommandBuffer::addToBatch(const render_state_t& state, const draw_area_t& area, const index_range_t& range)
+{
+    ++m_currentPrimitiveCount;
+    ++m_stats.primitives;
+    if (m_stats.primitives == 1u || state != m_lastState)
+        ++m_stats.stateChanges;
+    m_lastState = state;
+
+    // find most recent batch with same state - stop at first overlapping batch with different state (or at last barrier)
+    draw_batch_t* pTarget = nullptr;
+    uint32_t searchLimit = (m_batchCount > COMMAND_BUFFER_BATCH_SEARCH_DEPTH) ? m_batchCount - COMMAND_BUFFER_BATCH_SEARCH_DEPTH : 0u;
+    searchLimit = (m_firstOpenBatch > searchLimit) ? m_firstOpenBatch : searchLimit;
+    for (uint32_t i = m_batchCount; i > searchLimit; --i)
+    {
+        draw_batch_t& batch = m_pBatches[i - 1u];
+        if (batch.state == state)
+        {
+            pTarget = &batch;
+            if (i != m_batchCount)
+                ++m_stats.merged;
+            break;
+        }
+        if (batch.area.overlaps(area))
+            break;
+    }
+
+    // new batch
+    if (pTarget == nullptr)
+    {
+        m_pBatches = growArray(m_pBatches, m_batchCount, m_batchCapacity);
+        pTarget = &m_pBatches[m_batchCount];
+        ++m_batchCount;
+        ++m_stats.batches;
+        *pTarget = draw_batch_t{ state, area, nullptr, 0u, 0u };
+    }
+    else
+        pTarget->area.merge(area);
+
+    // append range (contiguous ranges merged)
+    if (pTarget->rangeCount > 0u && pTarget->pRanges[pTarget->rangeCount - 1u].first + pTarget->pRanges[pTarget->rangeCount - 1u].count == range.first)
+    {
+        pTarget->pRanges[pTarget->rangeCount - 1u].count += range.count;
+    }
+    else
+    {
+        pTarget->pRanges = growArray(pTarget->pRanges, pTarget->rangeCount, pTarget->rangeCapacity);
+        pTarget->pRanges[pTarget->rangeCount] = range;
+        ++(pTarget->rangeCount);
+    }
+}
+
+/// @brief Make room for one more item in an array of the frame arena (copied to bigger array if full)
+/// @param[in] pArray         Current array (or nullptr)
+/// @param[in] count          Number of used items
+/// @param[in,out] capacity   Number of allocated items
+/// @returns Array with at least one free item
+template <typename T>
+T* CommandBuffer::growArray(T* pArray, const uint32_t count, uint32_t& capacity)
+{
+    if (count < capacity)
+        return pArray;
+    capacity = (capacity > 0u) ? capacity * 2u : 8u;
+    T* pNewArray = m_frameArena.allocateArray<T>(capacity);
+    if (count > 0u)
+        memcpy(pNewArray, pArray, count * sizeof(T));
+    return pNewArray; // previous array released with frame arena
+}
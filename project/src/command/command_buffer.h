@@ -11,19 +11,129 @@ Description : fifo GPU command buffer
 #include <cstdint>
 #include "memory/vertex_buffer.h"
 #include "frame_buffer_settings.h"
+#include "../utils/memory/frame_arena.h"
+
+// PS1 GPU limits :
+//  - max 360000 flat-shaded polygons per second -> 12000/frame
+//  - max 180000 textured/gouraud-shaded polygons per second -> 6000/frame
+#define COMMAND_BUFFER_LINE_CAPACITY  (12000u * 2u) // vertices for lines
+#define COMMAND_BUFFER_POLY_CAPACITY  (10000u * 3u) // vertices for polygons
+#define COMMAND_BUFFER_BATCH_SEARCH_DEPTH 32u       // max number of previous batches checked to merge a primitive
+
+#define RENDER_STATE_OPAQUE      0xFFu // render_state_t.semiTransparency: no semi-transparency
+#define RENDER_STATE_TEXTURED    0x01u // render_state_t.flags: textured primitive
+#define RENDER_STATE_LINE        0x02u // render_state_t.flags: line primitive (line buffer)
+#define RENDER_STATE_DITHERED    0x04u // render_state_t.flags: dithering
+#define RENDER_STATE_MASK_FORCED 0x08u // render_state_t.flags: set mask bit while drawing
+#define RENDER_STATE_MASK_CHECK  0x10u // render_state_t.flags: preserve pixels with mask bit
+#define RENDER_STATE_FILL        0x20u // render_state_t.flags: area filled with color (no drawing area, no mask)
 
 /// @namespace command
 /// GPU commands management
 namespace command
 {
+    /// @struct render_state_t
+    /// @brief Render state of a primitive (primitives with identical states can be drawn together)
+    struct render_state_t
+    {
+        uint16_t texpageX;        ///< Texture page X base
+        uint16_t texpageY;        ///< Texture page Y base
+        uint16_t clutId;          ///< CLUT position (raw primitive value)
+        uint8_t colorDepth;       ///< Texture color depth (primitive::colordepth_t)
+        uint8_t semiTransparency; ///< Semi-transparency mode (primitive::stp_t or RENDER_STATE_OPAQUE)
+        uint32_t textureWindow;   ///< Texture window (mask U, mask V, offset U, offset V)
+        int16_t drawAreaLeft;     ///< Drawing area - left limit (inclusive)
+        int16_t drawAreaTop;      ///< Drawing area - top limit (inclusive)
+        int16_t drawAreaRight;    ///< Drawing area - right limit (inclusive)
+        int16_t drawAreaBottom;   ///< Drawing area - bottom limit (inclusive)
+        uint32_t flags;           ///< Rendering flags (RENDER_STATE_*)
+
+        /// @brief Compare render states
+        inline bool operator==(const render_state_t& other) const noexcept
+        {
+            return (texpageX == other.texpageX && texpageY == other.texpageY && clutId == other.clutId && colorDepth == other.colorDepth
+                 && semiTransparency == other.semiTransparency && textureWindow == other.textureWindow && flags == other.flags
+                 && drawAreaLeft == other.drawAreaLeft && drawAreaTop == other.drawAreaTop && drawAreaRight == other.drawAreaRight && drawAreaBottom == other.drawAreaBottom);
+        }
+        inline bool operator!=(const render_state_t& other) const noexcept { return !(*this == other); }
+    };
+
+    /// @struct draw_area_t
+    /// @brief Screen area covered by primitives (inclusive limits)
+    struct draw_area_t
+    {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+
+        /// @brief Check if areas overlap
+        inline bool overlaps(const draw_area_t& other) const noexcept
+        {
+            return (left <= other.right && other.left <= right && top <= other.bottom && other.top <= bottom);
+        }
+        /// @brief Extend area to include another area
+        inline void merge(const draw_area_t& other) noexcept
+        {
+            left = (other.left < left) ? other.left : left;
+            top = (other.top < top) ? other.top : top;
+            right = (other.right > right) ? other.right : right;
+            bottom = (other.bottom > bottom) ? other.bottom : bottom;
+        }
+    };
+
+    /// @struct index_range_t
+    /// @brief Range of vertex indices (in line or polygon buffer)
+    struct index_range_t
+    {
+        uint32_t first; ///< First index
+        uint32_t count; ///< Number of indices
+    };
+
+    /// @struct draw_batch_t
+    /// @brief Primitives drawn with the same render state (in order of index ranges)
+    struct draw_batch_t
+    {
+        render_state_t state;   ///< Common render state
+        draw_area_t area;       ///< Area covered by primitives of batch
+        index_range_t* pRanges; ///< Index ranges (line buffer if RENDER_STATE_LINE, polygon buffer otherwise) - frame arena memory
+        uint32_t rangeCount;    ///< Number of index ranges
+        uint32_t rangeCapacity; ///< Allocated index ranges
+    };
+
+    /// @struct command_buffer_stats_t
+    /// @brief Batching counters of current frame
+    struct command_buffer_stats_t
+    {
+        uint32_t primitives;   ///< Primitives pushed
+        uint32_t batches;      ///< Draw batches
+        uint32_t stateChanges; ///< Render state changes in submission order (= number of batches without reordering)
+        uint32_t merged;       ///< Primitives moved to an earlier batch (no overlap with primitives drawn in between)
+
+        /// @brief Get merge ratio (state changes per batch: 1.0 = no gain)
+        inline float mergeRatio() const noexcept { return (batches > 0u) ? static_cast<float>(stateChanges) / static_cast<float>(batches) : 1.0f; }
+    };
+
+
     /// @class CommandBuffer
-    /// @brief FIFO GPU command buffer
+    /// @brief FIFO GPU command buffer - primitives grouped in batches by render state
+    /// @details A primitive joins the most recent batch with the same render state, unless it overlaps a batch
+    ///          with a different state drawn after it (strict ordering kept wherever primitives overlap).
+    ///          Operations that can't be batched (VRAM copies/uploads, texture cache flush) close existing batches (see pushBarrier).
+    ///          Batch records are stored in the frame arena: the buffer must be cleared before the arena is reset.
     class CommandBuffer
     {
     private:
         FrameBufferSettings m_drawSettings; ///< Frame buffer drawing settings
-        memory::VertexBuffer m_lineBuffer;  ///< FIFO buffer for line vertices
-        memory::VertexBuffer m_polyBuffer;  ///< FIFO buffer for polygon vertices
+        memory::VertexBuffer<COMMAND_BUFFER_LINE_CAPACITY> m_lineBuffer; ///< FIFO buffer for line vertices
+        memory::VertexBuffer<COMMAND_BUFFER_POLY_CAPACITY> m_polyBuffer; ///< FIFO buffer for polygon vertices
+        ::utils::memory::FrameArena& m_frameArena; ///< Per-frame memory (batch records)
+        draw_batch_t* m_pBatches;            ///< Draw batches (frame arena memory)
+        uint32_t m_batchCount;               ///< Number of used batches
+        uint32_t m_batchCapacity;            ///< Number of allocated batches
+        uint32_t m_firstOpenBatch;           ///< First batch that new primitives can join (previous batches closed by a barrier)
+        render_state_t m_lastState;          ///< Render state of last primitive (state change counter)
+        command_buffer_stats_t m_stats;      ///< Batching counters of current frame
         uint32_t m_currentPrimitiveCount;   ///< Total primitive count since last rendering
         bool m_isBusy;
 
@@ -34,18 +144,70 @@ namespace command
         /// @brief Set "available" status
         void unlock() noexcept;
 
+        /// @brief Add index range of a new primitive to a batch (merged with earlier batch if possible)
+        /// @param[in] state  Primitive render state
+        /// @param[in] area   Primitive area
+        /// @param[in] range  Primitive index range
+        void addToBatch(const render_state_t& state, const draw_area_t& area, const index_range_t& range);
+        /// @brief Make room for one more item in an array of the frame arena (copied to bigger array if full)
+        template <typename T>
+        T* growArray(T* pArray, const uint32_t count, uint32_t& capacity);
+        /// @brief Compute area covered by vertices
+        static draw_area_t getArea(const vertex_t* pVertices, const uint32_t vertexCount) noexcept;
+
     public:
         /// @brief Create GPU command buffer
-        CommandBuffer()
-        {
-            // PS1 GPU limits :
-            //  - max 360000 flat-shaded polygons per second -> 12000/frame
-            //  - max 180000 textured/gouraud-shaded polygons per second -> 6000/frame
-            m_lineBuffer.init(12000 * 2, false); // pre-allocate buffer for lines
-            m_polyBuffer.init(10000 * 3, true);  // pre-allocate buffer for polygons
-
-            //! ne pas vider contenu de frame avant de dessiner -> garder "restes" de la frame prcdente -> effets de tornade de certains jeux (crash 3, ff 7, ...)
-            //! ajout option pour vider frame avant dessin
-        }
+        /// @param[in] frameArena  Per-frame memory (see Dispatcher::getFrameArena)
+        explicit CommandBuffer(::utils::memory::FrameArena& frameArena);
+
+        /// @brief Get frame buffer drawing settings
+        inline FrameBufferSettings& drawSettings() noexcept { return m_drawSettings; }
+        /// @brief Build render state of a primitive (current drawing settings)
+        /// @param[in] isTextured         Textured primitive
+        /// @param[in] isSemiTransparent  Semi-transparent primitive
+        /// @param[in] isLine             Line primitive
+        /// @param[in] clutId             CLUT position (raw primitive value - ignored if not textured or 15-bit)
+        render_state_t getRenderState(const bool isTextured, const bool isSemiTransparent, const bool isLine, const uint16_t clutId) const noexcept;
+
+
+        // -- primitives -- ----------------------------------------------------
+
+        /// @brief Add line
+        /// @param[in] vertex0  First end point
+        /// @param[in] vertex1  Second end point
+        /// @param[in] state    Render state (see getRenderState)
+        /// @returns Success (false if buffer is full: frame must be rendered first)
+        bool pushLine(const vertex_t& vertex0, const vertex_t& vertex1, const render_state_t& state);
+        /// @brief Add triangle
+        /// @param[in] pVertices  Triangle vertices (3)
+        /// @param[in] state      Render state (see getRenderState)
+        /// @returns Success (false if buffer is full: frame must be rendered first)
+        bool pushTriangle(const vertex_t* pVertices, const render_state_t& state);
+        /// @brief Add quad
+        /// @param[in] pVertices  Quad vertices (4: 0-1 top, 2-3 bottom)
+        /// @param[in] state      Render state (see getRenderState)
+        /// @returns Success (false if buffer is full: frame must be rendered first)
+        bool pushQuad(const vertex_t* pVertices, const render_state_t& state);
+        /// @brief Close existing batches: next primitives can't be moved before this point (VRAM copy/upload, texture cache flush)
+        inline void pushBarrier() noexcept { m_firstOpenBatch = m_batchCount; }
+
+        /// @brief Remove all primitives and batches (after rendering them) - frame counters kept
+        void flushBatches() noexcept;
+        /// @brief Remove all primitives and batches + reset frame counters (before frame arena reset)
+        void clear() noexcept;
+
+
+        // -- batches -- -------------------------------------------------------
+
+        /// @brief Get draw batches (in drawing order)
+        inline const draw_batch_t* batches() const noexcept { return m_pBatches; }
+        /// @brief Get number of draw batches
+        inline uint32_t batchCount() const noexcept { return m_batchCount; }
+        /// @brief Get line vertex buffer (referenced by line batches)
+        inline const memory::VertexBuffer<COMMAND_BUFFER_LINE_CAPACITY>& lineBuffer() const noexcept { return m_lineBuffer; }
+        /// @brief Get polygon vertex buffer (referenced by polygon batches)
+        inline const memory::VertexBuffer<COMMAND_BUFFER_POLY_CAPACITY>& polyBuffer() const noexcept { return m_polyBuffer; }
+        /// @brief Get batching counters of current frame
+        inline const command_buffer_stats_t& getFrameStats() const noexcept { return m_stats; }
     };
 }
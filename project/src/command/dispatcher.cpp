@@ -7,5 +7,58 @@ License :     GPLv2
 Description : GPU command dispatcher
 *******************************************************************************/
 #include "../globals.h"
+#include "memory/status_register.h"
+#include "memory/video_memory.h"
+#include "primitive/primitive_facade.h"
+#include "frame_buffer_settings.h"
+#include "display_state.h"
+#include "memory/vram_write_tracker.h"
+#include "../utils/memory/frame_arena.h"
+#include "command_buffer.h"
+#include "display_list.h"
 #include "dispatcher.h"
 using namespace command;
+
+memory::VideoMemory Dispatcher::s_vram;         ///< Video memory image (native)
+FrameBufferSettings Dispatcher::s_drawSettings; ///< Frame buffer drawing settings
+DisplayState Dispatcher::s_displayState;        ///< Display state (display mode, interlaced fields)
+memory::VramWriteTracker Dispatcher::s_vramWrites; ///< VRAM areas modified since last frame
+::utils::memory::FrameArena Dispatcher::s_frameArena; ///< Per-frame memory (decoded primitives, vertex data, batch records)
+CommandBuffer Dispatcher::s_commandBuffer(Dispatcher::s_frameArena); ///< Decoded primitives grouped in draw batches (after frame arena: initialization order)
+DisplayList Dispatcher::s_displayList;          ///< Decoded primitives of current frame (if frame recording is enabled)
+DisplayList Dispatcher::s_lastFrameDisplayList; ///< Decoded primitives of last complete frame (if frame recording is enabled)
+bool Dispatcher::s_isFrameRecording = false;    ///< Frame recording status
+
+
+/// @brief Initialize GPU status, video memory and primitive processing
+/// @param[in] isZincEmu  Use doubled VRAM size (for Zinc)
+/// @throws runtime_error  Memory allocation failure
+void Dispatcher::init(const bool isZincEmu)
+{
+    memory::StatusRegister::init();
+    s_vram.init(isZincEmu);
+    s_drawSettings.reset();
+    s_displayState.reset();
+    s_vramWrites.markAll();
+    primitive::PrimitiveFacade::init(s_vram, s_drawSettings, s_displayState, s_vramWrites);
+}
+
+/// @brief Release video memory and primitive processing
+void Dispatcher::close()
+{
+    setFrameRecording(false);
+    primitive::PrimitiveFacade::close();
+    s_commandBuffer.clear();
+    s_frameArena.clear();
+    s_vram.close();
+}
+
+/// @brief Enable/disable recording of decoded frames in display lists (replay, statistics)
+/// @param[in] isEnabled  Recording status
+void Dispatcher::setFrameRecording(const bool isEnabled)
+{
+    s_isFrameRecording = isEnabled;
+    s_displayList.clear();
+    s_lastFrameDisplayList.clear();
+    primitive::PrimitiveFacade::setDisplayList((isEnabled) ? &s_displayList : nullptr);
+}
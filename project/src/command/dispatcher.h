@@ -8,6 +8,14 @@ Description : GPU command dispatcher
 *******************************************************************************/
 #pragma once
 
+#include "memory/video_memory.h"
+#include "frame_buffer_settings.h"
+#include "display_state.h"
+#include "memory/vram_write_tracker.h"
+#include "../utils/memory/frame_arena.h"
+#include "command_buffer.h"
+#include "display_list.h"
+
 /// @namespace command
 /// GPU commands management
 namespace command
@@ -16,6 +24,91 @@ namespace command
     /// @brief GPU command dispatcher
     class Dispatcher
     {
-        
+    private:
+        static memory::VideoMemory s_vram;          ///< Video memory image (native)
+        static FrameBufferSettings s_drawSettings;  ///< Frame buffer drawing settings
+        static DisplayState s_displayState;         ///< Display state (display mode, interlaced fields)
+        static memory::VramWriteTracker s_vramWrites; ///< VRAM areas modified since last frame
+        static ::utils::memory::FrameArena s_frameArena; ///< Per-frame memory (decoded primitives, vertex data, batch records)
+        static CommandBuffer s_commandBuffer;       ///< Decoded primitives grouped in draw batches (hardware rendering) - batch records in frame arena
+        static DisplayList s_displayList;           ///< Decoded primitives of current frame (if frame recording is enabled)
+        static DisplayList s_lastFrameDisplayList;  ///< Decoded primitives of last complete frame (if frame recording is enabled)
+        static bool s_isFrameRecording;             ///< Frame recording status
+
+
+    public:
+        /// @brief Initialize GPU status, video memory and primitive processing
+        /// @param[in] isZincEmu  Use doubled VRAM size (for Zinc)
+        /// @throws runtime_error  Memory allocation failure
+        static void init(const bool isZincEmu = false);
+
+        /// @brief Release video memory and primitive processing
+        static void close();
+
+        /// @brief Enable/disable recording of decoded frames in display lists (replay, statistics)
+        /// @param[in] isEnabled  Recording status
+        static void setFrameRecording(const bool isEnabled);
+
+
+        // -- getters -- -------------------------------------------------------
+
+        /// @brief Get video memory image
+        /// @returns VRAM reference
+        static inline memory::VideoMemory& getVram() noexcept
+        {
+            return s_vram;
+        }
+        /// @brief Get frame buffer drawing settings
+        /// @returns Drawing settings reference
+        static inline FrameBufferSettings& getDrawSettings() noexcept
+        {
+            return s_drawSettings;
+        }
+        /// @brief Get display state
+        /// @returns Display state reference
+        static inline DisplayState& getDisplayState() noexcept
+        {
+            return s_displayState;
+        }
+        /// @brief Get VRAM areas modified since last frame
+        /// @returns VRAM write tracker reference
+        static inline memory::VramWriteTracker& getVramWrites() noexcept
+        {
+            return s_vramWrites;
+        }
+        /// @brief Get per-frame memory (released at the end of each frame)
+        /// @returns Frame arena reference
+        static inline ::utils::memory::FrameArena& getFrameArena() noexcept
+        {
+            return s_frameArena;
+        }
+        /// @brief Get command buffer (draw batches of current frame)
+        /// @returns Command buffer reference
+        static inline CommandBuffer& getCommandBuffer() noexcept
+        {
+            return s_commandBuffer;
+        }
+        /// @brief Get display list of last complete frame (empty if frame recording is disabled)
+        /// @returns Display list reference
+        static inline const DisplayList& getLastFrameDisplayList() noexcept
+        {
+            return s_lastFrameDisplayList;
+        }
+
+
+        // -- frames -- --------------------------------------------------------
+
+        /// @brief End of frame: release per-frame memory (frame data must not be used anymore), reset VRAM write tracking
+        static inline void endFrame()
+        {
+            s_commandBuffer.clear(); // batch records stored in frame arena
+            if (s_isFrameRecording)
+            {
+                s_lastFrameDisplayList.swap(s_displayList); // memory of older frame reused
+                s_displayList.clear();
+            }
+            s_frameArena.reset();
+            s_vramWrites.clear();
+        }
     };
 }
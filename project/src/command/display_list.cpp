@@ -0,0 +1,174 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : display list - decoded primitives of a frame (replayable by any backend)
+*******************************************************************************/
+#include "../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../display/software/rasterizer.h"
+#include "display_list.h"
+using namespace command;
+using display::software::raster_vertex_t;
+using display::software::raster_state_t;
+
+
+/// @brief Remove recorded operations (memory kept)
+void DisplayList::clear() noexcept
+{
+    m_commands.clear();
+    m_states.clear();
+    m_vertices.clear();
+    m_pixels.clear();
+}
+
+/// @brief Pre-allocate memory
+/// @param[in] commandCount  Expected number of operations
+void DisplayList::reserve(const size_t commandCount)
+{
+    m_commands.reserve(commandCount);
+    m_states.reserve(commandCount / 4u);
+    m_vertices.reserve(commandCount * 3u);
+}
+
+/// @brief Exchange content with another display list (no copy)
+void DisplayList::swap(DisplayList& other) noexcept
+{
+    m_commands.swap(other.m_commands);
+    m_states.swap(other.m_states);
+    m_vertices.swap(other.m_vertices);
+    m_pixels.swap(other.m_pixels);
+}
+
+/// @brief Get content counters
+display_list_stats_t DisplayList::getStats() const noexcept
+{
+    return display_list_stats_t{ m_commands.size(), m_states.size(), m_vertices.size(), m_pixels.size(),
+                                 m_commands.size() * sizeof(display_command_t) + m_states.size() * sizeof(raster_state_t) + m_vertices.size() * sizeof(raster_vertex_t)
+                                 + m_pixels.size() * sizeof(uint16_t) };
+}
+
+
+// -- recording -- -------------------------------------------------------------
+
+/// @brief Compare rendering states (field by field: padding bytes may differ)
+static inline bool isSameState(const raster_state_t& first, const raster_state_t& second) noexcept
+{
+    const display::software::raster_texture_t& firstTexture = first.texture;
+    const display::software::raster_texture_t& secondTexture = second.texture;
+    return (first.clipLeft == second.clipLeft && first.clipTop == second.clipTop && first.clipRight == second.clipRight && first.clipBottom == second.clipBottom
+         && firstTexture.pVram == secondTexture.pVram && firstTexture.texpageX == secondTexture.texpageX && firstTexture.texpageY == secondTexture.texpageY
+         && firstTexture.clutX == secondTexture.clutX && firstTexture.clutY == secondTexture.clutY && firstTexture.colorDepth == secondTexture.colorDepth
+         && firstTexture.windowMaskU == secondTexture.windowMaskU && firstTexture.windowMaskV == secondTexture.windowMaskV
+         && firstTexture.windowOffsetU == secondTexture.windowOffsetU && firstTexture.windowOffsetV == secondTexture.windowOffsetV
+         && firstTexture.pDecodedPage == secondTexture.pDecodedPage && firstTexture.pUpscaledPage == secondTexture.pUpscaledPage
+         && firstTexture.upscalingFactor == secondTexture.upscalingFactor
+         && first.semiTransparency == second.semiTransparency && first.isTextured == second.isTextured && first.isShaded == second.isShaded
+         && first.isModulated == second.isModulated && first.isSemiTransparent == second.isSemiTransparent && first.isDithered == second.isDithered
+         && first.isMaskBitForced == second.isMaskBitForced && first.isMaskBitChecked == second.isMaskBitChecked
+         && first.isRectXFlip == second.isRectXFlip && first.isRectYFlip == second.isRectYFlip
+         && first.isFieldSkipped == second.isFieldSkipped && first.skippedFieldParity == second.skippedFieldParity);
+}
+
+/// @brief Get index of rendering state (added if different from last recorded state)
+uint32_t DisplayList::getStateIndex(const raster_state_t& state)
+{
+    if (m_states.empty() || isSameState(m_states.back(), state) == false)
+        m_states.push_back(state);
+    return static_cast<uint32_t>(m_states.size() - 1u);
+}
+
+/// @brief Append draw operation
+void DisplayList::appendDrawCommand(const display_op_t op, const raster_vertex_t* pVertices, const uint32_t vertexCount,
+                                    const raster_state_t& state, const int32_t width, const int32_t height)
+{
+    display_command_t command{};
+    command.op = op;
+    command.stateIndex = getStateIndex(state);
+    command.data = static_cast<uint32_t>(m_vertices.size());
+    command.params[0] = static_cast<int16_t>(width);
+    command.params[1] = static_cast<int16_t>(height);
+    m_vertices.insert(m_vertices.end(), pVertices, pVertices + vertexCount);
+    m_commands.push_back(command);
+}
+
+/// @brief Record triangle
+void DisplayList::recordTriangle(const raster_vertex_t* pVertices, const raster_state_t& state)
+{
+    appendDrawCommand(display_op_t::triangle, pVertices, 3u, state);
+}
+
+/// @brief Record line
+void DisplayList::recordLine(const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state)
+{
+    raster_vertex_t pVertices[2] = { v0, v1 };
+    appendDrawCommand(display_op_t::line, pVertices, 2u, state);
+}
+
+/// @brief Record rectangle
+void DisplayList::recordRectangle(const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state)
+{
+    appendDrawCommand(display_op_t::rectangle, &topLeft, 1u, state, width, height);
+}
+
+/// @brief Record area filled with color
+void DisplayList::recordFill(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color)
+{
+    display_command_t command{};
+    command.op = display_op_t::fill;
+    command.data = color;
+    command.params[0] = static_cast<int16_t>(x);
+    command.params[1] = static_cast<int16_t>(y);
+    command.params[2] = static_cast<int16_t>(width);
+    command.params[3] = static_cast<int16_t>(height);
+    m_commands.push_back(command);
+}
+
+/// @brief Record VRAM area copy
+void DisplayList::recordCopy(const int32_t sourceX, const int32_t sourceY, const int32_t destX, const int32_t destY, const int32_t width, const int32_t height)
+{
+    display_command_t command{};
+    command.op = display_op_t::copy;
+    command.params[0] = static_cast<int16_t>(sourceX);
+    command.params[1] = static_cast<int16_t>(sourceY);
+    command.params[2] = static_cast<int16_t>(destX);
+    command.params[3] = static_cast<int16_t>(destY);
+    command.params[4] = static_cast<int16_t>(width);
+    command.params[5] = static_cast<int16_t>(height);
+    m_commands.push_back(command);
+}
+
+/// @brief Record texture cache flush
+void DisplayList::recordTextureCacheClear()
+{
+    display_command_t command{};
+    command.op = display_op_t::clearTextureCache;
+    m_commands.push_back(command);
+}
+
+/// @brief Record CPU to VRAM transfer (pixels copied from written VRAM area, with VRAM wrapping)
+void DisplayList::recordUpload(const uint16_t* pVram, const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    display_command_t command{};
+    command.op = display_op_t::upload;
+    command.data = static_cast<uint32_t>(m_pixels.size());
+    command.params[0] = static_cast<int16_t>(x);
+    command.params[1] = static_cast<int16_t>(y);
+    command.params[2] = static_cast<int16_t>(width);
+    command.params[3] = static_cast<int16_t>(height);
+
+    m_pixels.reserve(m_pixels.size() + static_cast<size_t>(width) * static_cast<size_t>(height));
+    for (int32_t row = 0; row < height; ++row)
+    {
+        const uint16_t* pRow = pVram + static_cast<size_t>((y + row) & (RASTER_VRAM_HEIGHT - 1)) * RASTER_VRAM_WIDTH;
+        for (int32_t col = 0; col < width; ++col)
+            m_pixels.push_back(pRow[(x + col) & (RASTER_VRAM_WIDTH - 1)]);
+    }
+    m_commands.push_back(command);
+}
@@ -0,0 +1,160 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : display list - decoded primitives of a frame (replayable by any backend)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../display/software/rasterizer.h"
+
+/// @namespace command
+/// GPU commands management
+namespace command
+{
+    /// @enum display_op_t
+    /// @brief Display list operation
+    enum class display_op_t : uint8_t
+    {
+        triangle = 0,         ///< Triangle (3 vertices)
+        line = 1,             ///< Line (2 vertices)
+        rectangle = 2,        ///< Rectangle (1 vertex + size)
+        fill = 3,             ///< Area filled with color
+        copy = 4,             ///< VRAM area copy
+        clearTextureCache = 5, ///< Texture cache flush
+        upload = 6            ///< CPU to VRAM transfer (transferred pixels stored in display list)
+    };
+
+    /// @struct display_command_t
+    /// @brief Display list entry (24 bytes)
+    struct display_command_t
+    {
+        display_op_t op;      ///< Operation type
+        uint8_t reserved[3];
+        uint32_t stateIndex;  ///< Rendering state (state table index) - triangle/line/rectangle
+        uint32_t data;        ///< First vertex (vertex array index) - triangle/line/rectangle ; color - fill ; first pixel (pixel array index) - upload
+        int16_t params[6];    ///< rectangle: width, height ; fill/upload: x, y, width, height ; copy: source X/Y, destination X/Y, width, height
+    };
+
+    /// @struct display_list_stats_t
+    /// @brief Display list content counters
+    struct display_list_stats_t
+    {
+        size_t commands; ///< Recorded operations
+        size_t states;   ///< Unique consecutive rendering states
+        size_t vertices; ///< Recorded vertices
+        size_t pixels;   ///< Recorded transferred pixels
+        size_t bytes;    ///< Memory used by recorded data
+    };
+
+
+    /// @class DisplayList
+    /// @brief Display list - flat array of decoded primitives with indexed rendering states and vertices
+    /// @details Recorded during decoding (see PrimitiveFacade::setDisplayList), then consumed by any backend with the drawing
+    ///          interface of software::DualFrameBuffer (drawTriangle, drawLine, drawRectangle, fillArea, copyArea, clearTextureCache, uploadArea).
+    ///          A recorded frame can be replayed (benchmarks, other internal resolution) if the backend VRAM has the same initial content:
+    ///          CPU to VRAM transfers are recorded with their pixels.
+    class DisplayList
+    {
+    public:
+        /// @brief Create empty display list
+        DisplayList() = default;
+
+        /// @brief Remove recorded operations (memory kept)
+        void clear() noexcept;
+        /// @brief Pre-allocate memory
+        /// @param[in] commandCount  Expected number of operations
+        void reserve(const size_t commandCount);
+        /// @brief Exchange content with another display list (no copy)
+        void swap(DisplayList& other) noexcept;
+
+
+        // -- recording -- -----------------------------------------------------
+
+        /// @brief Record triangle
+        void recordTriangle(const display::software::raster_vertex_t* pVertices, const display::software::raster_state_t& state);
+        /// @brief Record line
+        void recordLine(const display::software::raster_vertex_t& v0, const display::software::raster_vertex_t& v1, const display::software::raster_state_t& state);
+        /// @brief Record rectangle
+        void recordRectangle(const display::software::raster_vertex_t& topLeft, const int32_t width, const int32_t height, const display::software::raster_state_t& state);
+        /// @brief Record area filled with color
+        void recordFill(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color);
+        /// @brief Record VRAM area copy
+        void recordCopy(const int32_t sourceX, const int32_t sourceY, const int32_t destX, const int32_t destY, const int32_t width, const int32_t height);
+        /// @brief Record texture cache flush
+        void recordTextureCacheClear();
+        /// @brief Record CPU to VRAM transfer (pixels copied from written VRAM area, with VRAM wrapping)
+        void recordUpload(const uint16_t* pVram, const int32_t x, const int32_t y, const int32_t width, const int32_t height);
+
+
+        // -- replay -- --------------------------------------------------------
+
+        /// @brief Execute recorded operations with a backend
+        /// @param[in] backend  Drawing backend (drawTriangle, drawLine, drawRectangle, fillArea, copyArea, clearTextureCache, uploadArea)
+        /// @param[in] pVram    Native VRAM used as texture source by backend (nullptr: VRAM used during recording)
+        template <typename Backend>
+        void replay(Backend& backend, const uint16_t* pVram = nullptr) const
+        {
+            display::software::raster_state_t state;
+            uint32_t currentStateIndex = UINT32_MAX;
+            for (auto it = m_commands.begin(); it != m_commands.end(); ++it)
+            {
+                const display_command_t& command = *it;
+                if (command.op <= display_op_t::rectangle && command.stateIndex != currentStateIndex)
+                {
+                    currentStateIndex = command.stateIndex;
+                    state = m_states[currentStateIndex];
+                    if (pVram != nullptr)
+                        state.texture.pVram = pVram;
+                }
+
+                switch (command.op)
+                {
+                    case display_op_t::triangle:  backend.drawTriangle(&m_vertices[command.data], state); break;
+                    case display_op_t::line:      backend.drawLine(m_vertices[command.data], m_vertices[command.data + 1u], state); break;
+                    case display_op_t::rectangle: backend.drawRectangle(m_vertices[command.data], command.params[0], command.params[1], state); break;
+                    case display_op_t::fill:      backend.fillArea(command.params[0], command.params[1], command.params[2], command.params[3], command.data); break;
+                    case display_op_t::copy:      backend.copyArea(command.params[0], command.params[1], command.params[2], command.params[3], command.params[4], command.params[5]); break;
+                    case display_op_t::clearTextureCache: backend.clearTextureCache(); break;
+                    case display_op_t::upload:    backend.uploadArea(command.params[0], command.params[1], command.params[2], command.params[3], &m_pixels[command.data]); break;
+                    default: break;
+                }
+            }
+        }
+
+
+        // -- content -- -------------------------------------------------------
+
+        /// @brief Get recorded operations
+        inline const std::vector<display_command_t>& commands() const noexcept { return m_commands; }
+        /// @brief Get rendering state table
+        inline const std::vector<display::software::raster_state_t>& states() const noexcept { return m_states; }
+        /// @brief Get vertex array
+        inline const std::vector<display::software::raster_vertex_t>& vertices() const noexcept { return m_vertices; }
+        /// @brief Get transferred pixel array
+        inline const std::vector<uint16_t>& pixels() const noexcept { return m_pixels; }
+        /// @brief Check if display list is empty
+        inline bool empty() const noexcept { return m_commands.empty(); }
+        /// @brief Get content counters
+        display_list_stats_t getStats() const noexcept;
+
+
+    private:
+        /// @brief Get index of rendering state (added if different from last recorded state)
+        uint32_t getStateIndex(const display::software::raster_state_t& state);
+        /// @brief Append draw operation
+        void appendDrawCommand(const display_op_t op, const display::software::raster_vertex_t* pVertices, const uint32_t vertexCount,
+                               const display::software::raster_state_t& state, const int32_t width = 0, const int32_t height = 0);
+
+    private:
+        std::vector<display_command_t> m_commands;                 ///< Recorded operations
+        std::vector<display::software::raster_state_t> m_states;   ///< Rendering states
+        std::vector<display::software::raster_vertex_t> m_vertices; ///< Vertices
+        std::vector<uint16_t> m_pixels;                            ///< Transferred pixels (uploads)
+    };
+}
@@ -0,0 +1,169 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : display state (display mode, display area, interlaced fields)
+*******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include "memory/status_register.h"
+#include "frame_buffer_settings.h"
+
+#define GPUSTATUS_FIELDDRAWING (GPUSTATUS_INTERLACED | GPUSTATUS_DOUBLEHEIGHT) // 480-line interlaced display
+#define GPUSTATUS_WIDTH368     0x00010000u // horizontal resolution 368 (overrides other width bits)
+
+// default display ranges (GP1(06h) / GP1(07h))
+#define DISPLAY_RANGE_X1_DEFAULT 0x260u
+#define DISPLAY_RANGE_X2_DEFAULT 0xC60u
+#define DISPLAY_RANGE_Y1_DEFAULT 0x010u
+#define DISPLAY_RANGE_Y2_DEFAULT 0x100u
+
+/// @namespace command
+/// GPU commands management
+namespace command
+{
+    /// @class DisplayState
+    /// @brief Display state (display mode, display area, interlaced fields)
+    class DisplayState
+    {
+    private:
+        bool m_isOddFrame;     ///< Even/odd frame flag (field currently displayed)
+        uint32_t m_displayX;   ///< Display area - left position in VRAM (GP1(05h))
+        uint32_t m_displayY;   ///< Display area - top position in VRAM (GP1(05h))
+        uint32_t m_rangeX1;    ///< Horizontal display range - start (GPU clock cycles, GP1(06h))
+        uint32_t m_rangeX2;    ///< Horizontal display range - end (GPU clock cycles, GP1(06h))
+        uint32_t m_rangeY1;    ///< Vertical display range - start (scanlines, GP1(07h))
+        uint32_t m_rangeY2;    ///< Vertical display range - end (scanlines, GP1(07h))
+
+
+    public:
+        /// @brief Create default display state
+        DisplayState() noexcept { reset(); }
+
+        /// @brief Reset display state to default values
+        inline void reset() noexcept
+        {
+            m_isOddFrame = false;
+            m_displayX = m_displayY = 0u;
+            m_rangeX1 = DISPLAY_RANGE_X1_DEFAULT;
+            m_rangeX2 = DISPLAY_RANGE_X2_DEFAULT;
+            m_rangeY1 = DISPLAY_RANGE_Y1_DEFAULT;
+            m_rangeY2 = DISPLAY_RANGE_Y2_DEFAULT;
+        }
+
+
+        // -- display mode -- --------------------------------------------------
+
+        /// @brief Set display mode (GP1(08h)) in status register
+        /// @param[in] gdata  Display mode command data
+        static inline void setDisplayMode(const uint32_t gdata) noexcept
+        {
+            uint32_t statusBits = ((gdata & 0x3Fu) << 17) | ((gdata & 0x40u) << 10) | ((gdata & 0x80u) << 7);
+            memory::StatusRegister::unsetStatus(GPUSTATUS_WIDTHBITS | GPUSTATUS_DOUBLEHEIGHT | GPUSTATUS_PAL | GPUSTATUS_RGB24 | GPUSTATUS_INTERLACED | 0x4000u);
+            memory::StatusRegister::setStatus(statusBits);
+        }
+        /// @brief Check if display uses 24-bit colors (otherwise: 15-bit)
+        static inline bool isRgb24() noexcept
+        {
+            return memory::StatusRegister::getStatus(GPUSTATUS_RGB24);
+        }
+        /// @brief Check if display is enabled (GP1(03h))
+        static inline bool isDisplayEnabled() noexcept
+        {
+            return (memory::StatusRegister::getStatus(GPUSTATUS_DISPLAYDISABLED) == false);
+        }
+
+
+        // -- display area -- --------------------------------------------------
+
+        /// @brief Set display area start (GP1(05h))
+        /// @param[in] gdata  Display area command data
+        inline void setDisplayAreaStart(const uint32_t gdata) noexcept
+        {
+            m_displayX = (gdata & 0x3FEu); // halfword address: always even
+            m_displayY = ((gdata >> 10) & 0x1FFu);
+        }
+        /// @brief Set horizontal display range (GP1(06h))
+        /// @param[in] gdata  Display range command data
+        inline void setHorizontalRange(const uint32_t gdata) noexcept
+        {
+            m_rangeX1 = (gdata & 0xFFFu);
+            m_rangeX2 = ((gdata >> 12) & 0xFFFu);
+        }
+        /// @brief Set vertical display range (GP1(07h))
+        /// @param[in] gdata  Display range command data
+        inline void setVerticalRange(const uint32_t gdata) noexcept
+        {
+            m_rangeY1 = (gdata & 0x3FFu);
+            m_rangeY2 = ((gdata >> 10) & 0x3FFu);
+        }
+
+        /// @brief Get display area left position in VRAM
+        inline uint32_t displayX() const noexcept { return m_displayX; }
+        /// @brief Get display area top position in VRAM
+        inline uint32_t displayY() const noexcept { return m_displayY; }
+        /// @brief Get displayed width (pixels) - horizontal range divided by dot clock, rounded to 4 pixels
+        inline uint32_t displayWidth() const noexcept
+        {
+            uint32_t dotClockDivider;
+            if (memory::StatusRegister::getStatus(GPUSTATUS_WIDTH368))
+                dotClockDivider = 7u;
+            else
+            {
+                switch (memory::StatusRegister::getStatusBits(GPUSTATUS_WIDTHBITS & ~GPUSTATUS_WIDTH368) >> 17)
+                {
+                    case 0: dotClockDivider = 10u; break; // 256
+                    case 1: dotClockDivider = 8u; break;  // 320
+                    case 2: dotClockDivider = 5u; break;  // 512
+                    default: dotClockDivider = 4u; break; // 640
+                }
+            }
+            uint32_t width = (m_rangeX2 > m_rangeX1) ? (((m_rangeX2 - m_rangeX1) / dotClockDivider + 2u) & ~0x3u) : 0u;
+            return (width <= 1024u) ? width : 1024u;
+        }
+        /// @brief Get displayed height (pixels) - vertical range, doubled in 480-line interlaced mode
+        inline uint32_t displayHeight() const noexcept
+        {
+            uint32_t height = (m_rangeY2 > m_rangeY1) ? m_rangeY2 - m_rangeY1 : 0u;
+            if (memory::StatusRegister::getStatusBits(GPUSTATUS_FIELDDRAWING) == static_cast<int32_t>(GPUSTATUS_FIELDDRAWING))
+                height <<= 1;
+            return (height <= 512u) ? height : 512u;
+        }
+
+
+        // -- interlaced fields -- ---------------------------------------------
+
+        /// @brief Change even/odd frame status (+ odd lines status bit, if interlaced)
+        inline void toggleOddFrame() noexcept
+        {
+            setOddFrame(!m_isOddFrame);
+        }
+        /// @brief Set even/odd frame status (+ odd lines status bit, if interlaced)
+        /// @param[in] isOddFrame  Odd frame flag value
+        inline void setOddFrame(const bool isOddFrame) noexcept
+        {
+            m_isOddFrame = isOddFrame;
+            if (isOddFrame && memory::StatusRegister::getStatus(GPUSTATUS_INTERLACED))
+                memory::StatusRegister::setStatus(GPUSTATUS_ODDLINES);
+            else
+                memory::StatusRegister::unsetStatus(GPUSTATUS_ODDLINES);
+        }
+        /// @brief Get even/odd frame status
+        /// @returns Odd frame flag value
+        inline bool isOddFrame() const noexcept
+        {
+            return m_isOddFrame;
+        }
+
+        /// @brief Check if drawing is limited to the field that isn't displayed (480-line interlaced display + drawing to display area not allowed)
+        /// @param[in] settings  Frame buffer settings
+        /// @returns Field drawing mode
+        static inline bool isFieldDrawing(const FrameBufferSettings& settings) noexcept
+        {
+            return (memory::StatusRegister::getStatusBits(GPUSTATUS_FIELDDRAWING) == static_cast<int32_t>(GPUSTATUS_FIELDDRAWING) && settings.isDrawingAllowed() == false);
+        }
+    };
+}
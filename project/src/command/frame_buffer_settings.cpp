@@ -9,3 +9,22 @@ Description : frame buffer drawing settings
 #include "../globals.h"
 #include "frame_buffer_settings.h"
 using namespace command;
+
+
+/// @brief Reset settings to default values
+void FrameBufferSettings::reset() noexcept
+{
+    m_drawAreaLeft = m_drawAreaTop = 0;
+    m_drawAreaRight = 1023;
+    m_drawAreaBottom = 511;
+    m_drawOffsetX = m_drawOffsetY = 0;
+
+    m_texpageX = m_texpageY = 0u;
+    m_colorDepth = primitive::colordepth_t::clut_4bit;
+    m_semiTransparency = primitive::stp_t::mean;
+    m_isDithered = m_isDrawingAllowed = false;
+    m_isRectXFlip = m_isRectYFlip = false;
+
+    setTextureWindow(0u, 0u, 0u, 0u);
+    m_isMaskBitForced = m_isMaskBitChecked = false;
+}
@@ -8,6 +8,9 @@ Description : frame buffer drawing settings
 *******************************************************************************/
 #pragma once
 
+#include <cstdint>
+#include "primitive/primitive_common.h"
+
 /// @namespace command
 /// GPU commands management
 namespace command
@@ -16,6 +19,127 @@ namespace command
     /// @brief Frame buffer drawing settings
     class FrameBufferSettings
     {
-        
+    private:
+        // drawing area
+        int32_t m_drawAreaLeft;   ///< Drawing area - left limit (inclusive)
+        int32_t m_drawAreaTop;    ///< Drawing area - top limit (inclusive)
+        int32_t m_drawAreaRight;  ///< Drawing area - right limit (inclusive)
+        int32_t m_drawAreaBottom; ///< Drawing area - bottom limit (inclusive)
+        int32_t m_drawOffsetX;    ///< Drawing offset - X (signed)
+        int32_t m_drawOffsetY;    ///< Drawing offset - Y (signed)
+
+        // texture page
+        uint32_t m_texpageX; ///< Texture page X base: 0, 64, ...
+        uint32_t m_texpageY; ///< Texture page Y base: 0 or 256
+        primitive::colordepth_t m_colorDepth; ///< Texture color depth
+        primitive::stp_t m_semiTransparency;  ///< Semi-transparency mode
+        bool m_isDithered;        ///< Dithering
+        bool m_isDrawingAllowed;  ///< Drawing to display area allowed
+        bool m_isRectXFlip;       ///< Textured rectangle X-flip
+        bool m_isRectYFlip;       ///< Textured rectangle Y-flip
+
+        // texture window
+        uint32_t m_texWindowMaskU;   ///< Preserved U coordinate bits
+        uint32_t m_texWindowMaskV;   ///< Preserved V coordinate bits
+        uint32_t m_texWindowOffsetU; ///< Forced U coordinate bits
+        uint32_t m_texWindowOffsetV; ///< Forced V coordinate bits
+
+        // mask
+        bool m_isMaskBitForced;  ///< Set mask bit while drawing
+        bool m_isMaskBitChecked; ///< Preserve pixels with mask bit
+
+
+    public:
+        /// @brief Create default settings
+        FrameBufferSettings() noexcept
+        {
+            reset();
+        }
+
+        /// @brief Reset settings to default values
+        void reset() noexcept;
+
+
+        // -- setters -- -------------------------------------------------------
+
+        /// @brief Set drawing area top-left limit (inclusive)
+        inline void setDrawAreaTopLeft(const int32_t x, const int32_t y) noexcept
+        {
+            m_drawAreaLeft = x;
+            m_drawAreaTop = y;
+        }
+        /// @brief Set drawing area bottom-right limit (inclusive)
+        inline void setDrawAreaBottomRight(const int32_t x, const int32_t y) noexcept
+        {
+            m_drawAreaRight = x;
+            m_drawAreaBottom = y;
+        }
+        /// @brief Set drawing offset (signed values)
+        inline void setDrawOffset(const int32_t x, const int32_t y) noexcept
+        {
+            m_drawOffsetX = x;
+            m_drawOffsetY = y;
+        }
+        /// @brief Set texture page and draw mode
+        inline void setTexturePage(const uint32_t x, const uint32_t y, const primitive::colordepth_t colorDepth, const primitive::stp_t semiTransparency) noexcept
+        {
+            m_texpageX = x;
+            m_texpageY = y;
+            m_colorDepth = colorDepth;
+            m_semiTransparency = semiTransparency;
+        }
+        /// @brief Set draw mode flags
+        inline void setDrawModeFlags(const bool isDithered, const bool isDrawingAllowed, const bool isRectXFlip, const bool isRectYFlip) noexcept
+        {
+            m_isDithered = isDithered;
+            m_isDrawingAllowed = isDrawingAllowed;
+            m_isRectXFlip = isRectXFlip;
+            m_isRectYFlip = isRectYFlip;
+        }
+        /// @brief Set texture window (values in 8-pixel steps)
+        /// @param[in] maskX    Manipulated U bits
+        /// @param[in] maskY    Manipulated V bits
+        /// @param[in] offsetX  Value for manipulated U bits
+        /// @param[in] offsetY  Value for manipulated V bits
+        inline void setTextureWindow(const uint32_t maskX, const uint32_t maskY, const uint32_t offsetX, const uint32_t offsetY) noexcept
+        {
+            m_texWindowMaskU = (~(maskX << 3)) & 0xFFu;
+            m_texWindowMaskV = (~(maskY << 3)) & 0xFFu;
+            m_texWindowOffsetU = ((offsetX & maskX) << 3) & 0xFFu;
+            m_texWindowOffsetV = ((offsetY & maskY) << 3) & 0xFFu;
+        }
+        /// @brief Set mask bit settings
+        inline void setMask(const bool isMaskBitForced, const bool isMaskBitChecked) noexcept
+        {
+            m_isMaskBitForced = isMaskBitForced;
+            m_isMaskBitChecked = isMaskBitChecked;
+        }
+
+
+        // -- getters -- -------------------------------------------------------
+
+        inline int32_t drawAreaLeft() const noexcept   { return m_drawAreaLeft; }   ///< Drawing area - left limit (inclusive)
+        inline int32_t drawAreaTop() const noexcept    { return m_drawAreaTop; }    ///< Drawing area - top limit (inclusive)
+        inline int32_t drawAreaRight() const noexcept  { return m_drawAreaRight; }  ///< Drawing area - right limit (inclusive)
+        inline int32_t drawAreaBottom() const noexcept { return m_drawAreaBottom; } ///< Drawing area - bottom limit (inclusive)
+        inline int32_t drawOffsetX() const noexcept    { return m_drawOffsetX; }    ///< Drawing offset - X
+        inline int32_t drawOffsetY() const noexcept    { return m_drawOffsetY; }    ///< Drawing offset - Y
+
+        inline uint32_t texpageX() const noexcept { return m_texpageX; } ///< Texture page X base
+        inline uint32_t texpageY() const noexcept { return m_texpageY; } ///< Texture page Y base
+        inline primitive::colordepth_t colorDepth() const noexcept   { return m_colorDepth; }       ///< Texture color depth
+        inline primitive::stp_t semiTransparency() const noexcept    { return m_semiTransparency; } ///< Semi-transparency mode
+        inline bool isDithered() const noexcept       { return m_isDithered; }       ///< Dithering
+        inline bool isDrawingAllowed() const noexcept { return m_isDrawingAllowed; } ///< Drawing to display area allowed
+        inline bool isRectXFlip() const noexcept      { return m_isRectXFlip; }      ///< Textured rectangle X-flip
+        inline bool isRectYFlip() const noexcept      { return m_isRectYFlip; }      ///< Textured rectangle Y-flip
+
+        inline uint32_t texWindowMaskU() const noexcept   { return m_texWindowMaskU; }   ///< Preserved U coordinate bits
+        inline uint32_t texWindowMaskV() const noexcept   { return m_texWindowMaskV; }   ///< Preserved V coordinate bits
+        inline uint32_t texWindowOffsetU() const noexcept { return m_texWindowOffsetU; } ///< Forced U coordinate bits
+        inline uint32_t texWindowOffsetV() const noexcept { return m_texWindowOffsetV; } ///< Forced V coordinate bits
+
+        inline bool isMaskBitForced() const noexcept  { return m_isMaskBitForced; }  ///< Set mask bit while drawing
+        inline bool isMaskBitChecked() const noexcept { return m_isMaskBitChecked; } ///< Preserve pixels with mask bit
     };
 }
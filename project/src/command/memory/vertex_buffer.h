@@ -10,7 +10,6 @@ Description : vertex data buffer
 
 #include <cstdlib>
 #include <cstdint>
-#include <vector>
 
 /// @namespace command
 /// GPU commands management
@@ -33,101 +32,155 @@ namespace command
     /// @brief Vertex texturing information (16-bit texture ID + UV coordinates)
     typedef uint32_t vertex_texture_t;
 
+    /// @struct vertex_t
+    /// @brief Interleaved vertex data (32 bytes: never split between two cache lines)
+    struct alignas(32) vertex_t
+    {
+        vertex_pos_t coords;      ///< Vertex coordinates : X, Y, Z
+        vertex_color_t color;     ///< Vertex color
+        vertex_texture_t texture; ///< Vertex texture information (ignored if not textured)
+    };
+    /// @brief Vertex index (position in vertex buffer)
+    typedef uint16_t vertex_index_t;
+
 
     /// @namespace command.primitive
     /// GPU memory management
     namespace memory
     {
         /// @class VertexBuffer
-        /// @brief Vertex data buffer
+        /// @brief Vertex data buffer - fixed capacity, interleaved vertices + index list (no allocation)
+        /// @details Quads are stored as 4 vertices + 6 indices (POLY0_* / POLY1_* triangles).
+        ///          Large object: meant to be stored in static/heap memory (not on the stack).
+        template <uint32_t _Capacity>
         class VertexBuffer
         {
-        private:
-            std::vector<float>* m_pVertexCoords;    ///< Vertex coordinates : X, Y, Z
-            std::vector<uint32_t>* m_pVertexColors; ///< Vertex colors
-            std::vector<uint32_t>* m_pTextureInfos; ///< Vertex texture informations
-
+            static_assert(_Capacity > 0u && _Capacity <= 65536u, "VertexBuffer: capacity must be addressable with vertex_index_t");
 
         public:
-            /// @brief Create default vertex buffer
-            VertexBuffer();
-            /// @brief Create and configure vertex buffer
-            /// @param[in] baseCapacity  Base capacity (pre-allocated number of vertices)
-            /// @param[in] isTextured    Use texture data
-            VertexBuffer(const uint32_t baseCapacity, const bool isTextured);
-            /// @brief Destroy vertex buffer
-            ~VertexBuffer();
-
-            /// @brief Configure vertex buffer
-            /// @param[in] baseCapacity  Base capacity (pre-allocated number of vertices)
-            /// @param[in] isTextured    Use texture data
-            void init(const uint32_t baseCapacity, const bool isTextured);
-
-            /// @brief Clear vertex buffer (remove content)
+            /// @brief Create empty vertex buffer
+            VertexBuffer() noexcept : m_vertexCount(0u), m_indexCount(0u) {}
+            // no copy allowed
+            VertexBuffer(const VertexBuffer& other) = delete;
+            VertexBuffer& operator=(const VertexBuffer& other) = delete;
+
+            /// @brief Clear vertex buffer (remove content, memory kept)
             inline void clear() noexcept
             {
-                m_pVertexCoords->clear();
-                m_pVertexColors->clear();
-                if (m_pTextureInfos != nullptr)
-                    m_pTextureInfos->clear();
+                m_vertexCount = 0u;
+                m_indexCount = 0u;
             }
 
-            /// @brief Add non-textured elements at the end of the buffer
-            /// @param[in] pCoords  Vertex coordinates to insert
-            /// @param[in] color    Vertex color to insert
-            inline void push(const vertex_pos_t& coords, const vertex_color_t color)
+
+            // -- insertion -- -------------------------------------------------
+
+            /// @brief Add line at the end of the buffer
+            /// @param[in] vertex0  First end point
+            /// @param[in] vertex1  Second end point
+            /// @returns Success (false if buffer is full)
+            inline bool pushLine(const vertex_t& vertex0, const vertex_t& vertex1) noexcept
             {
-                m_pVertexCoords->push_back(coords.x);
-                m_pVertexCoords->push_back(coords.y);
-                m_pVertexCoords->push_back(coords.z);
-                m_pVertexColors->push_back(color);
+                if (m_vertexCount + 2u > _Capacity)
+                    return false;
+                vertex_t* pOut = &m_vertices[m_vertexCount];
+                pOut[0] = vertex0;
+                pOut[1] = vertex1;
+                appendShape<2u>(s_lineIndices);
+                return true;
             }
 
-            /// @brief Add non-textured elements at the end of the buffer
-            /// @param[in] pCoords  Vertex coordinates to insert
-            /// @param[in] color    Vertex color to insert
-            /// @param[in] tex      Texture information to insert
-            inline void push(const vertex_pos_t& coords, const vertex_color_t& color, const vertex_texture_t& tex)
+            /// @brief Add triangle at the end of the buffer
+            /// @param[in] pVertices  Triangle vertices (3)
+            /// @returns Success (false if buffer is full)
+            inline bool pushTriangle(const vertex_t* pVertices) noexcept
             {
-                push(coords, color);
-                if (m_pTextureInfos != nullptr)
-                    m_pTextureInfos->push_back(tex);
+                return pushTriangles(pVertices, 1u);
+            }
+            /// @brief Add triangles at the end of the buffer
+            /// @param[in] pVertices      Triangle vertices (3 per triangle)
+            /// @param[in] triangleCount  Number of triangles
+            /// @returns Success (false if buffer is full: nothing inserted)
+            inline bool pushTriangles(const vertex_t* pVertices, const uint32_t triangleCount) noexcept
+            {
+                const uint32_t vertexCount = triangleCount * 3u;
+                if (m_vertexCount + vertexCount > _Capacity)
+                    return false;
+                vertex_t* pOut = &m_vertices[m_vertexCount];
+                for (uint32_t i = 0; i < vertexCount; ++i)
+                    pOut[i] = pVertices[i];
+                for (uint32_t i = 0; i < triangleCount; ++i)
+                    appendShape<3u>(s_triangleIndices);
+                return true;
             }
 
-            /// @brief Extract simple vertices as arrays (coordinates, colors)
-            /// @param[out] pOutCoords  Destination for array of vertex coordinates
-            /// @param[out] pOutColors  Destination for array of vertex colors
-            inline size_t read(float*& pOutCoords, uint32_t*& pOutColors) noexcept
+            /// @brief Add quad at the end of the buffer (vertex order of quad primitives: 0-1 top, 2-3 bottom)
+            /// @param[in] pVertices  Quad vertices (4)
+            /// @returns Success (false if buffer is full)
+            inline bool pushQuad(const vertex_t* pVertices) noexcept
             {
-                if (m_pVertexColors->size() > 0)
-                {
-                    pOutCoords = &((*m_pVertexCoords)[0]);
-                    pOutColors = &((*m_pVertexColors)[0]);
-
-                    return m_pVertexColors->size();
-                }
-                return 0;
+                return pushQuads(pVertices, 1u);
             }
+            /// @brief Add quads at the end of the buffer (vertex order of quad primitives: 0-1 top, 2-3 bottom)
+            /// @param[in] pVertices  Quad vertices (4 per quad)
+            /// @param[in] quadCount  Number of quads
+            /// @returns Success (false if buffer is full: nothing inserted)
+            inline bool pushQuads(const vertex_t* pVertices, const uint32_t quadCount) noexcept
+            {
+                const uint32_t vertexCount = quadCount * 4u;
+                if (m_vertexCount + vertexCount > _Capacity)
+                    return false;
+                vertex_t* pOut = &m_vertices[m_vertexCount];
+                for (uint32_t i = 0; i < vertexCount; ++i)
+                    pOut[i] = pVertices[i];
+                for (uint32_t i = 0; i < quadCount; ++i)
+                    appendShape<4u>(s_quadIndices);
+                return true;
+            }
+
+
+            // -- content -- ---------------------------------------------------
+
+            /// @brief Get interleaved vertices
+            inline const vertex_t* vertices() const noexcept { return m_vertices; }
+            /// @brief Get number of vertices
+            inline uint32_t size() const noexcept { return m_vertexCount; }
+            /// @brief Get vertex index list (2 per line, 3 per triangle, 6 per quad)
+            inline const vertex_index_t* indices() const noexcept { return m_indices; }
+            /// @brief Get number of indices
+            inline uint32_t indexCount() const noexcept { return m_indexCount; }
+            /// @brief Check if buffer is empty
+            inline bool empty() const noexcept { return (m_vertexCount == 0u); }
+            /// @brief Get max number of vertices
+            static inline uint32_t capacity() noexcept { return _Capacity; }
+
 
-            /// @brief Extract textured vertices as arrays (coordinates, colors, texture information)
-            /// @param[out] pOutCoords    Destination for array of vertex coordinates
-            /// @param[out] pOutColors    Destination for array of vertex colors
-            /// @param[out] pOutTextures  Destination for array of vertex texture information
-            inline size_t read(float*& pOutCoords, uint32_t*& pOutColors, uint32_t*& pOutTextures) noexcept
+        private:
+            /// @brief Append indices of last copied shape + count its vertices
+            /// @param[in] shapeIndices  Vertex indices in shape
+            template <uint32_t _ShapeVertexCount, uint32_t _ShapeIndexCount>
+            inline void appendShape(const vertex_index_t (&shapeIndices)[_ShapeIndexCount]) noexcept
             {
-                if (m_pVertexColors->size() > 0)
-                {
-                    pOutCoords = &((*m_pVertexCoords)[0]);
-                    pOutColors = &((*m_pVertexColors)[0]);
-                    if (m_pTextureInfos != nullptr)
-                        pOutTextures = &((*m_pTextureInfos)[0]);
-                    else
-                        pOutTextures = nullptr;
-
-                    return m_pVertexColors->size();
-                }
-                return 0;
+                vertex_index_t* pOut = &m_indices[m_indexCount];
+                for (uint32_t i = 0; i < _ShapeIndexCount; ++i)
+                    pOut[i] = static_cast<vertex_index_t>(m_vertexCount + shapeIndices[i]);
+                m_vertexCount += _ShapeVertexCount;
+                m_indexCount += _ShapeIndexCount;
             }
+
+            static constexpr vertex_index_t s_lineIndices[2] = { 0u, 1u };
+            static constexpr vertex_index_t s_triangleIndices[3] = { 0u, 1u, 2u };
+            static constexpr vertex_index_t s_quadIndices[6] = { 0u, 1u, 2u,   // POLY0_vertex0, POLY0_vertex1, POLY0_vertex2
+                                                                 2u, 1u, 3u }; // POLY1_vertex0, POLY1_vertex1, POLY1_vertex2
+
+        private:
+            alignas(64) vertex_t m_vertices[_Capacity];                     ///< Interleaved vertices
+            alignas(64) vertex_index_t m_indices[(_Capacity * 3u) / 2u + 2u]; ///< Vertex indices (max 6 per 4 vertices)
+            uint32_t m_vertexCount; ///< Number of vertices
+            uint32_t m_indexCount;  ///< Number of indices
         };
+
+        template <uint32_t _Capacity> constexpr vertex_index_t VertexBuffer<_Capacity>::s_lineIndices[2];
+        template <uint32_t _Capacity> constexpr vertex_index_t VertexBuffer<_Capacity>::s_triangleIndices[3];
+        template <uint32_t _Capacity> constexpr vertex_index_t VertexBuffer<_Capacity>::s_quadIndices[6];
     }
 }
@@ -0,0 +1,110 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : video memory write tracking (modified areas since last check)
+*******************************************************************************/
+#pragma once
+
+#include <cstdint>
+
+#define VRAM_WRITE_TRACKER_TILE_SIZE  32u // tile width/height (VRAM pixels)
+#define VRAM_WRITE_TRACKER_TILE_SHIFT 5u
+#define VRAM_WRITE_TRACKER_COLUMNS    32u // 1024 / tile size (one bit per column)
+#define VRAM_WRITE_TRACKER_ROWS       16u // 512 / tile size
+
+/// @namespace command
+/// GPU commands management
+namespace command
+{
+    /// @namespace command.memory
+    /// GPU memory management
+    namespace memory
+    {
+        /// @class VramWriteTracker
+        /// @brief Video memory write tracking - modified tiles (32x32 pixels) since last clear
+        /// @details Areas are given in VRAM pixels and wrap around VRAM edges (1024 x 512).
+        class VramWriteTracker
+        {
+        public:
+            /// @brief Create tracker (whole VRAM considered modified)
+            VramWriteTracker() noexcept { markAll(); }
+
+            /// @brief Mark area as modified
+            /// @param[in] x       Left position
+            /// @param[in] y       Top position
+            /// @param[in] width   Area width (pixels)
+            /// @param[in] height  Area height (rows)
+            inline void markArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height) noexcept
+            {
+                if (width <= 0 || height <= 0)
+                    return;
+                const uint32_t columnMask = getTileMask(static_cast<uint32_t>(x), static_cast<uint32_t>(width), 1024u, VRAM_WRITE_TRACKER_COLUMNS);
+                const uint32_t rowMask = getTileMask(static_cast<uint32_t>(y), static_cast<uint32_t>(height), 512u, VRAM_WRITE_TRACKER_ROWS);
+                for (uint32_t row = 0; row < VRAM_WRITE_TRACKER_ROWS; ++row)
+                {
+                    if (rowMask & (1u << row))
+                        m_tileRows[row] |= columnMask;
+                }
+            }
+            /// @brief Mark whole VRAM as modified
+            inline void markAll() noexcept
+            {
+                for (uint32_t row = 0; row < VRAM_WRITE_TRACKER_ROWS; ++row)
+                    m_tileRows[row] = 0xFFFFFFFFu;
+            }
+            /// @brief Reset modification status
+            inline void clear() noexcept
+            {
+                for (uint32_t row = 0; row < VRAM_WRITE_TRACKER_ROWS; ++row)
+                    m_tileRows[row] = 0u;
+            }
+
+            /// @brief Check if an area contains modified tiles
+            /// @param[in] x       Left position
+            /// @param[in] y       Top position
+            /// @param[in] width   Area width (pixels)
+            /// @param[in] height  Area height (rows)
+            /// @returns Modified status
+            inline bool isAreaModified(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height) const noexcept
+            {
+                if (width == 0u || height == 0u)
+                    return false;
+                const uint32_t columnMask = getTileMask(x, width, 1024u, VRAM_WRITE_TRACKER_COLUMNS);
+                const uint32_t rowMask = getTileMask(y, height, 512u, VRAM_WRITE_TRACKER_ROWS);
+                for (uint32_t row = 0; row < VRAM_WRITE_TRACKER_ROWS; ++row)
+                {
+                    if ((rowMask & (1u << row)) && (m_tileRows[row] & columnMask))
+                        return true;
+                }
+                return false;
+            }
+
+
+        private:
+            /// @brief Get tiles covered by a range (with wrapping)
+            /// @param[in] position   Range start
+            /// @param[in] length     Range length
+            /// @param[in] limit      VRAM size (wrapping limit)
+            /// @param[in] tileCount  Number of tiles in VRAM size
+            /// @returns Tile bits
+            static inline uint32_t getTileMask(uint32_t position, const uint32_t length, const uint32_t limit, const uint32_t tileCount) noexcept
+            {
+                const uint32_t allTiles = (tileCount >= 32u) ? 0xFFFFFFFFu : (1u << tileCount) - 1u;
+                if (length >= limit)
+                    return allTiles;
+                position &= (limit - 1u);
+                const uint32_t first = position >> VRAM_WRITE_TRACKER_TILE_SHIFT;
+                const uint32_t last = ((position + length - 1u) & (limit - 1u)) >> VRAM_WRITE_TRACKER_TILE_SHIFT;
+                const uint32_t fromFirst = allTiles & ~((1u << first) - 1u);
+                const uint32_t toLast = (last + 1u >= 32u) ? 0xFFFFFFFFu : (1u << (last + 1u)) - 1u;
+                return (position + length <= limit) ? (fromFirst & toLast) : ((fromFirst | toLast) & allTiles); // wrapped: [first; end] + [0; last]
+            }
+
+        private:
+            uint32_t m_tileRows[VRAM_WRITE_TRACKER_ROWS]; ///< Modified tiles (one bit per column, for each row of tiles)
+        };
+    }
+}
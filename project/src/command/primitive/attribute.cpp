@@ -7,9 +7,12 @@ License :     GPLv2
 Description : drawing attribute (area / transparency)
 *******************************************************************************/
 #include "../../globals.h"
+#include "../memory/status_register.h"
+#include "../frame_buffer_settings.h"
 #include "primitive_facade.h"
 #include "attribute.h"
 using namespace command::primitive;
+using command::memory::StatusRegister;
 
 
 // -- attribute types - frame buffer settings -- ---------------------------
@@ -19,8 +22,12 @@ using namespace command::primitive;
 void attr_texpage_t::process(command::cmd_block_t* pData)
 {
     attr_texpage_t* pAttr = (attr_texpage_t*)pData;
+    PrimitiveFacade::getFrameBufferSettings().setTexturePage(pAttr->x(), pAttr->y(), pAttr->colorDepth(), pAttr->semiTransparency());
+    PrimitiveFacade::getFrameBufferSettings().setDrawModeFlags(pAttr->isDithered(), pAttr->isDrawingAllowed(), pAttr->isXFlip(), pAttr->isYFlip());
 
-    //...
+    // status register: draw mode bits 0-10 + texture disabling (bit 15)
+    StatusRegister::unsetStatus(0x87FFu);
+    StatusRegister::setStatus(static_cast<uint32_t>((pAttr->raw & 0x7FFuL) | ((pAttr->raw & 0x800uL) << 4)));
 }
 
 /// @brief Process texture window change
@@ -28,8 +35,7 @@ void attr_texpage_t::process(command::cmd_block_t* pData)
 void attr_texwin_t::process(command::cmd_block_t* pData)
 {
     attr_texwin_t* pAttr = (attr_texwin_t*)pData;
-
-    //...
+    PrimitiveFacade::getFrameBufferSettings().setTextureWindow(pAttr->maskX(), pAttr->maskY(), pAttr->offsetX(), pAttr->offsetY());
 }
 
 /// @brief Process drawing area change
@@ -37,8 +43,11 @@ void attr_texwin_t::process(command::cmd_block_t* pData)
 void attr_drawarea_t::process(command::cmd_block_t* pData)
 {
     attr_drawarea_t* pAttr = (attr_drawarea_t*)pData;
-
-    //...
+    int32_t y = (pAttr->y() < 512uL) ? static_cast<int32_t>(pAttr->y()) : 511;
+    if (PrimitiveFacade::readCommandId(pAttr->raw) == 0xE3uL)
+        PrimitiveFacade::getFrameBufferSettings().setDrawAreaTopLeft(static_cast<int32_t>(pAttr->x()), y);
+    else
+        PrimitiveFacade::getFrameBufferSettings().setDrawAreaBottomRight(static_cast<int32_t>(pAttr->x()), y);
 }
 
 /// @brief Process drawing offset modification
@@ -46,8 +55,10 @@ void attr_drawarea_t::process(command::cmd_block_t* pData)
 void attr_drawoffset_t::process(command::cmd_block_t* pData)
 {
     attr_drawoffset_t* pAttr = (attr_drawoffset_t*)pData;
-
-    //...
+    // 11-bit signed values
+    int32_t x = static_cast<int32_t>(static_cast<uint32_t>(pAttr->x()) << 21) >> 21;
+    int32_t y = static_cast<int32_t>(static_cast<uint32_t>(pAttr->y()) << 21) >> 21;
+    PrimitiveFacade::getFrameBufferSettings().setDrawOffset(x, y);
 }
 
 /// @brief Process semi-transparency bit change
@@ -55,8 +66,13 @@ void attr_drawoffset_t::process(command::cmd_block_t* pData)
 void attr_stpmask_t::process(command::cmd_block_t* pData)
 {
     attr_stpmask_t* pAttr = (attr_stpmask_t*)pData;
+    PrimitiveFacade::getFrameBufferSettings().setMask(pAttr->isMaskBitForced(), pAttr->isMaskBitChecked());
 
-    //...
+    StatusRegister::unsetStatus(GPUSTATUS_MASKDRAWN | GPUSTATUS_MASKENABLED);
+    if (pAttr->isMaskBitForced())
+        StatusRegister::setStatus(GPUSTATUS_MASKDRAWN);
+    if (pAttr->isMaskBitChecked())
+        StatusRegister::setStatus(GPUSTATUS_MASKENABLED);
 }
 
 /// @brief Process GPU interrupt request flag
@@ -7,6 +7,7 @@ License :     GPLv2
 Description : image transfer command
 *******************************************************************************/
 #include "../../globals.h"
+#include "../../display/software/dual_frame_buffer.h"
 #include "primitive_facade.h"
 #include "image_transfer.h"
 using namespace command::primitive;
@@ -19,6 +20,12 @@ using namespace command::primitive;
 /// @param[in] pData  Raw attribute data pointer
 void cache_clear_t::process(command::cmd_block_t* pData)
 {
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        PrimitiveFacade::clearTextureCache();
+        return;
+    }
+
     //...
 }
 
@@ -45,6 +52,15 @@ void img_store_t::process(command::cmd_block_t* pData)
 void img_move_t::process(command::cmd_block_t* pData)
 {
     img_move_t* pAttr = (img_move_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        int32_t width = static_cast<int32_t>(((pAttr->range.x() - 1uL) & 0x3FFuL) + 1uL);
+        int32_t height = static_cast<int32_t>(((pAttr->range.y() - 1uL) & 0x1FFuL) + 1uL);
+        PrimitiveFacade::copyArea(static_cast<int32_t>(pAttr->source.x() & 0x3FFuL), static_cast<int32_t>(pAttr->source.y() & 0x1FFuL),
+                                  static_cast<int32_t>(pAttr->destination.x() & 0x3FFuL), static_cast<int32_t>(pAttr->destination.y() & 0x1FFuL),
+                                  width, height);
+        return;
+    }
 
     //...
 }
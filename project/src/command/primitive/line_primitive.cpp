@@ -7,9 +7,13 @@ License :     GPLv2
 Description : line primitive (line / poly-line)
 *******************************************************************************/
 #include "../../globals.h"
+#include "../../display/software/rasterizer.h"
+#include "../../display/software/dual_frame_buffer.h"
 #include "primitive_facade.h"
 #include "line_primitive.h"
 using namespace command::primitive;
+using display::software::raster_vertex_t;
+using display::software::raster_state_t;
 #pragma pack(push, 4)
 
 
@@ -20,6 +24,14 @@ using namespace command::primitive;
 void line_f2_t::process(command::cmd_block_t* pData)
 {
     line_f2_t* pPrim = (line_f2_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[2];
+        PrimitiveFacade::readDecodedVertices(pVertices, 2u);
+        raster_state_t state = PrimitiveFacade::createRasterState(false, false, false, !pPrim->isOpaque());
+        PrimitiveFacade::drawLine(pVertices[0], pVertices[1], state);
+        return;
+    }
 
     //...
 }
@@ -29,6 +41,14 @@ void line_f2_t::process(command::cmd_block_t* pData)
 void line_g2_t::process(command::cmd_block_t* pData)
 {
     line_g2_t* pPrim = (line_g2_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[2];
+        PrimitiveFacade::readDecodedVertices(pVertices, 2u);
+        raster_state_t state = PrimitiveFacade::createRasterState(false, true, false, !pPrim->isOpaque());
+        PrimitiveFacade::drawLine(pVertices[0], pVertices[1], state);
+        return;
+    }
 
     //...
 }
@@ -42,6 +62,20 @@ void line_fp_t::process(command::cmd_block_t* pData)
 {
     line_fp_t* pPrim = (line_fp_t*)pData;
     line_fp_iterator it(*pPrim);
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_state_t state = PrimitiveFacade::createRasterState(false, false, false, !pPrim->isOpaque());
+        raster_vertex_t pVertices[2];
+        pVertices[0].color = pVertices[1].color = static_cast<uint32_t>(pPrim->color.rgb24());
+        PrimitiveFacade::readCoordinates(*(it.read()), pVertices[0]);
+        while (it.next() && PrimitiveFacade::isPolylineEndCode(it.read()->raw) == false)
+        {
+            PrimitiveFacade::readCoordinates(*(it.read()), pVertices[1]);
+            PrimitiveFacade::drawLine(pVertices[0], pVertices[1], state);
+            pVertices[0] = pVertices[1];
+        }
+        return;
+    }
     //...
 
     do
@@ -56,6 +90,21 @@ void line_gp_t::process(command::cmd_block_t* pData)
 {
     line_gp_t* pPrim = (line_gp_t*)pData;
     line_gp_iterator it(*pPrim);
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_state_t state = PrimitiveFacade::createRasterState(false, true, false, !pPrim->isOpaque());
+        raster_vertex_t pVertices[2];
+        PrimitiveFacade::readCoordinates(it.read()->coord, pVertices[0]);
+        pVertices[0].color = static_cast<uint32_t>(it.read()->color.rgb24());
+        while (it.next() && PrimitiveFacade::isPolylineEndCode(it.read()->color.raw) == false)
+        {
+            PrimitiveFacade::readCoordinates(it.read()->coord, pVertices[1]);
+            pVertices[1].color = static_cast<uint32_t>(it.read()->color.rgb24());
+            PrimitiveFacade::drawLine(pVertices[0], pVertices[1], state);
+            pVertices[0] = pVertices[1];
+        }
+        return;
+    }
     //...
 
     do
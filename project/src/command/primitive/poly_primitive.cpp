@@ -7,9 +7,13 @@ License :     GPLv2
 Description : polygon primitive (triangle / quad)
 *******************************************************************************/
 #include "../../globals.h"
+#include "../../display/software/rasterizer.h"
+#include "../../display/software/dual_frame_buffer.h"
 #include "primitive_facade.h"
 #include "poly_primitive.h"
 using namespace command::primitive;
+using display::software::raster_vertex_t;
+using display::software::raster_state_t;
 #pragma pack(push, 4)
 
 
@@ -20,6 +24,14 @@ using namespace command::primitive;
 void poly_f3_t::process(command::cmd_block_t* pData)
 {
     poly_f3_t* pPrim = (poly_f3_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[3];
+        PrimitiveFacade::readDecodedVertices(pVertices, 3u);
+        raster_state_t state = PrimitiveFacade::createRasterState(false, false, false, !pPrim->isOpaque());
+        PrimitiveFacade::drawTriangle(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -29,6 +41,14 @@ void poly_f3_t::process(command::cmd_block_t* pData)
 void poly_f4_t::process(command::cmd_block_t* pData)
 {
     poly_f4_t* pPrim = (poly_f4_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[4];
+        PrimitiveFacade::readDecodedVertices(pVertices, 4u);
+        raster_state_t state = PrimitiveFacade::createRasterState(false, false, false, !pPrim->isOpaque());
+        PrimitiveFacade::drawQuad(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -38,6 +58,15 @@ void poly_f4_t::process(command::cmd_block_t* pData)
 void poly_ft3_t::process(command::cmd_block_t* pData)
 {
     poly_ft3_t* pPrim = (poly_ft3_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[3];
+        PrimitiveFacade::readDecodedVertices(pVertices, 3u);
+        raster_state_t state = PrimitiveFacade::createRasterState(true, false, pPrim->isBlended(), !pPrim->isOpaque());
+        PrimitiveFacade::setPolygonTexture(pPrim->vertex0.texture, pPrim->vertex1.texture, state);
+        PrimitiveFacade::drawTriangle(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -47,6 +76,15 @@ void poly_ft3_t::process(command::cmd_block_t* pData)
 void poly_ft4_t::process(command::cmd_block_t* pData)
 {
     poly_ft4_t* pPrim = (poly_ft4_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[4];
+        PrimitiveFacade::readDecodedVertices(pVertices, 4u);
+        raster_state_t state = PrimitiveFacade::createRasterState(true, false, pPrim->isBlended(), !pPrim->isOpaque());
+        PrimitiveFacade::setPolygonTexture(pPrim->vertex0.texture, pPrim->vertex1.texture, state);
+        PrimitiveFacade::drawQuad(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -59,6 +97,14 @@ void poly_ft4_t::process(command::cmd_block_t* pData)
 void poly_g3_t::process(command::cmd_block_t* pData)
 {
     poly_g3_t* pPrim = (poly_g3_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[3];
+        PrimitiveFacade::readDecodedVertices(pVertices, 3u);
+        raster_state_t state = PrimitiveFacade::createRasterState(false, true, false, !pPrim->isOpaque());
+        PrimitiveFacade::drawTriangle(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -68,6 +114,14 @@ void poly_g3_t::process(command::cmd_block_t* pData)
 void poly_g4_t::process(command::cmd_block_t* pData)
 {
     poly_g4_t* pPrim = (poly_g4_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[4];
+        PrimitiveFacade::readDecodedVertices(pVertices, 4u);
+        raster_state_t state = PrimitiveFacade::createRasterState(false, true, false, !pPrim->isOpaque());
+        PrimitiveFacade::drawQuad(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -77,6 +131,15 @@ void poly_g4_t::process(command::cmd_block_t* pData)
 void poly_gt3_t::process(command::cmd_block_t* pData)
 {
     poly_gt3_t* pPrim = (poly_gt3_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[3];
+        PrimitiveFacade::readDecodedVertices(pVertices, 3u);
+        raster_state_t state = PrimitiveFacade::createRasterState(true, true, pPrim->isBlended(), !pPrim->isOpaque());
+        PrimitiveFacade::setPolygonTexture(pPrim->vertex0.texture, pPrim->vertex1.texture, state);
+        PrimitiveFacade::drawTriangle(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -86,6 +149,15 @@ void poly_gt3_t::process(command::cmd_block_t* pData)
 void poly_gt4_t::process(command::cmd_block_t* pData)
 {
     poly_gt4_t* pPrim = (poly_gt4_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        raster_vertex_t pVertices[4];
+        PrimitiveFacade::readDecodedVertices(pVertices, 4u);
+        raster_state_t state = PrimitiveFacade::createRasterState(true, true, pPrim->isBlended(), !pPrim->isOpaque());
+        PrimitiveFacade::setPolygonTexture(pPrim->vertex0.texture, pPrim->vertex1.texture, state);
+        PrimitiveFacade::drawQuad(pVertices, state);
+        return;
+    }
 
     //...
 }
@@ -97,6 +97,14 @@ namespace command
             {
                 return ((raw >> 16) & 0x0FFFFuL);
             }
+            inline int32_t signedX() ///< Signed X coordinate (11-bit, sign-extended)
+            {
+                return (static_cast<int32_t>(static_cast<uint32_t>(raw) << 21) >> 21);
+            }
+            inline int32_t signedY() ///< Signed Y coordinate (11-bit, sign-extended)
+            {
+                return (static_cast<int32_t>(static_cast<uint32_t>(raw >> 16) << 21) >> 21);
+            }
         };
 
         /// @struct rect16_t
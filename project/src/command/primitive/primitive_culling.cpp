@@ -0,0 +1,180 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : primitive early rejection (before primitive processing)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstdint>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "primitive_culling.h"
+using namespace command::primitive;
+
+uint32_t PrimitiveCulling::s_pCounters[PRIMITIVE_REJECT_REASON_LENGTH] = { 0u, 0u, 0u, 0u }; ///< Number of processed primitives per reason
+
+
+// -- vertex helpers -- --------------------------------------------------------
+
+/// @brief Check bounds of 4 decoded vertices
+/// @param[in] pX        Decoded X coordinates (4) - duplicate last vertex for triangles and lines
+/// @param[in] pY        Decoded Y coordinates (4)
+/// @param[in] settings  Frame buffer settings (drawing area)
+/// @returns Rejection reason (oversized, outsideArea) or reject_reason_t::none
+static inline reject_reason_t checkVertexBounds(const int32_t* pX, const int32_t* pY, const command::FrameBufferSettings& settings) noexcept
+{
+    #if _SIMD_SSE2
+    // X in 16-bit lanes 0-3, Y in 16-bit lanes 4-7 (decoded coordinates always fit in 16 bits)
+    __m128i vertices = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pX)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pY)));
+
+    // bounds of vertices (X and Y reduced at the same time)
+    __m128i swapped = _mm_shuffle_epi32(vertices, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128i minXY = _mm_min_epi16(vertices, swapped);
+    __m128i maxXY = _mm_max_epi16(vertices, swapped);
+    minXY = _mm_min_epi16(minXY, _mm_shufflehi_epi16(_mm_shufflelo_epi16(minXY, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1)));
+    maxXY = _mm_max_epi16(maxXY, _mm_shufflehi_epi16(_mm_shufflelo_epi16(maxXY, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1)));
+
+    // hardware size limits
+    __m128i limits = _mm_set_epi16(PRIMITIVE_MAX_HEIGHT, PRIMITIVE_MAX_HEIGHT, PRIMITIVE_MAX_HEIGHT, PRIMITIVE_MAX_HEIGHT,
+                                   PRIMITIVE_MAX_WIDTH, PRIMITIVE_MAX_WIDTH, PRIMITIVE_MAX_WIDTH, PRIMITIVE_MAX_WIDTH);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_sub_epi16(maxXY, minXY), limits)) != 0)
+        return reject_reason_t::oversized;
+    // drawing area
+    const int16_t left = static_cast<int16_t>(settings.drawAreaLeft()), top = static_cast<int16_t>(settings.drawAreaTop());
+    const int16_t right = static_cast<int16_t>(settings.drawAreaRight()), bottom = static_cast<int16_t>(settings.drawAreaBottom());
+    __m128i areaMin = _mm_set_epi16(top, top, top, top, left, left, left, left);
+    __m128i areaMax = _mm_set_epi16(bottom, bottom, bottom, bottom, right, right, right, right);
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi16(minXY, areaMax), _mm_cmpgt_epi16(areaMin, maxXY))) != 0)
+        return reject_reason_t::outsideArea;
+
+    #else
+    int32_t minX = pX[0], maxX = pX[0], minY = pY[0], maxY = pY[0];
+    for (uint32_t i = 1; i < 4u; ++i)
+    {
+        minX = (pX[i] < minX) ? pX[i] : minX;
+        maxX = (pX[i] > maxX) ? pX[i] : maxX;
+        minY = (pY[i] < minY) ? pY[i] : minY;
+        maxY = (pY[i] > maxY) ? pY[i] : maxY;
+    }
+    if (maxX - minX > PRIMITIVE_MAX_WIDTH || maxY - minY > PRIMITIVE_MAX_HEIGHT)
+        return reject_reason_t::oversized;
+    if (maxX < settings.drawAreaLeft() || minX > settings.drawAreaRight() || maxY < settings.drawAreaTop() || minY > settings.drawAreaBottom())
+        return reject_reason_t::outsideArea;
+    #endif
+    return reject_reason_t::none;
+}
+
+
+// -- primitive type checks -- -------------------------------------------------
+
+/// @brief Check triangle
+/// @param[in] pX        Decoded X coordinates (last vertex duplicated)
+/// @param[in] pY        Decoded Y coordinates (last vertex duplicated)
+/// @param[in] settings  Frame buffer settings
+static inline reject_reason_t checkTriangle(const int32_t* pX, const int32_t* pY, const command::FrameBufferSettings& settings) noexcept
+{
+    reject_reason_t reason = checkVertexBounds(pX, pY, settings);
+    if (reason == reject_reason_t::none)
+    {
+        int32_t crossProduct = (pX[1] - pX[0]) * (pY[2] - pY[0]) - (pX[2] - pX[0]) * (pY[1] - pY[0]);
+        if (crossProduct == 0)
+            return reject_reason_t::degenerate;
+    }
+    return reason;
+}
+
+/// @brief Check quad (split in triangles 0-1-2 and 2-1-3 : rejected if both triangles are rejected)
+/// @param[in] pX        Decoded X coordinates (4)
+/// @param[in] pY        Decoded Y coordinates (4)
+/// @param[in] settings  Frame buffer settings
+static inline reject_reason_t checkQuad(const int32_t* pX, const int32_t* pY, const command::FrameBufferSettings& settings) noexcept
+{
+    const int32_t pFirstX[4] = { pX[0], pX[1], pX[2], pX[2] };
+    const int32_t pFirstY[4] = { pY[0], pY[1], pY[2], pY[2] };
+    reject_reason_t reason = checkTriangle(pFirstX, pFirstY, settings);
+    if (reason == reject_reason_t::none)
+        return reject_reason_t::none;
+
+    const int32_t pSecondX[4] = { pX[2], pX[1], pX[3], pX[3] };
+    const int32_t pSecondY[4] = { pY[2], pY[1], pY[3], pY[3] };
+    return (checkTriangle(pSecondX, pSecondY, settings) == reject_reason_t::none) ? reject_reason_t::none : reason;
+}
+
+/// @brief Check rectangle (sizes limited by command format: never oversized)
+/// @param[in] left      Decoded left coordinate
+/// @param[in] top       Decoded top coordinate
+/// @param[in] width     Rectangle width
+/// @param[in] height    Rectangle height
+/// @param[in] settings  Frame buffer settings
+static inline reject_reason_t checkRectangle(const int32_t left, const int32_t top, const int32_t width, const int32_t height, const command::FrameBufferSettings& settings) noexcept
+{
+    if (width == 0 || height == 0)
+        return reject_reason_t::degenerate;
+    if (left + width - 1 < settings.drawAreaLeft() || left > settings.drawAreaRight() || top + height - 1 < settings.drawAreaTop() || top > settings.drawAreaBottom())
+        return reject_reason_t::outsideArea;
+    return reject_reason_t::none;
+}
+
+
+// -- primitive rejection -- ---------------------------------------------------
+
+/// @brief Find rejection reason of a geometry primitive
+/// @param[in] commandId  Command identifier (geometry primitive: 0x20 - 0x7F)
+/// @param[in] pData      Primitive raw data blocks
+/// @param[in] pX         Decoded X coordinates of primitive vertices (VertexDecoder output: drawing offset applied)
+/// @param[in] pY         Decoded Y coordinates of primitive vertices
+/// @param[in] settings   Frame buffer settings (drawing area)
+/// @returns Rejection reason (or reject_reason_t::none)
+reject_reason_t PrimitiveCulling::checkPrimitive(const command::cmd_block_t commandId, const command::cmd_block_t* pData, const int32_t* pX, const int32_t* pY,
+                                                 const FrameBufferSettings& settings) noexcept
+{
+    if (commandId < 0x40uL) // polygon
+    {
+        if (commandId & 0x08uL) // quad
+            return checkQuad(pX, pY, settings);
+        const int32_t pTriangleX[4] = { pX[0], pX[1], pX[2], pX[2] };
+        const int32_t pTriangleY[4] = { pY[0], pY[1], pY[2], pY[2] };
+        return checkTriangle(pTriangleX, pTriangleY, settings);
+    }
+    else if (commandId < 0x60uL) // line (end points included: never degenerate)
+    {
+        if (commandId & 0x08uL) // poly-line
+            return reject_reason_t::none;
+        const int32_t pLineX[4] = { pX[0], pX[1], pX[1], pX[1] };
+        const int32_t pLineY[4] = { pY[0], pY[1], pY[1], pY[1] };
+        return checkVertexBounds(pLineX, pLineY, settings);
+    }
+    else // rectangle: color, vertex, [texture], [size]
+    {
+        int32_t width, height;
+        switch ((commandId >> 3) & 0x3uL)
+        {
+            case 0uL:
+            {
+                command::cmd_block_t size = pData[(commandId & 0x04uL) ? 3 : 2];
+                width = static_cast<int32_t>(size & 0x3FFuL);
+                height = static_cast<int32_t>((size >> 16) & 0x1FFuL);
+                break;
+            }
+            case 1uL: width = height = 1; break;
+            case 2uL: width = height = 8; break;
+            default:  width = height = 16; break;
+        }
+        return checkRectangle(pX[0], pY[0], width, height, settings);
+    }
+}
+
+/// @brief Apply texture page of a rejected textured polygon to current draw mode (side-effect of the primitive)
+void PrimitiveCulling::applyTexturePage(const command::cmd_block_t commandId, const command::cmd_block_t* pData, FrameBufferSettings& settings) noexcept
+{
+    if (commandId < 0x40uL && (commandId & 0x04uL)) // textured polygon -> texture page stored with second vertex
+    {
+        uint32_t stride = (commandId & 0x10uL) ? 3u : 2u;
+        coord8_tx_t texture;
+        texture.raw = pData[2u + stride];
+        settings.setTexturePage(texture.texpageX(), texture.texpageY(), texture.colorDepth(), texture.semiTransparency());
+    }
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : primitive early rejection (before primitive processing)
+*******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include "../frame_buffer_settings.h"
+#include "primitive_common.h"
+
+#define PRIMITIVE_MAX_WIDTH  1023 // max horizontal distance between vertices of a primitive
+#define PRIMITIVE_MAX_HEIGHT 511  // max vertical distance between vertices of a primitive
+#define PRIMITIVE_REJECT_REASON_LENGTH 4
+
+/// @namespace command
+/// GPU commands management
+namespace command
+{
+    /// @namespace command.primitive
+    /// Drawing primitive management
+    namespace primitive
+    {
+        /// @enum reject_reason_t
+        /// @brief Primitive rejection reason
+        enum class reject_reason_t : uint32_t
+        {
+            none = 0u,        ///< Not rejected (accepted primitive)
+            degenerate = 1u,  ///< Zero area (triangle) or zero size (rectangle)
+            outsideArea = 2u, ///< Fully outside of drawing area
+            oversized = 3u    ///< Distance between vertices above hardware limits (1023 x 511)
+        };
+
+
+        /// @class PrimitiveCulling
+        /// @brief Conservative early rejection of geometry primitives (polygons, lines, rectangles)
+        /// @details Only primitives that can't draw any pixel are rejected (bounds are not reduced by rasterization rules).
+        ///          Vertex coordinates are read from VertexDecoder output (sign extension and drawing offset already applied).
+        ///          Poly-lines are never rejected (variable length, each segment is processed by its primitive).
+        class PrimitiveCulling
+        {
+        private:
+            static uint32_t s_pCounters[PRIMITIVE_REJECT_REASON_LENGTH]; ///< Number of processed primitives per reason
+
+        public:
+            /// @brief Check if geometry primitive can be rejected (+ update counters)
+            /// @param[in] commandId  Command identifier (geometry primitive: 0x20 - 0x7F)
+            /// @param[in] pData      Primitive raw data blocks
+            /// @param[in] pX         Decoded X coordinates of primitive vertices (VertexDecoder output: drawing offset applied)
+            /// @param[in] pY         Decoded Y coordinates of primitive vertices
+            /// @param[in] settings   Frame buffer settings (drawing area - texture page updated if rejected textured polygon)
+            /// @returns Rejected (primitive must not be processed) or not
+            static inline bool isRejected(const command::cmd_block_t commandId, const command::cmd_block_t* pData, const int32_t* pX, const int32_t* pY,
+                                          FrameBufferSettings& settings) noexcept
+            {
+                reject_reason_t reason = checkPrimitive(commandId, pData, pX, pY, settings);
+                ++s_pCounters[static_cast<uint32_t>(reason)];
+                if (reason == reject_reason_t::none)
+                    return false;
+
+                applyTexturePage(commandId, pData, settings);
+                return true;
+            }
+
+            /// @brief Find rejection reason of a geometry primitive
+            /// @param[in] commandId  Command identifier (geometry primitive: 0x20 - 0x7F)
+            /// @param[in] pData      Primitive raw data blocks
+            /// @param[in] pX         Decoded X coordinates of primitive vertices (VertexDecoder output: drawing offset applied)
+            /// @param[in] pY         Decoded Y coordinates of primitive vertices
+            /// @param[in] settings   Frame buffer settings (drawing area)
+            /// @returns Rejection reason (or reject_reason_t::none)
+            static reject_reason_t checkPrimitive(const command::cmd_block_t commandId, const command::cmd_block_t* pData, const int32_t* pX, const int32_t* pY,
+                                                  const FrameBufferSettings& settings) noexcept;
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Get number of primitives checked with a specific result
+            /// @param[in] reason  Rejection reason (reject_reason_t::none: accepted primitives)
+            /// @returns Number of primitives
+            static inline uint32_t getCounter(const reject_reason_t reason) noexcept
+            {
+                return s_pCounters[static_cast<uint32_t>(reason)];
+            }
+            /// @brief Get total number of rejected primitives
+            static inline uint32_t getRejectedCount() noexcept
+            {
+                return s_pCounters[static_cast<uint32_t>(reject_reason_t::degenerate)] + s_pCounters[static_cast<uint32_t>(reject_reason_t::outsideArea)]
+                     + s_pCounters[static_cast<uint32_t>(reject_reason_t::oversized)];
+            }
+            /// @brief Reset all counters
+            static inline void resetCounters() noexcept
+            {
+                for (uint32_t i = 0; i < PRIMITIVE_REJECT_REASON_LENGTH; ++i)
+                    s_pCounters[i] = 0u;
+            }
+
+        private:
+            /// @brief Apply texture page of a rejected textured polygon to current draw mode (side-effect of the primitive)
+            static void applyTexturePage(const command::cmd_block_t commandId, const command::cmd_block_t* pData, FrameBufferSettings& settings) noexcept;
+        };
+    }
+}
@@ -8,6 +8,11 @@ Description : primitive drawing facade
 *******************************************************************************/
 #include "../../globals.h"
 #include <cstdlib>
+#include "../../display/software/rasterizer.h"
+#include "../../display/software/dual_frame_buffer.h"
+#include "../display_list.h"
+#include "../command_buffer.h"
+#include "../memory/vram_write_tracker.h"
 #include "primitive_facade.h"
 #include "line_primitive.h"
 #include "poly_primitive.h"
@@ -19,6 +24,13 @@ using namespace command::primitive;
 bool PrimitiveFacade::s_isInitialized = nullptr;                                ///< References status
 command::memory::VideoMemory* PrimitiveFacade::s_pVramAccess = nullptr;         ///< VRAM access used by primitives
 command::FrameBufferSettings* PrimitiveFacade::s_pDrawSettingsAccess = nullptr; ///< Frame buffer settings used by primitives
+command::DisplayState* PrimitiveFacade::s_pDisplayStateAccess = nullptr;        ///< Display state used by primitives (interlaced fields)
+command::memory::VramWriteTracker* PrimitiveFacade::s_pVramWrites = nullptr;    ///< VRAM areas modified by primitives
+display::software::DualFrameBuffer* PrimitiveFacade::s_pSoftwareRenderer = nullptr; ///< Software renderer (if software rendering mode)
+command::DisplayList* PrimitiveFacade::s_pDisplayList = nullptr;                ///< Display list recording decoded primitives (optional)
+command::CommandBuffer* PrimitiveFacade::s_pCommandBuffer = nullptr;            ///< Command buffer grouping decoded primitives in draw batches (hardware rendering)
+VertexDecoder PrimitiveFacade::s_vertexDecoder;                                 ///< Decoded vertices of current run of geometry primitives
+size_t PrimitiveFacade::s_decodedVertexIndex = 0u;                              ///< First decoded vertex of primitive being processed
 
 // multi-commands definition macros
 #define CMDx4(cmd,size)  {cmd,size},{cmd,size},{cmd,size},{cmd,size}
@@ -77,3 +89,371 @@ const index_row_t command::primitive::c_pPrimitiveIndex[PRIMITIVE_NUMBER] =
     // not implemented : E8 - FF
     CMDx24(PRIMITIVE_NI, 0)
 };
+
+
+// -- primitive creation -- ----------------------------------------------------
+
+/// @brief Create and process run of primitives with the same command identifier (consecutive packets)
+/// @param[in] commandId    Command identifier of every packet
+/// @param[in] pPackets     Consecutive raw primitive packets
+/// @param[in] packetCount  Number of packets
+void PrimitiveFacade::createPrimitives(const command::cmd_block_t commandId, command::cmd_block_t* pPackets, size_t packetCount)
+{
+    if (isCommandImplemented(commandId) == false || s_isInitialized == false)
+        return;
+    const size_t packetSize = c_pPrimitiveIndex[commandId].size;
+    if (isCommandSkippable(commandId) || isPolyline(packetSize)) // not decoded
+    {
+        for (; packetCount > 0u; --packetCount, pPackets += packetSize)
+            c_pPrimitiveIndex[commandId].command(pPackets);
+        return;
+    }
+
+    // geometry primitives: decode vertices of whole run (drawing offset can't change between packets with the same command identifier)
+    while (packetCount > 0u)
+    {
+        const size_t decodedCount = s_vertexDecoder.decode(commandId, pPackets, packetCount, s_pDrawSettingsAccess->drawOffsetX(), s_pDrawSettingsAccess->drawOffsetY());
+        if (decodedCount == 0u)
+            break;
+        const size_t vertexCount = s_vertexDecoder.layout().vertexCount;
+        for (size_t packet = 0; packet < decodedCount; ++packet, pPackets += packetSize)
+        {
+            s_decodedVertexIndex = packet * vertexCount;
+            if (PrimitiveCulling::isRejected(commandId, pPackets, s_vertexDecoder.x() + s_decodedVertexIndex, s_vertexDecoder.y() + s_decodedVertexIndex,
+                                             *s_pDrawSettingsAccess) == false)
+                c_pPrimitiveIndex[commandId].command(pPackets);
+        }
+        packetCount -= decodedCount;
+    }
+}
+
+
+// -- software rendering data -- -----------------------------------------------
+
+/// @brief Create rendering state from current frame buffer settings
+/// @param[in] isTextured         Texture mapping
+/// @param[in] isShaded           Gouraud shading
+/// @param[in] isModulated        Texture blending with vertex color
+/// @param[in] isSemiTransparent  Semi-transparency
+/// @returns Rendering state (texture page from current draw mode, interlaced field limits)
+display::software::raster_state_t PrimitiveFacade::createRasterState(const bool isTextured, const bool isShaded, const bool isModulated, const bool isSemiTransparent) noexcept
+{
+    const FrameBufferSettings& settings = *s_pDrawSettingsAccess;
+    display::software::raster_state_t state{}; // padding zeroed (states copied/compared as a whole)
+    state.clipLeft = settings.drawAreaLeft();
+    state.clipTop = settings.drawAreaTop();
+    state.clipRight = settings.drawAreaRight();
+    state.clipBottom = settings.drawAreaBottom();
+
+    state.texture.pVram = s_pVramAccess->rend();
+    state.texture.texpageX = settings.texpageX();
+    state.texture.texpageY = settings.texpageY();
+    state.texture.clutX = state.texture.clutY = 0u;
+    state.texture.colorDepth = settings.colorDepth();
+    state.texture.windowMaskU = settings.texWindowMaskU();
+    state.texture.windowMaskV = settings.texWindowMaskV();
+    state.texture.windowOffsetU = settings.texWindowOffsetU();
+    state.texture.windowOffsetV = settings.texWindowOffsetV();
+    state.texture.pDecodedPage = nullptr;
+    state.texture.pUpscaledPage = nullptr;
+    state.texture.upscalingFactor = 1u;
+
+    state.semiTransparency = settings.semiTransparency();
+    state.isTextured = isTextured;
+    state.isShaded = isShaded;
+    state.isModulated = (isTextured && isModulated);
+    state.isSemiTransparent = isSemiTransparent;
+    state.isDithered = settings.isDithered();
+    state.isMaskBitForced = settings.isMaskBitForced();
+    state.isMaskBitChecked = settings.isMaskBitChecked();
+    state.isRectXFlip = settings.isRectXFlip();
+    state.isRectYFlip = settings.isRectYFlip();
+
+    // interlaced display: only lines of the field that isn't displayed can be drawn
+    state.isFieldSkipped = DisplayState::isFieldDrawing(settings);
+    state.skippedFieldParity = (s_pDisplayStateAccess->isOddFrame()) ? 1 : 0;
+    return state;
+}
+
+/// @brief Set polygon texture page and CLUT (texture page also applied to current draw mode)
+/// @param[in] clutSource     Texture attributes containing CLUT
+/// @param[in] texpageSource  Texture attributes containing texture page
+/// @param[out] outState      Rendering state to update
+void PrimitiveFacade::setPolygonTexture(coord8_tx_t clutSource, coord8_tx_t texpageSource, display::software::raster_state_t& outState) noexcept
+{
+    s_pDrawSettingsAccess->setTexturePage(texpageSource.texpageX(), texpageSource.texpageY(), texpageSource.colorDepth(), texpageSource.semiTransparency());
+
+    outState.texture.texpageX = static_cast<uint32_t>(texpageSource.texpageX());
+    outState.texture.texpageY = static_cast<uint32_t>(texpageSource.texpageY());
+    outState.texture.colorDepth = texpageSource.colorDepth();
+    outState.texture.clutX = static_cast<uint32_t>(clutSource.clutX());
+    outState.texture.clutY = static_cast<uint32_t>(clutSource.clutY());
+    outState.semiTransparency = texpageSource.semiTransparency();
+}
+
+
+// -- software rendering output -- ---------------------------------------------
+
+/// @brief Mark bounding box of drawn primitive as modified (limited to drawing area)
+/// @param[in] pVramWrites  VRAM write tracker (or nullptr)
+/// @param[in] left         Left limit (inclusive)
+/// @param[in] top          Top limit (inclusive)
+/// @param[in] right        Right limit (inclusive)
+/// @param[in] bottom       Bottom limit (inclusive)
+/// @param[in] state        Rendering state (drawing area)
+static inline void markDrawnArea(command::memory::VramWriteTracker* pVramWrites, int32_t left, int32_t top, int32_t right, int32_t bottom,
+                                 const display::software::raster_state_t& state) noexcept
+{
+    if (pVramWrites == nullptr)
+        return;
+    left = (left > state.clipLeft) ? left : state.clipLeft;
+    top = (top > state.clipTop) ? top : state.clipTop;
+    right = (right < state.clipRight) ? right : state.clipRight;
+    bottom = (bottom < state.clipBottom) ? bottom : state.clipBottom;
+    pVramWrites->markArea(left, top, right - left + 1, bottom - top + 1); // empty area ignored
+}
+
+/// @brief Convert rendering state into command buffer render state
+/// @param[in] state           Rendering state
+/// @param[in] primitiveFlags  Primitive type flags (RENDER_STATE_LINE / RENDER_STATE_FILL)
+static inline command::render_state_t toRenderState(const display::software::raster_state_t& state, const uint32_t primitiveFlags) noexcept
+{
+    command::render_state_t renderState;
+    if (state.isTextured)
+    {
+        const bool isClut = (state.texture.colorDepth == colordepth_t::clut_4bit || state.texture.colorDepth == colordepth_t::clut_8bit);
+        renderState.texpageX = static_cast<uint16_t>(state.texture.texpageX);
+        renderState.texpageY = static_cast<uint16_t>(state.texture.texpageY);
+        renderState.clutId = (isClut) ? static_cast<uint16_t>(((state.texture.clutY & 0x1FFu) << 6) | ((state.texture.clutX >> 4) & 0x3Fu)) : 0u;
+        renderState.colorDepth = static_cast<uint8_t>(state.texture.colorDepth);
+        renderState.textureWindow = state.texture.windowMaskU | (state.texture.windowMaskV << 8)
+                                  | (state.texture.windowOffsetU << 16) | (state.texture.windowOffsetV << 24);
+    }
+    else
+    {
+        renderState.texpageX = renderState.texpageY = renderState.clutId = 0u;
+        renderState.colorDepth = 0u;
+        renderState.textureWindow = 0u;
+    }
+    renderState.semiTransparency = (state.isSemiTransparent) ? static_cast<uint8_t>(state.semiTransparency) : RENDER_STATE_OPAQUE;
+    renderState.drawAreaLeft = static_cast<int16_t>(state.clipLeft);
+    renderState.drawAreaTop = static_cast<int16_t>(state.clipTop);
+    renderState.drawAreaRight = static_cast<int16_t>(state.clipRight);
+    renderState.drawAreaBottom = static_cast<int16_t>(state.clipBottom);
+    renderState.flags = primitiveFlags | ((state.isTextured) ? RENDER_STATE_TEXTURED : 0u)
+                      | ((state.isDithered) ? RENDER_STATE_DITHERED : 0u)
+                      | ((state.isMaskBitForced) ? RENDER_STATE_MASK_FORCED : 0u)
+                      | ((state.isMaskBitChecked) ? RENDER_STATE_MASK_CHECK : 0u);
+    return renderState;
+}
+
+/// @brief Convert vertex into command buffer vertex
+/// @param[in] x      X coordinate
+/// @param[in] y      Y coordinate
+/// @param[in] color  Vertex color (00BbGgRr)
+/// @param[in] u      Texture U coordinate
+/// @param[in] v      Texture V coordinate
+static inline command::vertex_t toBufferVertex(const int32_t x, const int32_t y, const uint32_t color, const uint32_t u, const uint32_t v) noexcept
+{
+    command::vertex_t vertex;
+    vertex.coords = command::vertex_pos_t{ static_cast<float>(x), static_cast<float>(y), 0.0f };
+    vertex.color = color;
+    vertex.texture = (u & 0xFFu) | ((v & 0xFFu) << 8);
+    return vertex;
+}
+
+/// @brief Add rectangle to command buffer (quad: 0-1 top, 2-3 bottom) - buffer full: batches of previous primitives dropped (no hardware backend yet)
+/// @param[in] pCommandBuffer  Command buffer
+/// @param[in] topLeft         Top-left vertex
+/// @param[in] width           Rectangle width
+/// @param[in] height          Rectangle height
+/// @param[in] renderState     Render state
+/// @param[in] isXFlip         Texture X-flip
+/// @param[in] isYFlip         Texture Y-flip
+static inline void pushRectangle(command::CommandBuffer* pCommandBuffer, const display::software::raster_vertex_t& topLeft, const int32_t width, const int32_t height,
+                                 const command::render_state_t& renderState, const bool isXFlip, const bool isYFlip) noexcept
+{
+    const int32_t right = topLeft.x + width - 1, bottom = topLeft.y + height - 1; // last pixels (inclusive)
+    const uint32_t lastU = (isXFlip) ? topLeft.u - static_cast<uint32_t>(width - 1) : topLeft.u + static_cast<uint32_t>(width - 1);
+    const uint32_t lastV = (isYFlip) ? topLeft.v - static_cast<uint32_t>(height - 1) : topLeft.v + static_cast<uint32_t>(height - 1);
+    command::vertex_t pQuad[4] = {
+        toBufferVertex(topLeft.x, topLeft.y, topLeft.color, topLeft.u, topLeft.v), toBufferVertex(right, topLeft.y, topLeft.color, lastU, topLeft.v),
+        toBufferVertex(topLeft.x, bottom, topLeft.color, topLeft.u, lastV),        toBufferVertex(right, bottom, topLeft.color, lastU, lastV)
+    };
+    if (pCommandBuffer->pushQuad(pQuad, renderState) == false)
+    {
+        pCommandBuffer->flushBatches();
+        pCommandBuffer->pushQuad(pQuad, renderState);
+    }
+}
+
+/// @brief Mark bounding box of drawn polygon as modified (limited to drawing area)
+/// @param[in] pVramWrites  VRAM write tracker (or nullptr)
+/// @param[in] pVertices    Polygon vertices
+/// @param[in] vertexCount  Number of vertices
+/// @param[in] state        Rendering state (drawing area)
+static inline void markDrawnPolygon(command::memory::VramWriteTracker* pVramWrites, const display::software::raster_vertex_t* pVertices, const uint32_t vertexCount,
+                                    const display::software::raster_state_t& state) noexcept
+{
+    int32_t left = pVertices[0].x, right = pVertices[0].x, top = pVertices[0].y, bottom = pVertices[0].y;
+    for (uint32_t i = 1u; i < vertexCount; ++i)
+    {
+        left = (pVertices[i].x < left) ? pVertices[i].x : left;
+        right = (pVertices[i].x > right) ? pVertices[i].x : right;
+        top = (pVertices[i].y < top) ? pVertices[i].y : top;
+        bottom = (pVertices[i].y > bottom) ? pVertices[i].y : bottom;
+    }
+    markDrawnArea(pVramWrites, left, top, right, bottom, state);
+}
+
+/// @brief Output triangle
+void PrimitiveFacade::drawTriangle(const display::software::raster_vertex_t* pVertices, const display::software::raster_state_t& state)
+{
+    markDrawnPolygon(s_pVramWrites, pVertices, 3u, state);
+
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordTriangle(pVertices, state);
+    if (s_pCommandBuffer != nullptr)
+    {
+        command::vertex_t pBufferVertices[3];
+        for (uint32_t i = 0; i < 3u; ++i)
+            pBufferVertices[i] = toBufferVertex(pVertices[i].x, pVertices[i].y, (state.isShaded || i == 0u) ? pVertices[i].color : pVertices[0].color, pVertices[i].u, pVertices[i].v);
+        const command::render_state_t renderState = toRenderState(state, 0u);
+        if (s_pCommandBuffer->pushTriangle(pBufferVertices, renderState) == false) // buffer full: batches of previous primitives dropped (no hardware backend yet)
+        {
+            s_pCommandBuffer->flushBatches();
+            s_pCommandBuffer->pushTriangle(pBufferVertices, renderState);
+        }
+    }
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->drawTriangle(pVertices, state);
+}
+
+/// @brief Output quad (vertex order of quad primitives: 0-1 top, 2-3 bottom)
+void PrimitiveFacade::drawQuad(const display::software::raster_vertex_t* pVertices, const display::software::raster_state_t& state)
+{
+    markDrawnPolygon(s_pVramWrites, pVertices, 4u, state);
+
+    // display list + software renderer: two triangles (0-1-2, 2-1-3) - same split as quad indices of command buffer
+    const display::software::raster_vertex_t pSecondTriangle[3] = { pVertices[2], pVertices[1], pVertices[3] };
+    if (s_pDisplayList != nullptr)
+    {
+        s_pDisplayList->recordTriangle(pVertices, state);
+        s_pDisplayList->recordTriangle(pSecondTriangle, state);
+    }
+    if (s_pCommandBuffer != nullptr)
+    {
+        command::vertex_t pBufferVertices[4];
+        for (uint32_t i = 0; i < 4u; ++i)
+            pBufferVertices[i] = toBufferVertex(pVertices[i].x, pVertices[i].y, (state.isShaded || i == 0u) ? pVertices[i].color : pVertices[0].color, pVertices[i].u, pVertices[i].v);
+        const command::render_state_t renderState = toRenderState(state, 0u);
+        if (s_pCommandBuffer->pushQuad(pBufferVertices, renderState) == false) // buffer full: batches of previous primitives dropped (no hardware backend yet)
+        {
+            s_pCommandBuffer->flushBatches();
+            s_pCommandBuffer->pushQuad(pBufferVertices, renderState);
+        }
+    }
+    if (s_pSoftwareRenderer != nullptr)
+    {
+        s_pSoftwareRenderer->drawTriangle(pVertices, state);
+        s_pSoftwareRenderer->drawTriangle(pSecondTriangle, state);
+    }
+}
+
+/// @brief Output line
+void PrimitiveFacade::drawLine(const display::software::raster_vertex_t& v0, const display::software::raster_vertex_t& v1, const display::software::raster_state_t& state)
+{
+    markDrawnArea(s_pVramWrites, (v0.x < v1.x) ? v0.x : v1.x, (v0.y < v1.y) ? v0.y : v1.y, (v0.x > v1.x) ? v0.x : v1.x, (v0.y > v1.y) ? v0.y : v1.y, state);
+
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordLine(v0, v1, state);
+    if (s_pCommandBuffer != nullptr)
+    {
+        const command::vertex_t bufferVertex0 = toBufferVertex(v0.x, v0.y, v0.color, 0u, 0u);
+        const command::vertex_t bufferVertex1 = toBufferVertex(v1.x, v1.y, (state.isShaded) ? v1.color : v0.color, 0u, 0u);
+        const command::render_state_t renderState = toRenderState(state, RENDER_STATE_LINE);
+        if (s_pCommandBuffer->pushLine(bufferVertex0, bufferVertex1, renderState) == false) // buffer full: batches of previous primitives dropped (no hardware backend yet)
+        {
+            s_pCommandBuffer->flushBatches();
+            s_pCommandBuffer->pushLine(bufferVertex0, bufferVertex1, renderState);
+        }
+    }
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->drawLine(v0, v1, state);
+}
+
+/// @brief Output rectangle
+void PrimitiveFacade::drawRectangle(const display::software::raster_vertex_t& topLeft, const int32_t width, const int32_t height, const display::software::raster_state_t& state)
+{
+    markDrawnArea(s_pVramWrites, topLeft.x, topLeft.y, topLeft.x + width - 1, topLeft.y + height - 1, state);
+
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordRectangle(topLeft, width, height, state);
+    if (s_pCommandBuffer != nullptr && width > 0 && height > 0)
+        pushRectangle(s_pCommandBuffer, topLeft, width, height, toRenderState(state, 0u), state.isRectXFlip, state.isRectYFlip);
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->drawRectangle(topLeft, width, height, state);
+}
+
+/// @brief Output area filled with color
+void PrimitiveFacade::fillArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color)
+{
+    if (s_pVramWrites != nullptr)
+        s_pVramWrites->markArea(x, y, width, height);
+
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordFill(x, y, width, height, color);
+    if (s_pCommandBuffer != nullptr && width > 0 && height > 0)
+    {
+        const display::software::raster_state_t fillState{}; // untextured, opaque, no mask, drawing area ignored
+        pushRectangle(s_pCommandBuffer, display::software::raster_vertex_t{ x, y, color, 0u, 0u }, width, height, toRenderState(fillState, RENDER_STATE_FILL), false, false);
+    }
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->fillArea(x, y, width, height, color);
+}
+
+/// @brief Output VRAM area copy
+void PrimitiveFacade::copyArea(const int32_t sourceX, const int32_t sourceY, const int32_t destX, const int32_t destY, const int32_t width, const int32_t height)
+{
+    if (s_pVramWrites != nullptr)
+        s_pVramWrites->markArea(destX, destY, width, height);
+
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordCopy(sourceX, sourceY, destX, destY, width, height);
+    if (s_pCommandBuffer != nullptr) // copied by backend between batches: drawing order kept
+        s_pCommandBuffer->pushBarrier();
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->copyArea(sourceX, sourceY, destX, destY, width, height);
+}
+
+/// @brief Output start of CPU to VRAM transfer (native VRAM area about to be written)
+void PrimitiveFacade::beforeVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->beforeVramWrite(x, y, width, height);
+}
+
+/// @brief Output end of CPU to VRAM transfer (native VRAM area written)
+void PrimitiveFacade::onVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    if (s_pVramWrites != nullptr)
+        s_pVramWrites->markArea(x, y, width, height);
+
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordUpload(s_pVramAccess->rend(), x, y, width, height);
+    if (s_pCommandBuffer != nullptr) // transferred by backend between batches: drawing order kept
+        s_pCommandBuffer->pushBarrier();
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->onVramWrite(x, y, width, height);
+}
+
+/// @brief Output texture cache flush
+void PrimitiveFacade::clearTextureCache()
+{
+    if (s_pDisplayList != nullptr)
+        s_pDisplayList->recordTextureCacheClear();
+    if (s_pCommandBuffer != nullptr)
+        s_pCommandBuffer->pushBarrier();
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->clearTextureCache();
+}
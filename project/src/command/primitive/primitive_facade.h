@@ -12,8 +12,13 @@ Description : primitive drawing facade
 #include <cstdint>
 #include <cstddef>
 #include "../frame_buffer_settings.h"
+#include "../display_state.h"
 #include "../memory/video_memory.h"
+#include "../memory/vram_write_tracker.h"
+#include "../../display/software/rasterizer.h"
 #include "primitive_common.h"
+#include "primitive_culling.h"
+#include "vertex_decoder.h"
 #include "line_primitive.h"
 
 #define PRIMITIVE_NUMBER 256  // 0x00 - 0xFF
@@ -24,6 +29,19 @@ Description : primitive drawing facade
 #define PRIMITIVE_LINE_GOURAUD_FIRST_ID  0x50uL // first gouraud-shaded line ID
 
 
+namespace display
+{
+    namespace software
+    {
+        class DualFrameBuffer;
+    }
+}
+namespace command
+{
+    class DisplayList;
+    class CommandBuffer;
+}
+
 /// @namespace command
 /// GPU commands management
 namespace command
@@ -51,15 +69,27 @@ namespace command
             static bool s_isInitialized;                                 ///< References status
             static command::memory::VideoMemory* s_pVramAccess;          ///< VRAM access used by primitives
             static command::FrameBufferSettings* s_pDrawSettingsAccess;  ///< Frame buffer settings used by primitives
+            static command::DisplayState* s_pDisplayStateAccess;         ///< Display state used by primitives (interlaced fields)
+            static command::memory::VramWriteTracker* s_pVramWrites;     ///< VRAM areas modified by primitives
+            static display::software::DualFrameBuffer* s_pSoftwareRenderer; ///< Software renderer (if software rendering mode)
+            static command::DisplayList* s_pDisplayList;                   ///< Display list recording decoded primitives (optional)
+            static command::CommandBuffer* s_pCommandBuffer;               ///< Command buffer grouping decoded primitives in draw batches (hardware rendering)
+            static VertexDecoder s_vertexDecoder; ///< Decoded vertices of current run of geometry primitives
+            static size_t s_decodedVertexIndex;   ///< First decoded vertex of primitive being processed
 
         public:
             /// @brief Initialize primitive facade
             /// @param[in] usedVram          VRAM to use for primitives creation
             /// @param[in] usedDrawSettings  Frame buffer settings to use for primitives creation
-            static void init(memory::VideoMemory& usedVram, FrameBufferSettings& usedDrawSettings) noexcept
+            /// @param[in] usedDisplayState  Display state to use for primitives creation
+            /// @param[in] usedVramWrites    VRAM write tracker to update with drawn areas
+            static void init(memory::VideoMemory& usedVram, FrameBufferSettings& usedDrawSettings, DisplayState& usedDisplayState,
+                             memory::VramWriteTracker& usedVramWrites) noexcept
             {
                 s_pVramAccess = &usedVram;
                 s_pDrawSettingsAccess = &usedDrawSettings;
+                s_pDisplayStateAccess = &usedDisplayState;
+                s_pVramWrites = &usedVramWrites;
                 s_isInitialized = true;
             }
             /// @brief Close primitive facade
@@ -68,16 +98,45 @@ namespace command
                 s_isInitialized = false;
                 s_pVramAccess = nullptr;
                 s_pDrawSettingsAccess = nullptr;
+                s_pDisplayStateAccess = nullptr;
+                s_pVramWrites = nullptr;
+                s_pSoftwareRenderer = nullptr;
+                s_pDisplayList = nullptr;
+                s_pCommandBuffer = nullptr;
+            }
+            /// @brief Set software renderer used by primitives
+            /// @param[in] pRenderer  Software renderer (or nullptr to disable software rendering)
+            static inline void setSoftwareRenderer(display::software::DualFrameBuffer* pRenderer) noexcept
+            {
+                s_pSoftwareRenderer = pRenderer;
+            }
+            /// @brief Set display list used to record decoded primitives
+            /// @param[in] pDisplayList  Display list (or nullptr to stop recording)
+            static inline void setDisplayList(command::DisplayList* pDisplayList) noexcept
+            {
+                s_pDisplayList = pDisplayList;
+            }
+            /// @brief Set command buffer used to batch decoded primitives
+            /// @param[in] pCommandBuffer  Command buffer (or nullptr to disable batching)
+            static inline void setCommandBuffer(command::CommandBuffer* pCommandBuffer) noexcept
+            {
+                s_pCommandBuffer = pCommandBuffer;
             }
 
-            /// @brief Create and process primitive
+            /// @brief Create and process primitive (geometry primitives that can't draw anything are rejected first)
             /// @param[in] commandId  Command identifier
             /// @param[in] pData      Primitive raw data blocks
             static inline void createPrimitive(const command::cmd_block_t commandId, command::cmd_block_t* pData)
             {
-                if (isCommandImplemented(commandId) && s_isInitialized)
-                    c_pPrimitiveIndex[commandId].command(pData);
+                createPrimitives(commandId, pData, 1u);
             }
+            /// @brief Create and process run of primitives with the same command identifier (consecutive packets)
+            /// @details Vertices of geometry primitives are decoded for the whole run (VertexDecoder), then used by early rejection and by primitive processing.
+            ///          Poly-lines are not decoded (variable length: one poly-line per call).
+            /// @param[in] commandId    Command identifier of every packet
+            /// @param[in] pPackets     Consecutive raw primitive packets
+            /// @param[in] packetCount  Number of packets
+            static void createPrimitives(const command::cmd_block_t commandId, command::cmd_block_t* pPackets, size_t packetCount);
 
 
             // -- getters (only for primitives) -- -----------------------------
@@ -96,6 +155,86 @@ namespace command
                 return *s_pDrawSettingsAccess;
             }
 
+            /// @brief Get software renderer
+            /// @returns Software renderer (or nullptr if hardware rendering mode)
+            static inline display::software::DualFrameBuffer* getSoftwareRenderer() noexcept
+            {
+                return s_pSoftwareRenderer;
+            }
+            /// @brief Get display list
+            /// @returns Display list (or nullptr if not recording)
+            static inline command::DisplayList* getDisplayList() noexcept
+            {
+                return s_pDisplayList;
+            }
+            /// @brief Get command buffer
+            /// @returns Command buffer (or nullptr if not batching)
+            static inline command::CommandBuffer* getCommandBuffer() noexcept
+            {
+                return s_pCommandBuffer;
+            }
+            /// @brief Check if primitives are decoded into rendering data (software renderer, display list and/or command buffer)
+            static inline bool isDecodedOutput() noexcept
+            {
+                return (s_pSoftwareRenderer != nullptr || s_pDisplayList != nullptr || s_pCommandBuffer != nullptr);
+            }
+
+
+            // -- software rendering data (only for primitives) -- -------------
+
+            /// @brief Read decoded vertices of primitive being processed (drawing offset applied, flat color copied to every vertex)
+            /// @param[out] pOutVertices  Destination vertices
+            /// @param[in] vertexCount    Number of vertices of primitive type
+            static inline void readDecodedVertices(display::software::raster_vertex_t* pOutVertices, const size_t vertexCount) noexcept
+            {
+                for (size_t i = 0; i < vertexCount; ++i)
+                    s_vertexDecoder.getRasterVertex(s_decodedVertexIndex + i, pOutVertices[i]);
+            }
+            /// @brief Read vertex coordinates of poly-line (not decoded in runs: drawing offset applied)
+            /// @param[in] coord       Raw vertex coordinates
+            /// @param[out] outVertex  Destination vertex
+            static inline void readCoordinates(coord16_t coord, display::software::raster_vertex_t& outVertex) noexcept
+            {
+                outVertex.x = coord.signedX() + s_pDrawSettingsAccess->drawOffsetX();
+                outVertex.y = coord.signedY() + s_pDrawSettingsAccess->drawOffsetY();
+            }
+
+            /// @brief Create rendering state from current frame buffer settings
+            /// @param[in] isTextured         Texture mapping
+            /// @param[in] isShaded           Gouraud shading
+            /// @param[in] isModulated        Texture blending with vertex color
+            /// @param[in] isSemiTransparent  Semi-transparency
+            /// @returns Rendering state (texture page from current draw mode, interlaced field limits)
+            static display::software::raster_state_t createRasterState(const bool isTextured, const bool isShaded, const bool isModulated, const bool isSemiTransparent) noexcept;
+            /// @brief Set polygon texture page and CLUT (texture page also applied to current draw mode)
+            /// @param[in] clutSource     Texture attributes containing CLUT
+            /// @param[in] texpageSource  Texture attributes containing texture page
+            /// @param[out] outState      Rendering state to update
+            static void setPolygonTexture(coord8_tx_t clutSource, coord8_tx_t texpageSource, display::software::raster_state_t& outState) noexcept;
+
+
+            // -- software rendering output (only for primitives) -- -----------
+            // operations recorded in display list (if set), batched in command buffer (if set), then drawn by software renderer (if set) - modified areas tracked
+
+            /// @brief Output triangle
+            static void drawTriangle(const display::software::raster_vertex_t* pVertices, const display::software::raster_state_t& state);
+            /// @brief Output quad (vertex order of quad primitives: 0-1 top, 2-3 bottom)
+            static void drawQuad(const display::software::raster_vertex_t* pVertices, const display::software::raster_state_t& state);
+            /// @brief Output line
+            static void drawLine(const display::software::raster_vertex_t& v0, const display::software::raster_vertex_t& v1, const display::software::raster_state_t& state);
+            /// @brief Output rectangle
+            static void drawRectangle(const display::software::raster_vertex_t& topLeft, const int32_t width, const int32_t height, const display::software::raster_state_t& state);
+            /// @brief Output area filled with color
+            static void fillArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color);
+            /// @brief Output VRAM area copy
+            static void copyArea(const int32_t sourceX, const int32_t sourceY, const int32_t destX, const int32_t destY, const int32_t width, const int32_t height);
+            /// @brief Output texture cache flush
+            static void clearTextureCache();
+            /// @brief Output start of CPU to VRAM transfer (native VRAM area about to be written)
+            static void beforeVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height);
+            /// @brief Output end of CPU to VRAM transfer (native VRAM area written: recorded with its pixels)
+            static void onVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height);
+
 
             // -- command specificities -- -------------------------------------
 
@@ -7,12 +7,46 @@ License :     GPLv2
 Description : rectangle primitive (tile / sprite)
 *******************************************************************************/
 #include "../../globals.h"
+#include "../../display/software/rasterizer.h"
+#include "../../display/software/dual_frame_buffer.h"
 #include "primitive_facade.h"
 #include "rect_primitive.h"
 using namespace command::primitive;
+using display::software::raster_vertex_t;
+using display::software::raster_state_t;
 #pragma pack(push, 4)
 
 
+// -- software rendering helpers -- ------------------------------------
+
+/// @brief Draw tile (software renderer) - top-left position from decoded vertex
+/// @param[in] color   Tile color + primitive flags
+/// @param[in] width   Tile width
+/// @param[in] height  Tile height
+static inline void drawTile(rgb24_t color, const int32_t width, const int32_t height)
+{
+    raster_vertex_t topLeft;
+    PrimitiveFacade::readDecodedVertices(&topLeft, 1u);
+    raster_state_t state = PrimitiveFacade::createRasterState(false, false, false, (color.raw & PRIMITIVE_STP_BIT) != 0uL);
+    PrimitiveFacade::drawRectangle(topLeft, width, height, state);
+}
+
+/// @brief Draw sprite (software renderer) - top-left position and texture coordinates from decoded vertex, texture page from current draw mode
+/// @param[in] color    Sprite color + primitive flags
+/// @param[in] texture  Texture coordinates + CLUT
+/// @param[in] width    Sprite width
+/// @param[in] height   Sprite height
+static inline void drawSprite(rgb24_t color, coord8_tx_t texture, const int32_t width, const int32_t height)
+{
+    raster_vertex_t topLeft;
+    PrimitiveFacade::readDecodedVertices(&topLeft, 1u);
+    raster_state_t state = PrimitiveFacade::createRasterState(true, false, (color.raw & PRIMITIVE_BLEND_BIT) == 0uL, (color.raw & PRIMITIVE_STP_BIT) != 0uL);
+    state.texture.clutX = static_cast<uint32_t>(texture.clutX());
+    state.texture.clutY = static_cast<uint32_t>(texture.clutY());
+    PrimitiveFacade::drawRectangle(topLeft, width, height, state);
+}
+
+
 // -- primitive units - tiles -- ---------------------------------------
 
 /// @brief Fill blank area
@@ -20,6 +54,15 @@ using namespace command::primitive;
 void fill_area_t::process(command::cmd_block_t* pData)
 {
     fill_area_t* pPrim = (fill_area_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        // 16-pixel horizontal units, not affected by drawing area/offset and mask
+        int32_t width = static_cast<int32_t>(((pPrim->range.x() & 0x3FFuL) + 0xFuL) & ~0xFuL);
+        int32_t height = static_cast<int32_t>(pPrim->range.y() & 0x1FFuL);
+        PrimitiveFacade::fillArea(static_cast<int32_t>(pPrim->pos.x() & 0x3F0uL), static_cast<int32_t>(pPrim->pos.y() & 0x1FFuL),
+                                  width, height, static_cast<uint32_t>(pPrim->color.rgb24()));
+        return;
+    }
 
     //...
 }
@@ -29,6 +72,11 @@ void fill_area_t::process(command::cmd_block_t* pData)
 void tile_f_t::process(command::cmd_block_t* pData)
 {
     tile_f_t* pPrim = (tile_f_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawTile(pPrim->color, static_cast<int32_t>(pPrim->coord.size.x() & 0x3FFuL), static_cast<int32_t>(pPrim->coord.size.y() & 0x1FFuL));
+        return;
+    }
 
     //...
 }
@@ -38,6 +86,11 @@ void tile_f_t::process(command::cmd_block_t* pData)
 void tile_f1_t::process(command::cmd_block_t* pData)
 {
     tile_f1_t* pPrim = (tile_f1_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawTile(pPrim->color, 1, 1);
+        return;
+    }
 
     //...
 }
@@ -47,6 +100,11 @@ void tile_f1_t::process(command::cmd_block_t* pData)
 void tile_f8_t::process(command::cmd_block_t* pData)
 {
     tile_f8_t* pPrim = (tile_f8_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawTile(pPrim->color, 8, 8);
+        return;
+    }
 
     //...
 }
@@ -56,6 +114,11 @@ void tile_f8_t::process(command::cmd_block_t* pData)
 void tile_f16_t::process(command::cmd_block_t* pData)
 {
     tile_f16_t* pPrim = (tile_f16_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawTile(pPrim->color, 16, 16);
+        return;
+    }
 
     //...
 }
@@ -68,6 +131,11 @@ void tile_f16_t::process(command::cmd_block_t* pData)
 void sprite_f_t::process(command::cmd_block_t* pData)
 {
     sprite_f_t* pPrim = (sprite_f_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawSprite(pPrim->color, pPrim->texture, static_cast<int32_t>(pPrim->range.x() & 0x3FFuL), static_cast<int32_t>(pPrim->range.y() & 0x1FFuL));
+        return;
+    }
 
     //...
 }
@@ -77,6 +145,11 @@ void sprite_f_t::process(command::cmd_block_t* pData)
 void sprite_f1_t::process(command::cmd_block_t* pData)
 {
     sprite_f1_t* pPrim = (sprite_f1_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawSprite(pPrim->color, pPrim->texture, 1, 1);
+        return;
+    }
 
     //...
 }
@@ -86,6 +159,11 @@ void sprite_f1_t::process(command::cmd_block_t* pData)
 void sprite_f8_t::process(command::cmd_block_t* pData)
 {
     sprite_f8_t* pPrim = (sprite_f8_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawSprite(pPrim->color, pPrim->texture, 8, 8);
+        return;
+    }
 
     //...
 }
@@ -95,6 +173,11 @@ void sprite_f8_t::process(command::cmd_block_t* pData)
 void sprite_f16_t::process(command::cmd_block_t* pData)
 {
     sprite_f16_t* pPrim = (sprite_f16_t*)pData;
+    if (PrimitiveFacade::isDecodedOutput())
+    {
+        drawSprite(pPrim->color, pPrim->texture, 16, 16);
+        return;
+    }
 
     //...
 }
@@ -0,0 +1,158 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : batched vertex decoder - raw packets to structure-of-arrays vertex data
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "primitive_common.h"
+#include "vertex_decoder.h"
+using namespace command::primitive;
+
+// command identifier flags (geometry primitives)
+#define COMMAND_TYPE_MASK      0xE0uL // primitive type bits
+#define COMMAND_TYPE_POLYGON   0x20uL // polygon type
+#define COMMAND_TYPE_LINE      0x40uL // line type
+#define COMMAND_TYPE_RECTANGLE 0x60uL // rectangle type
+#define COMMAND_SHADED_BIT     0x10uL // gouraud shading (polygon/line)
+#define COMMAND_QUAD_BIT       0x08uL // quad (polygon)
+#define COMMAND_POLYLINE_BIT   0x08uL // poly-line (line)
+#define COMMAND_TEXTURED_BIT   0x04uL // texture mapping (polygon/rectangle)
+#define COMMAND_RECT_SIZE_MASK 0x18uL // rectangle size (00 = custom size block)
+
+
+/// @brief Get layout of vertex data for a primitive type
+/// @param[in] commandId   Command identifier (polygon, line or rectangle - poly-lines not supported: variable length)
+/// @param[out] outLayout  Packet layout
+/// @returns Supported primitive type
+bool VertexDecoder::getPacketLayout(const command::cmd_block_t commandId, packet_layout_t& outLayout) noexcept
+{
+    // vertex blocks: [color] coordinates [texture] -> first vertex color is always the command block
+    switch (commandId & COMMAND_TYPE_MASK)
+    {
+        case COMMAND_TYPE_POLYGON:
+            outLayout.isShaded = ((commandId & COMMAND_SHADED_BIT) != 0uL);
+            outLayout.isTextured = ((commandId & COMMAND_TEXTURED_BIT) != 0uL);
+            outLayout.vertexCount = ((commandId & COMMAND_QUAD_BIT) != 0uL) ? 4u : 3u;
+            break;
+        case COMMAND_TYPE_LINE:
+            if ((commandId & COMMAND_POLYLINE_BIT) != 0uL)
+                return false;
+            outLayout.isShaded = ((commandId & COMMAND_SHADED_BIT) != 0uL);
+            outLayout.isTextured = false;
+            outLayout.vertexCount = 2u;
+            break;
+        case COMMAND_TYPE_RECTANGLE:
+            outLayout.isShaded = false;
+            outLayout.isTextured = ((commandId & COMMAND_TEXTURED_BIT) != 0uL);
+            outLayout.vertexCount = 1u;
+            outLayout.vertexStride = (outLayout.isTextured) ? 2u : 1u;
+            outLayout.packetSize = 1u + outLayout.vertexStride + (((commandId & COMMAND_RECT_SIZE_MASK) == 0uL) ? 1u : 0u);
+            return true;
+        default: return false;
+    }
+    outLayout.vertexStride = 1u + ((outLayout.isShaded) ? 1u : 0u) + ((outLayout.isTextured) ? 1u : 0u);
+    outLayout.packetSize = outLayout.vertexCount * outLayout.vertexStride + ((outLayout.isShaded) ? 0u : 1u);
+    return true;
+}
+
+
+// -- decoding -- --------------------------------------------------------------
+
+/// @brief Decode batch of packets of the same primitive type (previous content replaced)
+/// @param[in] commandId    Command identifier of every packet
+/// @param[in] pPackets     Consecutive raw packets
+/// @param[in] packetCount  Number of packets
+/// @param[in] offsetX      Drawing offset X
+/// @param[in] offsetY      Drawing offset Y
+/// @returns Number of decoded packets (limited by capacity, 0 if type not supported)
+size_t VertexDecoder::decode(const command::cmd_block_t commandId, const command::cmd_block_t* pPackets, const size_t packetCount,
+                             const int32_t offsetX, const int32_t offsetY) noexcept
+{
+    m_vertexCount = m_packetCount = 0u;
+    if (pPackets == nullptr || getPacketLayout(commandId, m_layout) == false)
+        return 0u;
+
+    const size_t maxPacketCount = VERTEX_DECODER_CAPACITY / m_layout.vertexCount;
+    m_packetCount = (packetCount < maxPacketCount) ? packetCount : maxPacketCount;
+    m_vertexCount = m_packetCount * m_layout.vertexCount;
+    gatherRawBlocks(pPackets);
+    unpackRawBlocks(offsetX, offsetY);
+    return m_packetCount;
+}
+
+/// @brief Copy raw vertex blocks (strided) into contiguous arrays
+void VertexDecoder::gatherRawBlocks(const command::cmd_block_t* pPackets) noexcept
+{
+    // layout known at compile time -> unrolled copy, no per-vertex branch
+    switch (m_layout.vertexCount)
+    {
+        case 1u: // rectangles
+            if (m_layout.isTextured) gatherPackets<1u, 2u, false, true>(pPackets);
+            else                     gatherPackets<1u, 1u, false, false>(pPackets);
+            break;
+        case 2u: // lines
+            if (m_layout.isShaded) gatherPackets<2u, 2u, true, false>(pPackets);
+            else                   gatherPackets<2u, 1u, false, false>(pPackets);
+            break;
+        case 3u: // triangles
+            if (m_layout.isShaded) { if (m_layout.isTextured) gatherPackets<3u, 3u, true, true>(pPackets);  else gatherPackets<3u, 2u, true, false>(pPackets); }
+            else                   { if (m_layout.isTextured) gatherPackets<3u, 2u, false, true>(pPackets); else gatherPackets<3u, 1u, false, false>(pPackets); }
+            break;
+        default: // quads
+            if (m_layout.isShaded) { if (m_layout.isTextured) gatherPackets<4u, 3u, true, true>(pPackets);  else gatherPackets<4u, 2u, true, false>(pPackets); }
+            else                   { if (m_layout.isTextured) gatherPackets<4u, 2u, false, true>(pPackets); else gatherPackets<4u, 1u, false, false>(pPackets); }
+            break;
+    }
+
+    // pad last group of 4 (vectorized unpacking)
+    for (size_t out = m_vertexCount; (out & 0x3u) != 0u; ++out)
+        m_rawCoords[out] = m_rawColors[out] = m_rawTextures[out] = 0u;
+}
+
+/// @brief Convert contiguous raw blocks into vertex data
+void VertexDecoder::unpackRawBlocks(const int32_t offsetX, const int32_t offsetY) noexcept
+{
+    #if _SIMD_SSE2
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i drawOffsetX = _mm_set1_epi32(offsetX);
+    const __m128i drawOffsetY = _mm_set1_epi32(offsetY);
+    for (size_t i = 0; i < m_vertexCount; i += 4u)
+    {
+        // coordinates: 11-bit signed values (YyyyXxxx)
+        __m128i raw = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_rawCoords[i]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_x[i]), _mm_add_epi32(_mm_srai_epi32(_mm_slli_epi32(raw, 21), 21), drawOffsetX));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_y[i]), _mm_add_epi32(_mm_srai_epi32(_mm_slli_epi32(raw, 5), 21), drawOffsetY));
+
+        // color components (00BbGgRr)
+        raw = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_rawColors[i]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_r[i]), _mm_and_si128(raw, byteMask));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_g[i]), _mm_and_si128(_mm_srli_epi32(raw, 8), byteMask));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_b[i]), _mm_and_si128(_mm_srli_epi32(raw, 16), byteMask));
+
+        // texture coordinates (MiscYyXx)
+        raw = _mm_load_si128(reinterpret_cast<const __m128i*>(&m_rawTextures[i]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_u[i]), _mm_and_si128(raw, byteMask));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_v[i]), _mm_and_si128(_mm_srli_epi32(raw, 8), byteMask));
+    }
+
+    #else
+    for (size_t i = 0; i < m_vertexCount; ++i)
+    {
+        m_x[i] = (static_cast<int32_t>(m_rawCoords[i] << 21) >> 21) + offsetX;
+        m_y[i] = (static_cast<int32_t>(m_rawCoords[i] << 5) >> 21) + offsetY;
+        m_r[i] = static_cast<int32_t>(m_rawColors[i] & 0xFFu);
+        m_g[i] = static_cast<int32_t>((m_rawColors[i] >> 8) & 0xFFu);
+        m_b[i] = static_cast<int32_t>((m_rawColors[i] >> 16) & 0xFFu);
+        m_u[i] = static_cast<int32_t>(m_rawTextures[i] & 0xFFu);
+        m_v[i] = static_cast<int32_t>((m_rawTextures[i] >> 8) & 0xFFu);
+    }
+    #endif
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : batched vertex decoder - raw packets to structure-of-arrays vertex data
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "../../display/software/rasterizer.h"
+#include "primitive_common.h"
+
+#define VERTEX_DECODER_CAPACITY 256u // max number of vertices per decoded batch (multiple of 4)
+
+/// @namespace command
+/// GPU commands management
+namespace command
+{
+    /// @namespace command.primitive
+    /// Drawing primitive management
+    namespace primitive
+    {
+        /// @struct packet_layout_t
+        /// @brief Position of vertex data in raw primitive packets
+        struct packet_layout_t
+        {
+            uint32_t packetSize;   ///< Packet length (32-bit blocks)
+            uint32_t vertexCount;  ///< Number of vertices per packet
+            uint32_t vertexStride; ///< Distance between two vertices (32-bit blocks)
+            bool isShaded;         ///< Color per vertex (otherwise: color of first block for every vertex)
+            bool isTextured;       ///< Texture coordinates after each vertex position
+        };
+
+
+        /// @class VertexDecoder
+        /// @brief Batched vertex decoder - decodes N packets of the same primitive type in one pass
+        /// @details Output is stored as structure-of-arrays: sign-extended 11-bit X/Y (drawing offset applied), color components, UV.
+        ///          Flat-shaded colors are replicated for each vertex, untextured UV are set to 0: setup of a batch is branch-free.
+        ///          Large object: meant to be stored in static/heap memory (not on the stack).
+        class VertexDecoder
+        {
+        public:
+            /// @brief Create empty decoder
+            VertexDecoder() noexcept : m_vertexCount(0u), m_packetCount(0u), m_layout{ 0u, 0u, 0u, false, false } {}
+            // no copy allowed
+            VertexDecoder(const VertexDecoder& other) = delete;
+            VertexDecoder& operator=(const VertexDecoder& other) = delete;
+
+            /// @brief Get layout of vertex data for a primitive type
+            /// @param[in] commandId   Command identifier (polygon, line or rectangle - poly-lines not supported: variable length)
+            /// @param[out] outLayout  Packet layout
+            /// @returns Supported primitive type
+            static bool getPacketLayout(const command::cmd_block_t commandId, packet_layout_t& outLayout) noexcept;
+
+            /// @brief Decode batch of packets of the same primitive type (previous content replaced)
+            /// @param[in] commandId    Command identifier of every packet
+            /// @param[in] pPackets     Consecutive raw packets
+            /// @param[in] packetCount  Number of packets
+            /// @param[in] offsetX      Drawing offset X
+            /// @param[in] offsetY      Drawing offset Y
+            /// @returns Number of decoded packets (limited by capacity, 0 if type not supported)
+            size_t decode(const command::cmd_block_t commandId, const command::cmd_block_t* pPackets, const size_t packetCount,
+                          const int32_t offsetX, const int32_t offsetY) noexcept;
+
+
+            // -- decoded data -- ----------------------------------------------
+
+            /// @brief Get number of decoded vertices
+            inline size_t size() const noexcept { return m_vertexCount; }
+            /// @brief Get number of decoded packets
+            inline size_t packetCount() const noexcept { return m_packetCount; }
+            /// @brief Get layout of decoded packets
+            inline const packet_layout_t& layout() const noexcept { return m_layout; }
+
+            inline const int32_t* x() const noexcept { return m_x; } ///< X coordinates (native VRAM units)
+            inline const int32_t* y() const noexcept { return m_y; } ///< Y coordinates (native VRAM units)
+            inline const int32_t* r() const noexcept { return m_r; } ///< Red components (0 - 255)
+            inline const int32_t* g() const noexcept { return m_g; } ///< Green components (0 - 255)
+            inline const int32_t* b() const noexcept { return m_b; } ///< Blue components (0 - 255)
+            inline const int32_t* u() const noexcept { return m_u; } ///< Texture U coordinates (0 - 255)
+            inline const int32_t* v() const noexcept { return m_v; } ///< Texture V coordinates (0 - 255)
+
+            /// @brief Copy decoded vertex for software renderer
+            /// @param[in] index       Vertex index
+            /// @param[out] outVertex  Destination vertex
+            inline void getRasterVertex(const size_t index, display::software::raster_vertex_t& outVertex) const noexcept
+            {
+                outVertex.x = m_x[index];
+                outVertex.y = m_y[index];
+                outVertex.color = static_cast<uint32_t>(m_r[index] | (m_g[index] << 8) | (m_b[index] << 16));
+                outVertex.u = static_cast<uint32_t>(m_u[index]);
+                outVertex.v = static_cast<uint32_t>(m_v[index]);
+            }
+
+
+        private:
+            /// @brief Copy raw vertex blocks (strided) into contiguous arrays
+            void gatherRawBlocks(const command::cmd_block_t* pPackets) noexcept;
+            /// @brief Copy raw vertex blocks of packets with a specific layout
+            template <uint32_t _VertexCount, uint32_t _Stride, bool _IsShaded, bool _IsTextured>
+            inline void gatherPackets(const command::cmd_block_t* pPackets) noexcept
+            {
+                // vertex blocks: [color] coordinates [texture] -> first vertex color is always the command block
+                const size_t packetSize = m_layout.packetSize; // not constant for rectangles (optional size block)
+                uint32_t* pCoords = m_rawCoords;
+                uint32_t* pColors = m_rawColors;
+                uint32_t* pTextures = m_rawTextures;
+                for (size_t packet = 0; packet < m_packetCount; ++packet, pPackets += packetSize)
+                {
+                    for (uint32_t i = 0; i < _VertexCount; ++i)
+                    {
+                        *pCoords++ = static_cast<uint32_t>(pPackets[1u + i * _Stride]);
+                        *pColors++ = static_cast<uint32_t>(pPackets[(_IsShaded) ? i * _Stride : 0u]);
+                        *pTextures++ = (_IsTextured) ? static_cast<uint32_t>(pPackets[2u + i * _Stride]) : 0u;
+                    }
+                }
+            }
+            /// @brief Convert contiguous raw blocks into vertex data
+            void unpackRawBlocks(const int32_t offsetX, const int32_t offsetY) noexcept;
+
+        private:
+            // raw blocks (contiguous)
+            alignas(16) uint32_t m_rawCoords[VERTEX_DECODER_CAPACITY];
+            alignas(16) uint32_t m_rawColors[VERTEX_DECODER_CAPACITY];
+            alignas(16) uint32_t m_rawTextures[VERTEX_DECODER_CAPACITY];
+            // decoded vertices (structure-of-arrays)
+            alignas(16) int32_t m_x[VERTEX_DECODER_CAPACITY];
+            alignas(16) int32_t m_y[VERTEX_DECODER_CAPACITY];
+            alignas(16) int32_t m_r[VERTEX_DECODER_CAPACITY];
+            alignas(16) int32_t m_g[VERTEX_DECODER_CAPACITY];
+            alignas(16) int32_t m_b[VERTEX_DECODER_CAPACITY];
+            alignas(16) int32_t m_u[VERTEX_DECODER_CAPACITY];
+            alignas(16) int32_t m_v[VERTEX_DECODER_CAPACITY];
+
+            size_t m_vertexCount;     ///< Number of decoded vertices
+            size_t m_packetCount;     ///< Number of decoded packets
+            packet_layout_t m_layout; ///< Layout of decoded packets
+        };
+    }
+}
@@ -35,6 +35,7 @@ config_events_t Config::events;   ///< Events handling settings
 
 uint32_t Config::configFixBits = 0u;  ///< Configured fixes
 uint32_t Config::runtimeFixBits = 0u; ///< Fixes set by emulator
+std::string Config::gameId;           ///< Game executable ID set by emulator (empty if unknown)
 
 
 /// @brief Create config container (default values + default profile)
@@ -123,6 +124,9 @@ void Config::reset(const bool isKeyBindingReset) noexcept
     Config::display.windowRes = { 800, 600 };
     Config::display.colorDepth = display::window_color_mode_t::rgb_32bit;
     Config::display.subprecisionMode = subprecision_settings_t::disabled;
+    Config::display.renderingMode = rendering_mode_t::hardware;
+    Config::display.isHeadless = false;
+    Config::display.frameDump = frame_dump_format_t::disabled;
 
     Config::timer.timeMode = events::timemode_t::highResCounter;
     Config::timer.frameLimitMode = framelimit_settings_t::limit;
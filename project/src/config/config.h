@@ -53,6 +53,7 @@ namespace config
 
         static uint32_t configFixBits;   ///< Configured fixes
         static uint32_t runtimeFixBits;  ///< Fixes set by emulator
+        static std::string gameId;       ///< Game executable ID set by emulator (empty if unknown)
 
 
     public:
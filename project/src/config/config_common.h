@@ -43,6 +43,25 @@ namespace config
     };
     #define SUBPRECISION_SETTINGS_LENGTH 3
 
+    /// @enum rendering_mode_t
+    /// @brief Rendering modes
+    enum class rendering_mode_t : uint32_t
+    {
+        hardware = 0u, ///< Graphics API rendering
+        software = 1u  ///< CPU rendering (native VRAM + upscaled buffer)
+    };
+    #define RENDERING_MODE_LENGTH 2
+
+    /// @enum frame_dump_format_t
+    /// @brief Frame dump formats (every presented frame streamed to a file)
+    enum class frame_dump_format_t : uint32_t
+    {
+        disabled = 0u, ///< No frame dump
+        rawRgb = 1u,   ///< Raw RGB888 frames (no header, size in file name)
+        y4m = 2u       ///< YUV4MPEG2 stream (4:2:0)
+    };
+    #define FRAME_DUMP_FORMAT_LENGTH 3
+
     
     // -- data types - profile settings -- -------------------------------------
 
@@ -177,6 +196,9 @@ namespace config
         display::coord_t              windowRes;        ///< Window display resolution (X, Y)
         display::window_color_mode_t  colorDepth;       ///< Color depth (16-bit / 32-bit)
         subprecision_settings_t       subprecisionMode; ///< Geometry subprecision mode (integer / standard / enhanced)
+        rendering_mode_t              renderingMode;    ///< Rendering mode (hardware / software)
+        bool                          isHeadless;       ///< Headless output: no window, frames converted in memory (on/off)
+        frame_dump_format_t           frameDump;        ///< Frame dump of every presented frame (disabled / raw RGB / Y4M)
     };
     
     /// @struct config_timer_t
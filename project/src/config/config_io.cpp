@@ -70,6 +70,9 @@ void ConfigIO::loadConfig(std::vector<std::wstring>* pOutProfileNames)
         reader.read(L"WinResY", Config::display.windowRes.y);
         reader.read(L"Color", Config::display.colorDepth, display::window_color_mode_t::rgb_32bit);
         reader.read(L"GteAcc", Config::display.subprecisionMode, SUBPRECISION_SETTINGS_LENGTH, config::subprecision_settings_t::disabled);
+        reader.read(L"Renderer", Config::display.renderingMode, RENDERING_MODE_LENGTH, config::rendering_mode_t::hardware);
+        reader.read(L"Headless", Config::display.isHeadless);
+        reader.read(L"FrameDump", Config::display.frameDump, FRAME_DUMP_FORMAT_LENGTH, config::frame_dump_format_t::disabled);
 
         reader.read(L"TimeMode", Config::timer.timeMode, TIMEMODE_LENGTH, events::timemode_t::highResCounter);
         reader.read(L"FrameLimit", Config::timer.frameLimitMode, FRAMELIMIT_SETTINGS_LENGTH, config::framelimit_settings_t::limit);
@@ -131,6 +134,9 @@ void ConfigIO::saveConfig(const bool hasProfiles, const bool isSavingAllProfiles
     writer.writeInt(L"WinResY", Config::display.windowRes.y);
     writer.writeBoolType(L"Color", Config::display.colorDepth, display::window_color_mode_t::rgb_16bit);
     writer.writeIntType(L"Subprec", Config::display.subprecisionMode);
+    writer.writeIntType(L"Renderer", Config::display.renderingMode);
+    writer.writeBool(L"Headless", Config::display.isHeadless);
+    writer.writeIntType(L"FrameDump", Config::display.frameDump);
 
     writer.writeIntType(L"TimeMode", Config::timer.timeMode);
     writer.writeIntType(L"FrameLimit", Config::timer.frameLimitMode);
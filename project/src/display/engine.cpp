@@ -19,6 +19,10 @@ using namespace std::literals::string_literals;
 #include "../config/config.h"
 #include "utils/display_window.h"
 #include "shader.h"
+#include "software/dual_frame_buffer.h"
+#include "output/i_output_backend.h"
+#include "../command/display_state.h"
+#include "../command/memory/vram_write_tracker.h"
 #include "engine.h"
 using namespace display;
 
@@ -26,9 +30,21 @@ using namespace display;
 // engine status
 bool Engine::s_isInitialized = false; ///< Rendering engine initialization status
 GLuint Engine::s_programId = 0;       ///< Rendering pipeline program identifier
+software::DualFrameBuffer* Engine::s_pSoftwareRenderer = nullptr; ///< Software renderer (if software rendering mode)
+output::IOutputBackend* Engine::s_pOutputBackend = nullptr;       ///< Output backend replacing display window (if set)
+
+// presented display area
+bool Engine::s_hasPresentedFrame = false;   ///< A frame has already been presented with current output
+uint32_t Engine::s_presentedX = 0u;         ///< Last presented display area - left position
+uint32_t Engine::s_presentedY = 0u;         ///< Last presented display area - top position
+uint32_t Engine::s_presentedWidth = 0u;     ///< Last presented display area - width
+uint32_t Engine::s_presentedHeight = 0u;    ///< Last presented display area - height
+bool Engine::s_isPresentedRgb24 = false;    ///< Last presented display area - 24-bit color mode
+bool Engine::s_isPresentedEnabled = false;  ///< Last presented display area - display enabled
+uint64_t Engine::s_skippedFrameCount = 0uLL; ///< Number of unchanged frames (conversion/upload skipped)
 
 // window management
-utils::DisplayWindow* Engine::s_pWindowManager = nullptr; ///< Main window
+display::utils::DisplayWindow* Engine::s_pWindowManager = nullptr; ///< Main window
 device_handle_t Engine::s_windowDeviceContext = 0;        ///< Window device context
 #ifdef _WINDOWS
 HGLRC Engine::s_openGlRenderContext; ///< API rendering context
@@ -43,10 +59,10 @@ GLFWwindow* Engine::s_openGlRenderContext = nullptr; ///< API window context
 void Engine::createDisplayWindow(window_handle_t window)
 {
     // create display window
-    utils::DisplayWindow* pWindowManager = nullptr;
+    display::utils::DisplayWindow* pWindowManager = nullptr;
     try
     {
-        pWindowManager = new utils::DisplayWindow(window);
+        pWindowManager = new display::utils::DisplayWindow(window);
         pWindowManager->show(config::Config::display.windowRes.x, config::Config::display.windowRes.y,
             static_cast<int32_t>(config::Config::display.windowMode));
         if (config::Config::display.windowMode == display::utils::window_mode_t::fullscreen)
@@ -63,7 +79,7 @@ void Engine::createDisplayWindow(window_handle_t window)
 
     // disable screen-saver
     if (config::Config::events.isNoScreenSaver)
-        utils::DisplayWindow::setScreenSaver(false);
+        display::utils::DisplayWindow::setScreenSaver(false);
 
     s_pWindowManager = pWindowManager; // unlock render()
 }
@@ -71,7 +87,7 @@ void Engine::createDisplayWindow(window_handle_t window)
 /// @brief Close display window and restore menu
 void Engine::closeDisplayWindow()
 {
-    utils::DisplayWindow* pWindowManager = s_pWindowManager;
+    display::utils::DisplayWindow* pWindowManager = s_pWindowManager;
     s_pWindowManager = nullptr; // lock render()
 
     // close API and window
@@ -81,22 +97,94 @@ void Engine::closeDisplayWindow()
 
     // re-enable screensaver (if disabled)
     if (config::Config::events.isNoScreenSaver)
-        utils::DisplayWindow::setScreenSaver(true);
+        display::utils::DisplayWindow::setScreenSaver(true);
 }
 
 /// @brief Render current frame
-void Engine::render()
+/// @param[in] pVram         Native VRAM image
+/// @param[in] displayState  Display state (display area, color mode)
+void Engine::render(const uint16_t* pVram, const command::DisplayState& displayState, const command::memory::VramWriteTracker& vramWrites)
 {
+    // software mode: complete high resolution frame
+    if (s_pSoftwareRenderer != nullptr)
+        s_pSoftwareRenderer->endFrame();
+
+    // output backend (no display window)
+    if (s_pOutputBackend != nullptr)
+    {
+        if (updatePresentedArea(displayState, vramWrites))
+        {
+            // software mode: upscaled image (flushed by endFrame) -- 24-bit display (MDEC) only exists in native VRAM
+            if (s_pSoftwareRenderer != nullptr && command::DisplayState::isRgb24() == false)
+                s_pOutputBackend->presentHighRes(s_pSoftwareRenderer->getHighResBuffer(), s_pSoftwareRenderer->getScaleX(),
+                                                 s_pSoftwareRenderer->getScaleY(), displayState);
+            else
+                s_pOutputBackend->present(pVram, displayState);
+        }
+        else // unchanged display area -> previous output presented again
+        {
+            s_pOutputBackend->presentCached();
+            ++s_skippedFrameCount;
+        }
+        return;
+    }
+
     if (s_isInitialized == false)
     {
         if (s_pWindowManager != nullptr)
             initGL();
         return;
     }
+    if (updatePresentedArea(displayState, vramWrites) == false)
+        ++s_skippedFrameCount; // unchanged display area -> no conversion/upload, previous texture presented again
     //...
 }
 
 
+// -- output backend -- --------------------------------------------------------
+
+/// @brief Set output backend used instead of display window (ownership transferred, previous backend destroyed)
+/// @param[in] pBackend  Output backend (or nullptr to use display window)
+void Engine::setOutputBackend(output::IOutputBackend* pBackend)
+{
+    output::IOutputBackend* pPreviousBackend = s_pOutputBackend;
+    s_pOutputBackend = pBackend;
+    s_hasPresentedFrame = false; // no cached frame in new output
+    if (pPreviousBackend != nullptr)
+        delete pPreviousBackend;
+}
+
+
+// -- software rendering -- ----------------------------------------------------
+
+/// @brief Create software renderer (native VRAM + upscaled buffer)
+/// @param[in] pVram   Native VRAM image
+/// @param[in] scaleX  Horizontal internal resolution factor
+/// @param[in] scaleY  Vertical internal resolution factor
+/// @returns Software renderer
+/// @throws invalid_argument  Invalid VRAM or factors
+software::DualFrameBuffer* Engine::initSoftwareRenderer(uint16_t* pVram, const uint32_t scaleX, const uint32_t scaleY)
+{
+    closeSoftwareRenderer();
+    s_pSoftwareRenderer = new software::DualFrameBuffer(pVram, scaleX, scaleY);
+    #if _FIELD_VALIDATION == 1
+    s_pSoftwareRenderer->setFieldValidation(true);
+    #endif
+    return s_pSoftwareRenderer;
+}
+
+/// @brief Destroy software renderer
+void Engine::closeSoftwareRenderer()
+{
+    if (s_pSoftwareRenderer != nullptr)
+    {
+        software::DualFrameBuffer* pRenderer = s_pSoftwareRenderer;
+        s_pSoftwareRenderer = nullptr;
+        delete pRenderer;
+    }
+}
+
+
 // -- rendering API management -- --------------------------------------
 
 /// @brief Initialize rendering API
@@ -118,6 +206,7 @@ void Engine::closeGL()
     if (s_isInitialized == false)
         return;
     s_isInitialized = false;
+    s_hasPresentedFrame = false; // display texture destroyed
 
     //...
 }
@@ -127,3 +216,37 @@ void Engine::loadPipeline()
 {
 
 }
+
+
+// -- frame skipping -- --------------------------------------------------------
+
+/// @brief Check if display area content/position/mode has changed since last presented frame (and store new area)
+/// @param[in] displayState  Display state (display area, color mode)
+/// @param[in] vramWrites    VRAM areas modified since last frame
+/// @returns Modified status (always true if no frame was presented yet)
+bool Engine::updatePresentedArea(const command::DisplayState& displayState, const command::memory::VramWriteTracker& vramWrites) noexcept
+{
+    const uint32_t x = displayState.displayX();
+    const uint32_t y = displayState.displayY();
+    const uint32_t width = displayState.displayWidth();
+    const uint32_t height = displayState.displayHeight();
+    const bool isRgb24 = command::DisplayState::isRgb24();
+    const bool isEnabled = command::DisplayState::isDisplayEnabled();
+
+    bool isModified = (s_hasPresentedFrame == false || x != s_presentedX || y != s_presentedY || width != s_presentedWidth
+                    || height != s_presentedHeight || isRgb24 != s_isPresentedRgb24 || isEnabled != s_isPresentedEnabled);
+    if (isModified == false && isEnabled)
+    {
+        const uint32_t vramWidth = (isRgb24) ? (width * 3u + 1u) >> 1 : width; // 24-bit pixels: 1.5 VRAM pixel each
+        isModified = vramWrites.isAreaModified(x, y, vramWidth, height);
+    }
+
+    s_hasPresentedFrame = true;
+    s_presentedX = x;
+    s_presentedY = y;
+    s_presentedWidth = width;
+    s_presentedHeight = height;
+    s_isPresentedRgb24 = isRgb24;
+    s_isPresentedEnabled = isEnabled;
+    return isModified;
+}
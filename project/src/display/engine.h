@@ -8,8 +8,13 @@ Description : rendering engine - graphics API management
 *******************************************************************************/
 #pragma once
 
+#include <cstdint>
 #include "../vendor/opengl.h" // openGL includes
 #include "utils/display_window.h"
+#include "software/dual_frame_buffer.h"
+#include "output/i_output_backend.h"
+#include "../command/display_state.h"
+#include "../command/memory/vram_write_tracker.h"
 
 /// @namespace display
 /// Display management
@@ -23,6 +28,18 @@ namespace display
         // engine status
         static bool s_isInitialized; ///< Rendering engine initialization status
         static GLuint s_programId;   ///< Rendering pipeline program identifier
+        static software::DualFrameBuffer* s_pSoftwareRenderer; ///< Software renderer (if software rendering mode)
+        static output::IOutputBackend* s_pOutputBackend;       ///< Output backend replacing display window (if set)
+
+        // presented display area (to detect unchanged frames)
+        static bool s_hasPresentedFrame;      ///< A frame has already been presented with current output
+        static uint32_t s_presentedX;         ///< Last presented display area - left position
+        static uint32_t s_presentedY;         ///< Last presented display area - top position
+        static uint32_t s_presentedWidth;     ///< Last presented display area - width
+        static uint32_t s_presentedHeight;    ///< Last presented display area - height
+        static bool s_isPresentedRgb24;       ///< Last presented display area - 24-bit color mode
+        static bool s_isPresentedEnabled;     ///< Last presented display area - display enabled
+        static uint64_t s_skippedFrameCount;  ///< Number of unchanged frames (conversion/upload skipped)
 
         // window management
         static utils::DisplayWindow* s_pWindowManager; ///< Main window
@@ -43,8 +60,59 @@ namespace display
         /// @brief Close display window and restore menu
         static void closeDisplayWindow();
 
-        /// @brief Render current frame
-        static void render();
+        /// @brief Render current frame (conversion/upload skipped if display area hasn't changed since last frame)
+        /// @param[in] pVram         Native VRAM image
+        /// @param[in] displayState  Display state (display area, color mode)
+        /// @param[in] vramWrites    VRAM areas modified since last frame
+        static void render(const uint16_t* pVram, const command::DisplayState& displayState, const command::memory::VramWriteTracker& vramWrites);
+
+        /// @brief Get number of unchanged frames (previous output presented again)
+        /// @returns Skipped frame counter
+        static inline uint64_t getSkippedFrameCount() noexcept
+        {
+            return s_skippedFrameCount;
+        }
+
+
+        // -- output backend -- ------------------------------------------------
+
+        /// @brief Set output backend used instead of display window (ownership transferred, previous backend destroyed)
+        /// @param[in] pBackend  Output backend (or nullptr to use display window)
+        static void setOutputBackend(output::IOutputBackend* pBackend);
+
+        /// @brief Destroy output backend
+        static inline void closeOutputBackend()
+        {
+            setOutputBackend(nullptr);
+        }
+
+        /// @brief Get output backend
+        /// @returns Output backend (or nullptr if display window is used)
+        static inline output::IOutputBackend* getOutputBackend() noexcept
+        {
+            return s_pOutputBackend;
+        }
+
+
+        // -- software rendering -- --------------------------------------------
+
+        /// @brief Create software renderer (native VRAM + upscaled buffer)
+        /// @param[in] pVram   Native VRAM image
+        /// @param[in] scaleX  Horizontal internal resolution factor
+        /// @param[in] scaleY  Vertical internal resolution factor
+        /// @returns Software renderer
+        /// @throws invalid_argument  Invalid VRAM or factors
+        static software::DualFrameBuffer* initSoftwareRenderer(uint16_t* pVram, const uint32_t scaleX, const uint32_t scaleY);
+
+        /// @brief Destroy software renderer
+        static void closeSoftwareRenderer();
+
+        /// @brief Get software renderer
+        /// @returns Software renderer (or nullptr if hardware rendering mode)
+        static inline software::DualFrameBuffer* getSoftwareRenderer() noexcept
+        {
+            return s_pSoftwareRenderer;
+        }
 
     private:
         // -- rendering API management -- --------------------------------------
@@ -58,5 +126,11 @@ namespace display
 
         /// @brief Load/reload rendering pipeline
         static void loadPipeline();
+
+        /// @brief Check if display area content/position/mode has changed since last presented frame (and store new area)
+        /// @param[in] displayState  Display state (display area, color mode)
+        /// @param[in] vramWrites    VRAM areas modified since last frame
+        /// @returns Modified status (always true if no frame was presented yet)
+        static bool updatePresentedArea(const command::DisplayState& displayState, const command::memory::VramWriteTracker& vramWrites) noexcept;
     };
 }
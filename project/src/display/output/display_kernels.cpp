@@ -0,0 +1,283 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - VRAM display area conversion kernels (15-bit / 24-bit to RGBA8)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "display_kernels.h"
+using namespace display::output;
+
+#define VRAM_WIDTH     1024u
+#define VRAM_HEIGHT    512u
+#define VRAM_ROW_BYTES (VRAM_WIDTH * 2u)
+#define THUMBNAIL_MAX_TAPS 9u // source columns covered by a thumbnail column (1024 / 128, + 1 if misaligned)
+
+
+// -- display area conversion -- -----------------------------------------------
+
+/// @brief Convert 15-bit display area to RGBA8
+void DisplayKernels::convertRgb15(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                  uint32_t* pOut, const size_t outPitch) noexcept
+{
+    const uint32_t left = (x & (VRAM_WIDTH - 1u));
+    const uint32_t firstLength = (left + width <= VRAM_WIDTH) ? width : VRAM_WIDTH - left; // before row wrap
+    for (uint32_t row = 0; row < height; ++row, pOut += outPitch)
+    {
+        const uint16_t* pRow = &pVram[((y + row) & (VRAM_HEIGHT - 1u)) * VRAM_WIDTH];
+        convertRowRgb15(&pRow[left], firstLength, pOut);
+        if (firstLength < width)
+            convertRowRgb15(pRow, width - firstLength, &pOut[firstLength]);
+    }
+}
+
+/// @brief Convert 24-bit display area to RGBA8
+void DisplayKernels::convertRgb24(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                  uint32_t* pOut, const size_t outPitch) noexcept
+{
+    for (uint32_t row = 0; row < height; ++row, pOut += outPitch)
+    {
+        const uint8_t* pRow = reinterpret_cast<const uint8_t*>(&pVram[((y + row) & (VRAM_HEIGHT - 1u)) * VRAM_WIDTH]);
+        uint32_t byteOffset = (x & (VRAM_WIDTH - 1u)) * 2u;
+        for (uint32_t pixel = 0; pixel < width; )
+        {
+            // contiguous pixels before row wrap
+            uint32_t length = (VRAM_ROW_BYTES - byteOffset) / 3u;
+            if (length > width - pixel)
+                length = width - pixel;
+            if (length > 0u)
+            {
+                convertRowRgb24(&pRow[byteOffset], length, &pOut[pixel]);
+                pixel += length;
+                byteOffset = (byteOffset + length * 3u) & (VRAM_ROW_BYTES - 1u);
+            }
+            else // pixel straddling row wrap
+            {
+                pOut[pixel++] = DISPLAY_KERNEL_ALPHA | static_cast<uint32_t>(pRow[byteOffset])
+                              | (static_cast<uint32_t>(pRow[(byteOffset + 1u) & (VRAM_ROW_BYTES - 1u)]) << 8)
+                              | (static_cast<uint32_t>(pRow[(byteOffset + 2u) & (VRAM_ROW_BYTES - 1u)]) << 16);
+                byteOffset = (byteOffset + 3u) & (VRAM_ROW_BYTES - 1u);
+            }
+        }
+    }
+}
+
+/// @brief Copy display area of high resolution image (software renderer) to RGBA8
+void DisplayKernels::copyHighRes(const uint32_t* pHighResVram, const uint32_t scaleX, const uint32_t scaleY, const uint32_t x, const uint32_t y,
+                                 const uint32_t width, const uint32_t height, uint32_t* pOut, const size_t outPitch) noexcept
+{
+    const uint32_t highResWidth = VRAM_WIDTH * scaleX, highResHeight = VRAM_HEIGHT * scaleY;
+    const uint32_t left = (x & (VRAM_WIDTH - 1u)) * scaleX;
+    const uint32_t top = (y & (VRAM_HEIGHT - 1u)) * scaleY;
+    const uint32_t copiedWidth = (width <= highResWidth) ? width : highResWidth;
+    const uint32_t firstLength = (left + copiedWidth <= highResWidth) ? copiedWidth : highResWidth - left; // before row wrap
+    for (uint32_t row = 0; row < height; ++row, pOut += outPitch)
+    {
+        const uint32_t* pRow = &pHighResVram[static_cast<size_t>((top + row) % highResHeight) * highResWidth];
+        const uint32_t* pSource = &pRow[left];
+        for (uint32_t col = 0; col < copiedWidth; ++col)
+        {
+            if (col == firstLength)
+                pSource = pRow - firstLength;
+            pOut[col] = DISPLAY_KERNEL_ALPHA | (pSource[col] & 0x00FFFFFFu); // mask bit -> opaque
+        }
+    }
+}
+
+
+// -- thumbnail -- -------------------------------------------------------------
+
+/// @brief Add weighted display row to column sums (vertical box filter)
+/// @param[in] pRow     Converted display row (RGBA8)
+/// @param[in] width    Display width
+/// @param[in] weight   Coverage of display row in thumbnail row
+/// @param[out] pSums   Column sums (4 components per display column)
+static inline void accumulateThumbnailRow(const uint32_t* pRow, const uint32_t width, const uint32_t weight, uint32_t* pSums) noexcept
+{
+    uint32_t i = 0;
+    #if _SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_set1_epi16(static_cast<int16_t>(weight)); // 255 * max weight (96) fits in 16 bits
+    for (; i + 4u <= width; i += 4u)
+    {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pRow[i]));
+        const __m128i low = _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+        const __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+        __m128i* pTarget = reinterpret_cast<__m128i*>(&pSums[i * 4u]);
+        _mm_storeu_si128(pTarget, _mm_add_epi32(_mm_loadu_si128(pTarget), _mm_unpacklo_epi16(low, zero)));
+        _mm_storeu_si128(pTarget + 1, _mm_add_epi32(_mm_loadu_si128(pTarget + 1), _mm_unpackhi_epi16(low, zero)));
+        _mm_storeu_si128(pTarget + 2, _mm_add_epi32(_mm_loadu_si128(pTarget + 2), _mm_unpacklo_epi16(high, zero)));
+        _mm_storeu_si128(pTarget + 3, _mm_add_epi32(_mm_loadu_si128(pTarget + 3), _mm_unpackhi_epi16(high, zero)));
+    }
+    #endif
+    for (; i < width; ++i)
+    {
+        pSums[i * 4u] += (pRow[i] & 0xFFu) * weight;
+        pSums[i * 4u + 1u] += ((pRow[i] >> 8) & 0xFFu) * weight;
+        pSums[i * 4u + 2u] += ((pRow[i] >> 16) & 0xFFu) * weight;
+    }
+}
+
+/// @brief Create thumbnail of display area (area-averaging box filter, single pass over display area)
+void DisplayKernels::createThumbnail(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t displayWidth, const uint32_t displayHeight,
+                                     const bool isRgb24, uint8_t* pOut) noexcept
+{
+    const uint32_t width = (displayWidth > VRAM_WIDTH) ? VRAM_WIDTH : displayWidth;
+    const uint32_t height = (displayHeight > VRAM_HEIGHT) ? VRAM_HEIGHT : displayHeight;
+    if (width == 0u || height == 0u)
+    {
+        memset(pOut, 0, DISPLAY_THUMBNAIL_WIDTH * DISPLAY_THUMBNAIL_HEIGHT * 3u);
+        return;
+    }
+
+    // fixed-point box weights: display pixel = DISPLAY_THUMBNAIL_WIDTH units, thumbnail column = width units
+    // -> weight = overlap of both spans (weights of each thumbnail column: sum = width)
+    uint16_t firstColumns[DISPLAY_THUMBNAIL_WIDTH];
+    uint8_t tapCounts[DISPLAY_THUMBNAIL_WIDTH];
+    uint8_t weights[DISPLAY_THUMBNAIL_WIDTH * THUMBNAIL_MAX_TAPS];
+    for (uint32_t col = 0; col < DISPLAY_THUMBNAIL_WIDTH; ++col)
+    {
+        const uint32_t spanStart = col * width, spanEnd = spanStart + width;
+        const uint32_t first = spanStart / DISPLAY_THUMBNAIL_WIDTH, last = (spanEnd - 1u) / DISPLAY_THUMBNAIL_WIDTH;
+        firstColumns[col] = static_cast<uint16_t>(first);
+        tapCounts[col] = static_cast<uint8_t>(last - first + 1u);
+        for (uint32_t source = first; source <= last; ++source)
+        {
+            const uint32_t start = (source * DISPLAY_THUMBNAIL_WIDTH > spanStart) ? source * DISPLAY_THUMBNAIL_WIDTH : spanStart;
+            const uint32_t end = ((source + 1u) * DISPLAY_THUMBNAIL_WIDTH < spanEnd) ? (source + 1u) * DISPLAY_THUMBNAIL_WIDTH : spanEnd;
+            weights[col * THUMBNAIL_MAX_TAPS + (source - first)] = static_cast<uint8_t>(end - start);
+        }
+    }
+
+    // vertical pass on display columns (rows at thumbnail row boundaries: converted once, kept for next thumbnail row),
+    // then horizontal pass on column sums (once per thumbnail row)
+    uint32_t rowPixels[VRAM_WIDTH];
+    uint32_t columnSums[VRAM_WIDTH * 4u];
+    uint32_t cachedRow = 0xFFFFFFFFu;
+    const uint32_t divisor = width * height, rounding = (divisor >> 1);
+    for (uint32_t row = 0; row < DISPLAY_THUMBNAIL_HEIGHT; ++row)
+    {
+        const uint32_t spanStart = row * height, spanEnd = spanStart + height;
+        const uint32_t first = spanStart / DISPLAY_THUMBNAIL_HEIGHT, last = (spanEnd - 1u) / DISPLAY_THUMBNAIL_HEIGHT;
+        memset(columnSums, 0, width * 4u * sizeof(uint32_t));
+        for (uint32_t source = first; source <= last; ++source)
+        {
+            if (source != cachedRow)
+            {
+                if (isRgb24)
+                    convertRgb24(pVram, x, y + source, width, 1u, rowPixels, width);
+                else
+                    convertRgb15(pVram, x, y + source, width, 1u, rowPixels, width);
+                cachedRow = source;
+            }
+            const uint32_t start = (source * DISPLAY_THUMBNAIL_HEIGHT > spanStart) ? source * DISPLAY_THUMBNAIL_HEIGHT : spanStart;
+            const uint32_t end = ((source + 1u) * DISPLAY_THUMBNAIL_HEIGHT < spanEnd) ? (source + 1u) * DISPLAY_THUMBNAIL_HEIGHT : spanEnd;
+            accumulateThumbnailRow(rowPixels, width, end - start, columnSums);
+        }
+
+        const uint8_t* pWeights = weights;
+        for (uint32_t col = 0; col < DISPLAY_THUMBNAIL_WIDTH; ++col, pWeights += THUMBNAIL_MAX_TAPS, pOut += 3)
+        {
+            const uint32_t* pSums = &columnSums[firstColumns[col] * 4u];
+            uint32_t r = rounding, g = rounding, b = rounding; // max: 255 * width * height < 2^28
+            for (uint32_t tap = 0; tap < tapCounts[col]; ++tap, pSums += 4)
+            {
+                r += pSums[0] * pWeights[tap];
+                g += pSums[1] * pWeights[tap];
+                b += pSums[2] * pWeights[tap];
+            }
+            pOut[0] = static_cast<uint8_t>(b / divisor); // BGR
+            pOut[1] = static_cast<uint8_t>(g / divisor);
+            pOut[2] = static_cast<uint8_t>(r / divisor);
+        }
+    }
+}
+
+
+// -- row kernels -- -----------------------------------------------------------
+
+/// @brief Convert contiguous 15-bit pixels to RGBA8
+void DisplayKernels::convertRowRgb15(const uint16_t* pSource, const size_t length, uint32_t* pOut) noexcept
+{
+    size_t i = 0;
+    #if _SIMD_SSE2
+    const __m128i channelMask = _mm_set1_epi16(0x1F);
+    const __m128i alpha = _mm_set1_epi16(static_cast<int16_t>(0xFF00));
+    for (; i + 8u <= length; i += 8u)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSource[i]));
+        __m128i r = _mm_and_si128(pixels, channelMask);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 5), channelMask);
+        __m128i b = _mm_and_si128(_mm_srli_epi16(pixels, 10), channelMask);
+        // 5-bit -> 8-bit: (c << 3) | (c >> 2)
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+        __m128i redGreen = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        __m128i blueAlpha = _mm_or_si128(b, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i]), _mm_unpacklo_epi16(redGreen, blueAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i + 4u]), _mm_unpackhi_epi16(redGreen, blueAlpha));
+    }
+    #endif
+    for (; i < length; ++i)
+        pOut[i] = toRgba8(pSource[i]);
+}
+
+/// @brief Convert contiguous 24-bit pixels (R, G, B byte stream) to RGBA8
+void DisplayKernels::convertRowRgb24(const uint8_t* pSource, const size_t length, uint32_t* pOut) noexcept
+{
+    size_t i = 0;
+    #if _SIMD_SSE2
+    const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int32_t>(DISPLAY_KERNEL_ALPHA));
+    for (; i + 6u <= length; i += 4u) // 16-byte load for 12 bytes: never read after source end
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSource[i * 3u]));
+        // move each 3-byte pixel to the first lane, then interleave
+        __m128i pixels01 = _mm_unpacklo_epi32(bytes, _mm_srli_si128(bytes, 3));
+        __m128i pixels23 = _mm_unpacklo_epi32(_mm_srli_si128(bytes, 6), _mm_srli_si128(bytes, 9));
+        __m128i pixels = _mm_unpacklo_epi64(pixels01, pixels23);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i]), _mm_or_si128(_mm_and_si128(pixels, colorMask), alpha));
+    }
+    #endif
+    for (const uint8_t* pPixel = &pSource[i * 3u]; i < length; ++i, pPixel += 3)
+        pOut[i] = DISPLAY_KERNEL_ALPHA | static_cast<uint32_t>(pPixel[0]) | (static_cast<uint32_t>(pPixel[1]) << 8) | (static_cast<uint32_t>(pPixel[2]) << 16);
+}
+
+
+// -- scalar reference -- ------------------------------------------------------
+
+/// @brief Convert display area to RGBA8 (per-pixel reference implementation)
+void DisplayKernels::convertReference(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                      const bool isRgb24, uint32_t* pOut, const size_t outPitch) noexcept
+{
+    for (uint32_t row = 0; row < height; ++row, pOut += outPitch)
+    {
+        const uint16_t* pRow = &pVram[((y + row) & (VRAM_HEIGHT - 1u)) * VRAM_WIDTH];
+        for (uint32_t col = 0; col < width; ++col)
+        {
+            if (isRgb24)
+            {
+                uint32_t color = 0u;
+                for (uint32_t component = 0; component < 3u; ++component)
+                {
+                    uint32_t byteOffset = (x * 2u + col * 3u + component) & (VRAM_ROW_BYTES - 1u);
+                    uint32_t byteValue = (pRow[byteOffset >> 1] >> ((byteOffset & 0x1u) * 8u)) & 0xFFu;
+                    color |= byteValue << (component * 8u);
+                }
+                pOut[col] = DISPLAY_KERNEL_ALPHA | color;
+            }
+            else
+                pOut[col] = toRgba8(pRow[(x + col) & (VRAM_WIDTH - 1u)]);
+        }
+    }
+}
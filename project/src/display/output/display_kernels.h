@@ -0,0 +1,103 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - VRAM display area conversion kernels (15-bit / 24-bit to RGBA8)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define DISPLAY_KERNEL_ALPHA 0xFF000000u // opaque alpha of converted pixels
+#define DISPLAY_THUMBNAIL_WIDTH  128u     // screen picture width (PSEmu GPUgetScreenPic)
+#define DISPLAY_THUMBNAIL_HEIGHT 96u      // screen picture height
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @class DisplayKernels
+        /// @brief VRAM display area conversion kernels - RGBA8 output (bytes: R, G, B, A), 8/4 pixels at once with SSE2
+        /// @details Display areas wrap around VRAM (1024 pixels per row, 512 rows). In 24-bit mode, pixels are a byte stream
+        ///          in each VRAM row (3-byte pixels straddle 16-bit words) that also wraps at the end of the row.
+        class DisplayKernels
+        {
+        public:
+            /// @brief Convert 15-bit display area to RGBA8
+            /// @param[in] pVram      Native VRAM image (1024 x 512 pixels)
+            /// @param[in] x          Display area left position (VRAM pixels)
+            /// @param[in] y          Display area top position
+            /// @param[in] width      Display width (pixels, max 1024)
+            /// @param[in] height     Display height (rows, max 512)
+            /// @param[out] pOut      Destination pixels
+            /// @param[in] outPitch   Distance between two destination rows (pixels)
+            static void convertRgb15(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                     uint32_t* pOut, const size_t outPitch) noexcept;
+            /// @brief Convert 24-bit display area to RGBA8
+            /// @param[in] pVram      Native VRAM image (1024 x 512 pixels)
+            /// @param[in] x          Display area left position (VRAM halfwords)
+            /// @param[in] y          Display area top position
+            /// @param[in] width      Display width (24-bit pixels, max 682)
+            /// @param[in] height     Display height (rows, max 512)
+            /// @param[out] pOut      Destination pixels
+            /// @param[in] outPitch   Distance between two destination rows (pixels)
+            static void convertRgb24(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                     uint32_t* pOut, const size_t outPitch) noexcept;
+
+
+            /// @brief Copy display area of high resolution image (software renderer) to RGBA8
+            /// @param[in] pHighResVram  Upscaled VRAM image (RGBA with mask bit in alpha, 1024*scaleX x 512*scaleY pixels)
+            /// @param[in] scaleX     Horizontal internal resolution factor
+            /// @param[in] scaleY     Vertical internal resolution factor
+            /// @param[in] x          Display area left position (native VRAM pixels)
+            /// @param[in] y          Display area top position (native VRAM rows)
+            /// @param[in] width      Copied width (high resolution pixels)
+            /// @param[in] height     Copied height (high resolution rows)
+            /// @param[out] pOut      Destination pixels (opaque alpha)
+            /// @param[in] outPitch   Distance between two destination rows (pixels)
+            static void copyHighRes(const uint32_t* pHighResVram, const uint32_t scaleX, const uint32_t scaleY, const uint32_t x, const uint32_t y,
+                                    const uint32_t width, const uint32_t height, uint32_t* pOut, const size_t outPitch) noexcept;
+
+            /// @brief Create thumbnail of display area (area-averaging box filter, single pass over display area)
+            /// @param[in] pVram      Native VRAM image (1024 x 512 pixels)
+            /// @param[in] x          Display area left position (VRAM halfwords)
+            /// @param[in] y          Display area top position
+            /// @param[in] width      Display width (pixels, max 1024 - 15-bit / 682 - 24-bit)
+            /// @param[in] height     Display height (rows, max 512)
+            /// @param[in] isRgb24    24-bit display mode (otherwise: 15-bit)
+            /// @param[out] pOut      Destination thumbnail (DISPLAY_THUMBNAIL_WIDTH x DISPLAY_THUMBNAIL_HEIGHT, 24-bit BGR, top-down, no padding)
+            static void createThumbnail(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                        const bool isRgb24, uint8_t* pOut) noexcept;
+
+
+            // -- row kernels (contiguous source) -- ---------------------------
+
+            /// @brief Convert contiguous 15-bit pixels to RGBA8
+            static void convertRowRgb15(const uint16_t* pSource, const size_t length, uint32_t* pOut) noexcept;
+            /// @brief Convert contiguous 24-bit pixels (R, G, B byte stream) to RGBA8
+            static void convertRowRgb24(const uint8_t* pSource, const size_t length, uint32_t* pOut) noexcept;
+
+
+            // -- scalar reference -- ------------------------------------------
+
+            /// @brief Convert display area to RGBA8 (per-pixel reference implementation)
+            /// @param[in] isRgb24  24-bit display mode (otherwise: 15-bit)
+            static void convertReference(const uint16_t* pVram, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+                                         const bool isRgb24, uint32_t* pOut, const size_t outPitch) noexcept;
+
+            /// @brief Convert single 15-bit pixel to RGBA8
+            static inline uint32_t toRgba8(const uint16_t pixel) noexcept
+            {
+                uint32_t r = (pixel & 0x1Fu), g = ((pixel >> 5) & 0x1Fu), b = ((pixel >> 10) & 0x1Fu);
+                return DISPLAY_KERNEL_ALPHA | (((b << 3) | (b >> 2)) << 16) | (((g << 3) | (g >> 2)) << 8) | ((r << 3) | (r >> 2));
+            }
+        };
+    }
+}
@@ -0,0 +1,346 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - streaming frame dump (every presented frame, raw RGB888 or Y4M file)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std::literals::string_literals;
+#include "../../config/config_common.h"
+#include "../../command/display_state.h"
+#include "../../command/memory/status_register.h"
+#include "../../events/utils/file_io.h"
+#include "display_kernels.h"
+#include "frame_dump_writer.h"
+using namespace display::output;
+using config::frame_dump_format_t;
+
+
+/// @brief Create frame dump (allocate ring + start writer thread) - file created on first frame
+FrameDumpWriter::FrameDumpWriter(const std::string& basePath, const frame_dump_format_t format, const uint32_t ringSize, const uint32_t maxFramePixels)
+    : m_maxFramePixels(maxFramePixels), m_format(format), m_basePath(basePath), m_streamWidth(0u), m_streamHeight(0u), m_isStreamOpen(false), m_stagedFrames(0uLL),
+      m_producedCount(0uLL), m_consumedCount(0uLL), m_droppedCount(0uLL), m_writtenCount(0uLL), m_failedCount(0uLL), m_writtenBytes(0uLL), m_maxQueuedCount(0u),
+      m_isRunning(true), m_isIdle(false)
+{
+    // preallocated ring: no allocation on vsync
+    m_slots.resize((ringSize >= 2u) ? ringSize : 2u);
+    for (auto it = m_slots.begin(); it != m_slots.end(); ++it)
+    {
+        it->pixels.resize(maxFramePixels);
+        it->width = it->height = 0u;
+        it->isPal = false;
+    }
+    m_staging.reserve(FRAME_DUMP_WRITE_CHUNK + static_cast<size_t>(maxFramePixels) * 3u + 64u);
+    m_writerThread = std::thread(&FrameDumpWriter::runWriter, this);
+}
+
+/// @brief Write queued frames, then stop writer thread and close file
+FrameDumpWriter::~FrameDumpWriter()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_writerLock);
+        m_isRunning = false;
+    }
+    m_frameCondition.notify_all();
+    if (m_writerThread.joinable())
+        m_writerThread.join();
+}
+
+/// @brief Get default dump file path (writable path + FRAME_DUMP_FILE_PREFIX, without extension)
+std::string FrameDumpWriter::getDefaultBasePath()
+{
+    return events::utils::FileIO::getWritableFilePath() + FRAME_DUMP_FILE_PREFIX;
+}
+
+
+// -- capture (vsync) -- -------------------------------------------------------
+
+/// @brief Copy native display area into ring (black frame if display is disabled)
+bool FrameDumpWriter::captureDisplayArea(const uint16_t* pVram, const command::DisplayState& displayState) noexcept
+{
+    const uint32_t width = displayState.displayWidth(), height = displayState.displayHeight();
+    if (static_cast<size_t>(width) * height > m_maxFramePixels)
+    {
+        ++m_droppedCount;
+        return false;
+    }
+    frame_slot_t* pSlot = acquireSlot();
+    if (pSlot == nullptr)
+        return false;
+
+    pSlot->width = width;
+    pSlot->height = height;
+    pSlot->isPal = command::memory::StatusRegister::getStatus(GPUSTATUS_PAL);
+    if (width > 0u && height > 0u)
+    {
+        if (pVram == nullptr || command::DisplayState::isDisplayEnabled() == false)
+            memset(&pSlot->pixels[0], 0, static_cast<size_t>(width) * height * sizeof(uint32_t));
+        else if (command::DisplayState::isRgb24())
+            DisplayKernels::convertRgb24(pVram, displayState.displayX(), displayState.displayY(), width, height, &pSlot->pixels[0], width);
+        else
+            DisplayKernels::convertRgb15(pVram, displayState.displayX(), displayState.displayY(), width, height, &pSlot->pixels[0], width);
+    }
+    publishSlot();
+    return true;
+}
+
+/// @brief Copy processed frame into ring
+bool FrameDumpWriter::captureFrame(const uint32_t* pRgba, const uint32_t width, const uint32_t height, const size_t pitch, const bool isPal) noexcept
+{
+    if (pRgba == nullptr || static_cast<size_t>(width) * height > m_maxFramePixels)
+    {
+        ++m_droppedCount;
+        return false;
+    }
+    frame_slot_t* pSlot = acquireSlot();
+    if (pSlot == nullptr)
+        return false;
+
+    pSlot->width = width;
+    pSlot->height = height;
+    pSlot->isPal = isPal;
+    uint32_t* pOut = (width > 0u) ? &pSlot->pixels[0] : nullptr;
+    for (uint32_t row = 0; row < height && pOut != nullptr; ++row, pRgba += pitch, pOut += width)
+        memcpy(pOut, pRgba, width * sizeof(uint32_t));
+    publishSlot();
+    return true;
+}
+
+/// @brief Get next free slot (or nullptr if ring is full -> frame dropped)
+FrameDumpWriter::frame_slot_t* FrameDumpWriter::acquireSlot() noexcept
+{
+    const uint64_t produced = m_producedCount.load(std::memory_order_relaxed); // only modified by this thread
+    const uint64_t queued = produced - m_consumedCount.load(std::memory_order_acquire);
+    if (queued >= m_slots.size())
+    {
+        ++m_droppedCount; // back-pressure: writer thread behind
+        return nullptr;
+    }
+    if (queued + 1u > m_maxQueuedCount.load(std::memory_order_relaxed))
+        m_maxQueuedCount.store(static_cast<uint32_t>(queued + 1u), std::memory_order_relaxed);
+    return &m_slots[produced % m_slots.size()];
+}
+
+/// @brief Publish filled slot to writer thread
+void FrameDumpWriter::publishSlot() noexcept
+{
+    m_producedCount.fetch_add(1uLL, std::memory_order_release);
+    m_frameCondition.notify_one(); // no lock: a missed notification only delays writer until its next wake-up
+}
+
+/// @brief Wait until all queued frames are written in dump file
+void FrameDumpWriter::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_writerLock);
+    m_idleCondition.wait(lock, [this]()
+    {
+        return (m_isIdle && m_consumedCount.load(std::memory_order_acquire) == m_producedCount.load(std::memory_order_acquire));
+    });
+}
+
+
+// -- statistics -- ------------------------------------------------------------
+
+/// @brief Get frame dump statistics
+frame_dump_stats_t FrameDumpWriter::getStats() const noexcept
+{
+    frame_dump_stats_t stats;
+    const uint64_t consumed = m_consumedCount.load(std::memory_order_acquire);
+    stats.capturedFrames = m_producedCount.load(std::memory_order_acquire);
+    stats.writtenFrames = m_writtenCount.load();
+    stats.droppedFrames = m_droppedCount.load();
+    stats.failedFrames = m_failedCount.load();
+    stats.writtenBytes = m_writtenBytes.load();
+    stats.queuedFrames = static_cast<uint32_t>(stats.capturedFrames - consumed);
+    stats.maxQueuedFrames = m_maxQueuedCount.load();
+    return stats;
+}
+
+/// @brief Get dump file path (empty until first frame is written)
+std::string FrameDumpWriter::filePath() const
+{
+    std::lock_guard<std::mutex> guard(m_writerLock);
+    return m_filePath;
+}
+
+
+// -- encoding/writing (writer thread) -- --------------------------------------
+
+/// @brief Writer thread loop
+void FrameDumpWriter::runWriter()
+{
+    while (true)
+    {
+        const uint64_t consumed = m_consumedCount.load(std::memory_order_relaxed); // only modified by this thread
+        if (consumed == m_producedCount.load(std::memory_order_acquire))
+        {
+            flushStaging(); // ring empty: write pending frames before sleeping
+
+            std::unique_lock<std::mutex> lock(m_writerLock);
+            if (consumed != m_producedCount.load(std::memory_order_acquire))
+                continue;
+            if (m_isRunning == false)
+                break;
+            m_isIdle = true;
+            m_idleCondition.notify_all();
+            m_frameCondition.wait_for(lock, std::chrono::milliseconds(FRAME_DUMP_WAIT_MS));
+            m_isIdle = false;
+            continue;
+        }
+
+        const frame_slot_t& slot = m_slots[consumed % m_slots.size()];
+        if (m_streamWidth == 0u && slot.width > 0u && slot.height > 0u) // first frame: stream size + file creation
+            m_isStreamOpen = openStream(slot);
+        if (m_isStreamOpen)
+        {
+            encodeFrame(slot);
+            ++m_stagedFrames;
+        }
+        else if (m_streamWidth != 0u)
+            ++m_failedCount;
+        m_consumedCount.store(consumed + 1u, std::memory_order_release); // slot released before disk write
+
+        if (m_staging.size() >= FRAME_DUMP_WRITE_CHUNK)
+            flushStaging();
+    }
+    flushStaging();
+    m_file.close();
+}
+
+/// @brief Create dump file + stream header (first frame)
+bool FrameDumpWriter::openStream(const frame_slot_t& firstFrame)
+{
+    m_streamWidth = firstFrame.width;
+    m_streamHeight = firstFrame.height;
+    std::string filePath;
+    if (m_format == frame_dump_format_t::y4m)
+    {
+        m_streamWidth = (m_streamWidth + 1u) & ~0x1u; // 4:2:0 -> even size (padded with black)
+        m_streamHeight = (m_streamHeight + 1u) & ~0x1u;
+        filePath = m_basePath + ".y4m"s;
+    }
+    else
+        filePath = m_basePath + "_"s + std::to_string(m_streamWidth) + "x"s + std::to_string(m_streamHeight) + ".rgb"s;
+
+    m_file.rdbuf()->pubsetbuf(nullptr, 0); // unbuffered: staging chunks are written directly
+    m_file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (m_file.is_open() == false)
+        return false;
+    {
+        std::lock_guard<std::mutex> guard(m_writerLock);
+        m_filePath = filePath;
+    }
+
+    if (m_format == frame_dump_format_t::y4m)
+    {
+        char header[96];
+        int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%s Ip A1:1 C420jpeg\n", m_streamWidth, m_streamHeight,
+                              (firstFrame.isPal) ? "50:1" : "60000:1001");
+        if (length > 0)
+            m_staging.insert(m_staging.end(), header, header + length);
+    }
+    return true;
+}
+
+/// @brief Get source pixel of stream position (black outside of frame)
+static inline uint32_t getStreamPixel(const uint32_t* pPixels, const uint32_t width, const uint32_t height, const uint32_t x, const uint32_t y) noexcept
+{
+    return (x < width && y < height) ? pPixels[y * width + x] : 0u;
+}
+
+/// @brief Encode frame at the end of staging buffer (cropped/padded to stream size)
+void FrameDumpWriter::encodeFrame(const frame_slot_t& frame)
+{
+    const uint32_t* pPixels = &frame.pixels[0];
+    const size_t pixelCount = static_cast<size_t>(m_streamWidth) * m_streamHeight;
+    if (m_format == frame_dump_format_t::y4m)
+    {
+        // BT.601 limited range, chroma: average of 2x2 blocks
+        static const char frameHeader[] = "FRAME\n";
+        m_staging.insert(m_staging.end(), frameHeader, frameHeader + sizeof(frameHeader) - 1u);
+        const size_t offset = m_staging.size();
+        m_staging.resize(offset + pixelCount + pixelCount / 2u);
+        uint8_t* pLuma = &m_staging[offset];
+        uint8_t* pBlue = pLuma + pixelCount;
+        uint8_t* pRed = pBlue + pixelCount / 4u;
+
+        for (uint32_t y = 0; y < m_streamHeight; y += 2u)
+        {
+            for (uint32_t x = 0; x < m_streamWidth; x += 2u, ++pBlue, ++pRed)
+            {
+                const uint32_t block[4] = { getStreamPixel(pPixels, frame.width, frame.height, x, y), getStreamPixel(pPixels, frame.width, frame.height, x + 1u, y),
+                                            getStreamPixel(pPixels, frame.width, frame.height, x, y + 1u), getStreamPixel(pPixels, frame.width, frame.height, x + 1u, y + 1u) };
+                int32_t sumR = 0, sumG = 0, sumB = 0;
+                for (uint32_t i = 0; i < 4u; ++i)
+                {
+                    const int32_t r = static_cast<int32_t>(block[i] & 0xFFu), g = static_cast<int32_t>((block[i] >> 8) & 0xFFu), b = static_cast<int32_t>((block[i] >> 16) & 0xFFu);
+                    pLuma[(i >> 1) * m_streamWidth + (x | (i & 0x1u))] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    sumR += r;
+                    sumG += g;
+                    sumB += b;
+                }
+                sumR = (sumR + 2) >> 2;
+                sumG = (sumG + 2) >> 2;
+                sumB = (sumB + 2) >> 2;
+                *pBlue = static_cast<uint8_t>((-38 * sumR - 74 * sumG + 112 * sumB + 128 + (128 << 8)) >> 8);
+                *pRed = static_cast<uint8_t>((112 * sumR - 94 * sumG - 18 * sumB + 128 + (128 << 8)) >> 8);
+            }
+            pLuma += static_cast<size_t>(m_streamWidth) * 2u;
+        }
+    }
+    else // raw RGB888
+    {
+        const size_t offset = m_staging.size();
+        m_staging.resize(offset + pixelCount * 3u);
+        uint8_t* pOut = &m_staging[offset];
+        const uint32_t copiedWidth = (frame.width < m_streamWidth) ? frame.width : m_streamWidth;
+        const uint32_t copiedHeight = (frame.height < m_streamHeight) ? frame.height : m_streamHeight;
+        for (uint32_t y = 0; y < copiedHeight; ++y)
+        {
+            const uint32_t* pPixel = &pPixels[static_cast<size_t>(y) * frame.width];
+            for (uint32_t x = 0; x < copiedWidth; ++x, ++pPixel, pOut += 3)
+            {
+                pOut[0] = static_cast<uint8_t>(*pPixel);
+                pOut[1] = static_cast<uint8_t>(*pPixel >> 8);
+                pOut[2] = static_cast<uint8_t>(*pPixel >> 16);
+            }
+            memset(pOut, 0, (m_streamWidth - copiedWidth) * 3u); // black padding
+            pOut += (m_streamWidth - copiedWidth) * 3u;
+        }
+        memset(pOut, 0, static_cast<size_t>(m_streamHeight - copiedHeight) * m_streamWidth * 3u);
+    }
+}
+
+/// @brief Write staging buffer in dump file
+void FrameDumpWriter::flushStaging()
+{
+    if (m_staging.empty())
+        return;
+    m_file.write(reinterpret_cast<const char*>(&m_staging[0]), static_cast<std::streamsize>(m_staging.size()));
+    if (m_file.fail())
+    {
+        m_failedCount += m_stagedFrames;
+        m_file.clear();
+    }
+    else
+    {
+        m_writtenCount += m_stagedFrames;
+        m_writtenBytes += m_staging.size();
+    }
+    m_staging.clear(); // capacity kept
+    m_stagedFrames = 0uLL;
+}
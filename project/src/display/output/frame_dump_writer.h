@@ -0,0 +1,165 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - streaming frame dump (every presented frame, raw RGB888 or Y4M file)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "../../config/config_common.h"
+#include "../../command/display_state.h"
+
+#define FRAME_DUMP_FILE_PREFIX   "pandoraGS_frames"    // dump file name: prefix (+ "_<width>x<height>" for raw RGB) + extension
+#define FRAME_DUMP_RING_SIZE     8u                    // default number of preallocated frame slots
+#define FRAME_DUMP_MAX_PIXELS    (1024u * 512u)        // default pixels per slot (max native display area)
+#define FRAME_DUMP_WRITE_CHUNK   (4u * 1024u * 1024u)  // encoded frames written by chunks of at least 4 MB
+#define FRAME_DUMP_WAIT_MS       4                     // writer thread wake-up period (notifications from vsync never lock)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @struct frame_dump_stats_t
+        /// @brief Frame dump statistics
+        struct frame_dump_stats_t
+        {
+            uint64_t capturedFrames; ///< Frames copied to ring
+            uint64_t writtenFrames;  ///< Frames encoded in dump file
+            uint64_t droppedFrames;  ///< Frames dropped at capture: ring full (writer too slow = back-pressure)
+            uint64_t failedFrames;   ///< Frames lost because of file errors
+            uint64_t writtenBytes;   ///< Bytes written in dump file
+            uint32_t queuedFrames;   ///< Frames currently waiting in ring
+            uint32_t maxQueuedFrames; ///< Highest ring occupancy (back-pressure indicator)
+        };
+
+
+        /// @class FrameDumpWriter
+        /// @brief Streaming frame dump - each presented frame is copied into a ring of preallocated slots (vsync thread),
+        ///        then encoded and streamed to a file with large sequential writes (writer thread)
+        /// @details Single producer (vsync) / single consumer (writer) ring: capture never locks nor waits for the writer thread.
+        ///          If the ring is full, the frame is dropped and counted. Stream size and frame rate are set by the first frame:
+        ///          following frames with another size are cropped / padded with black.
+        class FrameDumpWriter
+        {
+        public:
+            /// @brief Create frame dump (allocate ring + start writer thread) - file created on first frame
+            /// @param[in] basePath        Dump file path without extension (size and extension added)
+            /// @param[in] format          Dump file format (raw RGB / Y4M)
+            /// @param[in] ringSize        Number of frame slots (min 2)
+            /// @param[in] maxFramePixels  Max pixels of a captured frame (bigger frames are dropped)
+            FrameDumpWriter(const std::string& basePath, const config::frame_dump_format_t format,
+                            const uint32_t ringSize = FRAME_DUMP_RING_SIZE, const uint32_t maxFramePixels = FRAME_DUMP_MAX_PIXELS);
+            /// @brief Write queued frames, then stop writer thread and close file
+            ~FrameDumpWriter();
+            // no copy/move allowed
+            FrameDumpWriter(const FrameDumpWriter& other) = delete;
+            FrameDumpWriter(FrameDumpWriter&& other) = delete;
+            FrameDumpWriter& operator=(const FrameDumpWriter& other) = delete;
+            FrameDumpWriter& operator=(FrameDumpWriter&& other) = delete;
+
+            /// @brief Get default dump file path (writable path + FRAME_DUMP_FILE_PREFIX, without extension)
+            static std::string getDefaultBasePath();
+
+
+            // -- capture (vsync) -- -------------------------------------------
+
+            /// @brief Copy native display area into ring (black frame if display is disabled)
+            /// @param[in] pVram         Native VRAM image (1024 x 512 pixels)
+            /// @param[in] displayState  Display state (display area, color mode)
+            /// @returns Frame queued (false if dropped)
+            bool captureDisplayArea(const uint16_t* pVram, const command::DisplayState& displayState) noexcept;
+            /// @brief Copy processed frame into ring
+            /// @param[in] pRgba   Frame pixels (RGBA8)
+            /// @param[in] width   Frame width
+            /// @param[in] height  Frame height
+            /// @param[in] pitch   Distance between two frame rows (pixels)
+            /// @param[in] isPal   PAL frame rate (50 Hz, otherwise 59.94 Hz)
+            /// @returns Frame queued (false if dropped)
+            bool captureFrame(const uint32_t* pRgba, const uint32_t width, const uint32_t height, const size_t pitch, const bool isPal) noexcept;
+
+            /// @brief Wait until all queued frames are written in dump file
+            void waitIdle();
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Get frame dump statistics
+            frame_dump_stats_t getStats() const noexcept;
+            /// @brief Get dump file path (empty until first frame is written)
+            std::string filePath() const;
+
+
+        private:
+            /// @struct frame_slot_t
+            /// @brief Preallocated frame slot
+            struct frame_slot_t
+            {
+                std::vector<uint32_t> pixels; ///< Frame pixels (RGBA8, width x height)
+                uint32_t width;               ///< Frame width
+                uint32_t height;              ///< Frame height
+                bool isPal;                   ///< PAL frame rate
+            };
+
+            /// @brief Get next free slot (or nullptr if ring is full -> frame dropped)
+            frame_slot_t* acquireSlot() noexcept;
+            /// @brief Publish filled slot to writer thread
+            void publishSlot() noexcept;
+
+            /// @brief Writer thread loop
+            void runWriter();
+            /// @brief Create dump file + stream header (first frame)
+            bool openStream(const frame_slot_t& firstFrame);
+            /// @brief Encode frame at the end of staging buffer (cropped/padded to stream size)
+            void encodeFrame(const frame_slot_t& frame);
+            /// @brief Write staging buffer in dump file
+            void flushStaging();
+
+
+        private:
+            std::vector<frame_slot_t> m_slots;          ///< Frame ring
+            const uint32_t m_maxFramePixels;            ///< Capacity of each slot
+            const config::frame_dump_format_t m_format; ///< Dump file format
+            const std::string m_basePath;               ///< Dump file path without extension
+            std::string m_filePath;                     ///< Dump file path
+            std::ofstream m_file;                       ///< Dump file (writer thread only)
+
+            // stream properties (set by first frame - writer thread only)
+            uint32_t m_streamWidth;                     ///< Stream frame width
+            uint32_t m_streamHeight;                    ///< Stream frame height
+            bool m_isStreamOpen;                        ///< Dump file created + header written
+            std::vector<uint8_t> m_staging;             ///< Encoded frames waiting for sequential write
+            uint64_t m_stagedFrames;                    ///< Number of frames in staging buffer
+
+            // ring positions (monotonic counters: slot = counter % ring size)
+            std::atomic<uint64_t> m_producedCount;      ///< Published frames (vsync thread)
+            std::atomic<uint64_t> m_consumedCount;      ///< Encoded frames, slot released (writer thread)
+            std::atomic<uint64_t> m_droppedCount;       ///< Dropped frames (ring full)
+            std::atomic<uint64_t> m_writtenCount;       ///< Frames written in file
+            std::atomic<uint64_t> m_failedCount;        ///< Frames lost (file errors)
+            std::atomic<uint64_t> m_writtenBytes;       ///< Bytes written in file
+            std::atomic<uint32_t> m_maxQueuedCount;     ///< Highest ring occupancy
+            bool m_isRunning;                           ///< Writer thread active (protected by writer lock)
+            bool m_isIdle;                              ///< Writer thread waiting: ring empty + staging written (protected by writer lock)
+
+            mutable std::mutex m_writerLock;            ///< Writer state + file path protection (never locked by capture)
+            std::condition_variable m_frameCondition;   ///< New frame / stop request
+            std::condition_variable m_idleCondition;    ///< Writer thread idle
+            std::thread m_writerThread;                 ///< Encoding/writing thread
+        };
+    }
+}
@@ -0,0 +1,188 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : headless output backend - display area converted to RGB888 frames in memory
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "../../config/config_common.h"
+#include "../../command/memory/status_register.h"
+#include "../../command/display_state.h"
+#include "../scaling/screen_upscaler.h"
+#include "../scaling/screen_resampler.h"
+#include "display_kernels.h"
+#include "post_processing.h"
+#include "headless_output.h"
+using namespace display::output;
+
+frame_callback_t HeadlessOutput::s_frameCallback = nullptr; ///< Frame callback
+void* HeadlessOutput::s_pCallbackUserData = nullptr;        ///< Frame callback user data
+
+
+/// @brief Present current frame (convert display area to RGB888 + call frame callback)
+/// @param[in] pVram         Native VRAM image (1024 x 512 pixels)
+/// @param[in] displayState  Display state (display area, color mode)
+void HeadlessOutput::present(const uint16_t* pVram, const command::DisplayState& displayState)
+{
+    const uint32_t sourceWidth = displayState.displayWidth();
+    const uint32_t sourceHeight = displayState.displayHeight();
+    const bool isBlack = (pVram == nullptr || command::DisplayState::isDisplayEnabled() == false);
+    if (isBlack == false && sourceWidth > 0u && sourceHeight > 0u)
+    {
+        m_rgbaFrame.resize(static_cast<size_t>(sourceWidth) * sourceHeight); // memory kept between frames
+        if (command::DisplayState::isRgb24())
+            DisplayKernels::convertRgb24(pVram, displayState.displayX(), displayState.displayY(), sourceWidth, sourceHeight, &m_rgbaFrame[0], sourceWidth);
+        else
+            DisplayKernels::convertRgb15(pVram, displayState.displayX(), displayState.displayY(), sourceWidth, sourceHeight, &m_rgbaFrame[0], sourceWidth);
+    }
+    outputFrame(sourceWidth, sourceHeight, isBlack);
+}
+
+/// @brief Present current frame from high resolution image (copy display area at internal resolution + call frame callback)
+/// @param[in] pHighResVram  Upscaled VRAM image (RGBA, 1024*scaleX x 512*scaleY pixels)
+/// @param[in] scaleX        Horizontal internal resolution factor
+/// @param[in] scaleY        Vertical internal resolution factor
+/// @param[in] displayState  Display state (display area, color mode)
+void HeadlessOutput::presentHighRes(const uint32_t* pHighResVram, const uint32_t scaleX, const uint32_t scaleY, const command::DisplayState& displayState)
+{
+    const uint32_t sourceWidth = displayState.displayWidth() * scaleX;
+    const uint32_t sourceHeight = displayState.displayHeight() * scaleY;
+    const bool isBlack = (pHighResVram == nullptr || command::DisplayState::isDisplayEnabled() == false);
+    if (isBlack == false && sourceWidth > 0u && sourceHeight > 0u)
+    {
+        m_rgbaFrame.resize(static_cast<size_t>(sourceWidth) * sourceHeight);
+        DisplayKernels::copyHighRes(pHighResVram, scaleX, scaleY, displayState.displayX(), displayState.displayY(), sourceWidth, sourceHeight,
+                                    &m_rgbaFrame[0], sourceWidth);
+    }
+    outputFrame(sourceWidth, sourceHeight, isBlack);
+}
+
+/// @brief Apply screen stages to converted display area (if enabled), convert to RGB888 + call frame callback
+void HeadlessOutput::outputFrame(const uint32_t sourceWidth, const uint32_t sourceHeight, const bool isBlack)
+{
+    const uint32_t factor = (m_pUpscaler) ? m_pUpscaler->factor() : 1u;
+    const bool isResampled = (m_pResampler && sourceWidth > 0u && sourceHeight > 0u);
+    m_width = (isResampled) ? m_outputWidth : sourceWidth * factor;
+    m_height = (isResampled) ? m_outputHeight : sourceHeight * factor;
+    const size_t pixelCount = static_cast<size_t>(m_width) * m_height;
+    m_frame.resize(pixelCount * 3u); // memory kept between frames
+    m_pPresentedFrame = nullptr;
+    ++m_frameCount;
+    if (m_frame.empty())
+        return;
+
+    if (isBlack)
+        memset(&m_frame[0], 0, m_frame.size());
+    else
+    {
+        // display area (RGBA8) -> upscaled -> resampled to output size -> post-processed (single tiled pass) -> RGB888
+        const uint32_t* pFrame = &m_rgbaFrame[0];
+        if (factor > 1u)
+        {
+            m_scaledFrame.resize(static_cast<size_t>(sourceWidth) * factor * sourceHeight * factor);
+            m_pUpscaler->upscale(&m_rgbaFrame[0], sourceWidth, sourceHeight, &m_scaledFrame[0]);
+            pFrame = &m_scaledFrame[0];
+        }
+        if (isResampled)
+        {
+            const bool isPal = command::memory::StatusRegister::getStatus(GPUSTATUS_PAL);
+            m_pResampler->setTarget(m_resamplingMode, scaling::ScreenResampler::computeTarget(m_screenSettings, isPal, sourceWidth * factor, sourceHeight * factor,
+                                                                                              m_width, m_height)); // weights only recomputed if geometry changed
+            m_resampledFrame.resize(pixelCount);
+            m_pResampler->resample(pFrame, &m_resampledFrame[0]);
+            pFrame = &m_resampledFrame[0];
+        }
+        if (m_pPostProcessing)
+        {
+            m_pPostProcessing->configure(post_processing_settings_t::fromConfig(m_screenSettings, m_scalingSettings, m_width, m_height), m_width, m_height);
+            m_processedFrame.resize(pixelCount);
+            m_pPostProcessing->process(pFrame, &m_processedFrame[0]);
+            pFrame = &m_processedFrame[0];
+        }
+        m_pPresentedFrame = pFrame;
+
+        uint8_t* pOut = &m_frame[0];
+        for (const uint32_t* pEnd = pFrame + pixelCount; pFrame < pEnd; ++pFrame, pOut += 3)
+        {
+            pOut[0] = static_cast<uint8_t>(*pFrame);
+            pOut[1] = static_cast<uint8_t>(*pFrame >> 8);
+            pOut[2] = static_cast<uint8_t>(*pFrame >> 16);
+        }
+    }
+
+    if (s_frameCallback != nullptr)
+        s_frameCallback(&m_frame[0], static_cast<long>(m_width), static_cast<long>(m_height), s_pCallbackUserData);
+}
+
+/// @brief Set screen upscaling applied to presented frames (frame size multiplied by factor)
+/// @param[in] mode    Upscaling type
+/// @param[in] factor  Requested upscaling factor (1 = no upscaling)
+void HeadlessOutput::setScreenScaling(const config::upscaling_mode_t mode, const uint32_t factor)
+{
+    if (factor > 1u)
+        m_pUpscaler.reset(new scaling::ScreenUpscaler(mode, factor));
+    else
+        m_pUpscaler.reset();
+    m_scaledFrame.clear();
+    m_pPresentedFrame = nullptr; // buffer released
+}
+
+/// @brief Set screen post-processing applied to presented frames (mirroring, curvature, black borders, screen smoothing)
+/// @param[in] screen   Screen adjustment settings (also used for output size geometry)
+/// @param[in] scaling  Scaling / smoothing settings (screen smoothing)
+void HeadlessOutput::setScreenEffects(const config::config_screen_t& screen, const config::config_scaling_t& scaling)
+{
+    m_screenSettings = screen;
+    m_scalingSettings = scaling;
+    const bool isEnabled = (scaling.screenSmoothing != config::screen_smooth_mode_t::none || screen.isMirrored
+                         || screen.curvature != config::screen_curvature_t::none || screen.blackBorders.x > 0u || screen.blackBorders.y > 0u);
+    if (isEnabled)
+    {
+        if (!m_pPostProcessing)
+            m_pPostProcessing.reset(new PostProcessing());
+    }
+    else
+    {
+        m_pPostProcessing.reset();
+        m_processedFrame.clear();
+        m_pPresentedFrame = nullptr; // buffer released
+    }
+}
+
+/// @brief Set fixed output size: frames resampled to this size (ratio, stretching and cropping from screen settings)
+/// @param[in] width   Output width (0 = upscaled display area size)
+/// @param[in] height  Output height (0 = upscaled display area size)
+/// @param[in] mode    Interpolation type
+void HeadlessOutput::setOutputSize(const uint32_t width, const uint32_t height, const config::interpolation_mode_t mode)
+{
+    if (width > 0u && height > 0u)
+    {
+        if (!m_pResampler)
+            m_pResampler.reset(new scaling::ScreenResampler());
+        m_outputWidth = width;
+        m_outputHeight = height;
+        m_resamplingMode = mode;
+    }
+    else
+    {
+        m_pResampler.reset();
+        m_resampledFrame.clear();
+        m_pPresentedFrame = nullptr; // buffer released
+        m_outputWidth = m_outputHeight = 0u;
+    }
+}
+
+/// @brief Present last frame again (same RGB888 frame sent to frame callback)
+void HeadlessOutput::presentCached()
+{
+    ++m_frameCount;
+    if (s_frameCallback != nullptr && m_frame.empty() == false)
+        s_frameCallback(&m_frame[0], static_cast<long>(m_width), static_cast<long>(m_height), s_pCallbackUserData);
+}
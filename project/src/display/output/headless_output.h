@@ -0,0 +1,142 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : headless output backend - display area converted to RGB888 frames in memory
+*******************************************************************************/
+#pragma once
+
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../../config/config_common.h"
+#include "../../command/display_state.h"
+#include "../scaling/screen_upscaler.h"
+#include "../scaling/screen_resampler.h"
+#include "post_processing.h"
+#include "i_output_backend.h"
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @brief Frame callback (headless output)
+        /// @param pRgb       Frame pixels (RGB888, rows of width * 3 bytes, no padding)
+        /// @param width      Frame width (pixels)
+        /// @param height     Frame height (pixels)
+        /// @param pUserData  User data (set with callback)
+        typedef void (CALLBACK* frame_callback_t)(const unsigned char* pRgb, long width, long height, void* pUserData);
+
+
+        /// @class HeadlessOutput
+        /// @brief Headless output backend - no window and no graphics API: each frame is converted to RGB888 in memory,
+        ///        then optionally sent to a callback (regression/throughput tests on hosts without GPU)
+        /// @details Screen stages of each frame: display area -> screen upscaling -> resampling to output size (optional)
+        ///          -> fused post-processing (mirroring, curvature, smoothing, black borders) -> RGB888.
+        class HeadlessOutput : public IOutputBackend
+        {
+        public:
+            /// @brief Create headless output
+            HeadlessOutput() noexcept : m_screenSettings(), m_scalingSettings(), m_resamplingMode(config::interpolation_mode_t::nearest),
+                                        m_outputWidth(0u), m_outputHeight(0u), m_pPresentedFrame(nullptr), m_width(0u), m_height(0u), m_frameCount(0uLL) {}
+            /// @brief Destroy headless output
+            virtual ~HeadlessOutput() {}
+
+            /// @brief Present current frame (convert display area to RGB888 + call frame callback)
+            /// @param[in] pVram         Native VRAM image (1024 x 512 pixels)
+            /// @param[in] displayState  Display state (display area, color mode)
+            virtual void present(const uint16_t* pVram, const command::DisplayState& displayState) override;
+            /// @brief Present current frame from high resolution image (copy display area at internal resolution + call frame callback)
+            /// @param[in] pHighResVram  Upscaled VRAM image (RGBA, 1024*scaleX x 512*scaleY pixels)
+            /// @param[in] scaleX        Horizontal internal resolution factor
+            /// @param[in] scaleY        Vertical internal resolution factor
+            /// @param[in] displayState  Display state (display area, color mode)
+            virtual void presentHighRes(const uint32_t* pHighResVram, const uint32_t scaleX, const uint32_t scaleY, const command::DisplayState& displayState) override;
+            /// @brief Present last frame again (same RGB888 frame sent to frame callback)
+            virtual void presentCached() override;
+            /// @brief Get last presented frame, after screen stages (valid until next call to present)
+            /// @param[out] outWidth   Frame width
+            /// @param[out] outHeight  Frame height
+            /// @returns Frame pixels (RGBA8, rows without padding) - nullptr if last frame was black or if no frame was presented
+            virtual const uint32_t* getPresentedFrame(uint32_t& outWidth, uint32_t& outHeight) const noexcept override
+            {
+                outWidth = m_width;
+                outHeight = m_height;
+                return m_pPresentedFrame;
+            }
+
+            /// @brief Set screen upscaling applied to presented frames (frame size multiplied by factor)
+            /// @param[in] mode    Upscaling type
+            /// @param[in] factor  Requested upscaling factor (1 = no upscaling)
+            void setScreenScaling(const config::upscaling_mode_t mode, const uint32_t factor);
+            /// @brief Set screen post-processing applied to presented frames (mirroring, curvature, black borders, screen smoothing)
+            /// @param[in] screen   Screen adjustment settings (also used for output size geometry)
+            /// @param[in] scaling  Scaling / smoothing settings (screen smoothing)
+            void setScreenEffects(const config::config_screen_t& screen, const config::config_scaling_t& scaling);
+            /// @brief Set fixed output size: frames resampled to this size (ratio, stretching and cropping from screen settings)
+            /// @param[in] width   Output width (0 = upscaled display area size)
+            /// @param[in] height  Output height (0 = upscaled display area size)
+            /// @param[in] mode    Interpolation type
+            void setOutputSize(const uint32_t width, const uint32_t height, const config::interpolation_mode_t mode);
+
+            /// @brief Set callback receiving every presented frame (process-wide, set before GPUopen or between frames)
+            /// @param[in] callback   Frame callback (or nullptr to disable it)
+            /// @param[in] pUserData  User data sent to callback
+            static inline void setFrameCallback(frame_callback_t callback, void* pUserData) noexcept
+            {
+                s_frameCallback = callback;
+                s_pCallbackUserData = pUserData;
+            }
+
+
+            // -- getters -- ---------------------------------------------------
+
+            /// @brief Get last frame (RGB888)
+            inline const uint8_t* frame() const noexcept { return (m_frame.empty() == false) ? &m_frame[0] : nullptr; }
+            /// @brief Get last frame width (pixels)
+            inline uint32_t width() const noexcept { return m_width; }
+            /// @brief Get last frame height (pixels)
+            inline uint32_t height() const noexcept { return m_height; }
+            /// @brief Get number of presented frames
+            inline uint64_t frameCount() const noexcept { return m_frameCount; }
+
+
+        private:
+            /// @brief Apply screen stages to converted display area (if enabled), convert to RGB888 + call frame callback
+            /// @param[in] sourceWidth   Converted area width (m_rgbaFrame)
+            /// @param[in] sourceHeight  Converted area height
+            /// @param[in] isBlack       Display disabled (black frame)
+            void outputFrame(const uint32_t sourceWidth, const uint32_t sourceHeight, const bool isBlack);
+
+        private:
+            std::vector<uint32_t> m_rgbaFrame; ///< Converted display area (RGBA8)
+            std::vector<uint32_t> m_scaledFrame; ///< Upscaled display area (RGBA8)
+            std::unique_ptr<scaling::ScreenUpscaler> m_pUpscaler; ///< Screen upscaling (optional)
+            std::vector<uint32_t> m_resampledFrame; ///< Display area resampled to output size (RGBA8)
+            std::unique_ptr<scaling::ScreenResampler> m_pResampler; ///< Resampling to output size (optional)
+            std::vector<uint32_t> m_processedFrame; ///< Post-processed frame (RGBA8)
+            std::unique_ptr<PostProcessing> m_pPostProcessing; ///< Screen post-processing (optional)
+            config::config_screen_t m_screenSettings;   ///< Screen adjustment settings
+            config::config_scaling_t m_scalingSettings; ///< Screen smoothing settings
+            config::interpolation_mode_t m_resamplingMode; ///< Resampling interpolation type
+            uint32_t m_outputWidth;       ///< Fixed output width (0 = upscaled display area size)
+            uint32_t m_outputHeight;      ///< Fixed output height
+            const uint32_t* m_pPresentedFrame; ///< Last frame after screen stages (RGBA8: one of the frame buffers above)
+            std::vector<uint8_t> m_frame; ///< Last frame (RGB888)
+            uint32_t m_width;             ///< Last frame width
+            uint32_t m_height;            ///< Last frame height
+            uint64_t m_frameCount;        ///< Number of presented frames
+
+            static frame_callback_t s_frameCallback; ///< Frame callback
+            static void* s_pCallbackUserData;        ///< Frame callback user data
+        };
+    }
+}
@@ -0,0 +1,50 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - interface
+*******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include "../../command/display_state.h"
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @class IOutputBackend
+        /// @brief Output backend - interface (presents the display area of each frame)
+        class IOutputBackend
+        {
+        public:
+            /// @brief Destroy backend
+            virtual ~IOutputBackend() {}
+
+            /// @brief Present current frame (called on every vsync)
+            /// @param[in] pVram         Native VRAM image (1024 x 512 pixels)
+            /// @param[in] displayState  Display state (display area, color mode)
+            virtual void present(const uint16_t* pVram, const command::DisplayState& displayState) = 0;
+            /// @brief Present current frame from high resolution image (software renderer, called on every vsync)
+            /// @param[in] pHighResVram  Upscaled VRAM image (RGBA, 1024*scaleX x 512*scaleY pixels)
+            /// @param[in] scaleX        Horizontal internal resolution factor
+            /// @param[in] scaleY        Vertical internal resolution factor
+            /// @param[in] displayState  Display state (display area, color mode)
+            virtual void presentHighRes(const uint32_t* pHighResVram, const uint32_t scaleX, const uint32_t scaleY, const command::DisplayState& displayState) = 0;
+            /// @brief Present last frame again (display area unchanged since last call to present: no conversion/upload)
+            virtual void presentCached() = 0;
+
+            /// @brief Get last presented frame, after screen processing (valid until next call to present)
+            /// @param[out] outWidth   Frame width
+            /// @param[out] outHeight  Frame height
+            /// @returns Frame pixels (RGBA8, rows without padding) - nullptr if no processed frame exists (black frame, no frame yet)
+            virtual const uint32_t* getPresentedFrame(uint32_t& outWidth, uint32_t& outHeight) const noexcept = 0;
+        };
+    }
+}
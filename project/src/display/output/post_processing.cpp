@@ -0,0 +1,368 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - fused screen post-processing (remap, smoothing, color, borders) by tiles
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "remap_table.h"
+#include "post_processing.h"
+using namespace display::output;
+using config::screen_smooth_mode_t;
+
+#define TILE_BUFFER_SIZE ((POST_PROCESSING_TILE_SIZE + 2u) * (POST_PROCESSING_TILE_SIZE + 2u)) // tile + halo
+#define NOISE_AMPLITUDE  3 // max noise added to color components (screen smoothing "noise")
+
+/// @brief Current time for stage costs (nanoseconds)
+static inline uint64_t getProfilingTime() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+// -- settings -- --------------------------------------------------------------
+
+/// @brief Create settings from profile (no gamma / scanlines yet: not in profile)
+post_processing_settings_t post_processing_settings_t::fromConfig(const config::config_screen_t& screen, const config::config_scaling_t& scaling,
+                                                                  const uint32_t outputWidth, const uint32_t outputHeight) noexcept
+{
+    post_processing_settings_t settings;
+    settings.smoothing = scaling.screenSmoothing;
+    settings.isMirrored = screen.isMirrored;
+    settings.curvature = screen.curvature;
+    settings.clipX = (screen.blackBorders.x * 2u < outputWidth) ? screen.blackBorders.x : 0u;
+    settings.clipY = (screen.blackBorders.y * 2u < outputHeight) ? screen.blackBorders.y : 0u;
+    settings.clipWidth = outputWidth - settings.clipX * 2u;
+    settings.clipHeight = outputHeight - settings.clipY * 2u;
+    settings.gamma = POST_PROCESSING_GAMMA_NEUTRAL;
+    settings.scanlineIntensity = 0u;
+    return settings;
+}
+
+
+// -- pipeline compilation -- --------------------------------------------------
+
+/// @brief Create post-processing pipeline
+PostProcessing::PostProcessing(const uint32_t workerCount)
+    : m_settings(), m_width(0u), m_height(0u), m_tileColumns(0u), m_frameIndex(0u), m_isConfigured(false), m_isProfiling(false), m_isRemapped(false),
+      m_profiledFrames(0uLL), m_threadPool(workerCount)
+{
+    for (uint32_t stage = 0; stage < POST_PROCESSING_STAGE_COUNT; ++stage)
+    {
+        m_isStageEnabled[stage] = false;
+        m_stageTimes[stage] = 0uLL;
+    }
+}
+
+/// @brief Compile enabled stages (only if settings or size changed)
+bool PostProcessing::configure(const post_processing_settings_t& settings, const uint32_t width, const uint32_t height)
+{
+    if (m_isConfigured && settings == m_settings && width == m_width && height == m_height)
+        return false;
+    m_settings = settings;
+    m_width = width;
+    m_height = height;
+    m_tileColumns = (width + POST_PROCESSING_TILE_SIZE - 1u) / POST_PROCESSING_TILE_SIZE;
+    m_isConfigured = true;
+
+    // coordinate remap (curvature: remap table computed once, shared by all tiles)
+    m_sourceColumns.resize(width);
+    for (uint32_t x = 0; x < width; ++x)
+        m_sourceColumns[x] = (settings.isMirrored) ? width - 1u - x : x;
+    m_isRemapped = false;
+    if (settings.curvature != config::screen_curvature_t::none)
+    {
+        m_remapTable.build(settings.curvature, settings.isMirrored, width, height);
+        m_isRemapped = (m_remapTable.empty() == false);
+    }
+
+    // color LUTs: gamma, then scanline darkening of odd rows
+    const uint32_t intensity = (settings.scanlineIntensity > 8u) ? 8u : settings.scanlineIntensity;
+    const double exponent = (settings.gamma > 0u) ? static_cast<double>(POST_PROCESSING_GAMMA_NEUTRAL) / static_cast<double>(settings.gamma) : 1.0;
+    for (uint32_t value = 0; value < 256u; ++value)
+    {
+        const double corrected = (settings.gamma == POST_PROCESSING_GAMMA_NEUTRAL) ? static_cast<double>(value)
+                                                                                  : 255.0 * std::pow(static_cast<double>(value) / 255.0, exponent);
+        const uint32_t normal = static_cast<uint32_t>(corrected + 0.5);
+        m_colorLuts[0][value] = static_cast<uint8_t>((normal > 255u) ? 255u : normal);
+        m_colorLuts[1][value] = static_cast<uint8_t>((m_colorLuts[0][value] * (16u - intensity) + 8u) >> 4);
+    }
+
+    m_isStageEnabled[static_cast<uint32_t>(post_processing_stage_t::source)] = true;
+    m_isStageEnabled[static_cast<uint32_t>(post_processing_stage_t::smoothing)] = (settings.smoothing != screen_smooth_mode_t::none);
+    m_isStageEnabled[static_cast<uint32_t>(post_processing_stage_t::color)] = (settings.gamma != POST_PROCESSING_GAMMA_NEUTRAL || intensity > 0u);
+    m_isStageEnabled[static_cast<uint32_t>(post_processing_stage_t::output)] = true;
+    resetStats();
+    return true;
+}
+
+
+// -- stage statistics -- ------------------------------------------------------
+
+/// @brief Get average cost of a stage (CPU time of all threads, microseconds per frame)
+double PostProcessing::getStageCost(const post_processing_stage_t stage) const noexcept
+{
+    return (m_profiledFrames > 0uLL) ? static_cast<double>(m_stageTimes[static_cast<uint32_t>(stage)].load()) / (1000.0 * static_cast<double>(m_profiledFrames)) : 0.0;
+}
+
+/// @brief Get stage name
+const char* PostProcessing::getStageName(const post_processing_stage_t stage) noexcept
+{
+    switch (stage)
+    {
+        case post_processing_stage_t::source:    return "source/remap";
+        case post_processing_stage_t::smoothing: return "smoothing";
+        case post_processing_stage_t::color:     return "color LUT";
+        case post_processing_stage_t::output:    return "borders/output";
+        default: return "";
+    }
+}
+
+/// @brief Reset stage costs
+void PostProcessing::resetStats() noexcept
+{
+    for (uint32_t stage = 0; stage < POST_PROCESSING_STAGE_COUNT; ++stage)
+        m_stageTimes[stage] = 0uLL;
+    m_profiledFrames = 0uLL;
+}
+
+
+// -- processing -- ------------------------------------------------------------
+
+/// @brief Process image (waits for completion)
+void PostProcessing::process(const uint32_t* pSource, uint32_t* pOut)
+{
+    if (m_isConfigured == false || m_width == 0u || m_height == 0u)
+        return;
+    const uint32_t tileCount = m_tileColumns * ((m_height + POST_PROCESSING_TILE_SIZE - 1u) / POST_PROCESSING_TILE_SIZE);
+    m_threadPool.parallelFor(tileCount, [&](const uint32_t tile)
+    {
+        processTile(pSource, pOut, tile);
+    });
+    ++m_frameIndex;
+    if (m_isProfiling)
+        ++m_profiledFrames;
+}
+
+/// @brief Process one output tile (all enabled stages)
+void PostProcessing::processTile(const uint32_t* pSource, uint32_t* pOut, const uint32_t tileIndex) noexcept
+{
+    const uint32_t left = (tileIndex % m_tileColumns) * POST_PROCESSING_TILE_SIZE;
+    const uint32_t top = (tileIndex / m_tileColumns) * POST_PROCESSING_TILE_SIZE;
+    const uint32_t width = (left + POST_PROCESSING_TILE_SIZE < m_width) ? POST_PROCESSING_TILE_SIZE : m_width - left;
+    const uint32_t height = (top + POST_PROCESSING_TILE_SIZE < m_height) ? POST_PROCESSING_TILE_SIZE : m_height - top;
+    const bool isSmoothed = m_isStageEnabled[static_cast<uint32_t>(post_processing_stage_t::smoothing)];
+    const uint32_t halo = (isSmoothed && m_settings.smoothing != screen_smooth_mode_t::noise) ? 1u : 0u;
+
+    uint32_t input[TILE_BUFFER_SIZE];
+    uint32_t filtered[POST_PROCESSING_TILE_SIZE * POST_PROCESSING_TILE_SIZE];
+    uint64_t times[POST_PROCESSING_STAGE_COUNT + 1u];
+    times[0] = (m_isProfiling) ? getProfilingTime() : 0uLL;
+
+    fetchTile(pSource, left, top, width, height, halo, input);
+    times[1] = (m_isProfiling) ? getProfilingTime() : 0uLL;
+
+    uint32_t* pTile = input;
+    if (isSmoothed)
+    {
+        smoothTile(input, left, top, width, height, filtered);
+        pTile = filtered;
+    }
+    times[2] = (m_isProfiling) ? getProfilingTime() : 0uLL;
+
+    if (m_isStageEnabled[static_cast<uint32_t>(post_processing_stage_t::color)])
+        colorTile(pTile, top, width, height);
+    times[3] = (m_isProfiling) ? getProfilingTime() : 0uLL;
+
+    storeTile(pTile, left, top, width, height, pOut);
+    if (m_isProfiling)
+    {
+        times[4] = getProfilingTime();
+        for (uint32_t stage = 0; stage < POST_PROCESSING_STAGE_COUNT; ++stage)
+            m_stageTimes[stage].fetch_add(times[stage + 1u] - times[stage], std::memory_order_relaxed);
+    }
+}
+
+
+// -- stages -- ----------------------------------------------------------------
+
+/// @brief Source stage - fetch tile (+ halo) from source image
+void PostProcessing::fetchTile(const uint32_t* pSource, const uint32_t left, const uint32_t top, const uint32_t width, const uint32_t height,
+                               const uint32_t halo, uint32_t* pTile) const noexcept
+{
+    const uint32_t bufferWidth = width + halo * 2u;
+    for (uint32_t row = 0; row < height + halo * 2u; ++row, pTile += bufferWidth)
+    {
+        // clamped source row/columns (halo outside of image)
+        const int32_t y = static_cast<int32_t>(top + row) - static_cast<int32_t>(halo);
+        const uint32_t* pSourceRow = pSource + static_cast<size_t>((y < 0) ? 0 : ((y >= static_cast<int32_t>(m_height)) ? m_height - 1u : static_cast<uint32_t>(y))) * m_width;
+        uint32_t col = 0;
+        if (m_isRemapped) // curvature: bilinear samples from remap table
+        {
+            const size_t rowIndex = static_cast<size_t>(pSourceRow - pSource);
+            if (halo != 0u)
+                m_remapTable.sampleRow(pSource, rowIndex + ((left > 0u) ? left - 1u : 0u), 1u, &pTile[col++]);
+            m_remapTable.sampleRow(pSource, rowIndex + left, width, &pTile[col]);
+            col += width;
+            if (halo != 0u)
+                m_remapTable.sampleRow(pSource, rowIndex + ((left + width < m_width) ? left + width : m_width - 1u), 1u, &pTile[col]);
+            continue;
+        }
+
+        if (halo != 0u)
+            pTile[col++] = pSourceRow[m_sourceColumns[(left > 0u) ? left - 1u : 0u]];
+
+        if (m_settings.isMirrored) // reversed source columns
+        {
+            uint32_t x = left;
+            #if _SIMD_SSE2
+            for (; x + 3u < left + width; x += 4u, col += 4u)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSourceRow[m_sourceColumns[x + 3u]]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&pTile[col]), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3)));
+            }
+            #endif
+            for (; x < left + width; ++x, ++col)
+                pTile[col] = pSourceRow[m_sourceColumns[x]];
+        }
+        else
+        {
+            memcpy(&pTile[col], &pSourceRow[left], width * sizeof(uint32_t));
+            col += width;
+        }
+
+        if (halo != 0u)
+            pTile[col] = pSourceRow[m_sourceColumns[(left + width < m_width) ? left + width : m_width - 1u]];
+    }
+}
+
+/// @brief Smoothing stage - 3x3 filter of tile with halo
+void PostProcessing::smoothTile(const uint32_t* pInput, const uint32_t left, const uint32_t top, const uint32_t width, const uint32_t height,
+                                uint32_t* pOut) const noexcept
+{
+    if (m_settings.smoothing == screen_smooth_mode_t::noise) // no halo: add position-based noise to color components
+    {
+        for (uint32_t row = 0; row < height; ++row)
+        {
+            for (uint32_t col = 0; col < width; ++col, ++pInput, ++pOut)
+            {
+                uint32_t hash = ((left + col) * 73856093u) ^ ((top + row) * 19349663u) ^ (m_frameIndex * 83492791u);
+                hash ^= hash >> 13;
+                const int32_t noise = static_cast<int32_t>(((hash * 0x5BD1E995u) >> 16) % (NOISE_AMPLITUDE * 2 + 1)) - NOISE_AMPLITUDE;
+                uint32_t color = *pInput & 0xFF000000u;
+                for (uint32_t shift = 0; shift < 24u; shift += 8u)
+                {
+                    int32_t component = static_cast<int32_t>((*pInput >> shift) & 0xFFu) + noise;
+                    color |= static_cast<uint32_t>((component < 0) ? 0 : ((component > 255) ? 255 : component)) << shift;
+                }
+                *pOut = color;
+            }
+        }
+        return;
+    }
+
+    // slight: (4 * center + cross) / 8 ; blur: [1 2 1] x [1 2 1] / 16
+    const bool isBlur = (m_settings.smoothing == screen_smooth_mode_t::blur);
+    const uint32_t pitch = width + 2u;
+    for (uint32_t row = 0; row < height; ++row, pOut += width)
+    {
+        const uint32_t* pAbove = pInput + static_cast<size_t>(row) * pitch; // left neighbour of first pixel
+        const uint32_t* pCenter = pAbove + pitch;
+        const uint32_t* pBelow = pCenter + pitch;
+        uint32_t col = 0;
+        #if _SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16((isBlur) ? 8 : 4);
+        for (; col + 1u < width; col += 2u) // 2 pixels (8 components)
+        {
+            #define LOAD_PIXELS(ptr) _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)), zero)
+            const __m128i center = LOAD_PIXELS(&pCenter[col + 1u]);
+            const __m128i cross = _mm_add_epi16(_mm_add_epi16(LOAD_PIXELS(&pAbove[col + 1u]), LOAD_PIXELS(&pBelow[col + 1u])),
+                                                _mm_add_epi16(LOAD_PIXELS(&pCenter[col]), LOAD_PIXELS(&pCenter[col + 2u])));
+            __m128i sum;
+            if (isBlur)
+            {
+                const __m128i corners = _mm_add_epi16(_mm_add_epi16(LOAD_PIXELS(&pAbove[col]), LOAD_PIXELS(&pAbove[col + 2u])),
+                                                      _mm_add_epi16(LOAD_PIXELS(&pBelow[col]), LOAD_PIXELS(&pBelow[col + 2u])));
+                sum = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(center, 2), _mm_slli_epi16(cross, 1)), _mm_add_epi16(corners, rounding)), 4);
+            }
+            else
+                sum = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(center, 2), cross), rounding), 3);
+            #undef LOAD_PIXELS
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&pOut[col]), _mm_packus_epi16(sum, sum));
+        }
+        #endif
+        for (; col < width; ++col)
+        {
+            uint32_t color = 0u;
+            for (uint32_t shift = 0; shift < 32u; shift += 8u)
+            {
+                #define COMPONENT(pixel) (((pixel) >> shift) & 0xFFu)
+                const uint32_t cross = COMPONENT(pAbove[col + 1u]) + COMPONENT(pBelow[col + 1u]) + COMPONENT(pCenter[col]) + COMPONENT(pCenter[col + 2u]);
+                const uint32_t value = (isBlur)
+                                     ? (COMPONENT(pCenter[col + 1u]) * 4u + cross * 2u + COMPONENT(pAbove[col]) + COMPONENT(pAbove[col + 2u])
+                                        + COMPONENT(pBelow[col]) + COMPONENT(pBelow[col + 2u]) + 8u) >> 4
+                                     : (COMPONENT(pCenter[col + 1u]) * 4u + cross + 4u) >> 3;
+                #undef COMPONENT
+                color |= value << shift;
+            }
+            pOut[col] = color;
+        }
+    }
+}
+
+/// @brief Color stage - apply row LUTs
+void PostProcessing::colorTile(uint32_t* pTile, const uint32_t top, const uint32_t width, const uint32_t height) const noexcept
+{
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        const uint8_t* pLut = m_colorLuts[(top + row) & 0x1u];
+        for (uint32_t col = 0; col < width; ++col, ++pTile)
+        {
+            const uint32_t color = *pTile;
+            *pTile = (color & 0xFF000000u) | static_cast<uint32_t>(pLut[color & 0xFFu]) | (static_cast<uint32_t>(pLut[(color >> 8) & 0xFFu]) << 8)
+                   | (static_cast<uint32_t>(pLut[(color >> 16) & 0xFFu]) << 16);
+        }
+    }
+}
+
+/// @brief Output stage - store tile with black borders
+void PostProcessing::storeTile(const uint32_t* pTile, const uint32_t left, const uint32_t top, const uint32_t width, const uint32_t height,
+                               uint32_t* pOut) const noexcept
+{
+    // visible columns of tile
+    const uint32_t clipRight = m_settings.clipX + m_settings.clipWidth;
+    const uint32_t visibleStart = (m_settings.clipX > left) ? ((m_settings.clipX < left + width) ? m_settings.clipX - left : width) : 0u;
+    const uint32_t visibleEnd = (clipRight < left + width) ? ((clipRight > left) ? clipRight - left : 0u) : width;
+
+    for (uint32_t row = 0; row < height; ++row, pTile += width)
+    {
+        uint32_t* pOutRow = pOut + static_cast<size_t>(top + row) * m_width + left;
+        const uint32_t y = top + row;
+        if (y < m_settings.clipY || y >= m_settings.clipY + m_settings.clipHeight || visibleStart >= visibleEnd)
+        {
+            for (uint32_t col = 0; col < width; ++col)
+                pOutRow[col] = POST_PROCESSING_BLACK;
+            continue;
+        }
+        for (uint32_t col = 0; col < visibleStart; ++col)
+            pOutRow[col] = POST_PROCESSING_BLACK;
+        memcpy(&pOutRow[visibleStart], &pTile[visibleStart], (visibleEnd - visibleStart) * sizeof(uint32_t));
+        for (uint32_t col = visibleEnd; col < width; ++col)
+            pOutRow[col] = POST_PROCESSING_BLACK;
+    }
+}
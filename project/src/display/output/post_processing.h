@@ -0,0 +1,155 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - fused screen post-processing (remap, smoothing, color, borders) by tiles
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "remap_table.h"
+
+#define POST_PROCESSING_TILE_SIZE     64u  // output tile width/height (tile buffers stay in L1/L2 cache)
+#define POST_PROCESSING_STAGE_COUNT   4u
+#define POST_PROCESSING_GAMMA_NEUTRAL 100u // gamma x100
+#define POST_PROCESSING_BLACK         0xFF000000u // black borders (RGBA8)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @enum post_processing_stage_t
+        /// @brief Post-processing stages (in processing order)
+        enum class post_processing_stage_t : uint32_t
+        {
+            source = 0u,    ///< Source pixel fetch + coordinate remap (mirroring, curvature)
+            smoothing = 1u, ///< Screen smoothing (3x3 neighbourhood)
+            color = 2u,     ///< Color LUT (gamma + scanlines folded together)
+            output = 3u     ///< Black borders + output store
+        };
+
+        /// @struct post_processing_settings_t
+        /// @brief Screen post-processing settings
+        struct post_processing_settings_t
+        {
+            config::screen_smooth_mode_t smoothing; ///< Screen smoothing type
+            bool     isMirrored;        ///< Horizontal mirroring
+            config::screen_curvature_t curvature; ///< CRT screen curvature
+            uint32_t clipX;             ///< Visible area left position (black borders)
+            uint32_t clipY;             ///< Visible area top position
+            uint32_t clipWidth;         ///< Visible area width
+            uint32_t clipHeight;        ///< Visible area height
+            uint32_t gamma;             ///< Gamma correction x100 (100 = neutral)
+            uint32_t scanlineIntensity; ///< Scanline darkening of odd rows (0 = none, 8 = 50%)
+
+            inline bool operator==(const post_processing_settings_t& other) const noexcept
+            {
+                return (smoothing == other.smoothing && isMirrored == other.isMirrored && curvature == other.curvature && clipX == other.clipX && clipY == other.clipY
+                     && clipWidth == other.clipWidth && clipHeight == other.clipHeight && gamma == other.gamma && scanlineIntensity == other.scanlineIntensity);
+            }
+            inline bool operator!=(const post_processing_settings_t& other) const noexcept { return !(*this == other); }
+
+            /// @brief Create settings from profile (no gamma / scanlines yet: not in profile - screen upscaling applied before pipeline)
+            /// @param[in] screen        Screen adjustment settings
+            /// @param[in] scaling       Scaling / smoothing settings
+            /// @param[in] outputWidth   Output image width
+            /// @param[in] outputHeight  Output image height
+            static post_processing_settings_t fromConfig(const config::config_screen_t& screen, const config::config_scaling_t& scaling,
+                                                         const uint32_t outputWidth, const uint32_t outputHeight) noexcept;
+        };
+
+
+        /// @class PostProcessing
+        /// @brief Screen post-processing - enabled stages compiled into a single pass over 64x64 output tiles (processed by a thread pool)
+        /// @details Each tile is fetched once from the source image (+ 1 pixel halo for smoothing), processed by every stage in a tile buffer,
+        ///          then stored once in the output image. Color corrections are folded into one LUT per row type (scanlines).
+        ///          Screen upscaling (screenScaling) is not a stage: it changes the image size and its pixel-art scalers read neighbourhoods
+        ///          wider than a tile halo, so it runs as a separate pass before this pipeline (see HeadlessOutput).
+        class PostProcessing
+        {
+        public:
+            /// @brief Create post-processing pipeline
+            /// @param[in] workerCount  Number of worker threads (0 = one per hardware thread, except caller thread)
+            PostProcessing(const uint32_t workerCount = 0u);
+            // no copy allowed
+            PostProcessing(const PostProcessing& other) = delete;
+            PostProcessing& operator=(const PostProcessing& other) = delete;
+
+            /// @brief Compile enabled stages (only if settings or size changed)
+            /// @param[in] settings  Post-processing settings
+            /// @param[in] width     Image width
+            /// @param[in] height    Image height
+            /// @returns Pipeline recompiled (true) or reused (false)
+            bool configure(const post_processing_settings_t& settings, const uint32_t width, const uint32_t height);
+
+            /// @brief Process image (waits for completion)
+            /// @param[in] pSource  Source image (RGBA8, width x height)
+            /// @param[out] pOut    Output image (RGBA8, width x height, not the source image)
+            void process(const uint32_t* pSource, uint32_t* pOut);
+
+
+            // -- stage statistics -- ------------------------------------------
+
+            /// @brief Enable/disable stage cost measurement
+            inline void setProfiling(const bool isEnabled) noexcept { m_isProfiling = isEnabled; }
+            /// @brief Check if a stage is enabled in current pipeline
+            inline bool isStageEnabled(const post_processing_stage_t stage) const noexcept { return m_isStageEnabled[static_cast<uint32_t>(stage)]; }
+            /// @brief Get average cost of a stage (CPU time of all threads, microseconds per frame)
+            double getStageCost(const post_processing_stage_t stage) const noexcept;
+            /// @brief Get stage name
+            static const char* getStageName(const post_processing_stage_t stage) noexcept;
+            /// @brief Reset stage costs
+            void resetStats() noexcept;
+
+            /// @brief Get number of threads used for each image (workers + caller thread)
+            inline uint32_t concurrency() const noexcept { return m_threadPool.concurrency(); }
+
+
+        private:
+            /// @brief Process one output tile (all enabled stages)
+            void processTile(const uint32_t* pSource, uint32_t* pOut, const uint32_t tileIndex) noexcept;
+
+            /// @brief Source stage - fetch tile (+ halo) from source image
+            void fetchTile(const uint32_t* pSource, const uint32_t left, const uint32_t top, const uint32_t width, const uint32_t height,
+                           const uint32_t halo, uint32_t* pTile) const noexcept;
+            /// @brief Smoothing stage - 3x3 filter of tile with halo
+            void smoothTile(const uint32_t* pInput, const uint32_t left, const uint32_t top, const uint32_t width, const uint32_t height,
+                            uint32_t* pOut) const noexcept;
+            /// @brief Color stage - apply row LUTs
+            void colorTile(uint32_t* pTile, const uint32_t top, const uint32_t width, const uint32_t height) const noexcept;
+            /// @brief Output stage - store tile with black borders
+            void storeTile(const uint32_t* pTile, const uint32_t left, const uint32_t top, const uint32_t width, const uint32_t height,
+                           uint32_t* pOut) const noexcept;
+
+
+        private:
+            post_processing_settings_t m_settings;         ///< Current settings
+            uint32_t m_width;                              ///< Image width
+            uint32_t m_height;                             ///< Image height
+            uint32_t m_tileColumns;                        ///< Number of tiles per row
+            uint32_t m_frameIndex;                         ///< Processed frames (noise seed)
+            bool m_isConfigured;                           ///< Pipeline compiled
+            bool m_isProfiling;                            ///< Stage cost measurement
+            bool m_isStageEnabled[POST_PROCESSING_STAGE_COUNT]; ///< Compiled stages
+            std::vector<uint32_t> m_sourceColumns;         ///< Source column of each output column (mirroring)
+            RemapTable m_remapTable;                       ///< Source position of each output pixel (curvature + mirroring)
+            bool m_isRemapped;                             ///< Remap table used by source stage
+            uint8_t m_colorLuts[2][256];                   ///< Color LUTs (normal rows / scanline rows)
+
+            std::atomic<uint64_t> m_stageTimes[POST_PROCESSING_STAGE_COUNT]; ///< Accumulated stage costs (nanoseconds)
+            uint64_t m_profiledFrames;                     ///< Number of measured frames
+            ::utils::thread::ThreadPool m_threadPool;      ///< Tile processing threads
+        };
+    }
+}
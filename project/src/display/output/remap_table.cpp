@@ -0,0 +1,171 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - precomputed coordinate remap (CRT curvature, mirroring)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "../../config/config_common.h"
+#include "remap_table.h"
+using namespace display::output;
+using config::screen_curvature_t;
+
+#define FISHEYE_STRENGTH        0.12  // radial distortion (fisheye)
+#define CURVED_SHAPE_STRENGTH_X 0.031 // horizontal edge bending (curved shape)
+#define CURVED_SHAPE_STRENGTH_Y 0.042 // vertical edge bending (curved shape)
+#define WEIGHT_SHIFT            (REMAP_TABLE_FRACTION_BITS * 2u)
+
+
+/// @brief Compute table (only if size or settings changed)
+bool RemapTable::build(const config::screen_curvature_t curvature, const bool isMirrored, const uint32_t width, const uint32_t height)
+{
+    if (curvature == m_curvature && isMirrored == m_isMirrored && width == m_width && height == m_height && m_offsets.empty() == false)
+        return false;
+    m_curvature = curvature;
+    m_isMirrored = isMirrored;
+    m_width = width;
+    m_height = height;
+    if (width < 2u || height < 2u)
+    {
+        m_offsets.clear();
+        m_weights.clear();
+        return true;
+    }
+    m_offsets.resize(static_cast<size_t>(width) * height);
+    m_weights.resize(m_offsets.size());
+
+    const double halfWidth = static_cast<double>(width) * 0.5, halfHeight = static_cast<double>(height) * 0.5;
+    const int64_t maxFixedX = static_cast<int64_t>(width - 1u) << REMAP_TABLE_FRACTION_BITS;
+    const int64_t maxFixedY = static_cast<int64_t>(height - 1u) << REMAP_TABLE_FRACTION_BITS;
+
+    size_t index = 0;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const double v = (static_cast<double>(y) + 0.5) / halfHeight - 1.0; // [-1; 1]
+        for (uint32_t x = 0; x < width; ++x, ++index)
+        {
+            double u = (static_cast<double>(x) + 0.5) / halfWidth - 1.0;
+            if (isMirrored)
+                u = -u;
+
+            double sourceU = u, sourceV = v;
+            switch (curvature)
+            {
+                case screen_curvature_t::fisheye:
+                {
+                    // radial distortion (middle of screen edges kept at image edges -> rounded black corners)
+                    const double distortion = (1.0 + FISHEYE_STRENGTH * (u * u + v * v)) / (1.0 + FISHEYE_STRENGTH);
+                    sourceU = u * distortion;
+                    sourceV = v * distortion;
+                    break;
+                }
+                case screen_curvature_t::curvedShape:
+                    sourceU = u * (1.0 + CURVED_SHAPE_STRENGTH_X * v * v);
+                    sourceV = v * (1.0 + CURVED_SHAPE_STRENGTH_Y * u * u);
+                    break;
+                default: break;
+            }
+            if (sourceU < -1.0 || sourceU > 1.0 || sourceV < -1.0 || sourceV > 1.0)
+            {
+                m_offsets[index] = REMAP_TABLE_OUTSIDE;
+                m_weights[index] = 0uLL;
+                continue;
+            }
+
+            // fixed-point source position (pixel centers at integer positions), clamped to keep a 2x2 quad inside of image
+            int64_t fixedX = static_cast<int64_t>(std::floor(((sourceU + 1.0) * halfWidth - 0.5) * REMAP_TABLE_FRACTION_ONE + 0.5));
+            int64_t fixedY = static_cast<int64_t>(std::floor(((sourceV + 1.0) * halfHeight - 0.5) * REMAP_TABLE_FRACTION_ONE + 0.5));
+            fixedX = (fixedX < 0) ? 0 : ((fixedX > maxFixedX) ? maxFixedX : fixedX);
+            fixedY = (fixedY < 0) ? 0 : ((fixedY > maxFixedY) ? maxFixedY : fixedY);
+            uint32_t sourceX = static_cast<uint32_t>(fixedX >> REMAP_TABLE_FRACTION_BITS), fractionX = static_cast<uint32_t>(fixedX) & (REMAP_TABLE_FRACTION_ONE - 1u);
+            uint32_t sourceY = static_cast<uint32_t>(fixedY >> REMAP_TABLE_FRACTION_BITS), fractionY = static_cast<uint32_t>(fixedY) & (REMAP_TABLE_FRACTION_ONE - 1u);
+            if (sourceX >= width - 1u) // last column -> right pixel of quad
+            {
+                sourceX = width - 2u;
+                fractionX = REMAP_TABLE_FRACTION_ONE;
+            }
+            if (sourceY >= height - 1u)
+            {
+                sourceY = height - 2u;
+                fractionY = REMAP_TABLE_FRACTION_ONE;
+            }
+            m_offsets[index] = sourceY * width + sourceX;
+            const uint64_t left = REMAP_TABLE_FRACTION_ONE - fractionX;
+            m_weights[index] = (left * (REMAP_TABLE_FRACTION_ONE - fractionY)) | (static_cast<uint64_t>(fractionX * (REMAP_TABLE_FRACTION_ONE - fractionY)) << 16)
+                             | ((left * fractionY) << 32) | (static_cast<uint64_t>(fractionX * fractionY) << 48);
+        }
+    }
+    return true;
+}
+
+#if _SIMD_SSE2
+/// @brief Bilinear blend of a 2x2 source quad (result: 4 x int32 components)
+/// @param[in] pQuad    Top-left pixel of quad
+/// @param[in] width    Source image width
+/// @param[in] weights  Bilinear weights (top-left, top-right, bottom-left, bottom-right)
+static inline __m128i blendQuad(const uint32_t* pQuad, const uint32_t width, const uint64_t weights) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightPairs = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&weights));
+
+    // pixel pairs (left/right) of top and bottom rows: r0 r1 g0 g1 b0 b1 a0 a1 * w0 w1
+    __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pQuad)), zero);
+    __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pQuad + width)), zero);
+    top = _mm_madd_epi16(_mm_unpacklo_epi16(top, _mm_srli_si128(top, 8)), _mm_shuffle_epi32(weightPairs, _MM_SHUFFLE(0, 0, 0, 0)));
+    bottom = _mm_madd_epi16(_mm_unpacklo_epi16(bottom, _mm_srli_si128(bottom, 8)), _mm_shuffle_epi32(weightPairs, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(top, bottom), _mm_set1_epi32(1 << (WEIGHT_SHIFT - 1u))), WEIGHT_SHIFT);
+}
+#endif
+
+/// @brief Sample contiguous output pixels of a row
+void RemapTable::sampleRow(const uint32_t* pSource, const size_t index, const uint32_t length, uint32_t* pOut) const noexcept
+{
+    const uint32_t* pOffset = &m_offsets[index];
+    const uint64_t* pWeights = &m_weights[index];
+    uint32_t i = 0;
+    #if _SIMD_SSE2
+    const __m128i black = _mm_cvtsi32_si128(static_cast<int32_t>(REMAP_TABLE_BLACK));
+    const __m128i blackComponents = _mm_unpacklo_epi16(_mm_unpacklo_epi8(black, _mm_setzero_si128()), _mm_setzero_si128());
+    for (; i + 1u < length; i += 2u) // 2 pixels per store
+    {
+        const __m128i first = (pOffset[i] != REMAP_TABLE_OUTSIDE) ? blendQuad(pSource + pOffset[i], m_width, pWeights[i]) : blackComponents;
+        const __m128i second = (pOffset[i + 1u] != REMAP_TABLE_OUTSIDE) ? blendQuad(pSource + pOffset[i + 1u], m_width, pWeights[i + 1u]) : blackComponents;
+        const __m128i channels = _mm_packs_epi32(first, second);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&pOut[i]), _mm_packus_epi16(channels, channels));
+    }
+    #endif
+    for (; i < length; ++i)
+    {
+        if (pOffset[i] == REMAP_TABLE_OUTSIDE)
+        {
+            pOut[i] = REMAP_TABLE_BLACK;
+            continue;
+        }
+        #if _SIMD_SSE2
+        __m128i sum = blendQuad(pSource + pOffset[i], m_width, pWeights[i]);
+        sum = _mm_packs_epi32(sum, sum);
+        pOut[i] = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+        #else
+        const uint32_t* pQuad = pSource + pOffset[i];
+        const uint32_t pixels[4] = { pQuad[0], pQuad[1], pQuad[m_width], pQuad[m_width + 1u] };
+        uint32_t color = 0u;
+        for (uint32_t shift = 0; shift < 32u; shift += 8u)
+        {
+            uint32_t sum = (1u << (WEIGHT_SHIFT - 1u));
+            for (uint32_t corner = 0; corner < 4u; ++corner)
+                sum += static_cast<uint32_t>((pWeights[i] >> (corner * 16u)) & 0xFFFFu) * ((pixels[corner] >> shift) & 0xFFu);
+            color |= (sum >> WEIGHT_SHIFT) << shift;
+        }
+        pOut[i] = color;
+        #endif
+    }
+}
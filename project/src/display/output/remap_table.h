@@ -0,0 +1,70 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - precomputed coordinate remap (CRT curvature, mirroring)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../config/config_common.h"
+
+#define REMAP_TABLE_OUTSIDE       0xFFFFFFFFu // output pixel outside of curved screen (black)
+#define REMAP_TABLE_FRACTION_BITS 7u          // bilinear fraction precision (weights: 2 x 7 bits = 14 bits)
+#define REMAP_TABLE_FRACTION_ONE  (1u << REMAP_TABLE_FRACTION_BITS)
+#define REMAP_TABLE_BLACK         0xFF000000u
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @class RemapTable
+        /// @brief Coordinate remap table - source position of each output pixel (top-left source offset + bilinear weights)
+        /// @details Computed once per size/settings change, then read-only: shared by all threads processing a frame.
+        ///          Sampling only does 2 paired loads and a fixed-point blend per pixel (no trigonometry/division).
+        class RemapTable
+        {
+        public:
+            RemapTable() noexcept : m_width(0u), m_height(0u), m_curvature(config::screen_curvature_t::none), m_isMirrored(false) {}
+
+            /// @brief Compute table (only if size or settings changed)
+            /// @param[in] curvature   Screen curvature type
+            /// @param[in] isMirrored  Horizontal mirroring
+            /// @param[in] width       Image width (source and output, min 2)
+            /// @param[in] height      Image height (source and output, min 2)
+            /// @returns Table recomputed (true) or reused (false)
+            bool build(const config::screen_curvature_t curvature, const bool isMirrored, const uint32_t width, const uint32_t height);
+
+            /// @brief Sample contiguous output pixels of a row
+            /// @param[in] pSource  Source image (width x height)
+            /// @param[in] index    Index of first output pixel (y * width + x)
+            /// @param[in] length   Number of output pixels
+            /// @param[out] pOut    Destination pixels
+            void sampleRow(const uint32_t* pSource, const size_t index, const uint32_t length, uint32_t* pOut) const noexcept;
+
+            /// @brief Check if table contains data
+            inline bool empty() const noexcept { return m_offsets.empty(); }
+            /// @brief Get source offset of each output pixel (top-left of bilinear quad, or REMAP_TABLE_OUTSIDE)
+            inline const std::vector<uint32_t>& offsets() const noexcept { return m_offsets; }
+            /// @brief Get bilinear weights of each output pixel (4 x 16 bits: top-left, top-right, bottom-left, bottom-right - sum = 1 << 14)
+            inline const std::vector<uint64_t>& weights() const noexcept { return m_weights; }
+
+
+        private:
+            std::vector<uint32_t> m_offsets;   ///< Source offset of each output pixel
+            std::vector<uint64_t> m_weights;   ///< Bilinear weights of each output pixel
+            uint32_t m_width;                  ///< Image width
+            uint32_t m_height;                 ///< Image height
+            config::screen_curvature_t m_curvature; ///< Screen curvature type
+            bool m_isMirrored;                 ///< Horizontal mirroring
+        };
+    }
+}
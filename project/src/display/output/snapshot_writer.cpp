@@ -0,0 +1,255 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - asynchronous snapshot writer (captured on vsync, encoded/written by background thread)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std::literals::string_literals;
+#include "../../command/display_state.h"
+#include "../../events/utils/file_io.h"
+#include "../../utils/io/mapped_file.h"
+#include "display_kernels.h"
+#include "snapshot_writer.h"
+using namespace display::output;
+
+#ifdef _WINDOWS
+#define SNAPSHOT_SEPARATOR "\\"
+#else
+#define SNAPSHOT_SEPARATOR "/"
+#endif
+#define BITMAP_HEADER_SIZE 54u // file header (14) + info header (40)
+
+
+/// @brief Create snapshot writer (allocate buffer pool + start writer thread)
+SnapshotWriter::SnapshotWriter(const std::string& directoryPath)
+    : m_directoryPath(directoryPath), m_nextIndex(1u), m_isRequested(false), m_freeCount(SNAPSHOT_QUEUE_SIZE), m_pendingFirst(0u), m_pendingCount(0u),
+      m_isWriting(false), m_isRunning(true), m_writtenCount(0uLL), m_droppedCount(0uLL), m_failedCount(0uLL)
+{
+    // preallocated pool: no allocation during capture (unless frames are bigger than native display area)
+    for (uint32_t i = 0; i < SNAPSHOT_QUEUE_SIZE; ++i)
+    {
+        m_buffers[i].pixels.resize(SNAPSHOT_POOL_PIXELS);
+        m_buffers[i].width = m_buffers[i].height = 0u;
+        m_freeBuffers[i] = i;
+    }
+    m_writerThread = std::thread(&SnapshotWriter::runWriter, this);
+}
+
+/// @brief Write pending snapshots, then stop writer thread
+SnapshotWriter::~SnapshotWriter()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_queueLock);
+        m_isRunning = false;
+    }
+    m_queueCondition.notify_all();
+    if (m_writerThread.joinable())
+        m_writerThread.join();
+}
+
+/// @brief Get default snapshot directory (writable path + SNAPSHOT_DIRECTORY)
+std::string SnapshotWriter::getDefaultDirectoryPath()
+{
+    return events::utils::FileIO::getWritableFilePath() + SNAPSHOT_DIRECTORY;
+}
+
+
+// -- capture (vsync) -- -------------------------------------------------------
+
+/// @brief Capture native display area if a snapshot was requested (copy to pooled buffer, no encoding)
+bool SnapshotWriter::captureDisplayArea(const uint16_t* pVram, const command::DisplayState& displayState)
+{
+    if (isRequested() == false)
+        return false;
+    m_isRequested.store(false, std::memory_order_relaxed);
+
+    const uint32_t width = displayState.displayWidth(), height = displayState.displayHeight();
+    if (pVram == nullptr || width == 0u || height == 0u || command::DisplayState::isDisplayEnabled() == false)
+        return false;
+    snapshot_buffer_t* pBuffer = acquireBuffer();
+    if (pBuffer == nullptr)
+        return false;
+
+    pBuffer->width = width;
+    pBuffer->height = height;
+    if (command::DisplayState::isRgb24())
+        DisplayKernels::convertRgb24(pVram, displayState.displayX(), displayState.displayY(), width, height, &pBuffer->pixels[0], width);
+    else
+        DisplayKernels::convertRgb15(pVram, displayState.displayX(), displayState.displayY(), width, height, &pBuffer->pixels[0], width);
+    submitBuffer(pBuffer);
+    return true;
+}
+
+/// @brief Capture processed frame if a snapshot was requested (copy to pooled buffer, no encoding)
+bool SnapshotWriter::captureFrame(const uint32_t* pRgba, const uint32_t width, const uint32_t height, const size_t pitch)
+{
+    if (isRequested() == false)
+        return false;
+    m_isRequested.store(false, std::memory_order_relaxed);
+
+    if (pRgba == nullptr || width == 0u || height == 0u)
+        return false;
+    snapshot_buffer_t* pBuffer = acquireBuffer();
+    if (pBuffer == nullptr)
+        return false;
+
+    pBuffer->width = width;
+    pBuffer->height = height;
+    if (pBuffer->pixels.size() < static_cast<size_t>(width) * height)
+        pBuffer->pixels.resize(static_cast<size_t>(width) * height); // kept in pool for next snapshots
+    uint32_t* pOut = &pBuffer->pixels[0];
+    for (uint32_t row = 0; row < height; ++row, pRgba += pitch, pOut += width)
+        memcpy(pOut, pRgba, width * sizeof(uint32_t));
+    submitBuffer(pBuffer);
+    return true;
+}
+
+/// @brief Get free buffer from pool (or nullptr if all buffers are queued)
+SnapshotWriter::snapshot_buffer_t* SnapshotWriter::acquireBuffer() noexcept
+{
+    std::lock_guard<std::mutex> guard(m_queueLock);
+    if (m_freeCount == 0u)
+    {
+        ++m_droppedCount;
+        return nullptr;
+    }
+    return &m_buffers[m_freeBuffers[--m_freeCount]];
+}
+
+/// @brief Queue captured buffer for encoding
+void SnapshotWriter::submitBuffer(snapshot_buffer_t* pBuffer)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_queueLock);
+        m_pendingBuffers[(m_pendingFirst + m_pendingCount) % SNAPSHOT_QUEUE_SIZE] = static_cast<uint32_t>(pBuffer - m_buffers);
+        ++m_pendingCount;
+    }
+    m_queueCondition.notify_one();
+}
+
+/// @brief Wait until all queued snapshots are written
+void SnapshotWriter::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_queueLock);
+    m_idleCondition.wait(lock, [this]() { return (m_pendingCount == 0u && m_isWriting == false); });
+}
+
+
+// -- encoding/writing (writer thread) -- --------------------------------------
+
+/// @brief Writer thread loop
+void SnapshotWriter::runWriter()
+{
+    std::vector<uint8_t> encoded; // reused between snapshots
+    std::unique_lock<std::mutex> lock(m_queueLock);
+    while (true)
+    {
+        m_queueCondition.wait(lock, [this]() { return (m_pendingCount > 0u || m_isRunning == false); });
+        if (m_pendingCount == 0u) // stopped + queue empty
+            break;
+
+        const uint32_t bufferIndex = m_pendingBuffers[m_pendingFirst];
+        m_pendingFirst = (m_pendingFirst + 1u) % SNAPSHOT_QUEUE_SIZE;
+        --m_pendingCount;
+        m_isWriting = true;
+        lock.unlock();
+
+        bool isWritten;
+        try
+        {
+            isWritten = writeSnapshot(m_buffers[bufferIndex], encoded);
+        }
+        catch (...) { isWritten = false; } // allocation failure
+        if (isWritten)
+            ++m_writtenCount;
+        else
+            ++m_failedCount;
+
+        lock.lock();
+        m_freeBuffers[m_freeCount++] = bufferIndex;
+        m_isWriting = false;
+        m_idleCondition.notify_all();
+    }
+}
+
+/// @brief Store 16-bit/32-bit little-endian value
+static inline void storeLittleEndian(uint8_t* pOut, const uint32_t value, const uint32_t bytes) noexcept
+{
+    for (uint32_t i = 0; i < bytes; ++i)
+        pOut[i] = static_cast<uint8_t>(value >> (i * 8u));
+}
+
+/// @brief Encode buffer as 24-bit BMP and write it in a new file (writer thread)
+bool SnapshotWriter::writeSnapshot(const snapshot_buffer_t& buffer, std::vector<uint8_t>& encoded)
+{
+    // 24-bit BMP: bottom-up BGR rows, padded to 4 bytes
+    const uint32_t rowBytes = (buffer.width * 3u + 3u) & ~0x3u;
+    const uint32_t imageBytes = rowBytes * buffer.height;
+    encoded.assign(BITMAP_HEADER_SIZE + imageBytes, 0u);
+    uint8_t* pHeader = &encoded[0];
+    pHeader[0] = 'B';
+    pHeader[1] = 'M';
+    storeLittleEndian(&pHeader[2], BITMAP_HEADER_SIZE + imageBytes, 4u); // file size
+    storeLittleEndian(&pHeader[10], BITMAP_HEADER_SIZE, 4u); // pixel data offset
+    storeLittleEndian(&pHeader[14], 40u, 4u);                // info header size
+    storeLittleEndian(&pHeader[18], buffer.width, 4u);
+    storeLittleEndian(&pHeader[22], buffer.height, 4u);
+    storeLittleEndian(&pHeader[26], 1u, 2u);                 // planes
+    storeLittleEndian(&pHeader[28], 24u, 2u);                // bits per pixel
+    storeLittleEndian(&pHeader[34], imageBytes, 4u);
+    storeLittleEndian(&pHeader[38], 2835u, 4u);              // 72 DPI
+    storeLittleEndian(&pHeader[42], 2835u, 4u);
+    for (uint32_t row = 0; row < buffer.height; ++row)
+    {
+        const uint32_t* pPixel = &buffer.pixels[static_cast<size_t>(buffer.height - 1u - row) * buffer.width];
+        uint8_t* pOut = &encoded[BITMAP_HEADER_SIZE + static_cast<size_t>(row) * rowBytes];
+        for (uint32_t col = 0; col < buffer.width; ++col, ++pPixel, pOut += 3)
+        {
+            pOut[0] = static_cast<uint8_t>(*pPixel >> 16);
+            pOut[1] = static_cast<uint8_t>(*pPixel >> 8);
+            pOut[2] = static_cast<uint8_t>(*pPixel);
+        }
+    }
+
+    // first unused file name (never overwrite previous snapshots)
+    if (::utils::io::MappedFile::createDirectory(m_directoryPath) == false)
+        return false;
+    std::string filePath;
+    for (; m_nextIndex <= SNAPSHOT_MAX_INDEX; ++m_nextIndex)
+    {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), SNAPSHOT_FILE_PREFIX "%05u.bmp", m_nextIndex);
+        filePath = m_directoryPath + SNAPSHOT_SEPARATOR + fileName;
+        std::ifstream existingFile(filePath, std::ios::binary);
+        if (existingFile.is_open() == false)
+            break;
+    }
+    if (m_nextIndex > SNAPSHOT_MAX_INDEX)
+        return false;
+    ++m_nextIndex;
+
+    // single sequential write
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (file.is_open() == false)
+        return false;
+    file.write(reinterpret_cast<const char*>(&encoded[0]), static_cast<std::streamsize>(encoded.size()));
+    file.close();
+    if (file.fail())
+        return false;
+    m_lastFilePath = filePath;
+    return true;
+}
@@ -0,0 +1,138 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : output backend - asynchronous snapshot writer (captured on vsync, encoded/written by background thread)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "../../command/display_state.h"
+
+#define SNAPSHOT_DIRECTORY    "snap"          // snapshot directory (in writable path)
+#define SNAPSHOT_FILE_PREFIX  "pandoraGS_"    // snapshot file names: prefix + 5-digit index + ".bmp"
+#define SNAPSHOT_QUEUE_SIZE   4u              // max number of captured snapshots waiting for encoding (bursts)
+#define SNAPSHOT_MAX_INDEX    99999u
+#define SNAPSHOT_POOL_PIXELS  (1024u * 512u)  // pixels preallocated per buffer (max native display area)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.output
+    /// Frame output backends
+    namespace output
+    {
+        /// @class SnapshotWriter
+        /// @brief Asynchronous snapshot writer - requested snapshots are copied into pooled buffers on next vsync,
+        ///        then encoded (24-bit BMP) and written by a background thread
+        /// @details Capture never blocks on encoding/disk: if every pooled buffer is still queued, the snapshot is dropped (see droppedCount).
+        class SnapshotWriter
+        {
+        public:
+            /// @brief Create snapshot writer (allocate buffer pool + start writer thread)
+            /// @param[in] directoryPath  Destination directory (created on first snapshot if necessary)
+            explicit SnapshotWriter(const std::string& directoryPath);
+            /// @brief Write pending snapshots, then stop writer thread
+            ~SnapshotWriter();
+            // no copy/move allowed
+            SnapshotWriter(const SnapshotWriter& other) = delete;
+            SnapshotWriter(SnapshotWriter&& other) = delete;
+            SnapshotWriter& operator=(const SnapshotWriter& other) = delete;
+            SnapshotWriter& operator=(SnapshotWriter&& other) = delete;
+
+            /// @brief Get default snapshot directory (writable path + SNAPSHOT_DIRECTORY)
+            static std::string getDefaultDirectoryPath();
+
+            /// @brief Request snapshot of next frame (any thread)
+            inline void request() noexcept { m_isRequested.store(true, std::memory_order_release); }
+            /// @brief Check if a snapshot is waiting for next frame
+            inline bool isRequested() const noexcept { return m_isRequested.load(std::memory_order_acquire); }
+
+
+            // -- capture (vsync) -- -------------------------------------------
+
+            /// @brief Capture native display area if a snapshot was requested (copy to pooled buffer, no encoding)
+            /// @param[in] pVram         Native VRAM image (1024 x 512 pixels)
+            /// @param[in] displayState  Display state (display area, color mode)
+            /// @returns Snapshot queued (false if not requested, display disabled or no buffer available)
+            bool captureDisplayArea(const uint16_t* pVram, const command::DisplayState& displayState);
+            /// @brief Capture processed frame if a snapshot was requested (copy to pooled buffer, no encoding)
+            /// @param[in] pRgba   Frame pixels (RGBA8)
+            /// @param[in] width   Frame width
+            /// @param[in] height  Frame height
+            /// @param[in] pitch   Distance between two frame rows (pixels)
+            /// @returns Snapshot queued (false if not requested, empty frame or no buffer available)
+            bool captureFrame(const uint32_t* pRgba, const uint32_t width, const uint32_t height, const size_t pitch);
+
+            /// @brief Wait until all queued snapshots are written
+            void waitIdle();
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Get number of written snapshot files
+            inline uint64_t writtenCount() const noexcept { return m_writtenCount.load(); }
+            /// @brief Get number of dropped snapshots (no buffer available when frame was captured)
+            inline uint64_t droppedCount() const noexcept { return m_droppedCount.load(); }
+            /// @brief Get number of snapshots that couldn't be written (directory or file error)
+            inline uint64_t failedCount() const noexcept { return m_failedCount.load(); }
+            /// @brief Get path of last written snapshot file (call waitIdle first to avoid concurrent writes)
+            inline const std::string& lastFilePath() const noexcept { return m_lastFilePath; }
+
+
+        private:
+            /// @struct snapshot_buffer_t
+            /// @brief Pooled snapshot buffer
+            struct snapshot_buffer_t
+            {
+                std::vector<uint32_t> pixels; ///< Captured pixels (RGBA8, width x height)
+                uint32_t width;               ///< Captured width
+                uint32_t height;              ///< Captured height
+            };
+
+            /// @brief Get free buffer from pool (or nullptr if all buffers are queued)
+            snapshot_buffer_t* acquireBuffer() noexcept;
+            /// @brief Queue captured buffer for encoding
+            void submitBuffer(snapshot_buffer_t* pBuffer);
+            /// @brief Writer thread loop
+            void runWriter();
+            /// @brief Encode buffer as 24-bit BMP and write it in a new file (writer thread)
+            bool writeSnapshot(const snapshot_buffer_t& buffer, std::vector<uint8_t>& encoded);
+
+
+        private:
+            std::string m_directoryPath;                   ///< Destination directory
+            std::string m_lastFilePath;                    ///< Last written file
+            uint32_t m_nextIndex;                          ///< Next file index to try
+            std::atomic<bool> m_isRequested;               ///< Snapshot requested for next frame
+
+            snapshot_buffer_t m_buffers[SNAPSHOT_QUEUE_SIZE]; ///< Buffer pool
+            uint32_t m_freeBuffers[SNAPSHOT_QUEUE_SIZE];   ///< Free buffer indexes (stack)
+            uint32_t m_freeCount;                          ///< Number of free buffers
+            uint32_t m_pendingBuffers[SNAPSHOT_QUEUE_SIZE]; ///< Queued buffer indexes (ring)
+            uint32_t m_pendingFirst;                       ///< First queued buffer position in ring
+            uint32_t m_pendingCount;                       ///< Number of queued buffers
+            bool m_isWriting;                              ///< Writer thread is encoding/writing a buffer
+            bool m_isRunning;                              ///< Writer thread active
+
+            std::atomic<uint64_t> m_writtenCount;          ///< Written snapshot files
+            std::atomic<uint64_t> m_droppedCount;          ///< Dropped snapshots
+            std::atomic<uint64_t> m_failedCount;           ///< Write failures
+
+            std::mutex m_queueLock;                        ///< Queue/pool protection (never held during encoding/writing)
+            std::condition_variable m_queueCondition;      ///< New queued buffer / stop request
+            std::condition_variable m_idleCondition;       ///< Buffer written
+            std::thread m_writerThread;                    ///< Encoding/writing thread
+        };
+    }
+}
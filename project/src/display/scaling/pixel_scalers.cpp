@@ -0,0 +1,648 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : pixel-art upscaling kernels (2xSaI, xBR, xBRZ) - strip processing
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "../../config/config_common.h"
+#include "pixel_scalers.h"
+using namespace display::scaling;
+using config::upscaling_mode_t;
+
+#define COVERAGE_SAMPLES     8  // samples per sub-pixel side (coverage estimation: 64 samples -> weight step of 4/256)
+#define CORNER_ROTATIONS     4  // corners processed for each pixel (bottom-right, top-right, top-left, bottom-left)
+#define XBRZ_DOMINANT_RATIO  36 // xBRZ dominant gradient threshold (x10)
+#define XBRZ_STEEP_RATIO     22 // xBRZ steep line threshold (x10)
+
+
+// -- color operations -- ------------------------------------------------------
+
+/// @brief Compute weighted color distance between two distance keys (sum of byte differences)
+static inline uint32_t keyDistance(const uint64_t* pKeyA, const uint64_t* pKeyB) noexcept
+{
+    #if _SIMD_SSE2
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_sad_epu8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pKeyA)),
+                                                                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pKeyB)))));
+    #else
+    uint32_t sum = 0;
+    for (uint32_t shift = 0; shift < 64u; shift += 8u)
+    {
+        const int32_t diff = static_cast<int32_t>((*pKeyA >> shift) & 0xFFu) - static_cast<int32_t>((*pKeyB >> shift) & 0xFFu);
+        sum += static_cast<uint32_t>((diff >= 0) ? diff : -diff);
+    }
+    return sum;
+    #endif
+}
+/// @brief Check if two colors are similar
+static inline bool isKeyEqual(const uint64_t* pKeyA, const uint64_t* pKeyB) noexcept
+{
+    return (keyDistance(pKeyA, pKeyB) < PIXEL_SCALERS_EQ_LIMIT);
+}
+
+/// @brief Mix two colors (weight: 0 = dest, 256 = source)
+static inline uint32_t mixColors(const uint32_t dest, const uint32_t source, const uint32_t weight) noexcept
+{
+    const uint32_t inverse = 256u - weight;
+    const uint32_t redBlue = ((((dest & 0x00FF00FFu) * inverse) + ((source & 0x00FF00FFu) * weight)) >> 8) & 0x00FF00FFu;
+    const uint32_t greenAlpha = ((((dest >> 8) & 0x00FF00FFu) * inverse) + (((source >> 8) & 0x00FF00FFu) * weight)) & 0xFF00FF00u;
+    return (redBlue | greenAlpha);
+}
+/// @brief Mean value of two colors (2xSaI interpolation)
+static inline uint32_t interpolate2(const uint32_t a, const uint32_t b) noexcept
+{
+    return ((a & 0xFEFEFEFEu) >> 1) + ((b & 0xFEFEFEFEu) >> 1) + (a & b & 0x01010101u);
+}
+/// @brief Mean value of four colors (2xSaI interpolation)
+static inline uint32_t interpolate4(const uint32_t a, const uint32_t b, const uint32_t c, const uint32_t d) noexcept
+{
+    const uint32_t high = ((a & 0xFCFCFCFCu) >> 2) + ((b & 0xFCFCFCFCu) >> 2) + ((c & 0xFCFCFCFCu) >> 2) + ((d & 0xFCFCFCFCu) >> 2);
+    const uint32_t low = (((a & 0x03030303u) + (b & 0x03030303u) + (c & 0x03030303u) + (d & 0x03030303u)) >> 2) & 0x03030303u;
+    return high + low;
+}
+
+
+// -- blending patterns -- -----------------------------------------------------
+
+/// @enum blend_pattern_t
+/// @brief Area blended with a neighbour color, in a corner of the output block
+enum blend_pattern_t : uint32_t
+{
+    none = 0u,            ///< No blending
+    corner = 1u,          ///< Rounded corner (xBRZ)
+    diagonalInner = 2u,   ///< Small 45 degree edge (xBR weak edge)
+    diagonal = 3u,        ///< 45 degree edge
+    shallow = 4u,         ///< Shallow edge (~27 degrees)
+    steep = 5u,           ///< Steep edge (~63 degrees)
+    steepAndShallow = 6u, ///< Shallow + steep edges
+    patternCount = 7u
+};
+
+/// @struct blend_weight_t
+/// @brief Sub-pixel of output block blended with a neighbour color
+struct blend_weight_t
+{
+    uint8_t subX;    ///< Sub-pixel column
+    uint8_t subY;    ///< Sub-pixel row
+    uint16_t weight; ///< Neighbour color weight (1 - 256)
+};
+/// @struct blend_area_t
+/// @brief Sub-pixels of output block covered by a blending pattern
+struct blend_area_t
+{
+    uint32_t count; ///< Number of covered sub-pixels
+    blend_weight_t subPixels[PIXEL_SCALERS_MAX_FACTOR * PIXEL_SCALERS_MAX_FACTOR];
+};
+/// @struct blend_tables_t
+/// @brief Blending patterns of each factor (for each corner rotation)
+struct blend_tables_t
+{
+    blend_area_t areas[PIXEL_SCALERS_MAX_FACTOR + 1u][CORNER_ROTATIONS][blend_pattern_t::patternCount];
+};
+
+// corner rotations: canonical 'right' and 'down' directions (canonical corner = bottom-right)
+static const int32_t c_pRotationRight[CORNER_ROTATIONS][2] = { { 1, 0 }, { 0, -1 }, { -1, 0 }, { 0, 1 } };
+static const int32_t c_pRotationDown[CORNER_ROTATIONS][2]  = { { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 } };
+
+/// @brief Check if a canonical position (bottom-right corner, pixel in [0;1]) is covered by a blending pattern
+static inline bool isPatternCovered(const blend_pattern_t pattern, const double x, const double y) noexcept
+{
+    switch (pattern)
+    {
+        case blend_pattern_t::corner:          return (x > 0.5 && y > 0.5 && (x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5) > 0.25);
+        case blend_pattern_t::diagonalInner:   return (x + y > 1.75);
+        case blend_pattern_t::diagonal:        return (x + y > 1.5);
+        case blend_pattern_t::shallow:         return (y + 0.5 * x > 1.0);
+        case blend_pattern_t::steep:           return (x + 0.5 * y > 1.0);
+        case blend_pattern_t::steepAndShallow: return (y + 0.5 * x > 1.0 || x + 0.5 * y > 1.0);
+        default: return false;
+    }
+}
+
+/// @brief Compute covered sub-pixels of each pattern, for each factor and rotation
+static blend_tables_t buildBlendTables() noexcept
+{
+    blend_tables_t tables;
+    memset(&tables, 0, sizeof(blend_tables_t));
+    for (uint32_t factor = 2u; factor <= PIXEL_SCALERS_MAX_FACTOR; ++factor)
+    {
+        for (uint32_t rotation = 0; rotation < CORNER_ROTATIONS; ++rotation)
+        {
+            for (uint32_t pattern = blend_pattern_t::corner; pattern < blend_pattern_t::patternCount; ++pattern)
+            {
+                blend_area_t& area = tables.areas[factor][rotation][pattern];
+                for (uint32_t subY = 0; subY < factor; ++subY)
+                {
+                    for (uint32_t subX = 0; subX < factor; ++subX)
+                    {
+                        // sample sub-pixel area -> rotate into canonical position
+                        uint32_t coveredSamples = 0;
+                        for (uint32_t sampleY = 0; sampleY < COVERAGE_SAMPLES; ++sampleY)
+                        {
+                            for (uint32_t sampleX = 0; sampleX < COVERAGE_SAMPLES; ++sampleX)
+                            {
+                                const double px = (static_cast<double>(subX) + (sampleX + 0.5) / COVERAGE_SAMPLES) / factor - 0.5;
+                                const double py = (static_cast<double>(subY) + (sampleY + 0.5) / COVERAGE_SAMPLES) / factor - 0.5;
+                                const double x = 0.5 + px * c_pRotationRight[rotation][0] + py * c_pRotationRight[rotation][1];
+                                const double y = 0.5 + px * c_pRotationDown[rotation][0] + py * c_pRotationDown[rotation][1];
+                                if (isPatternCovered(static_cast<blend_pattern_t>(pattern), x, y))
+                                    ++coveredSamples;
+                            }
+                        }
+                        if (coveredSamples > 0u)
+                        {
+                            area.subPixels[area.count] = blend_weight_t{ static_cast<uint8_t>(subX), static_cast<uint8_t>(subY),
+                                                                         static_cast<uint16_t>(coveredSamples * 256u / (COVERAGE_SAMPLES * COVERAGE_SAMPLES)) };
+                            ++area.count;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return tables;
+}
+/// @brief Get blending patterns (computed on first use - thread-safe initialization)
+static const blend_tables_t& getBlendTables() noexcept
+{
+    static const blend_tables_t tables = buildBlendTables();
+    return tables;
+}
+
+/// @brief Blend neighbour color into output block
+static inline void applyPattern(uint32_t* pBlock, const size_t outWidth, const blend_area_t& area, const uint32_t color) noexcept
+{
+    for (uint32_t i = 0; i < area.count; ++i)
+    {
+        uint32_t& subPixel = pBlock[area.subPixels[i].subY * outWidth + area.subPixels[i].subX];
+        subPixel = mixColors(subPixel, color, area.subPixels[i].weight);
+    }
+}
+
+/// @struct neighbour_offsets_t
+/// @brief Offsets of rotated neighbours in padded buffer (canonical names: e = center, f = right, h = down)
+struct neighbour_offsets_t
+{
+    ptrdiff_t a, b, c, d, f, g, h, i; ///< 3x3 kernel
+    ptrdiff_t f4, i4, h5, i5;         ///< Outer neighbours (right of f/i, below h/i)
+    uint32_t cornerBR;                ///< Corner index of canonical bottom-right corner
+    uint32_t cornerTR;                ///< Corner index of canonical top-right corner
+    uint32_t cornerBL;                ///< Corner index of canonical bottom-left corner
+};
+
+/// @brief Get corner index (0 = top-left, 1 = top-right, 2 = bottom-right, 3 = bottom-left) from direction
+static inline uint32_t toCornerIndex(const int32_t x, const int32_t y) noexcept
+{
+    return (y < 0) ? ((x < 0) ? 0u : 1u) : ((x > 0) ? 2u : 3u);
+}
+/// @brief Compute neighbour offsets of each rotation
+static void buildNeighbourOffsets(const ptrdiff_t rowPitch, neighbour_offsets_t* pOutOffsets) noexcept
+{
+    for (uint32_t rotation = 0; rotation < CORNER_ROTATIONS; ++rotation)
+    {
+        const int32_t* pRight = c_pRotationRight[rotation];
+        const int32_t* pDown = c_pRotationDown[rotation];
+        auto offset = [&](const int32_t right, const int32_t down)
+        {
+            return static_cast<ptrdiff_t>(right * pRight[1] + down * pDown[1]) * rowPitch + static_cast<ptrdiff_t>(right * pRight[0] + down * pDown[0]);
+        };
+        neighbour_offsets_t& out = pOutOffsets[rotation];
+        out.a = offset(-1, -1); out.b = offset(0, -1); out.c = offset(1, -1);
+        out.d = offset(-1, 0);                         out.f = offset(1, 0);
+        out.g = offset(-1, 1);  out.h = offset(0, 1);  out.i = offset(1, 1);
+        out.f4 = offset(2, 0); out.i4 = offset(2, 1); out.h5 = offset(0, 2); out.i5 = offset(1, 2);
+
+        out.cornerBR = toCornerIndex(pRight[0] + pDown[0], pRight[1] + pDown[1]);
+        out.cornerTR = toCornerIndex(pRight[0] - pDown[0], pRight[1] - pDown[1]);
+        out.cornerBL = toCornerIndex(pDown[0] - pRight[0], pDown[1] - pRight[1]);
+    }
+}
+
+
+// -- strip processing -- ------------------------------------------------------
+
+/// @brief Check if a mode/factor pair is supported by a single pass
+/// @param[in] mode    Upscaling type (sai: 2x ; xbr: 2x-4x ; xbrz/xbrzEnhanced: 2x-6x)
+/// @param[in] factor  Upscaling factor
+bool PixelScalers::isSupported(const config::upscaling_mode_t mode, const uint32_t factor) noexcept
+{
+    switch (mode)
+    {
+        case upscaling_mode_t::sai:  return (factor == 2u);
+        case upscaling_mode_t::xbr:  return (factor >= 2u && factor <= 4u);
+        case upscaling_mode_t::xbrz:
+        case upscaling_mode_t::xbrzEnhanced: return (factor >= 2u && factor <= PIXEL_SCALERS_MAX_FACTOR);
+        default: return false;
+    }
+}
+
+/// @brief Upscale a strip of source rows
+/// @param[in] mode       Upscaling type (must be supported with factor)
+/// @param[in] factor     Upscaling factor
+/// @param[in] pSource    Complete source image (width x height)
+/// @param[in] width      Source width
+/// @param[in] height     Source height
+/// @param[in] firstRow   First source row of strip
+/// @param[in] endRow     End of strip (excluded source row)
+/// @param[out] pOut      Complete output image (width*factor x height*factor): only rows of strip are written
+/// @param[in] buffer     Working memory (one per concurrent strip)
+void PixelScalers::scaleStrip(const config::upscaling_mode_t mode, const uint32_t factor, const uint32_t* pSource, const uint32_t width, const uint32_t height,
+                              const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, scaling_buffer_t& buffer)
+{
+    if (width == 0u || firstRow >= endRow || endRow > height)
+        return;
+    if (isSupported(mode, factor) == false)
+    {
+        scaleNearestStrip(factor, pSource, width, firstRow, endRow, pOut);
+        return;
+    }
+
+    loadPaddedRows(pSource, width, height, firstRow, endRow, (mode != upscaling_mode_t::sai), buffer);
+    switch (mode)
+    {
+        case upscaling_mode_t::sai: scaleSai(width, firstRow, endRow, pOut, buffer); break;
+        case upscaling_mode_t::xbr: scaleXbr(factor, width, firstRow, endRow, pOut, buffer); break;
+        default:                    scaleXbrz(factor, width, firstRow, endRow, pOut, buffer); break;
+    }
+}
+
+/// @brief Copy source rows of a strip (+ border) into padded buffer (+ distance keys if required)
+void PixelScalers::loadPaddedRows(const uint32_t* pSource, const uint32_t width, const uint32_t height, const uint32_t firstRow, const uint32_t endRow,
+                                  const bool useKeys, scaling_buffer_t& buffer)
+{
+    const size_t paddedWidth = width + 2u * PIXEL_SCALERS_BORDER;
+    const size_t paddedHeight = (endRow - firstRow) + 2u * PIXEL_SCALERS_BORDER;
+    buffer.colors.resize(paddedWidth * paddedHeight); // memory kept between frames
+    if (useKeys)
+        buffer.keys.resize(paddedWidth * paddedHeight);
+
+    uint32_t* pPaddedRow = &buffer.colors[0];
+    for (int32_t row = static_cast<int32_t>(firstRow) - static_cast<int32_t>(PIXEL_SCALERS_BORDER);
+         row < static_cast<int32_t>(endRow + PIXEL_SCALERS_BORDER); ++row, pPaddedRow += paddedWidth)
+    {
+        // replicate image borders
+        const int32_t sourceRow = (row < 0) ? 0 : ((row >= static_cast<int32_t>(height)) ? static_cast<int32_t>(height) - 1 : row);
+        const uint32_t* pSourceRow = pSource + static_cast<size_t>(sourceRow) * width;
+        memcpy(pPaddedRow + PIXEL_SCALERS_BORDER, pSourceRow, width * sizeof(uint32_t));
+        for (uint32_t i = 0; i < PIXEL_SCALERS_BORDER; ++i)
+        {
+            pPaddedRow[i] = pSourceRow[0];
+            pPaddedRow[paddedWidth - 1u - i] = pSourceRow[width - 1u];
+        }
+    }
+    if (useKeys)
+        toDistanceKeys(&buffer.colors[0], buffer.colors.size(), &buffer.keys[0]);
+}
+
+/// @brief Convert row of pixels to color distance keys
+/// @param[in] pColors    Source pixels (RGBA8)
+/// @param[in] length     Number of pixels
+/// @param[out] pOutKeys  Distance keys
+void PixelScalers::toDistanceKeys(const uint32_t* pColors, const size_t length, uint64_t* pOutKeys) noexcept
+{
+    size_t i = 0;
+    #if _SIMD_SSE2
+    // 16-bit arithmetic in low half of each 32-bit lane (high half stays 0)
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i chromaOffset = _mm_set1_epi32(32895);
+    for (; i + 4u <= length; i += 4u)
+    {
+        const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pColors[i]));
+        const __m128i r = _mm_and_si128(colors, byteMask);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(colors, 8), byteMask);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(colors, 16), byteMask);
+        const __m128i a = _mm_srli_epi32(colors, 24);
+
+        __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi32(77)), _mm_mullo_epi16(g, _mm_set1_epi32(150)));
+        y = _mm_srli_epi32(_mm_add_epi16(y, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi32(29)), _mm_set1_epi32(128))), 8);
+        __m128i u = _mm_add_epi16(_mm_slli_epi32(b, 7), chromaOffset);
+        u = _mm_srli_epi32(_mm_sub_epi16(_mm_sub_epi16(u, _mm_mullo_epi16(r, _mm_set1_epi32(43))), _mm_mullo_epi16(g, _mm_set1_epi32(85))), 8);
+        __m128i v = _mm_add_epi16(_mm_slli_epi32(r, 7), chromaOffset);
+        v = _mm_srli_epi32(_mm_sub_epi16(_mm_sub_epi16(v, _mm_mullo_epi16(g, _mm_set1_epi32(107))), _mm_mullo_epi16(b, _mm_set1_epi32(21))), 8);
+
+        // keys: low = YYYY, high = U V A A
+        const __m128i yy = _mm_or_si128(y, _mm_slli_epi32(y, 8));
+        const __m128i low = _mm_or_si128(yy, _mm_slli_epi32(yy, 16));
+        const __m128i high = _mm_or_si128(_mm_or_si128(u, _mm_slli_epi32(v, 8)), _mm_or_si128(_mm_slli_epi32(a, 16), _mm_slli_epi32(a, 24)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOutKeys[i]), _mm_unpacklo_epi32(low, high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOutKeys[i + 2u]), _mm_unpackhi_epi32(low, high));
+    }
+    #endif
+    for (; i < length; ++i)
+        pOutKeys[i] = toDistanceKey(pColors[i]);
+}
+
+
+// -- nearest neighbour -- -----------------------------------------------------
+
+/// @brief Duplicate each source pixel of a row (factor times)
+static inline void fillNearestRow(const uint32_t* pSourceRow, const uint32_t width, const uint32_t factor, uint32_t* pOutRow) noexcept
+{
+    uint32_t x = 0;
+    #if _SIMD_SSE2
+    if (factor == 2u)
+    {
+        for (; x + 4u <= width; x += 4u, pOutRow += 8)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSourceRow[x]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow), _mm_unpacklo_epi32(pixels, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow + 4), _mm_unpackhi_epi32(pixels, pixels));
+        }
+    }
+    else if (factor == 4u)
+    {
+        for (; x + 4u <= width; x += 4u, pOutRow += 16)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSourceRow[x]));
+            const __m128i low = _mm_unpacklo_epi32(pixels, pixels);
+            const __m128i high = _mm_unpackhi_epi32(pixels, pixels);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow), _mm_unpacklo_epi64(low, low));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow + 4), _mm_unpackhi_epi64(low, low));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow + 8), _mm_unpacklo_epi64(high, high));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutRow + 12), _mm_unpackhi_epi64(high, high));
+        }
+    }
+    #endif
+    for (; x < width; ++x)
+    {
+        for (uint32_t i = 0; i < factor; ++i)
+            *pOutRow++ = pSourceRow[x];
+    }
+}
+/// @brief Fill output rows of a source row with duplicated pixels
+static inline void fillNearestBlocks(const uint32_t* pSourceRow, const uint32_t width, const uint32_t factor, uint32_t* pOutRow) noexcept
+{
+    const size_t outWidth = static_cast<size_t>(width) * factor;
+    fillNearestRow(pSourceRow, width, factor, pOutRow);
+    for (uint32_t i = 1; i < factor; ++i)
+        memcpy(pOutRow + i * outWidth, pOutRow, outWidth * sizeof(uint32_t));
+}
+
+/// @brief Nearest neighbour upscaling of a strip (pixel duplication)
+void PixelScalers::scaleNearestStrip(const uint32_t factor, const uint32_t* pSource, const uint32_t width,
+                                     const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut) noexcept
+{
+    const size_t outWidth = static_cast<size_t>(width) * factor;
+    for (uint32_t row = firstRow; row < endRow; ++row)
+        fillNearestBlocks(pSource + static_cast<size_t>(row) * width, width, factor, pOut + static_cast<size_t>(row) * factor * outWidth);
+}
+
+
+// -- 2xSaI -- -----------------------------------------------------------------
+
+/// @brief 2xSaI neighbour comparison
+static inline int32_t getSaiResult(const uint32_t a, const uint32_t b, const uint32_t c, const uint32_t d) noexcept
+{
+    int32_t x = 0, y = 0;
+    if (a == c) ++x; else if (b == c) ++y;
+    if (a == d) ++x; else if (b == d) ++y;
+    return ((x <= 1) ? 1 : 0) - ((y <= 1) ? 1 : 0);
+}
+
+/// @brief 2xSaI (2x)
+void PixelScalers::scaleSai(const uint32_t width, const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, const scaling_buffer_t& buffer) noexcept
+{
+    const ptrdiff_t pitch = static_cast<ptrdiff_t>(width + 2u * PIXEL_SCALERS_BORDER);
+    const size_t outWidth = static_cast<size_t>(width) * 2u;
+    const uint32_t* pCenterRow = &buffer.colors[PIXEL_SCALERS_BORDER * pitch + PIXEL_SCALERS_BORDER];
+    for (uint32_t row = firstRow; row < endRow; ++row, pCenterRow += pitch)
+    {
+        uint32_t* pOutRow = pOut + static_cast<size_t>(row) * 2u * outWidth;
+        for (uint32_t x = 0; x < width; ++x, pOutRow += 2)
+        {
+            //   I E F J
+            //   G A B K
+            //   H C D L
+            //   M N O P
+            const uint32_t* p = pCenterRow + x;
+            const uint32_t I = p[-pitch - 1], E = p[-pitch], F = p[-pitch + 1], J = p[-pitch + 2];
+            const uint32_t G = p[-1],         A = p[0],      B = p[1],          K = p[2];
+            const uint32_t H = p[pitch - 1],  C = p[pitch],  D = p[pitch + 1],  L = p[pitch + 2];
+            const uint32_t M = p[2 * pitch - 1], N = p[2 * pitch], O = p[2 * pitch + 1];
+
+            uint32_t right, bottom, bottomRight;
+            if (A == D && B != C)
+            {
+                right = ((A == E && B == L) || (A == C && A == F && B != E && B == J)) ? A : interpolate2(A, B);
+                bottom = ((A == G && C == O) || (A == B && A == H && G != C && C == M)) ? A : interpolate2(A, C);
+                bottomRight = A;
+            }
+            else if (B == C && A != D)
+            {
+                right = ((B == F && A == H) || (B == E && B == D && A != F && A == I)) ? B : interpolate2(A, B);
+                bottom = ((C == H && A == F) || (C == G && C == D && A != H && A == I)) ? C : interpolate2(A, C);
+                bottomRight = B;
+            }
+            else if (A == D && B == C)
+            {
+                if (A == B)
+                    right = bottom = bottomRight = A;
+                else
+                {
+                    right = interpolate2(A, B);
+                    bottom = interpolate2(A, C);
+                    const int32_t result = getSaiResult(A, B, G, E) - getSaiResult(B, A, K, F) - getSaiResult(B, A, H, N) + getSaiResult(A, B, L, O);
+                    bottomRight = (result > 0) ? A : ((result < 0) ? B : interpolate4(A, B, C, D));
+                }
+            }
+            else
+            {
+                bottomRight = interpolate4(A, B, C, D);
+                if (A == C && A == F && B != E && B == J)      right = A;
+                else if (B == E && B == D && A != F && A == I) right = B;
+                else                                           right = interpolate2(A, B);
+                if (A == B && A == H && G != C && C == M)      bottom = A;
+                else if (C == G && C == D && A != H && A == I) bottom = C;
+                else                                           bottom = interpolate2(A, C);
+            }
+            pOutRow[0] = A;
+            pOutRow[1] = right;
+            pOutRow[outWidth] = bottom;
+            pOutRow[outWidth + 1u] = bottomRight;
+        }
+    }
+}
+
+
+// -- xBR -- -------------------------------------------------------------------
+
+/// @brief xBR level 2 (2x - 4x)
+void PixelScalers::scaleXbr(const uint32_t factor, const uint32_t width, const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, const scaling_buffer_t& buffer) noexcept
+{
+    const ptrdiff_t pitch = static_cast<ptrdiff_t>(width + 2u * PIXEL_SCALERS_BORDER);
+    const size_t outWidth = static_cast<size_t>(width) * factor;
+    neighbour_offsets_t rotations[CORNER_ROTATIONS];
+    buildNeighbourOffsets(pitch, rotations);
+    const blend_tables_t& tables = getBlendTables();
+
+    const size_t firstIndex = PIXEL_SCALERS_BORDER * pitch + PIXEL_SCALERS_BORDER;
+    for (uint32_t row = firstRow; row < endRow; ++row)
+    {
+        const uint32_t* pColors = &buffer.colors[firstIndex + (row - firstRow) * pitch];
+        const uint64_t* pKeys = &buffer.keys[firstIndex + (row - firstRow) * pitch];
+        uint32_t* pOutRow = pOut + static_cast<size_t>(row) * factor * outWidth;
+        fillNearestBlocks(pColors, width, factor, pOutRow);
+
+        for (uint32_t x = 0; x < width; ++x, ++pColors, ++pKeys, pOutRow += factor)
+        {
+            for (uint32_t rotation = 0; rotation < CORNER_ROTATIONS; ++rotation)
+            {
+                const neighbour_offsets_t& n = rotations[rotation];
+                const uint32_t E = pColors[0], F = pColors[n.f], H = pColors[n.h];
+                if (E == F || E == H)
+                    continue;
+
+                // edge direction: weighted gradients of both diagonals
+                const uint64_t* e = pKeys;
+                const uint32_t edgeWeight = keyDistance(e, e + n.c) + keyDistance(e, e + n.g) + keyDistance(e + n.i, e + n.h5)
+                                          + keyDistance(e + n.i, e + n.f4) + (keyDistance(e + n.h, e + n.f) << 2);
+                const uint32_t innerWeight = keyDistance(e + n.h, e + n.d) + keyDistance(e + n.h, e + n.i5) + keyDistance(e + n.f, e + n.i4)
+                                           + keyDistance(e + n.f, e + n.b) + (keyDistance(e, e + n.i) << 2);
+                if (edgeWeight > innerWeight)
+                    continue;
+
+                blend_pattern_t pattern = blend_pattern_t::diagonalInner;
+                const bool isEdgeAllowed = ((isKeyEqual(e + n.f, e + n.b) == false && isKeyEqual(e + n.h, e + n.d) == false)
+                                         || (isKeyEqual(e, e + n.i) && isKeyEqual(e + n.f, e + n.i4) == false && isKeyEqual(e + n.h, e + n.i5) == false)
+                                         || isKeyEqual(e, e + n.g) || isKeyEqual(e, e + n.c));
+                if (edgeWeight < innerWeight && isEdgeAllowed)
+                {
+                    const uint32_t fg = keyDistance(e + n.f, e + n.g);
+                    const uint32_t hc = keyDistance(e + n.h, e + n.c);
+                    const bool isShallow = ((fg << 1) <= hc && E != pColors[n.g] && pColors[n.d] != pColors[n.g]);
+                    const bool isSteep = (fg >= (hc << 1) && E != pColors[n.c] && pColors[n.b] != pColors[n.c]);
+                    pattern = (isShallow) ? ((isSteep) ? blend_pattern_t::steepAndShallow : blend_pattern_t::shallow)
+                                          : ((isSteep) ? blend_pattern_t::steep : blend_pattern_t::diagonal);
+                }
+                const uint32_t blendColor = (keyDistance(e, e + n.f) <= keyDistance(e, e + n.h)) ? F : H;
+                applyPattern(pOutRow, outWidth, tables.areas[factor][rotation][pattern], blendColor);
+            }
+        }
+    }
+}
+
+
+// -- xBRZ -- ------------------------------------------------------------------
+
+#define XBRZ_BLEND_NONE     0u
+#define XBRZ_BLEND_NORMAL   1u
+#define XBRZ_BLEND_DOMINANT 2u
+#define XBRZ_CORNER_TL 0u // corner bit shifts (2 bits per corner)
+#define XBRZ_CORNER_TR 2u
+#define XBRZ_CORNER_BR 4u
+#define XBRZ_CORNER_BL 6u
+
+/// @brief xBRZ (2x - 6x)
+void PixelScalers::scaleXbrz(const uint32_t factor, const uint32_t width, const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, scaling_buffer_t& buffer) noexcept
+{
+    const ptrdiff_t pitch = static_cast<ptrdiff_t>(width + 2u * PIXEL_SCALERS_BORDER);
+    const size_t outWidth = static_cast<size_t>(width) * factor;
+    neighbour_offsets_t rotations[CORNER_ROTATIONS];
+    buildNeighbourOffsets(pitch, rotations);
+    const blend_tables_t& tables = getBlendTables();
+
+    // corner blending types: analyze each 2x2 block touching a pixel of the strip (padded pixels: [-1; width] x [firstRow-1; endRow])
+    buffer.blends.assign(buffer.colors.size(), 0u);
+    const ptrdiff_t firstBlock = pitch + 1; // padded position of block (-1, firstRow - 1)
+    for (uint32_t blockRow = 0; blockRow <= endRow - firstRow; ++blockRow)
+    {
+        for (uint32_t blockX = 0; blockX <= width; ++blockX)
+        {
+            //   A B C D
+            //   E F G H    (F, G, J, K) = analyzed block
+            //   I J K L
+            //   M N O P
+            const ptrdiff_t index = firstBlock + blockRow * pitch + blockX;
+            const uint32_t* p = &buffer.colors[index];
+            const uint32_t F = p[0], G = p[1], J = p[pitch], K = p[pitch + 1];
+            if ((F == G && J == K) || (F == J && G == K))
+                continue;
+
+            const uint64_t* k = &buffer.keys[index];
+            const uint32_t jg = keyDistance(k + pitch - 1, k) + keyDistance(k, k - pitch + 1) + keyDistance(k + 2 * pitch, k + pitch + 1)
+                              + keyDistance(k + pitch + 1, k + 2) + (keyDistance(k + pitch, k + 1) << 2);
+            const uint32_t fk = keyDistance(k - 1, k + pitch) + keyDistance(k + pitch, k + 2 * pitch + 1) + keyDistance(k - pitch, k + 1)
+                              + keyDistance(k + 1, k + pitch + 2) + (keyDistance(k, k + pitch + 1) << 2);
+            uint8_t* pBlends = &buffer.blends[index];
+            if (jg < fk) // F-K diagonal edge
+            {
+                const uint8_t type = (XBRZ_DOMINANT_RATIO * jg < 10u * fk) ? XBRZ_BLEND_DOMINANT : XBRZ_BLEND_NORMAL;
+                if (F != G && F != J)
+                    pBlends[0] |= static_cast<uint8_t>(type << XBRZ_CORNER_BR);
+                if (K != J && K != G)
+                    pBlends[pitch + 1] |= static_cast<uint8_t>(type << XBRZ_CORNER_TL);
+            }
+            else if (fk < jg) // J-G diagonal edge
+            {
+                const uint8_t type = (XBRZ_DOMINANT_RATIO * fk < 10u * jg) ? XBRZ_BLEND_DOMINANT : XBRZ_BLEND_NORMAL;
+                if (J != F && J != K)
+                    pBlends[pitch] |= static_cast<uint8_t>(type << XBRZ_CORNER_TR);
+                if (G != F && G != K)
+                    pBlends[1] |= static_cast<uint8_t>(type << XBRZ_CORNER_BL);
+            }
+        }
+    }
+
+    // blend pixels of strip
+    const size_t firstIndex = PIXEL_SCALERS_BORDER * pitch + PIXEL_SCALERS_BORDER;
+    for (uint32_t row = firstRow; row < endRow; ++row)
+    {
+        const size_t rowIndex = firstIndex + (row - firstRow) * pitch;
+        const uint32_t* pColors = &buffer.colors[rowIndex];
+        const uint64_t* pKeys = &buffer.keys[rowIndex];
+        const uint8_t* pBlends = &buffer.blends[rowIndex];
+        uint32_t* pOutRow = pOut + static_cast<size_t>(row) * factor * outWidth;
+        fillNearestBlocks(pColors, width, factor, pOutRow);
+
+        for (uint32_t x = 0; x < width; ++x, ++pColors, ++pKeys, ++pBlends, pOutRow += factor)
+        {
+            const uint32_t blends = *pBlends;
+            if (blends == 0u)
+                continue;
+            for (uint32_t rotation = 0; rotation < CORNER_ROTATIONS; ++rotation)
+            {
+                const neighbour_offsets_t& n = rotations[rotation];
+                const uint32_t bottomRight = (blends >> (n.cornerBR * 2u)) & 0x3u;
+                if (bottomRight == XBRZ_BLEND_NONE)
+                    continue;
+
+                // line blending (or only rounded corner for isolated pixels and L-shapes)
+                const uint64_t* e = pKeys;
+                bool isLineBlend = true;
+                if (bottomRight < XBRZ_BLEND_DOMINANT)
+                {
+                    if (((blends >> (n.cornerTR * 2u)) & 0x3u) != XBRZ_BLEND_NONE && isKeyEqual(e, e + n.g) == false)
+                        isLineBlend = false;
+                    else if (((blends >> (n.cornerBL * 2u)) & 0x3u) != XBRZ_BLEND_NONE && isKeyEqual(e, e + n.c) == false)
+                        isLineBlend = false;
+                    else if (isKeyEqual(e, e + n.i) == false && isKeyEqual(e + n.g, e + n.h) && isKeyEqual(e + n.h, e + n.i)
+                          && isKeyEqual(e + n.i, e + n.f) && isKeyEqual(e + n.f, e + n.c))
+                        isLineBlend = false;
+                }
+
+                blend_pattern_t pattern = blend_pattern_t::corner;
+                if (isLineBlend)
+                {
+                    const uint32_t fg = keyDistance(e + n.f, e + n.g);
+                    const uint32_t hc = keyDistance(e + n.h, e + n.c);
+                    const uint32_t E = pColors[0];
+                    const bool isShallow = (XBRZ_STEEP_RATIO * fg <= 10u * hc && E != pColors[n.g] && pColors[n.d] != pColors[n.g]);
+                    const bool isSteep = (XBRZ_STEEP_RATIO * hc <= 10u * fg && E != pColors[n.c] && pColors[n.b] != pColors[n.c]);
+                    pattern = (isShallow) ? ((isSteep) ? blend_pattern_t::steepAndShallow : blend_pattern_t::shallow)
+                                          : ((isSteep) ? blend_pattern_t::steep : blend_pattern_t::diagonal);
+                }
+                const uint32_t blendColor = (keyDistance(e, e + n.f) <= keyDistance(e, e + n.h)) ? pColors[n.f] : pColors[n.h];
+                applyPattern(pOutRow, outWidth, tables.areas[factor][rotation][pattern], blendColor);
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : pixel-art upscaling kernels (2xSaI, xBR, xBRZ) - strip processing
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../config/config_common.h"
+
+#define PIXEL_SCALERS_BORDER     2u // neighbour pixels read around each source pixel (padding)
+#define PIXEL_SCALERS_MAX_FACTOR 6u // max factor of a single pass
+#define PIXEL_SCALERS_EQ_LIMIT   48u // max distance between "equal" colors (sum of distance key byte differences)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.scaling
+    /// Image upscaling
+    namespace scaling
+    {
+        /// @struct scaling_buffer_t
+        /// @brief Working memory of a strip (padded copy of source rows + color distance keys) - reused between frames
+        struct scaling_buffer_t
+        {
+            std::vector<uint32_t> colors; ///< Padded source pixels (RGBA8)
+            std::vector<uint64_t> keys;   ///< Padded color distance keys (see PixelScalers::toDistanceKey)
+            std::vector<uint8_t> blends;  ///< Corner blending types (xBRZ)
+        };
+
+
+        /// @class PixelScalers
+        /// @brief Pixel-art upscaling kernels - RGBA8 images (0xAABBGGRR), processed by strips of source rows
+        /// @details Each strip reads its neighbour rows directly from the complete source image (borders replicated):
+        ///          an image processed in several strips (any order, any thread) is identical to an image processed in one call.
+        ///          Blending patterns are computed once per factor (sub-pixel coverage), then applied with integer weights.
+        class PixelScalers
+        {
+        public:
+            /// @brief Check if a mode/factor pair is supported by a single pass
+            /// @param[in] mode    Upscaling type (sai: 2x ; xbr: 2x-4x ; xbrz/xbrzEnhanced: 2x-6x)
+            /// @param[in] factor  Upscaling factor
+            static bool isSupported(const config::upscaling_mode_t mode, const uint32_t factor) noexcept;
+
+            /// @brief Upscale a strip of source rows
+            /// @param[in] mode       Upscaling type (must be supported with factor)
+            /// @param[in] factor     Upscaling factor
+            /// @param[in] pSource    Complete source image (width x height)
+            /// @param[in] width      Source width
+            /// @param[in] height     Source height
+            /// @param[in] firstRow   First source row of strip
+            /// @param[in] endRow     End of strip (excluded source row)
+            /// @param[out] pOut      Complete output image (width*factor x height*factor): only rows of strip are written
+            /// @param[in] buffer     Working memory (one per concurrent strip)
+            static void scaleStrip(const config::upscaling_mode_t mode, const uint32_t factor, const uint32_t* pSource, const uint32_t width, const uint32_t height,
+                                   const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, scaling_buffer_t& buffer);
+
+            /// @brief Nearest neighbour upscaling of a strip (pixel duplication)
+            static void scaleNearestStrip(const uint32_t factor, const uint32_t* pSource, const uint32_t width,
+                                          const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut) noexcept;
+
+
+            // -- color comparison -- ------------------------------------------
+
+            /// @brief Convert pixel to color distance key (one byte per weight: luma x4, blue/red chroma, alpha x2)
+            /// @param[in] color  RGBA8 pixel
+            /// @returns Distance key (8 bytes: Y Y Y Y U V A A)
+            static inline uint64_t toDistanceKey(const uint32_t color) noexcept
+            {
+                const int32_t r = static_cast<int32_t>(color & 0xFFu), g = static_cast<int32_t>((color >> 8) & 0xFFu), b = static_cast<int32_t>((color >> 16) & 0xFFu);
+                const uint64_t y = static_cast<uint64_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+                const uint64_t u = static_cast<uint64_t>((128 * b - 43 * r - 85 * g + 32895) >> 8);
+                const uint64_t v = static_cast<uint64_t>((128 * r - 107 * g - 21 * b + 32895) >> 8);
+                const uint64_t a = static_cast<uint64_t>(color >> 24);
+                return (y * 0x01010101uLL) | (u << 32) | (v << 40) | (a * 0x0101000000000000uLL);
+            }
+            /// @brief Convert row of pixels to color distance keys
+            /// @param[in] pColors    Source pixels (RGBA8)
+            /// @param[in] length     Number of pixels
+            /// @param[out] pOutKeys  Distance keys
+            static void toDistanceKeys(const uint32_t* pColors, const size_t length, uint64_t* pOutKeys) noexcept;
+
+
+        private:
+            /// @brief Copy source rows of a strip (+ border) into padded buffer (+ distance keys if required)
+            static void loadPaddedRows(const uint32_t* pSource, const uint32_t width, const uint32_t height, const uint32_t firstRow, const uint32_t endRow,
+                                       const bool useKeys, scaling_buffer_t& buffer);
+
+            /// @brief 2xSaI (2x)
+            static void scaleSai(const uint32_t width, const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, const scaling_buffer_t& buffer) noexcept;
+            /// @brief xBR level 2 (2x - 4x)
+            static void scaleXbr(const uint32_t factor, const uint32_t width, const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, const scaling_buffer_t& buffer) noexcept;
+            /// @brief xBRZ (2x - 6x)
+            static void scaleXbrz(const uint32_t factor, const uint32_t width, const uint32_t firstRow, const uint32_t endRow, uint32_t* pOut, scaling_buffer_t& buffer) noexcept;
+        };
+    }
+}
@@ -0,0 +1,387 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : screen resampling (final scaling to window size) - separable filters with precomputed weights
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "screen_resampler.h"
+using namespace display::scaling;
+using config::interpolation_mode_t;
+
+#define RESAMPLER_PI          3.14159265358979323846
+#define RESAMPLER_OUT_SHIFT   (SCREEN_RESAMPLER_WEIGHT_BITS * 2u - SCREEN_RESAMPLER_INTER_SHIFT) // vertical pass result -> 8-bit
+
+
+// -- filter kernels -- --------------------------------------------------------
+
+/// @brief Get filter radius of an interpolation type (source pixels, before downscaling adjustment)
+static inline double getKernelRadius(const interpolation_mode_t mode) noexcept
+{
+    switch (mode)
+    {
+        case interpolation_mode_t::bicubic: return 2.0;
+        case interpolation_mode_t::lanczos: return 3.0;
+        default: return 1.0;
+    }
+}
+
+/// @brief Compute filter weight of an interpolation type
+/// @param[in] mode      Interpolation type
+/// @param[in] distance  Distance between source pixel and sampling position (filter units)
+static inline double getKernelWeight(const interpolation_mode_t mode, double distance) noexcept
+{
+    distance = std::fabs(distance);
+    switch (mode)
+    {
+        case interpolation_mode_t::bicubic: // Catmull-Rom (a = -0.5)
+        {
+            if (distance < 1.0)
+                return (1.5 * distance - 2.5) * distance * distance + 1.0;
+            return (distance < 2.0) ? ((-0.5 * distance + 2.5) * distance - 4.0) * distance + 2.0 : 0.0;
+        }
+        case interpolation_mode_t::lanczos: // Lanczos-3
+        {
+            if (distance < 1e-8)
+                return 1.0;
+            if (distance >= 3.0)
+                return 0.0;
+            const double pix = RESAMPLER_PI * distance;
+            return 3.0 * std::sin(pix) * std::sin(pix / 3.0) / (pix * pix);
+        }
+        default: return (distance < 1.0) ? 1.0 - distance : 0.0; // triangle
+    }
+}
+
+
+// -- geometry -- --------------------------------------------------------------
+
+/// @brief Create screen resampler
+/// @param[in] workerCount  Number of worker threads (0 = one per hardware thread, except caller thread)
+ScreenResampler::ScreenResampler(const uint32_t workerCount)
+    : m_mode(interpolation_mode_t::nearest), m_target(), m_isConfigured(false), m_firstSourceRow(0u), m_sourceRowCount(0u), m_threadPool(workerCount) {}
+
+/// @brief Compute output geometry of screen image (ratio, stretching, cropping, black borders)
+screen_target_t ScreenResampler::computeTarget(const config::config_screen_t& settings, const bool isPal, const uint32_t sourceWidth,
+                                               const uint32_t sourceHeight, const uint32_t windowWidth, const uint32_t windowHeight) noexcept
+{
+    screen_target_t target;
+    target.sourceWidth = sourceWidth;
+    target.sourceHeight = sourceHeight;
+    target.windowWidth = windowWidth;
+    target.windowHeight = windowHeight;
+
+    // black borders -> visible area
+    target.clipX = (settings.blackBorders.x * 2u < windowWidth) ? settings.blackBorders.x : 0u;
+    target.clipY = (settings.blackBorders.y * 2u < windowHeight) ? settings.blackBorders.y : 0u;
+    target.clipWidth = windowWidth - target.clipX * 2u;
+    target.clipHeight = windowHeight - target.clipY * 2u;
+    if (sourceWidth == 0u || sourceHeight == 0u || target.clipWidth == 0u || target.clipHeight == 0u)
+    {
+        target.x = target.y = 0;
+        target.width = target.height = 0u;
+        return target;
+    }
+
+    // display ratio (non-square pixels: 15:10 NTSC / 4:3 PAL)
+    uint64_t ratioX = sourceWidth, ratioY = sourceHeight;
+    if (settings.pixelRatio == config::pixel_ratio_mode_t::nonSquare)
+    {
+        ratioX = (isPal && settings.isNtscRatioForced == false) ? 4u : 15u;
+        ratioY = (isPal && settings.isNtscRatioForced == false) ? 3u : 10u;
+    }
+
+    // keep ratio: fit in visible area (black sides) / fill visible area (cropped)
+    const uint64_t areaWidth = target.clipWidth, areaHeight = target.clipHeight;
+    const bool isWidthLimited = (areaWidth * ratioY <= areaHeight * ratioX);
+    const uint64_t fitWidth = (isWidthLimited) ? areaWidth : (areaHeight * ratioX + ratioY / 2u) / ratioY;
+    const uint64_t fitHeight = (isWidthLimited) ? (areaWidth * ratioY + ratioX / 2u) / ratioX : areaHeight;
+    const uint64_t fillWidth = (isWidthLimited) ? (areaHeight * ratioX + ratioY / 2u) / ratioY : areaWidth;
+    const uint64_t fillHeight = (isWidthLimited) ? areaHeight : (areaWidth * ratioY + ratioX / 2u) / ratioX;
+    const uint64_t crop = (settings.ratioCrop > SCREEN_RATIO_MAX_VAL) ? SCREEN_RATIO_MAX_VAL : settings.ratioCrop;
+    uint64_t width = fitWidth + (fillWidth - fitWidth) * crop / SCREEN_RATIO_MAX_VAL;
+    uint64_t height = fitHeight + (fillHeight - fitHeight) * crop / SCREEN_RATIO_MAX_VAL;
+
+    // stretching of remaining black sides
+    const uint64_t stretch = (settings.ratioStretch > SCREEN_RATIO_MAX_VAL) ? SCREEN_RATIO_MAX_VAL : settings.ratioStretch;
+    if (width < areaWidth)
+        width += (areaWidth - width) * stretch / SCREEN_RATIO_MAX_VAL;
+    if (height < areaHeight)
+        height += (areaHeight - height) * stretch / SCREEN_RATIO_MAX_VAL;
+
+    target.width = static_cast<uint32_t>((width > 0u) ? width : 1u);
+    target.height = static_cast<uint32_t>((height > 0u) ? height : 1u);
+    target.x = static_cast<int32_t>(target.clipX) + (static_cast<int32_t>(target.clipWidth) - static_cast<int32_t>(target.width)) / 2;
+    target.y = static_cast<int32_t>(target.clipY) + (static_cast<int32_t>(target.clipHeight) - static_cast<int32_t>(target.height)) / 2;
+    return target;
+}
+
+
+// -- weight tables -- ---------------------------------------------------------
+
+/// @brief Set filter and output geometry (weight tables only recomputed if something changed)
+bool ScreenResampler::setTarget(const config::interpolation_mode_t mode, const screen_target_t& target)
+{
+    if (m_isConfigured && mode == m_mode && target == m_target)
+        return false;
+    m_mode = mode;
+    m_target = target;
+    m_isConfigured = true;
+
+    computeAxis(mode, target.sourceWidth, target.x, target.width, target.clipX, target.clipWidth, m_columns);
+    computeAxis(mode, target.sourceHeight, target.y, target.height, target.clipY, target.clipHeight, m_rows);
+
+    // source rows read by vertical taps (starts are non-decreasing)
+    m_firstSourceRow = m_sourceRowCount = 0u;
+    if (m_rows.length > 0u && m_columns.length > 0u)
+    {
+        m_firstSourceRow = m_rows.starts.front();
+        m_sourceRowCount = m_rows.starts.back() + m_rows.taps - m_firstSourceRow;
+    }
+    m_intermediate.assign(static_cast<size_t>(m_sourceRowCount) * m_columns.length * 4u, 0);
+    return true;
+}
+
+/// @brief Compute filter taps of an axis
+void ScreenResampler::computeAxis(const config::interpolation_mode_t mode, const uint32_t sourceSize, const int32_t imagePos, const uint32_t imageSize,
+                                  const uint32_t clipPos, const uint32_t clipSize, resampling_axis_t& outAxis)
+{
+    // visible output positions
+    const int64_t visibleStart = (imagePos > static_cast<int32_t>(clipPos)) ? imagePos : static_cast<int32_t>(clipPos);
+    const int64_t visibleEnd = (static_cast<int64_t>(imagePos) + imageSize < static_cast<int64_t>(clipPos) + clipSize)
+                             ? static_cast<int64_t>(imagePos) + imageSize : static_cast<int64_t>(clipPos) + clipSize;
+    outAxis.first = static_cast<uint32_t>(visibleStart);
+    outAxis.length = (sourceSize > 0u && visibleEnd > visibleStart) ? static_cast<uint32_t>(visibleEnd - visibleStart) : 0u;
+    outAxis.starts.resize(outAxis.length);
+
+    // filter size (downscaling: filter widened to cover all source pixels)
+    const double scale = (imageSize > 0u && sourceSize > 0u) ? static_cast<double>(imageSize) / static_cast<double>(sourceSize) : 1.0;
+    const double filterScale = (scale < 1.0) ? scale : 1.0;
+    const double radius = (mode == interpolation_mode_t::nearest) ? 0.5 : getKernelRadius(mode) / filterScale;
+    const uint32_t rawTaps = (mode == interpolation_mode_t::nearest) ? 1u : static_cast<uint32_t>(std::ceil(radius * 2.0));
+    outAxis.taps = (rawTaps < sourceSize) ? rawTaps : sourceSize;
+    outAxis.pairStride = (outAxis.taps + 1u) / 2u;
+    outAxis.weights.assign(static_cast<size_t>(outAxis.length) * outAxis.pairStride, 0);
+    if (outAxis.length == 0u)
+        return;
+
+    std::vector<double> weights(outAxis.taps);
+    for (uint32_t i = 0; i < outAxis.length; ++i)
+    {
+        // sampling position in source (pixel centers at integer positions)
+        const double position = (static_cast<double>(visibleStart + i - imagePos) + 0.5) / scale - 0.5;
+        const int64_t rawStart = (mode == interpolation_mode_t::nearest) ? static_cast<int64_t>(std::floor(position + 0.5))
+                                                                          : static_cast<int64_t>(std::floor(position - radius)) + 1;
+        const int64_t maxStart = static_cast<int64_t>(sourceSize - outAxis.taps);
+        const int64_t start = (rawStart < 0) ? 0 : ((rawStart > maxStart) ? maxStart : rawStart);
+        outAxis.starts[i] = static_cast<uint32_t>(start);
+
+        // raw weights (taps outside of source folded on edge pixels)
+        for (auto& weight : weights)
+            weight = 0.0;
+        for (int64_t tap = 0; tap < static_cast<int64_t>(rawTaps); ++tap)
+        {
+            const int64_t sourcePos = rawStart + tap;
+            double weight = 1.0;
+            if (mode == interpolation_mode_t::bilinearEnhanced && scale > 1.0) // sharp bilinear: nearest upscaling + smoothed pixel edges
+            {
+                double fraction = position - std::floor(position);
+                fraction = (fraction - 0.5) * scale + 0.5;
+                fraction = (fraction < 0.0) ? 0.0 : ((fraction > 1.0) ? 1.0 : fraction);
+                weight = (tap == 0) ? 1.0 - fraction : ((tap == 1) ? fraction : 0.0);
+            }
+            else if (mode != interpolation_mode_t::nearest)
+                weight = getKernelWeight(mode, (static_cast<double>(sourcePos) - position) * filterScale);
+
+            const int64_t slot = ((sourcePos < start) ? start : ((sourcePos >= start + outAxis.taps) ? start + outAxis.taps - 1 : sourcePos)) - start;
+            weights[static_cast<size_t>(slot)] += weight;
+        }
+
+        // normalized fixed-point weights (rounding error added to main tap)
+        double sum = 0.0;
+        for (auto weight : weights)
+            sum += weight;
+        if (sum == 0.0)
+            weights[0] = sum = 1.0;
+        int32_t fixedWeights[2] = { 0, 0 };
+        int32_t total = 0, mainTap = 0;
+        int32_t* pPairs = &outAxis.weights[static_cast<size_t>(i) * outAxis.pairStride];
+        for (uint32_t tap = 0; tap < outAxis.taps; ++tap)
+        {
+            int32_t fixedWeight = static_cast<int32_t>(std::floor(weights[tap] / sum * static_cast<double>(1u << SCREEN_RESAMPLER_WEIGHT_BITS) + 0.5));
+            total += fixedWeight;
+            if (weights[tap] > weights[mainTap])
+                mainTap = static_cast<int32_t>(tap);
+            pPairs[tap >> 1] |= (tap & 0x1u) ? static_cast<int32_t>(static_cast<uint32_t>(fixedWeight) << 16)
+                                             : static_cast<int32_t>(static_cast<uint16_t>(fixedWeight));
+        }
+        const int32_t error = static_cast<int32_t>(1u << SCREEN_RESAMPLER_WEIGHT_BITS) - total;
+        if (error != 0)
+        {
+            int32_t& pair = pPairs[mainTap >> 1];
+            fixedWeights[0] = static_cast<int16_t>(pair & 0xFFFF);
+            fixedWeights[1] = static_cast<int16_t>(static_cast<uint32_t>(pair) >> 16);
+            fixedWeights[mainTap & 0x1] += error;
+            pair = static_cast<int32_t>(static_cast<uint16_t>(fixedWeights[0]) | (static_cast<uint32_t>(fixedWeights[1]) << 16));
+        }
+    }
+}
+
+
+// -- resampling -- ------------------------------------------------------------
+
+/// @brief Resample image (waits for completion)
+void ScreenResampler::resample(const uint32_t* pSource, uint32_t* pOut)
+{
+    if (m_isConfigured == false || m_target.windowWidth == 0u || m_target.windowHeight == 0u)
+        return;
+
+    // horizontal pass (source rows read by vertical taps)
+    if (m_sourceRowCount > 0u)
+    {
+        const uint32_t stripCount = (m_sourceRowCount + SCREEN_RESAMPLER_STRIP_ROWS - 1u) / SCREEN_RESAMPLER_STRIP_ROWS;
+        m_threadPool.parallelFor(stripCount, [&](const uint32_t strip)
+        {
+            const uint32_t firstRow = strip * SCREEN_RESAMPLER_STRIP_ROWS;
+            filterRows(pSource, firstRow, (firstRow + SCREEN_RESAMPLER_STRIP_ROWS < m_sourceRowCount) ? firstRow + SCREEN_RESAMPLER_STRIP_ROWS : m_sourceRowCount);
+        });
+    }
+
+    // vertical pass (+ black borders)
+    const uint32_t stripCount = (m_target.windowHeight + SCREEN_RESAMPLER_STRIP_ROWS - 1u) / SCREEN_RESAMPLER_STRIP_ROWS;
+    m_threadPool.parallelFor(stripCount, [&](const uint32_t strip)
+    {
+        const uint32_t firstRow = strip * SCREEN_RESAMPLER_STRIP_ROWS;
+        filterColumns(pOut, firstRow, (firstRow + SCREEN_RESAMPLER_STRIP_ROWS < m_target.windowHeight) ? firstRow + SCREEN_RESAMPLER_STRIP_ROWS : m_target.windowHeight);
+    });
+}
+
+/// @brief Horizontal pass - source rows -> intermediate rows (8.6 fixed-point)
+void ScreenResampler::filterRows(const uint32_t* pSource, const uint32_t firstRow, const uint32_t endRow) noexcept
+{
+    const uint32_t taps = m_columns.taps;
+    for (uint32_t row = firstRow; row < endRow; ++row)
+    {
+        const uint32_t* pSourceRow = pSource + static_cast<size_t>(m_firstSourceRow + row) * m_target.sourceWidth;
+        int16_t* pOut = &m_intermediate[static_cast<size_t>(row) * m_columns.length * 4u];
+        const uint32_t* pStart = &m_columns.starts[0];
+        const int32_t* pPairs = &m_columns.weights[0];
+        for (uint32_t x = 0; x < m_columns.length; ++x, pOut += 4, pPairs += m_columns.pairStride)
+        {
+            const uint32_t* pTaps = pSourceRow + pStart[x];
+            #if _SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            __m128i sum = _mm_set1_epi32(1 << (SCREEN_RESAMPLER_INTER_SHIFT - 1u));
+            uint32_t tap = 0;
+            for (; tap + 1u < taps; tap += 2u) // 2 pixels: r0 r1 g0 g1 b0 b1 a0 a1 * w0 w1
+            {
+                __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pTaps[tap])), zero);
+                pixels = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, _mm_set1_epi32(pPairs[tap >> 1])));
+            }
+            if (tap < taps) // last odd tap (high weight = 0)
+            {
+                __m128i pixels = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pTaps[tap])), zero);
+                pixels = _mm_unpacklo_epi16(pixels, zero);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, _mm_set1_epi32(pPairs[tap >> 1])));
+            }
+            sum = _mm_srai_epi32(sum, SCREEN_RESAMPLER_INTER_SHIFT);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pOut), _mm_packs_epi32(sum, sum));
+            #else
+            int32_t sum[4] = { 0, 0, 0, 0 };
+            for (uint32_t tap = 0; tap < taps; ++tap)
+            {
+                const int32_t weight = static_cast<int16_t>((tap & 0x1u) ? static_cast<uint32_t>(pPairs[tap >> 1]) >> 16 : pPairs[tap >> 1] & 0xFFFF);
+                for (uint32_t channel = 0; channel < 4u; ++channel)
+                    sum[channel] += weight * static_cast<int32_t>((pTaps[tap] >> (channel * 8u)) & 0xFFu);
+            }
+            for (uint32_t channel = 0; channel < 4u; ++channel)
+            {
+                const int32_t value = (sum[channel] + (1 << (SCREEN_RESAMPLER_INTER_SHIFT - 1u))) >> SCREEN_RESAMPLER_INTER_SHIFT;
+                pOut[channel] = static_cast<int16_t>((value < -32768) ? -32768 : ((value > 32767) ? 32767 : value));
+            }
+            #endif
+        }
+    }
+}
+
+/// @brief Vertical pass - intermediate rows -> output rows
+void ScreenResampler::filterColumns(uint32_t* pOut, const uint32_t firstRow, const uint32_t endRow) const noexcept
+{
+    const uint32_t taps = m_rows.taps;
+    const size_t interPitch = static_cast<size_t>(m_columns.length) * 4u;
+    for (uint32_t row = firstRow; row < endRow; ++row)
+    {
+        uint32_t* pOutRow = pOut + static_cast<size_t>(row) * m_target.windowWidth;
+        const bool isVisibleRow = (row >= m_rows.first && row < m_rows.first + m_rows.length && m_columns.length > 0u);
+        const uint32_t visibleStart = (isVisibleRow) ? m_columns.first : m_target.windowWidth;
+        const uint32_t visibleEnd = (isVisibleRow) ? m_columns.first + m_columns.length : m_target.windowWidth;
+        for (uint32_t x = 0; x < visibleStart; ++x)
+            pOutRow[x] = SCREEN_RESAMPLER_BLACK;
+        for (uint32_t x = visibleEnd; x < m_target.windowWidth; ++x)
+            pOutRow[x] = SCREEN_RESAMPLER_BLACK;
+        if (isVisibleRow == false)
+            continue;
+
+        const uint32_t index = row - m_rows.first;
+        const int16_t* pFirstTap = &m_intermediate[static_cast<size_t>(m_rows.starts[index] - m_firstSourceRow) * interPitch];
+        const int32_t* pPairs = &m_rows.weights[static_cast<size_t>(index) * m_rows.pairStride];
+        uint32_t* pVisible = pOutRow + visibleStart;
+        uint32_t x = 0;
+        #if _SIMD_SSE2
+        const __m128i rounding = _mm_set1_epi32(1 << (RESAMPLER_OUT_SHIFT - 1u));
+        for (; x + 1u < m_columns.length; x += 2u) // 2 pixels (8 channels) per iteration
+        {
+            __m128i sumLow = rounding, sumHigh = rounding;
+            const int16_t* pTap = pFirstTap + x * 4u;
+            uint32_t tap = 0;
+            for (; tap + 1u < taps; tap += 2u, pTap += interPitch * 2u)
+            {
+                const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pTap));
+                const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pTap + interPitch));
+                const __m128i weights = _mm_set1_epi32(pPairs[tap >> 1]);
+                sumLow = _mm_add_epi32(sumLow, _mm_madd_epi16(_mm_unpacklo_epi16(row0, row1), weights));
+                sumHigh = _mm_add_epi32(sumHigh, _mm_madd_epi16(_mm_unpackhi_epi16(row0, row1), weights));
+            }
+            if (tap < taps)
+            {
+                const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pTap));
+                const __m128i weights = _mm_set1_epi32(pPairs[tap >> 1]);
+                sumLow = _mm_add_epi32(sumLow, _mm_madd_epi16(_mm_unpacklo_epi16(row0, _mm_setzero_si128()), weights));
+                sumHigh = _mm_add_epi32(sumHigh, _mm_madd_epi16(_mm_unpackhi_epi16(row0, _mm_setzero_si128()), weights));
+            }
+            const __m128i channels = _mm_packs_epi32(_mm_srai_epi32(sumLow, RESAMPLER_OUT_SHIFT), _mm_srai_epi32(sumHigh, RESAMPLER_OUT_SHIFT));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&pVisible[x]), _mm_packus_epi16(channels, channels));
+        }
+        #endif
+        for (; x < m_columns.length; ++x)
+        {
+            int32_t sum[4] = { 0, 0, 0, 0 };
+            const int16_t* pTap = pFirstTap + x * 4u;
+            for (uint32_t tap = 0; tap < taps; ++tap, pTap += interPitch)
+            {
+                const int32_t weight = static_cast<int16_t>((tap & 0x1u) ? static_cast<uint32_t>(pPairs[tap >> 1]) >> 16 : pPairs[tap >> 1] & 0xFFFF);
+                for (uint32_t channel = 0; channel < 4u; ++channel)
+                    sum[channel] += weight * pTap[channel];
+            }
+            uint32_t color = 0u;
+            for (uint32_t channel = 0; channel < 4u; ++channel)
+            {
+                const int32_t value = (sum[channel] + (1 << (RESAMPLER_OUT_SHIFT - 1u))) >> RESAMPLER_OUT_SHIFT;
+                color |= static_cast<uint32_t>((value < 0) ? 0 : ((value > 255) ? 255 : value)) << (channel * 8u);
+            }
+            pVisible[x] = color;
+        }
+    }
+}
@@ -0,0 +1,146 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : screen resampling (final scaling to window size) - separable filters with precomputed weights
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+
+#define SCREEN_RESAMPLER_WEIGHT_BITS  14u  // fixed-point filter weights (sum of taps = 1 << bits)
+#define SCREEN_RESAMPLER_INTER_SHIFT  8u   // horizontal pass result: 8.6 fixed-point (room for filter overshoot)
+#define SCREEN_RESAMPLER_STRIP_ROWS   32u  // rows per strip (work unit of a thread)
+#define SCREEN_RESAMPLER_BLACK        0xFF000000u // borders / outside of image (RGBA8)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.scaling
+    /// Image upscaling
+    namespace scaling
+    {
+        /// @struct screen_target_t
+        /// @brief Output geometry of screen image in window
+        struct screen_target_t
+        {
+            uint32_t sourceWidth;  ///< Source image width
+            uint32_t sourceHeight; ///< Source image height
+            uint32_t windowWidth;  ///< Output width
+            uint32_t windowHeight; ///< Output height
+            uint32_t clipX;        ///< Visible area left position (without black borders)
+            uint32_t clipY;        ///< Visible area top position
+            uint32_t clipWidth;    ///< Visible area width
+            uint32_t clipHeight;   ///< Visible area height
+            int32_t  x;            ///< Stretched image left position (may be outside of visible area: cropped)
+            int32_t  y;            ///< Stretched image top position
+            uint32_t width;        ///< Stretched image width
+            uint32_t height;       ///< Stretched image height
+
+            inline bool operator==(const screen_target_t& other) const noexcept
+            {
+                return (sourceWidth == other.sourceWidth && sourceHeight == other.sourceHeight && windowWidth == other.windowWidth && windowHeight == other.windowHeight
+                     && clipX == other.clipX && clipY == other.clipY && clipWidth == other.clipWidth && clipHeight == other.clipHeight
+                     && x == other.x && y == other.y && width == other.width && height == other.height);
+            }
+            inline bool operator!=(const screen_target_t& other) const noexcept { return !(*this == other); }
+        };
+
+        /// @struct resampling_axis_t
+        /// @brief Precomputed filter taps of each output pixel along one axis
+        struct resampling_axis_t
+        {
+            uint32_t first;                 ///< First output position (visible)
+            uint32_t length;                ///< Number of output positions (visible)
+            uint32_t taps;                  ///< Number of taps per output position
+            uint32_t pairStride;            ///< Number of weight pairs per output position ((taps + 1) / 2)
+            std::vector<uint32_t> starts;   ///< First source position of each output position
+            std::vector<int32_t> weights;   ///< Weight pairs of each output position (2 x int16: tap 2k in low bits, tap 2k+1 in high bits)
+        };
+
+
+        /// @class ScreenResampler
+        /// @brief Screen resampling - separable filter (horizontal pass, then vertical pass), fixed-point weights computed when geometry changes
+        /// @details Both passes are split in strips of rows processed by a thread pool (output identical to a single-threaded run).
+        ///          Downscaling widens the filters (anti-aliasing).
+        class ScreenResampler
+        {
+        public:
+            /// @brief Create screen resampler
+            /// @param[in] workerCount  Number of worker threads (0 = one per hardware thread, except caller thread)
+            ScreenResampler(const uint32_t workerCount = 0u);
+            // no copy allowed
+            ScreenResampler(const ScreenResampler& other) = delete;
+            ScreenResampler& operator=(const ScreenResampler& other) = delete;
+
+            /// @brief Compute output geometry of screen image (ratio, stretching, cropping, black borders)
+            /// @param[in] settings      Screen adjustment settings
+            /// @param[in] isPal         PAL video mode (4:3 non-square pixel ratio, unless NTSC ratio is forced)
+            /// @param[in] sourceWidth   Source image width
+            /// @param[in] sourceHeight  Source image height
+            /// @param[in] windowWidth   Output width
+            /// @param[in] windowHeight  Output height
+            /// @returns Output geometry
+            static screen_target_t computeTarget(const config::config_screen_t& settings, const bool isPal, const uint32_t sourceWidth,
+                                                 const uint32_t sourceHeight, const uint32_t windowWidth, const uint32_t windowHeight) noexcept;
+
+            /// @brief Set filter and output geometry (weight tables only recomputed if something changed)
+            /// @param[in] mode    Interpolation type
+            /// @param[in] target  Output geometry
+            /// @returns Weight tables recomputed (true) or reused (false)
+            bool setTarget(const config::interpolation_mode_t mode, const screen_target_t& target);
+
+            /// @brief Resample image (waits for completion)
+            /// @param[in] pSource  Source image (RGBA8, target sourceWidth x sourceHeight)
+            /// @param[out] pOut    Output image (RGBA8, target windowWidth x windowHeight)
+            void resample(const uint32_t* pSource, uint32_t* pOut);
+
+
+            // -- getters -- ---------------------------------------------------
+
+            /// @brief Get interpolation type
+            inline config::interpolation_mode_t mode() const noexcept { return m_mode; }
+            /// @brief Get output geometry
+            inline const screen_target_t& target() const noexcept { return m_target; }
+            /// @brief Get number of threads used for each image (workers + caller thread)
+            inline uint32_t concurrency() const noexcept { return m_threadPool.concurrency(); }
+
+
+        private:
+            /// @brief Compute filter taps of an axis
+            /// @param[in] mode        Interpolation type
+            /// @param[in] sourceSize  Source size
+            /// @param[in] imagePos    Stretched image position
+            /// @param[in] imageSize   Stretched image size
+            /// @param[in] clipPos     Visible area position
+            /// @param[in] clipSize    Visible area size
+            /// @param[out] outAxis    Filter taps
+            static void computeAxis(const config::interpolation_mode_t mode, const uint32_t sourceSize, const int32_t imagePos, const uint32_t imageSize,
+                                    const uint32_t clipPos, const uint32_t clipSize, resampling_axis_t& outAxis);
+
+            /// @brief Horizontal pass - source rows -> intermediate rows (8.6 fixed-point)
+            void filterRows(const uint32_t* pSource, const uint32_t firstRow, const uint32_t endRow) noexcept;
+            /// @brief Vertical pass - intermediate rows -> output rows
+            void filterColumns(uint32_t* pOut, const uint32_t firstRow, const uint32_t endRow) const noexcept;
+
+
+        private:
+            config::interpolation_mode_t m_mode; ///< Interpolation type
+            screen_target_t m_target;            ///< Output geometry
+            bool m_isConfigured;                 ///< Weight tables available
+            resampling_axis_t m_columns;         ///< Horizontal filter taps
+            resampling_axis_t m_rows;            ///< Vertical filter taps
+            uint32_t m_firstSourceRow;           ///< First source row read by vertical taps
+            uint32_t m_sourceRowCount;           ///< Number of source rows read by vertical taps
+            std::vector<int16_t> m_intermediate; ///< Horizontal pass result (m_sourceRowCount rows of visible width x 4 channels)
+            ::utils::thread::ThreadPool m_threadPool; ///< Strip processing threads
+        };
+    }
+}
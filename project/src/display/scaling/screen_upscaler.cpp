@@ -0,0 +1,96 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : screen upscaling (final display image) - multithreaded strips
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "pixel_scalers.h"
+#include "screen_upscaler.h"
+using namespace display::scaling;
+using config::upscaling_mode_t;
+
+
+/// @brief Create screen upscaler
+/// @param[in] mode         Upscaling type
+/// @param[in] factor       Requested upscaling factor (1 - 8)
+/// @param[in] workerCount  Number of worker threads (0 = one per hardware thread, except caller thread)
+ScreenUpscaler::ScreenUpscaler(const config::upscaling_mode_t mode, const uint32_t factor, const uint32_t workerCount)
+    : m_mode(mode), m_factor(getOutputFactor(mode, factor)), m_threadPool(workerCount)
+{
+    if (mode == upscaling_mode_t::sai && m_factor > 1u) // repeated 2x passes
+    {
+        for (uint32_t scaled = 1u; scaled < m_factor; scaled *= 2u)
+            m_passFactors.push_back(2u);
+    }
+    else
+        m_passFactors.push_back(m_factor);
+}
+
+/// @brief Get factor really produced by a mode for a requested factor
+/// @param[in] mode    Upscaling type
+/// @param[in] factor  Requested upscaling factor
+/// @returns Output factor (sai: 2/4/8 ; xbr: 2-4 ; xbrz: 2-6 ; other modes: requested factor)
+uint32_t ScreenUpscaler::getOutputFactor(const config::upscaling_mode_t mode, const uint32_t factor) noexcept
+{
+    if (factor <= 1u)
+        return 1u;
+    switch (mode)
+    {
+        case upscaling_mode_t::sai:  return (factor >= 8u) ? 8u : ((factor >= 4u) ? 4u : 2u);
+        case upscaling_mode_t::xbr:  return (factor > 4u) ? 4u : factor;
+        case upscaling_mode_t::xbrz:
+        case upscaling_mode_t::xbrzEnhanced: return (factor > PIXEL_SCALERS_MAX_FACTOR) ? PIXEL_SCALERS_MAX_FACTOR : factor;
+        default: return (factor > 8u) ? 8u : factor;
+    }
+}
+
+/// @brief Upscale image (waits for completion)
+/// @param[in] pSource  Source image (RGBA8, width x height)
+/// @param[in] width    Source width
+/// @param[in] height   Source height
+/// @param[out] pOut    Output image (RGBA8, width*factor() x height*factor())
+void ScreenUpscaler::upscale(const uint32_t* pSource, const uint32_t width, const uint32_t height, uint32_t* pOut)
+{
+    if (width == 0u || height == 0u)
+        return;
+
+    uint32_t passWidth = width, passHeight = height;
+    const uint32_t* pPassSource = pSource;
+    for (size_t pass = 0; pass < m_passFactors.size(); ++pass)
+    {
+        // last pass -> output image ; other passes -> alternate intermediate buffers
+        const uint32_t passFactor = m_passFactors[pass];
+        uint32_t* pPassOut = pOut;
+        if (pass + 1u < m_passFactors.size())
+        {
+            std::vector<uint32_t>& passBuffer = (pass & 0x1u) ? m_passBuffer2 : m_passBuffer;
+            passBuffer.resize(static_cast<size_t>(passWidth) * passHeight * passFactor * passFactor);
+            pPassOut = &passBuffer[0];
+        }
+
+        const uint32_t stripCount = (passHeight + SCREEN_UPSCALER_STRIP_ROWS - 1u) / SCREEN_UPSCALER_STRIP_ROWS;
+        if (m_stripBuffers.size() < stripCount)
+            m_stripBuffers.resize(stripCount);
+        m_threadPool.parallelFor(stripCount, [&](const uint32_t strip)
+        {
+            const uint32_t firstRow = strip * SCREEN_UPSCALER_STRIP_ROWS;
+            const uint32_t endRow = (firstRow + SCREEN_UPSCALER_STRIP_ROWS < passHeight) ? firstRow + SCREEN_UPSCALER_STRIP_ROWS : passHeight;
+            if (passFactor <= 1u)
+                PixelScalers::scaleNearestStrip(1u, pPassSource, passWidth, firstRow, endRow, pPassOut);
+            else
+                PixelScalers::scaleStrip(m_mode, passFactor, pPassSource, passWidth, passHeight, firstRow, endRow, pPassOut, m_stripBuffers[strip]);
+        });
+
+        pPassSource = pPassOut;
+        passWidth *= passFactor;
+        passHeight *= passFactor;
+    }
+}
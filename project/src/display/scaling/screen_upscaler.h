@@ -0,0 +1,76 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : screen upscaling (final display image) - multithreaded strips
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "pixel_scalers.h"
+
+#define SCREEN_UPSCALER_STRIP_ROWS 16u // source rows per strip (work unit of a thread)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.scaling
+    /// Image upscaling
+    namespace scaling
+    {
+        /// @class ScreenUpscaler
+        /// @brief Screen upscaling - display image split in horizontal strips, processed by a thread pool
+        /// @details Output is identical to a single-threaded run (strips read their neighbour rows from the complete source image).
+        ///          Factors not supported by a mode in one pass are reached with several passes (2xSaI: 4x = 2x + 2x) or limited
+        ///          to the max factor of the mode (see getOutputFactor). Modes without software implementation use nearest neighbour.
+        class ScreenUpscaler
+        {
+        public:
+            /// @brief Create screen upscaler
+            /// @param[in] mode         Upscaling type
+            /// @param[in] factor       Requested upscaling factor (1 - 8)
+            /// @param[in] workerCount  Number of worker threads (0 = one per hardware thread, except caller thread)
+            ScreenUpscaler(const config::upscaling_mode_t mode, const uint32_t factor, const uint32_t workerCount = 0u);
+            // no copy allowed
+            ScreenUpscaler(const ScreenUpscaler& other) = delete;
+            ScreenUpscaler& operator=(const ScreenUpscaler& other) = delete;
+
+            /// @brief Get factor really produced by a mode for a requested factor
+            /// @param[in] mode    Upscaling type
+            /// @param[in] factor  Requested upscaling factor
+            /// @returns Output factor (sai: 2/4/8 ; xbr: 2-4 ; xbrz: 2-6 ; other modes: requested factor)
+            static uint32_t getOutputFactor(const config::upscaling_mode_t mode, const uint32_t factor) noexcept;
+
+            /// @brief Upscale image (waits for completion)
+            /// @param[in] pSource  Source image (RGBA8, width x height)
+            /// @param[in] width    Source width
+            /// @param[in] height   Source height
+            /// @param[out] pOut    Output image (RGBA8, width*factor() x height*factor())
+            void upscale(const uint32_t* pSource, const uint32_t width, const uint32_t height, uint32_t* pOut);
+
+            /// @brief Get upscaling type
+            inline config::upscaling_mode_t mode() const noexcept { return m_mode; }
+            /// @brief Get output factor
+            inline uint32_t factor() const noexcept { return m_factor; }
+            /// @brief Get number of threads used for each image (workers + caller thread)
+            inline uint32_t concurrency() const noexcept { return m_threadPool.concurrency(); }
+
+
+        private:
+            config::upscaling_mode_t m_mode;              ///< Upscaling type
+            uint32_t m_factor;                            ///< Output factor
+            std::vector<uint32_t> m_passFactors;          ///< Factor of each pass
+            std::vector<uint32_t> m_passBuffer;           ///< Intermediate image (multiple passes)
+            std::vector<uint32_t> m_passBuffer2;          ///< Intermediate image (more than 2 passes)
+            std::vector<scaling_buffer_t> m_stripBuffers; ///< Working memory of each strip
+            ::utils::thread::ThreadPool m_threadPool;     ///< Strip processing threads
+        };
+    }
+}
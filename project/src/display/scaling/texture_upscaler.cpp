@@ -0,0 +1,361 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : background texture upscaling (decoded texture pages)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include "../software/rasterizer.h"
+#include "pixel_scalers.h"
+#include "texture_upscaler.h"
+using namespace display::scaling;
+
+
+/// @brief Create texture upscaler
+/// @param[in] mode          Upscaling type
+/// @param[in] factor        Upscaling factor (limited to UPSCALING_MODE_TEXTURE_MAX_FACTOR)
+/// @param[in] workerCount   Number of background worker threads
+/// @param[in] memoryBudget  Max memory used by upscaled pages (bytes)
+/// @param[in] frameBudget   Max upscaling work started per frame (microseconds of worker time)
+TextureUpscaler::TextureUpscaler(const config::upscaling_mode_t mode, const uint32_t factor, const uint32_t workerCount, const size_t memoryBudget, const uint32_t frameBudget)
+    : m_mode(mode), m_factor(toValidFactor(factor)),
+      m_scalingFunction(getScalingFunction(mode)), m_frameBudget(frameBudget), m_averageJobCost(TEXTURE_UPSCALER_INITIAL_JOB_COST),
+      m_frameIndex(0uLL), m_threadPool((workerCount > 0u) ? workerCount : 1u)
+{
+    m_maxPageCount = memoryBudget / getPageBytes(m_factor);
+    if (m_maxPageCount == 0u)
+        m_maxPageCount = 1u;
+    resetStats();
+}
+
+/// @brief Cancel pending jobs and stop workers
+TextureUpscaler::~TextureUpscaler()
+{
+    clear(); // workers only skip cancelled jobs (joined when thread pool is destroyed)
+}
+
+
+// -- upscaling functions -- ---------------------------------------------------
+
+#define TEXEL_ALPHA_OPAQUE      0x80u // RGBA8 alpha of opaque texels (no semi-transparency bit)
+#define TEXEL_ALPHA_SEMI_TRANSP 0xFFu // RGBA8 alpha of texels with semi-transparency bit
+
+/// @brief Pixel-art upscaling of 15-bit texels (transparency and semi-transparency bit kept in RGBA8 alpha during upscaling)
+template <config::upscaling_mode_t _Mode>
+static void scalePixelArt(const uint16_t* pSource, const uint32_t width, const uint32_t height, const uint32_t factor, uint16_t* pOut)
+{
+    // passes (2xSaI: 2x only -> 4x = 2 passes)
+    const uint32_t passFactor = (_Mode == config::upscaling_mode_t::sai) ? 2u : factor;
+    const uint32_t passCount = (_Mode == config::upscaling_mode_t::sai && factor == 4u) ? 2u : 1u;
+    if (factor <= 1u || PixelScalers::isSupported(_Mode, passFactor) == false || (passCount == 1u && passFactor != factor))
+    {
+        TextureUpscaler::scaleNearest(pSource, width, height, factor, pOut);
+        return;
+    }
+
+    // 15-bit texels -> RGBA8 (0 = transparent)
+    const size_t texelCount = static_cast<size_t>(width) * height;
+    std::vector<uint32_t> colors(texelCount);
+    for (size_t i = 0; i < texelCount; ++i)
+    {
+        const uint32_t texel = pSource[i];
+        const uint32_t alpha = (texel == 0u) ? 0u : ((texel & 0x8000u) ? TEXEL_ALPHA_SEMI_TRANSP : TEXEL_ALPHA_OPAQUE);
+        colors[i] = (alpha << 24) | (display::software::Rasterizer::toRgba(static_cast<uint16_t>(texel)) & 0x00FFFFFFu);
+    }
+
+    // upscaling (single strip: already called from a background worker)
+    scaling_buffer_t buffer;
+    uint32_t passWidth = width, passHeight = height;
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        std::vector<uint32_t> scaled(colors.size() * passFactor * passFactor);
+        PixelScalers::scaleStrip(_Mode, passFactor, &colors[0], passWidth, passHeight, 0u, passHeight, &scaled[0], buffer);
+        colors.swap(scaled);
+        passWidth *= passFactor;
+        passHeight *= passFactor;
+    }
+
+    // RGBA8 -> 15-bit texels (mostly transparent -> 0 ; blended to black -> source texel)
+    for (uint32_t y = 0; y < passHeight; ++y)
+    {
+        const uint32_t* pColorRow = &colors[static_cast<size_t>(y) * passWidth];
+        const uint16_t* pSourceRow = pSource + static_cast<size_t>(y / factor) * width;
+        uint16_t* pOutRow = pOut + static_cast<size_t>(y) * passWidth;
+        for (uint32_t x = 0; x < passWidth; ++x)
+        {
+            const uint32_t color = pColorRow[x];
+            const uint32_t alpha = color >> 24;
+            uint32_t texel = 0u;
+            if (alpha >= (TEXEL_ALPHA_OPAQUE >> 1))
+            {
+                texel = ((color >> 3) & 0x1Fu) | ((color >> 6) & 0x3E0u) | ((color >> 9) & 0x7C00u);
+                texel |= (alpha >= ((TEXEL_ALPHA_OPAQUE + TEXEL_ALPHA_SEMI_TRANSP) >> 1)) ? 0x8000u : 0u;
+                if (texel == 0u)
+                    texel = pSourceRow[x / factor];
+            }
+            pOutRow[x] = static_cast<uint16_t>(texel);
+        }
+    }
+}
+
+/// @brief Get upscaling function of a mode (nearest neighbour for modes without software implementation)
+/// @param[in] mode  Upscaling type
+texture_scaling_function_t TextureUpscaler::getScalingFunction(const config::upscaling_mode_t mode) noexcept
+{
+    switch (mode)
+    {
+        case config::upscaling_mode_t::sai:          return scalePixelArt<config::upscaling_mode_t::sai>;
+        case config::upscaling_mode_t::xbr:          return scalePixelArt<config::upscaling_mode_t::xbr>;
+        case config::upscaling_mode_t::xbrz:
+        case config::upscaling_mode_t::xbrzEnhanced: return scalePixelArt<config::upscaling_mode_t::xbrz>;
+        //... superXbr, nnedi3
+        default: return scaleNearest;
+    }
+}
+
+/// @brief Nearest neighbour upscaling (texel duplication)
+void TextureUpscaler::scaleNearest(const uint16_t* pSource, const uint32_t width, const uint32_t height, const uint32_t factor, uint16_t* pOut)
+{
+    const uint32_t outWidth = width * factor;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint16_t* pSourceRow = pSource + y * width;
+        uint16_t* pOutRow = pOut + (y * factor) * outWidth;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            for (uint32_t i = 0; i < factor; ++i)
+                pOutRow[x * factor + i] = pSourceRow[x];
+        }
+        for (uint32_t i = 1; i < factor; ++i)
+            memcpy(pOutRow + i * outWidth, pOutRow, outWidth * sizeof(uint16_t));
+    }
+}
+
+
+// -- pages -- -----------------------------------------------------------------
+
+/// @brief Find upscaled page
+/// @param[in] pageId  Page content key
+/// @returns Upscaled page (256*factor x 256*factor texels) or nullptr (native texture must be used)
+const uint16_t* TextureUpscaler::find(const uint64_t pageId) noexcept
+{
+    auto it = m_pages.find(pageId);
+    if (it == m_pages.end())
+        return nullptr;
+    it->second.lastUse = m_frameIndex;
+    return it->second.texels.data();
+}
+
+/// @brief Request page upscaling (ignored if already upscaled or in progress)
+/// @param[in] pageId        Page content key
+/// @param[in] pSourcePage   Decoded source page (256 x 256 texels) - copied
+/// @param[in] sourceX       Source texel area in VRAM: left position
+/// @param[in] sourceY       Source texel area in VRAM: top position
+/// @param[in] sourceWidth   Source texel area in VRAM: width (VRAM units)
+void TextureUpscaler::request(const uint64_t pageId, const uint16_t* pSourcePage, const int32_t sourceX, const int32_t sourceY, const int32_t sourceWidth)
+{
+    if (m_factor <= 1u || m_jobs.find(pageId) != m_jobs.end() || m_pages.find(pageId) != m_pages.end())
+        return;
+
+    std::shared_ptr<upscaling_job_t> pJob = std::make_shared<upscaling_job_t>();
+    pJob->pageId = pageId;
+    pJob->area = source_area_t{ sourceX, sourceY, sourceWidth };
+    pJob->source.assign(pSourcePage, pSourcePage + TEXTURE_UPSCALER_PAGE_SIZE * TEXTURE_UPSCALER_PAGE_SIZE);
+    pJob->state = job_state_t::queued;
+    pJob->duration = 0u;
+
+    m_jobs[pageId] = pJob;
+    m_waitingJobs.push_back(pJob);
+    ++m_stats.requests;
+}
+
+/// @brief Open persistent cache of upscaled pages (can be called from any thread, before creating upscaler)
+/// @param[in] directoryPath  Game cache directory (see UpscaledTextureStore::getGameDirectoryPath)
+/// @param[in] mode           Upscaling type
+/// @param[in] factor         Upscaling factor (limited to UPSCALING_MODE_TEXTURE_MAX_FACTOR)
+/// @param[in] maxFileSize    Max cache file size (bytes)
+/// @returns Open cache (or nullptr on failure)
+std::unique_ptr<UpscaledTextureStore> TextureUpscaler::openPersistentCache(const std::string& directoryPath, const config::upscaling_mode_t mode,
+                                                                           const uint32_t factor, const size_t maxFileSize)
+{
+    const uint32_t validFactor = toValidFactor(factor);
+    if (directoryPath.empty() || validFactor <= 1u)
+        return nullptr;
+
+    std::unique_ptr<UpscaledTextureStore> pStore(new UpscaledTextureStore());
+    if (pStore->open(directoryPath, mode, validFactor, getPageBytes(validFactor), maxFileSize) == false)
+        return nullptr;
+    return pStore;
+}
+
+/// @brief Use persistent cache of upscaled pages (pending jobs cancelled)
+/// @param[in] pStore  Open cache with same upscaling type/factor (see openPersistentCache) - nullptr to disable
+/// @returns Success (cache compatible with upscaler)
+bool TextureUpscaler::setPersistentCache(std::unique_ptr<UpscaledTextureStore> pStore)
+{
+    // stop using current store
+    clear();
+    m_threadPool.waitIdle();
+    m_pStore.reset();
+    if (pStore == nullptr)
+        return true;
+    if (pStore->isOpen() == false || pStore->mode() != m_mode || pStore->factor() != m_factor)
+        return false;
+
+    m_pStore = std::move(pStore);
+    return true;
+}
+
+/// @brief Upscale page (worker thread) - loaded from persistent cache if available
+void TextureUpscaler::runJob(const std::shared_ptr<upscaling_job_t>& pJob, texture_scaling_function_t scalingFunction, const uint32_t factor,
+                             UpscaledTextureStore* pStore) noexcept
+{
+    uint32_t expectedState = job_state_t::queued;
+    if (pJob->state.compare_exchange_strong(expectedState, job_state_t::running) == false) // cancelled
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        pJob->result.resize(pJob->source.size() * factor * factor);
+        const uint64_t contentHash = (pStore != nullptr) ? UpscaledTextureStore::computeHash(pJob->source.data(), pJob->source.size()) : 0uLL;
+        if (pStore == nullptr || pStore->load(contentHash, pJob->result.data()) == false)
+        {
+            scalingFunction(pJob->source.data(), TEXTURE_UPSCALER_PAGE_SIZE, TEXTURE_UPSCALER_PAGE_SIZE, factor, pJob->result.data());
+            if (pStore != nullptr && pJob->state.load() == job_state_t::running) // don't store pages invalidated meanwhile
+                pStore->store(contentHash, pJob->result.data());
+        }
+    }
+    catch (...) // allocation failure: page stays native
+    {
+        pJob->result.clear();
+    }
+    pJob->duration = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+    expectedState = job_state_t::running;
+    pJob->state.compare_exchange_strong(expectedState, job_state_t::completed); // not marked if cancelled meanwhile
+}
+
+
+// -- invalidation / frames -- -------------------------------------------------
+
+/// @brief Check if source area overlaps a written area
+bool TextureUpscaler::isAreaWritten(const source_area_t& area, const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept
+{
+    const int32_t areaX = left & (RASTER_VRAM_WIDTH - 1);
+    const int32_t areaY = top & (RASTER_VRAM_HEIGHT - 1);
+    const int32_t areaWidth = (right - left + 1 < RASTER_VRAM_WIDTH) ? right - left + 1 : RASTER_VRAM_WIDTH;
+    const int32_t areaHeight = (bottom - top + 1 < RASTER_VRAM_HEIGHT) ? bottom - top + 1 : RASTER_VRAM_HEIGHT;
+
+    return ((((area.x - areaX) & (RASTER_VRAM_WIDTH - 1)) < areaWidth || ((areaX - area.x) & (RASTER_VRAM_WIDTH - 1)) < area.width)
+         && (((area.y - areaY) & (RASTER_VRAM_HEIGHT - 1)) < areaHeight || ((areaY - area.y) & (RASTER_VRAM_HEIGHT - 1)) < TEXTURE_UPSCALER_PAGE_SIZE));
+}
+
+/// @brief Cancel jobs and remove pages whose source area overlaps a written VRAM area (with VRAM wrapping)
+/// @param[in] left    Left limit of written area (inclusive)
+/// @param[in] top     Top limit of written area (inclusive)
+/// @param[in] right   Right limit of written area (inclusive)
+/// @param[in] bottom  Bottom limit of written area (inclusive)
+void TextureUpscaler::invalidateArea(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept
+{
+    if (right < left || bottom < top)
+        return;
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); )
+    {
+        if (isAreaWritten(it->second->area, left, top, right, bottom))
+        {
+            it->second->state = job_state_t::cancelled;
+            it = m_jobs.erase(it);
+            ++m_stats.cancelled;
+        }
+        else
+            ++it;
+    }
+    for (auto it = m_pages.begin(); it != m_pages.end(); )
+    {
+        if (isAreaWritten(it->second.area, left, top, right, bottom))
+        {
+            it = m_pages.erase(it);
+            ++m_stats.discarded;
+        }
+        else
+            ++it;
+    }
+}
+
+/// @brief Cancel all jobs and remove all pages (page content keys reset)
+void TextureUpscaler::clear() noexcept
+{
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it)
+        it->second->state = job_state_t::cancelled;
+    m_stats.cancelled += m_jobs.size();
+    m_jobs.clear();
+    m_waitingJobs.clear();
+    m_pages.clear();
+}
+
+/// @brief End of frame: swap completed pages in, apply memory budget, start queued jobs (within frame budget)
+void TextureUpscaler::endFrame()
+{
+    ++m_frameIndex;
+
+    // swap completed pages in
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); )
+    {
+        upscaling_job_t& job = *(it->second);
+        if (job.state.load() == job_state_t::completed)
+        {
+            m_stats.workTime += job.duration;
+            m_averageJobCost = (m_averageJobCost * 7u + job.duration) / 8u;
+            if (job.result.empty() == false)
+            {
+                m_pages[job.pageId] = upscaled_page_t{ job.area, std::move(job.result), m_frameIndex };
+                ++m_stats.completed;
+            }
+            it = m_jobs.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    // memory budget: remove least recently used pages
+    while (m_pages.size() > m_maxPageCount)
+    {
+        auto oldest = m_pages.begin();
+        for (auto it = m_pages.begin(); it != m_pages.end(); ++it)
+        {
+            if (it->second.lastUse < oldest->second.lastUse)
+                oldest = it;
+        }
+        m_pages.erase(oldest);
+        ++m_stats.evictions;
+    }
+
+    // start queued jobs (at least one per frame)
+    uint32_t startedCost = 0u;
+    while (m_waitingJobs.empty() == false && (startedCost == 0u || startedCost + m_averageJobCost <= m_frameBudget))
+    {
+        std::shared_ptr<upscaling_job_t> pJob = m_waitingJobs.front();
+        m_waitingJobs.pop_front();
+        if (pJob->state.load() != job_state_t::queued) // cancelled
+            continue;
+
+        texture_scaling_function_t scalingFunction = m_scalingFunction;
+        const uint32_t factor = m_factor;
+        UpscaledTextureStore* pStore = m_pStore.get();
+        m_threadPool.post([pJob, scalingFunction, factor, pStore]() { runJob(pJob, scalingFunction, factor, pStore); });
+        startedCost += (m_averageJobCost > 0u) ? m_averageJobCost : 1u;
+    }
+}
@@ -0,0 +1,215 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : background texture upscaling (decoded texture pages)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "upscaled_texture_store.h"
+
+#define TEXTURE_UPSCALER_PAGE_SIZE            256 // source page width/height (texels)
+#define TEXTURE_UPSCALER_DEFAULT_FRAME_BUDGET 4000u // default upscaling work started per frame (microseconds of worker time)
+#define TEXTURE_UPSCALER_DEFAULT_MEMORY_BUDGET (64u * 1024u * 1024u) // default memory used by upscaled pages (bytes)
+#define TEXTURE_UPSCALER_INITIAL_JOB_COST     2000u // estimated job duration before first measure (microseconds)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.scaling
+    /// Image upscaling
+    namespace scaling
+    {
+        /// @brief Texture upscaling function (15-bit texels, 0 = transparent)
+        /// @param[in] pSource  Source texels (width x height)
+        /// @param[in] width    Source width
+        /// @param[in] height   Source height
+        /// @param[in] factor   Upscaling factor
+        /// @param[out] pOut    Upscaled texels (width*factor x height*factor)
+        typedef void (*texture_scaling_function_t)(const uint16_t* pSource, const uint32_t width, const uint32_t height, const uint32_t factor, uint16_t* pOut);
+
+        /// @struct texture_upscaler_stats_t
+        /// @brief Texture upscaler counters
+        struct texture_upscaler_stats_t
+        {
+            uint64_t requests;  ///< Upscaling jobs created
+            uint64_t completed; ///< Upscaled pages swapped in (usable for rendering)
+            uint64_t cancelled; ///< Jobs cancelled (source page invalidated before completion)
+            uint64_t discarded; ///< Upscaled pages removed (source page invalidated)
+            uint64_t evictions; ///< Upscaled pages removed to stay in memory budget (least recently used)
+            uint64_t workTime;  ///< Total worker time (microseconds)
+        };
+
+
+        /// @class TextureUpscaler
+        /// @brief Background texture page upscaling - results are swapped in at the end of a frame (native texture used meanwhile)
+        /// @details Pages are identified by their content key (texture page + palette): any VRAM write in the source area
+        ///          cancels pending jobs and removes upscaled pages. Upscaled pages are only removed/replaced at the end of a frame:
+        ///          rendering of the frame must be complete before endFrame() is called.
+        class TextureUpscaler
+        {
+        public:
+            /// @brief Create texture upscaler
+            /// @param[in] mode          Upscaling type
+            /// @param[in] factor        Upscaling factor (limited to UPSCALING_MODE_TEXTURE_MAX_FACTOR)
+            /// @param[in] workerCount   Number of background worker threads
+            /// @param[in] memoryBudget  Max memory used by upscaled pages (bytes)
+            /// @param[in] frameBudget   Max upscaling work started per frame (microseconds of worker time)
+            TextureUpscaler(const config::upscaling_mode_t mode, const uint32_t factor, const uint32_t workerCount = 1u,
+                            const size_t memoryBudget = TEXTURE_UPSCALER_DEFAULT_MEMORY_BUDGET, const uint32_t frameBudget = TEXTURE_UPSCALER_DEFAULT_FRAME_BUDGET);
+            /// @brief Cancel pending jobs and stop workers
+            ~TextureUpscaler();
+            // no copy allowed
+            TextureUpscaler(const TextureUpscaler& other) = delete;
+            TextureUpscaler& operator=(const TextureUpscaler& other) = delete;
+
+            /// @brief Get upscaling function of a mode (nearest neighbour for modes without software implementation)
+            /// @param[in] mode  Upscaling type
+            static texture_scaling_function_t getScalingFunction(const config::upscaling_mode_t mode) noexcept;
+            /// @brief Nearest neighbour upscaling (texel duplication)
+            static void scaleNearest(const uint16_t* pSource, const uint32_t width, const uint32_t height, const uint32_t factor, uint16_t* pOut);
+
+
+            // -- pages -- -----------------------------------------------------
+
+            /// @brief Find upscaled page
+            /// @param[in] pageId  Page content key
+            /// @returns Upscaled page (256*factor x 256*factor texels) or nullptr (native texture must be used)
+            const uint16_t* find(const uint64_t pageId) noexcept;
+            /// @brief Request page upscaling (ignored if already upscaled or in progress)
+            /// @param[in] pageId        Page content key
+            /// @param[in] pSourcePage   Decoded source page (256 x 256 texels) - copied
+            /// @param[in] sourceX       Source texel area in VRAM: left position
+            /// @param[in] sourceY       Source texel area in VRAM: top position
+            /// @param[in] sourceWidth   Source texel area in VRAM: width (VRAM units)
+            void request(const uint64_t pageId, const uint16_t* pSourcePage, const int32_t sourceX, const int32_t sourceY, const int32_t sourceWidth);
+
+            /// @brief Get upscaling factor
+            inline uint32_t factor() const noexcept { return m_factor; }
+            /// @brief Get upscaling type
+            inline config::upscaling_mode_t mode() const noexcept { return m_mode; }
+
+            /// @brief Open persistent cache of upscaled pages (can be called from any thread, before creating upscaler)
+            /// @param[in] directoryPath  Game cache directory (see UpscaledTextureStore::getGameDirectoryPath)
+            /// @param[in] mode           Upscaling type
+            /// @param[in] factor         Upscaling factor (limited to UPSCALING_MODE_TEXTURE_MAX_FACTOR)
+            /// @param[in] maxFileSize    Max cache file size (bytes)
+            /// @returns Open cache (or nullptr on failure)
+            static std::unique_ptr<UpscaledTextureStore> openPersistentCache(const std::string& directoryPath, const config::upscaling_mode_t mode, const uint32_t factor,
+                                                                             const size_t maxFileSize = UPSCALED_TEXTURE_STORE_DEFAULT_SIZE);
+            /// @brief Use persistent cache of upscaled pages (pending jobs cancelled)
+            /// @param[in] pStore  Open cache with same upscaling type/factor (see openPersistentCache) - nullptr to disable
+            /// @returns Success (cache compatible with upscaler)
+            bool setPersistentCache(std::unique_ptr<UpscaledTextureStore> pStore);
+            /// @brief Get persistent cache of upscaled pages (or nullptr if disabled)
+            inline UpscaledTextureStore* getPersistentCache() const noexcept { return m_pStore.get(); }
+
+
+            // -- invalidation / frames -- -------------------------------------
+
+            /// @brief Cancel jobs and remove pages whose source area overlaps a written VRAM area (with VRAM wrapping)
+            /// @param[in] left    Left limit of written area (inclusive)
+            /// @param[in] top     Top limit of written area (inclusive)
+            /// @param[in] right   Right limit of written area (inclusive)
+            /// @param[in] bottom  Bottom limit of written area (inclusive)
+            void invalidateArea(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept;
+            /// @brief Cancel all jobs and remove all pages (page content keys reset)
+            void clear() noexcept;
+            /// @brief End of frame: swap completed pages in, apply memory budget, start queued jobs (within frame budget)
+            void endFrame();
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Get number of usable upscaled pages
+            inline size_t size() const noexcept { return m_pages.size(); }
+            /// @brief Get number of jobs not swapped in yet (queued, in progress or completed)
+            inline size_t pendingJobCount() const noexcept { return m_jobs.size(); }
+            /// @brief Get upscaler counters
+            inline const texture_upscaler_stats_t& getStats() const noexcept { return m_stats; }
+            /// @brief Reset upscaler counters
+            inline void resetStats() noexcept { m_stats = texture_upscaler_stats_t{ 0uLL, 0uLL, 0uLL, 0uLL, 0uLL, 0uLL }; }
+
+
+        private:
+            /// @enum job_state_t
+            /// @brief Upscaling job state
+            enum job_state_t : uint32_t
+            {
+                queued = 0u,
+                running = 1u,
+                completed = 2u,
+                cancelled = 3u
+            };
+            /// @struct source_area_t
+            /// @brief Source texel area in VRAM
+            struct source_area_t
+            {
+                int32_t x;
+                int32_t y;
+                int32_t width;
+            };
+            /// @struct upscaling_job_t
+            /// @brief Upscaling job (shared with worker thread)
+            struct upscaling_job_t
+            {
+                uint64_t pageId;               ///< Page content key
+                source_area_t area;            ///< Source texel area
+                std::vector<uint16_t> source;  ///< Source page copy
+                std::vector<uint16_t> result;  ///< Upscaled page
+                std::atomic<uint32_t> state;   ///< Job state (job_state_t)
+                uint32_t duration;             ///< Worker time (microseconds)
+            };
+            /// @struct upscaled_page_t
+            /// @brief Usable upscaled page
+            struct upscaled_page_t
+            {
+                source_area_t area;           ///< Source texel area
+                std::vector<uint16_t> texels; ///< Upscaled texels
+                uint64_t lastUse;             ///< Last frame of use (LRU)
+            };
+
+            /// @brief Upscale page (worker thread)
+            static void runJob(const std::shared_ptr<upscaling_job_t>& pJob, texture_scaling_function_t scalingFunction, const uint32_t factor,
+                               UpscaledTextureStore* pStore) noexcept;
+            /// @brief Check if source area overlaps a written area
+            static bool isAreaWritten(const source_area_t& area, const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept;
+            /// @brief Limit upscaling factor to supported values
+            static inline uint32_t toValidFactor(const uint32_t factor) noexcept
+            {
+                return (factor == 0u) ? 1u : ((factor > UPSCALING_MODE_TEXTURE_MAX_FACTOR) ? UPSCALING_MODE_TEXTURE_MAX_FACTOR : factor);
+            }
+            /// @brief Get memory used by one upscaled page
+            static inline size_t getPageBytes(const uint32_t factor) noexcept { return TEXTURE_UPSCALER_PAGE_SIZE * TEXTURE_UPSCALER_PAGE_SIZE * factor * factor * sizeof(uint16_t); }
+
+
+        private:
+            config::upscaling_mode_t m_mode;                 ///< Upscaling type
+            uint32_t m_factor;                               ///< Upscaling factor
+            texture_scaling_function_t m_scalingFunction;    ///< Upscaling implementation
+            std::unordered_map<uint64_t, std::shared_ptr<upscaling_job_t>> m_jobs; ///< Jobs not swapped in yet (by page key)
+            std::deque<std::shared_ptr<upscaling_job_t>> m_waitingJobs;            ///< Jobs not started yet (started at end of frame)
+            std::unordered_map<uint64_t, upscaled_page_t> m_pages;                 ///< Usable upscaled pages (by page key)
+            size_t m_maxPageCount;                           ///< Max number of upscaled pages (memory budget)
+            uint32_t m_frameBudget;                          ///< Max upscaling work started per frame (microseconds)
+            uint32_t m_averageJobCost;                       ///< Average measured job duration (microseconds)
+            uint64_t m_frameIndex;                           ///< Current frame (LRU)
+            texture_upscaler_stats_t m_stats;                ///< Upscaler counters
+            std::unique_ptr<UpscaledTextureStore> m_pStore;  ///< Persistent cache (used by workers: destroyed after thread pool)
+            ::utils::thread::ThreadPool m_threadPool;        ///< Background workers (separate from rendering threads)
+        };
+    }
+}
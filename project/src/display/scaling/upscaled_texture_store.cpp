@@ -0,0 +1,305 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : persistent cache of upscaled textures (memory-mapped file per game)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+using namespace std::literals::string_literals;
+#include "../../events/utils/file_io.h"
+#include "upscaled_texture_store.h"
+using namespace display::scaling;
+
+#ifdef _WINDOWS
+#define UPSCALED_TEXTURE_STORE_SEPARATOR "\\"
+#else
+#define UPSCALED_TEXTURE_STORE_SEPARATOR "/"
+#endif
+
+/// @brief Round size to file sections alignment
+static inline size_t alignSize(const size_t size) noexcept
+{
+    return (size + UPSCALED_TEXTURE_STORE_ALIGNMENT - 1u) & ~static_cast<size_t>(UPSCALED_TEXTURE_STORE_ALIGNMENT - 1u);
+}
+
+
+/// @brief Create closed store
+UpscaledTextureStore::UpscaledTextureStore() noexcept
+    : m_mode(config::upscaling_mode_t::native), m_factor(1u), m_slotCount(0u), m_allocatedSlots(0u), m_slotBytes(0u), m_pageBytes(0u), m_indexOffset(0u), m_dataOffset(0u),
+      m_stats{ 0uLL, 0uLL, 0uLL, 0uLL } {}
+
+/// @brief Get cache directory of a game (created if necessary)
+/// @param[in] gameId  Game executable identifier (from GPUsetExeName)
+/// @returns Directory path (or empty string if game unknown or directory not available)
+std::string UpscaledTextureStore::getGameDirectoryPath(const std::string& gameId)
+{
+    // game identifier -> valid directory name
+    std::string directoryName;
+    directoryName.reserve(gameId.size());
+    for (auto it = gameId.begin(); it != gameId.end(); ++it)
+    {
+        char c = *it;
+        bool isValid = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.');
+        directoryName += (isValid) ? c : '_';
+    }
+    if (directoryName.empty() || directoryName.find_first_not_of('.') == std::string::npos)
+        return ""s;
+
+    std::string basePath = events::utils::FileIO::getWritableFilePath() + UPSCALED_TEXTURE_STORE_DIRECTORY;
+    std::string gamePath = basePath + UPSCALED_TEXTURE_STORE_SEPARATOR + directoryName;
+    if (::utils::io::MappedFile::createDirectory(basePath) == false || ::utils::io::MappedFile::createDirectory(gamePath) == false)
+        return ""s;
+    return gamePath + UPSCALED_TEXTURE_STORE_SEPARATOR;
+}
+
+/// @brief Compute content hash of source texels (decoded page: texels + CLUT)
+/// @param[in] pTexels     Source texels
+/// @param[in] texelCount  Number of texels
+uint64_t UpscaledTextureStore::computeHash(const uint16_t* pTexels, const size_t texelCount) noexcept
+{
+    // FNV-1a on 64-bit words (4 texels) + texel count
+    uint64_t hash = 14695981039346656037uLL ^ static_cast<uint64_t>(texelCount);
+    size_t i = 0;
+    for (; i + 4u <= texelCount; i += 4u)
+    {
+        uint64_t block;
+        memcpy(&block, &pTexels[i], sizeof(uint64_t));
+        hash = (hash ^ block) * 1099511628211uLL;
+        hash ^= (hash >> 29);
+    }
+    for (; i < texelCount; ++i)
+        hash = (hash ^ pTexels[i]) * 1099511628211uLL;
+    return hash;
+}
+
+
+// -- file management -- -------------------------------------------------------
+
+/// @brief Open (or create) cache file - file is reset if its version, type, factor or size limit differs
+/// @param[in] directoryPath  Game cache directory (see getGameDirectoryPath)
+/// @param[in] mode           Upscaling type
+/// @param[in] factor         Upscaling factor
+/// @param[in] pageBytes      Size of an upscaled page (bytes)
+/// @param[in] maxFileSize    Max file size (bytes)
+/// @returns Success
+bool UpscaledTextureStore::open(const std::string& directoryPath, const config::upscaling_mode_t mode, const uint32_t factor, const size_t pageBytes, const size_t maxFileSize)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_file.close();
+    m_slotIndexes.clear();
+    m_freeSlots.clear();
+    if (directoryPath.empty() || pageBytes == 0u)
+        return false;
+
+    // file geometry (size limit)
+    m_pageBytes = pageBytes;
+    m_slotBytes = alignSize(pageBytes);
+    const size_t headerBytes = alignSize(sizeof(file_header_t));
+    m_slotCount = (maxFileSize > headerBytes) ? (maxFileSize - headerBytes) / (m_slotBytes + sizeof(index_entry_t)) : 0u;
+    if (m_slotCount == 0u)
+        return false;
+    m_indexOffset = headerBytes;
+    m_dataOffset = m_indexOffset + alignSize(m_slotCount * sizeof(index_entry_t));
+
+    // header + index: page slots already allocated in existing file are kept
+    std::string filePath = directoryPath + "textures_"s + std::to_string(static_cast<uint32_t>(mode)) + "_x"s + std::to_string(factor) + ".cache"s;
+    if (m_file.open(filePath, m_dataOffset, true) == false)
+        return false;
+    m_mode = mode;
+    m_factor = factor;
+
+    // check file version/geometry
+    const file_header_t* pHeader = reinterpret_cast<const file_header_t*>(m_file.data());
+    if (m_file.isCreated() || pHeader->magic != UPSCALED_TEXTURE_STORE_MAGIC || pHeader->version != UPSCALED_TEXTURE_STORE_VERSION
+    ||  pHeader->mode != static_cast<uint32_t>(mode) || pHeader->factor != factor || pHeader->slotCount != m_slotCount || pHeader->slotBytes != m_slotBytes)
+    {
+        reset(mode, factor);
+        if (m_file.size() != m_dataOffset && m_file.resize(m_dataOffset) == false) // remove previous page slots
+            return false;
+    }
+    m_allocatedSlots = (m_file.size() - m_dataOffset) / m_slotBytes;
+    if (m_allocatedSlots > m_slotCount)
+        m_allocatedSlots = m_slotCount;
+
+    // read index (allocated slots)
+    const index_entry_t* pIndex = getIndex();
+    m_slotIndexes.reserve(m_allocatedSlots);
+    for (size_t slot = m_allocatedSlots; slot > 0u; --slot)
+    {
+        if (pIndex[slot - 1u].isUsed != 0u)
+            m_slotIndexes[pIndex[slot - 1u].contentHash] = slot - 1u;
+        else
+            m_freeSlots.push_back(slot - 1u);
+    }
+    return true;
+}
+
+/// @brief Reset file content (header + empty index)
+void UpscaledTextureStore::reset(const config::upscaling_mode_t mode, const uint32_t factor) noexcept
+{
+    memset(m_file.data() + m_indexOffset, 0, m_dataOffset - m_indexOffset);
+    file_header_t* pHeader = reinterpret_cast<file_header_t*>(m_file.data());
+    pHeader->magic = UPSCALED_TEXTURE_STORE_MAGIC;
+    pHeader->version = UPSCALED_TEXTURE_STORE_VERSION;
+    pHeader->mode = static_cast<uint32_t>(mode);
+    pHeader->factor = factor;
+    pHeader->slotCount = m_slotCount;
+    pHeader->slotBytes = m_slotBytes;
+    pHeader->clock = 0uLL;
+}
+
+/// @brief Add page slots at the end of file (new slots added to free slots)
+/// @returns Success (false if file size limit is reached or if file can't be extended)
+bool UpscaledTextureStore::extendSlots() noexcept
+{
+    if (m_allocatedSlots >= m_slotCount)
+        return false;
+    const size_t slotCount = (m_slotCount - m_allocatedSlots > UPSCALED_TEXTURE_STORE_GROWTH) ? m_allocatedSlots + UPSCALED_TEXTURE_STORE_GROWTH : m_slotCount;
+    if (m_file.resize(m_dataOffset + slotCount * m_slotBytes) == false)
+    {
+        m_slotIndexes.clear(); // file closed
+        m_freeSlots.clear();
+        m_allocatedSlots = 0u;
+        return false;
+    }
+    for (size_t slot = slotCount; slot > m_allocatedSlots; --slot) // lowest slot used first
+        m_freeSlots.push_back(slot - 1u);
+    m_allocatedSlots = slotCount;
+    return true;
+}
+
+/// @brief Close cache file
+void UpscaledTextureStore::close() noexcept
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_file.close();
+    m_slotIndexes.clear();
+    m_freeSlots.clear();
+    m_allocatedSlots = 0u;
+}
+
+
+// -- pages -- -----------------------------------------------------------------
+
+/// @brief Load upscaled page
+/// @param[in] contentHash  Source content hash
+/// @param[out] pOutData    Upscaled page destination (page size)
+/// @returns Page found
+bool UpscaledTextureStore::load(const uint64_t contentHash, void* pOutData)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_file.isOpen() == false)
+        return false;
+    auto it = m_slotIndexes.find(contentHash);
+    if (it == m_slotIndexes.end())
+    {
+        ++m_stats.misses;
+        return false;
+    }
+
+    file_header_t* pHeader = reinterpret_cast<file_header_t*>(m_file.data());
+    getIndex()[it->second].lastUse = ++(pHeader->clock);
+    memcpy(pOutData, getSlotData(it->second), m_pageBytes);
+    ++m_stats.hits;
+    return true;
+}
+
+/// @brief Store upscaled page (least recently used page replaced if file is full)
+/// @param[in] contentHash  Source content hash
+/// @param[in] pData        Upscaled page (page size)
+void UpscaledTextureStore::store(const uint64_t contentHash, const void* pData)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_file.isOpen() == false || m_slotIndexes.find(contentHash) != m_slotIndexes.end())
+        return;
+
+    // find slot (file extended if all allocated slots are used)
+    if (m_freeSlots.empty() && extendSlots() == false && m_slotIndexes.empty())
+        return;
+    index_entry_t* pIndex = getIndex(); // after file extension (memory mapped again)
+    size_t slot;
+    if (m_freeSlots.empty() == false)
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else // evict least recently used page
+    {
+        slot = 0u;
+        for (size_t i = 1u; i < m_allocatedSlots; ++i)
+        {
+            if (pIndex[i].lastUse < pIndex[slot].lastUse)
+                slot = i;
+        }
+        m_slotIndexes.erase(pIndex[slot].contentHash);
+        ++m_stats.evictions;
+    }
+
+    // write page before marking entry as used (incomplete pages never indexed)
+    pIndex[slot].isUsed = 0u;
+    memcpy(getSlotData(slot), pData, m_pageBytes);
+    file_header_t* pHeader = reinterpret_cast<file_header_t*>(m_file.data());
+    pIndex[slot].contentHash = contentHash;
+    pIndex[slot].lastUse = ++(pHeader->clock);
+    pIndex[slot].isUsed = 1u;
+
+    m_slotIndexes[contentHash] = slot;
+    ++m_stats.writes;
+}
+
+/// @brief Preload most recently used pages from disk (before first frame)
+/// @param[in] maxPageCount  Max number of pages to preload
+/// @returns Number of preloaded pages
+size_t UpscaledTextureStore::warmUp(const size_t maxPageCount)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_file.isOpen() == false || maxPageCount == 0u)
+        return 0u;
+
+    // sort stored pages by last use
+    const index_entry_t* pIndex = getIndex();
+    std::vector<size_t> slots;
+    slots.reserve(m_slotIndexes.size());
+    for (auto it = m_slotIndexes.begin(); it != m_slotIndexes.end(); ++it)
+        slots.push_back(it->second);
+    const size_t pageCount = (slots.size() < maxPageCount) ? slots.size() : maxPageCount;
+    std::partial_sort(slots.begin(), slots.begin() + pageCount, slots.end(), [pIndex](const size_t lhs, const size_t rhs) { return pIndex[lhs].lastUse > pIndex[rhs].lastUse; });
+
+    // read one byte per memory page -> loaded by the system
+    uint8_t checksum = 0u;
+    for (size_t i = 0; i < pageCount; ++i)
+    {
+        const volatile uint8_t* pData = getSlotData(slots[i]);
+        for (size_t offset = 0; offset < m_pageBytes; offset += UPSCALED_TEXTURE_STORE_ALIGNMENT)
+            checksum ^= pData[offset];
+    }
+    (void)checksum;
+    return pageCount;
+}
+
+
+// -- statistics -- ------------------------------------------------------------
+
+/// @brief Get number of stored pages
+size_t UpscaledTextureStore::size()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_slotIndexes.size();
+}
+
+/// @brief Get store counters
+upscaled_texture_store_stats_t UpscaledTextureStore::getStats()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_stats;
+}
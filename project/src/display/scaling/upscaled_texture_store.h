@@ -0,0 +1,173 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : persistent cache of upscaled textures (memory-mapped file per game)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include "../../utils/io/mapped_file.h"
+#include "../../config/config_common.h"
+
+#define UPSCALED_TEXTURE_STORE_MAGIC        0x43544750u // "PGTC"
+#define UPSCALED_TEXTURE_STORE_VERSION      2u          // file format version (+ scaler implementations): older files are reset
+#define UPSCALED_TEXTURE_STORE_DEFAULT_SIZE (256u * 1024u * 1024u) // default max file size (bytes)
+#define UPSCALED_TEXTURE_STORE_DIRECTORY    "pandoraGS_cache"
+#define UPSCALED_TEXTURE_STORE_ALIGNMENT    4096u       // file sections alignment (bytes)
+#define UPSCALED_TEXTURE_STORE_GROWTH       16u         // number of page slots added when file is extended
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.scaling
+    /// Image upscaling
+    namespace scaling
+    {
+        /// @struct upscaled_texture_store_stats_t
+        /// @brief Persistent texture cache counters
+        struct upscaled_texture_store_stats_t
+        {
+            uint64_t hits;      ///< Upscaled pages loaded from file
+            uint64_t misses;    ///< Pages not found in file
+            uint64_t writes;    ///< Upscaled pages written in file
+            uint64_t evictions; ///< Pages replaced to stay in file size limit (least recently used)
+        };
+
+
+        /// @class UpscaledTextureStore
+        /// @brief Persistent cache of upscaled texture pages - one memory-mapped file per game, upscaling type and factor
+        /// @details File: header (version, type, factor, slot geometry) + index (content hash, last use) + fixed-size page slots.
+        ///          The index is sized for the file size limit, but page slots are only added to the file when they're needed.
+        ///          Only the index is read when the file is opened: page data is loaded by the system when a page is used.
+        ///          Thread-safe: used by upscaling worker threads.
+        class UpscaledTextureStore
+        {
+        public:
+            /// @brief Create closed store
+            UpscaledTextureStore() noexcept;
+            /// @brief Close store (modified pages written by the system)
+            ~UpscaledTextureStore() { close(); }
+            // no copy allowed
+            UpscaledTextureStore(const UpscaledTextureStore& other) = delete;
+            UpscaledTextureStore& operator=(const UpscaledTextureStore& other) = delete;
+
+            /// @brief Get cache directory of a game (created if necessary)
+            /// @param[in] gameId  Game executable identifier (from GPUsetExeName)
+            /// @returns Directory path (or empty string if game unknown or directory not available)
+            static std::string getGameDirectoryPath(const std::string& gameId);
+            /// @brief Compute content hash of source texels (decoded page: texels + CLUT)
+            /// @param[in] pTexels     Source texels
+            /// @param[in] texelCount  Number of texels
+            static uint64_t computeHash(const uint16_t* pTexels, const size_t texelCount) noexcept;
+
+
+            // -- file management -- -------------------------------------------
+
+            /// @brief Open (or create) cache file - file is reset if its version, type, factor or size limit differs
+            /// @param[in] directoryPath  Game cache directory (see getGameDirectoryPath)
+            /// @param[in] mode           Upscaling type
+            /// @param[in] factor         Upscaling factor
+            /// @param[in] pageBytes      Size of an upscaled page (bytes)
+            /// @param[in] maxFileSize    Max file size (bytes)
+            /// @returns Success
+            bool open(const std::string& directoryPath, const config::upscaling_mode_t mode, const uint32_t factor, const size_t pageBytes,
+                      const size_t maxFileSize = UPSCALED_TEXTURE_STORE_DEFAULT_SIZE);
+            /// @brief Close cache file
+            void close() noexcept;
+            /// @brief Check if cache file is open
+            inline bool isOpen() const noexcept { return m_file.isOpen(); }
+            /// @brief Get upscaling type of stored pages
+            inline config::upscaling_mode_t mode() const noexcept { return m_mode; }
+            /// @brief Get upscaling factor of stored pages
+            inline uint32_t factor() const noexcept { return m_factor; }
+
+
+            // -- pages -- -----------------------------------------------------
+
+            /// @brief Load upscaled page
+            /// @param[in] contentHash  Source content hash
+            /// @param[out] pOutData    Upscaled page destination (page size)
+            /// @returns Page found
+            bool load(const uint64_t contentHash, void* pOutData);
+            /// @brief Store upscaled page (least recently used page replaced if file is full)
+            /// @param[in] contentHash  Source content hash
+            /// @param[in] pData        Upscaled page (page size)
+            void store(const uint64_t contentHash, const void* pData);
+            /// @brief Preload most recently used pages from disk (before first frame)
+            /// @param[in] maxPageCount  Max number of pages to preload
+            /// @returns Number of preloaded pages
+            size_t warmUp(const size_t maxPageCount);
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Get number of stored pages
+            size_t size();
+            /// @brief Get max number of stored pages
+            inline size_t capacity() const noexcept { return m_slotCount; }
+            /// @brief Get number of page slots currently allocated in file
+            inline size_t allocatedSlots() const noexcept { return m_allocatedSlots; }
+            /// @brief Get store counters
+            upscaled_texture_store_stats_t getStats();
+
+
+        private:
+            /// @struct file_header_t
+            /// @brief Cache file header
+            struct file_header_t
+            {
+                uint32_t magic;     ///< File type identifier
+                uint32_t version;   ///< File format version
+                uint32_t mode;      ///< Upscaling type
+                uint32_t factor;    ///< Upscaling factor
+                uint64_t slotCount; ///< Number of page slots
+                uint64_t slotBytes; ///< Size of a page slot
+                uint64_t clock;     ///< Access counter (LRU)
+            };
+            /// @struct index_entry_t
+            /// @brief Cache file index entry (one per slot)
+            struct index_entry_t
+            {
+                uint64_t contentHash; ///< Source content hash
+                uint64_t lastUse;     ///< Last access (clock value)
+                uint32_t isUsed;      ///< Slot contains a complete page
+                uint32_t reserved;
+            };
+
+            /// @brief Get index entries
+            inline index_entry_t* getIndex() const noexcept { return reinterpret_cast<index_entry_t*>(m_file.data() + m_indexOffset); }
+            /// @brief Get page slot data
+            inline uint8_t* getSlotData(const size_t slot) const noexcept { return m_file.data() + m_dataOffset + slot * m_slotBytes; }
+            /// @brief Reset file content (header + empty index)
+            void reset(const config::upscaling_mode_t mode, const uint32_t factor) noexcept;
+            /// @brief Add page slots at the end of file (new slots added to free slots)
+            /// @returns Success (false if file size limit is reached or if file can't be extended)
+            bool extendSlots() noexcept;
+
+
+        private:
+            ::utils::io::MappedFile m_file;  ///< Memory-mapped cache file
+            config::upscaling_mode_t m_mode; ///< Upscaling type of stored pages
+            uint32_t m_factor;               ///< Upscaling factor of stored pages
+            size_t m_slotCount;              ///< Max number of page slots (file size limit)
+            size_t m_allocatedSlots;         ///< Number of page slots allocated in file
+            size_t m_slotBytes;              ///< Size of a page slot (aligned in file)
+            size_t m_pageBytes;              ///< Size of an upscaled page
+            size_t m_indexOffset;            ///< Index position in file
+            size_t m_dataOffset;             ///< Page slots position in file
+            std::unordered_map<uint64_t, size_t> m_slotIndexes; ///< Slot of each stored page (by content hash)
+            std::vector<size_t> m_freeSlots; ///< Available slots
+            upscaled_texture_store_stats_t m_stats; ///< Store counters
+            std::mutex m_lock;               ///< Worker threads synchronization
+        };
+    }
+}
@@ -0,0 +1,462 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - packed 15-bit semi-transparency kernels
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#if _SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#include "../../command/primitive/primitive_common.h"
+#include "blend_kernels.h"
+using namespace display::software;
+using command::primitive::stp_t;
+
+// packed channel masks (mBbb-bbGg-gggR-rrrr)
+#define PACKED_HALF_MASK      0x3DEFu // channels without high bit (after >>1)
+#define PACKED_QUARTER_MASK   0x1CE7u // channels without 2 high bits (after >>2)
+#define PACKED_CARRY_BITS     0x8420u // carry bits above each channel
+#define PACKED_LOW_BITS       0x0421u // lowest bit of each channel
+#define PACKED_RB_MASK        0x7C1Fu // red + blue channels
+#define PACKED_RB_GUARD_BITS  0x8020u // guard bits above red + blue
+#define PACKED_G_MASK         0x03E0u // green channel
+#define PACKED_G_GUARD_BIT    0x0400u // guard bit above green
+
+
+// -- packed blending operations -- --------------------------------------------
+// -> inputs never contain mask bit: every channel operation is done in place with carry/borrow guards
+
+/// @struct blend_mean_op_t
+/// @brief Semi-transparency operation: B/2 + F/2
+struct blend_mean_op_t
+{
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept
+    {
+        return ((back >> 1) & PACKED_HALF_MASK) + ((front >> 1) & PACKED_HALF_MASK);
+    }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept
+    {
+        const __m128i halfMask = _mm_set1_epi16(PACKED_HALF_MASK);
+        return _mm_add_epi16(_mm_and_si128(_mm_srli_epi16(back, 1), halfMask), _mm_and_si128(_mm_srli_epi16(front, 1), halfMask));
+    }
+    #endif
+};
+
+/// @struct blend_add_op_t
+/// @brief Semi-transparency operation: B + F (saturated)
+struct blend_add_op_t
+{
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept
+    {
+        // overflowed channels: sum without low bits is even for each channel -> no carry propagation from lower channels
+        uint32_t sum = back + front;
+        uint32_t carry = (sum - ((back ^ front) & PACKED_LOW_BITS)) & PACKED_CARRY_BITS;
+        return ((sum - carry) | (carry - (carry >> 5))) & BLEND_KERNEL_COLOR_BITS;
+    }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept
+    {
+        __m128i sum = _mm_add_epi16(back, front);
+        __m128i carry = _mm_sub_epi16(sum, _mm_and_si128(_mm_xor_si128(back, front), _mm_set1_epi16(PACKED_LOW_BITS)));
+        carry = _mm_and_si128(carry, _mm_set1_epi16(static_cast<int16_t>(PACKED_CARRY_BITS)));
+        return _mm_or_si128(_mm_sub_epi16(sum, carry), _mm_sub_epi16(carry, _mm_srli_epi16(carry, 5)));
+    }
+    #endif
+};
+
+/// @struct blend_sub_op_t
+/// @brief Semi-transparency operation: B - F (saturated)
+struct blend_sub_op_t
+{
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept
+    {
+        // red + blue (guard bit remains set if no borrow)
+        uint32_t diffRB = ((back & PACKED_RB_MASK) | PACKED_RB_GUARD_BITS) - (front & PACKED_RB_MASK);
+        uint32_t guardRB = diffRB & PACKED_RB_GUARD_BITS;
+        // green
+        uint32_t diffG = ((back & PACKED_G_MASK) | PACKED_G_GUARD_BIT) - (front & PACKED_G_MASK);
+        uint32_t guardG = diffG & PACKED_G_GUARD_BIT;
+        return (diffRB & (guardRB - (guardRB >> 5))) | (diffG & (guardG - (guardG >> 5)));
+    }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept
+    {
+        const __m128i maskRB = _mm_set1_epi16(PACKED_RB_MASK);
+        const __m128i guardBitsRB = _mm_set1_epi16(static_cast<int16_t>(PACKED_RB_GUARD_BITS));
+        const __m128i maskG = _mm_set1_epi16(PACKED_G_MASK);
+        const __m128i guardBitG = _mm_set1_epi16(PACKED_G_GUARD_BIT);
+
+        __m128i diffRB = _mm_sub_epi16(_mm_or_si128(_mm_and_si128(back, maskRB), guardBitsRB), _mm_and_si128(front, maskRB));
+        __m128i guardRB = _mm_and_si128(diffRB, guardBitsRB);
+        __m128i diffG = _mm_sub_epi16(_mm_or_si128(_mm_and_si128(back, maskG), guardBitG), _mm_and_si128(front, maskG));
+        __m128i guardG = _mm_and_si128(diffG, guardBitG);
+        return _mm_or_si128(_mm_and_si128(diffRB, _mm_sub_epi16(guardRB, _mm_srli_epi16(guardRB, 5))),
+                            _mm_and_si128(diffG, _mm_sub_epi16(guardG, _mm_srli_epi16(guardG, 5))));
+    }
+    #endif
+};
+
+/// @struct blend_add_part_op_t
+/// @brief Semi-transparency operation: B + F/4 (saturated)
+struct blend_add_part_op_t
+{
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept
+    {
+        return blend_add_op_t::apply(back, (front >> 2) & PACKED_QUARTER_MASK);
+    }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept
+    {
+        return blend_add_op_t::apply(back, _mm_and_si128(_mm_srli_epi16(front, 2), _mm_set1_epi16(PACKED_QUARTER_MASK)));
+    }
+    #endif
+};
+
+/// @struct blend_opaque_op_t
+/// @brief Opaque operation: F
+struct blend_opaque_op_t
+{
+    static inline uint32_t apply(const uint32_t, const uint32_t front) noexcept
+    {
+        return front;
+    }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i, const __m128i front) noexcept
+    {
+        return front;
+    }
+    #endif
+};
+
+
+// -- RGBA blending operations -- ----------------------------------------------
+// -> 8-bit channels: saturation with unsigned saturated arithmetic (alpha byte is replaced after blending)
+
+/// @brief Blend RGBA channels separately (scalar)
+template <typename ChannelOp>
+static inline uint32_t blendChannels32(const uint32_t back, const uint32_t front) noexcept
+{
+    uint32_t out = 0u;
+    for (uint32_t shift = 0u; shift < 24u; shift += 8u)
+    {
+        int32_t channel = ChannelOp::apply(static_cast<int32_t>((back >> shift) & 0xFFu), static_cast<int32_t>((front >> shift) & 0xFFu));
+        out |= static_cast<uint32_t>((channel < 0) ? 0 : ((channel > 0xFF) ? 0xFF : channel)) << shift;
+    }
+    return out;
+}
+
+/// @struct blend_mean_op32_t
+/// @brief Semi-transparency operation: B/2 + F/2
+struct blend_mean_op32_t
+{
+    static inline int32_t apply(const int32_t back, const int32_t front) noexcept { return (back >> 1) + (front >> 1); }
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept
+    {
+        return ((back >> 1) & 0x7F7F7F7Fu) + ((front >> 1) & 0x7F7F7F7Fu);
+    }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept
+    {
+        const __m128i halfMask = _mm_set1_epi32(0x7F7F7F7F);
+        return _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(back, 1), halfMask), _mm_and_si128(_mm_srli_epi32(front, 1), halfMask));
+    }
+    #endif
+};
+
+/// @struct blend_add_op32_t
+/// @brief Semi-transparency operation: B + F (saturated)
+struct blend_add_op32_t
+{
+    static inline int32_t apply(const int32_t back, const int32_t front) noexcept { return back + front; }
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept { return blendChannels32<blend_add_op32_t>(back, front); }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept { return _mm_adds_epu8(back, front); }
+    #endif
+};
+
+/// @struct blend_sub_op32_t
+/// @brief Semi-transparency operation: B - F (saturated)
+struct blend_sub_op32_t
+{
+    static inline int32_t apply(const int32_t back, const int32_t front) noexcept { return back - front; }
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept { return blendChannels32<blend_sub_op32_t>(back, front); }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept { return _mm_subs_epu8(back, front); }
+    #endif
+};
+
+/// @struct blend_add_part_op32_t
+/// @brief Semi-transparency operation: B + F/4 (saturated)
+struct blend_add_part_op32_t
+{
+    static inline int32_t apply(const int32_t back, const int32_t front) noexcept { return back + (front >> 2); }
+    static inline uint32_t apply(const uint32_t back, const uint32_t front) noexcept { return blendChannels32<blend_add_part_op32_t>(back, front); }
+    #if _SIMD_SSE2
+    static inline __m128i apply(const __m128i back, const __m128i front) noexcept
+    {
+        return _mm_adds_epu8(back, _mm_and_si128(_mm_srli_epi32(front, 2), _mm_set1_epi32(0x3F3F3F3F)));
+    }
+    #endif
+};
+
+
+// -- kernels -- ---------------------------------------------------------------
+
+#if _SIMD_SSE2
+/// @brief Blend 8 pixels
+template <typename BlendOp, bool IsTextured, bool IsBlended>
+static inline void blendBlock8(uint16_t* pDest, const uint16_t* pSource, const __m128i forcedMaskBit, const bool isMaskChecked) noexcept
+{
+    const __m128i colorBits = _mm_set1_epi16(BLEND_KERNEL_COLOR_BITS);
+    __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDest));
+    __m128i front = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource));
+    __m128i frontColor = _mm_and_si128(front, colorBits);
+
+    __m128i out = (IsBlended) ? BlendOp::apply(_mm_and_si128(back, colorBits), frontColor) : frontColor;
+    __m128i keptPixels = _mm_setzero_si128();
+    if (IsTextured)
+    {
+        if (IsBlended) // only blend texels with mask bit
+        {
+            __m128i semiTransparentTexels = _mm_srai_epi16(front, 15);
+            out = _mm_or_si128(_mm_and_si128(semiTransparentTexels, out), _mm_andnot_si128(semiTransparentTexels, frontColor));
+        }
+        out = _mm_or_si128(out, _mm_andnot_si128(colorBits, front)); // keep texel mask bit
+        keptPixels = _mm_cmpeq_epi16(front, keptPixels); // transparent texels
+    }
+    out = _mm_or_si128(out, forcedMaskBit);
+    if (isMaskChecked)
+        keptPixels = _mm_or_si128(keptPixels, _mm_srai_epi16(back, 15));
+
+    out = _mm_or_si128(_mm_and_si128(keptPixels, back), _mm_andnot_si128(keptPixels, out));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDest), out);
+}
+#endif
+
+/// @brief Blend row of pixels (16 pixels per iteration, then 8, then remaining pixels)
+template <typename BlendOp, bool IsTextured, bool IsBlended>
+static void blendRow(uint16_t* pDest, const uint16_t* pSource, const size_t length, const uint16_t forcedMaskBit, const bool isMaskChecked)
+{
+    size_t i = 0;
+    #if _SIMD_SSE2
+    const __m128i forcedMaskBits = _mm_set1_epi16(static_cast<int16_t>(forcedMaskBit));
+    for (; i + 16u <= length; i += 16u)
+    {
+        blendBlock8<BlendOp, IsTextured, IsBlended>(pDest + i, pSource + i, forcedMaskBits, isMaskChecked);
+        blendBlock8<BlendOp, IsTextured, IsBlended>(pDest + i + 8u, pSource + i + 8u, forcedMaskBits, isMaskChecked);
+    }
+    if (i + 8u <= length)
+    {
+        blendBlock8<BlendOp, IsTextured, IsBlended>(pDest + i, pSource + i, forcedMaskBits, isMaskChecked);
+        i += 8u;
+    }
+    #endif
+
+    // remaining pixels
+    for (; i < length; ++i)
+    {
+        uint32_t back = pDest[i];
+        uint32_t front = pSource[i];
+        if ((isMaskChecked && (back & BLEND_KERNEL_MASK_BIT)) || (IsTextured && front == 0u))
+            continue;
+
+        uint32_t out;
+        if (IsBlended && (!IsTextured || (front & BLEND_KERNEL_MASK_BIT)))
+            out = BlendOp::apply(back & BLEND_KERNEL_COLOR_BITS, front & BLEND_KERNEL_COLOR_BITS);
+        else
+            out = front & BLEND_KERNEL_COLOR_BITS;
+        if (IsTextured)
+            out |= (front & BLEND_KERNEL_MASK_BIT);
+        pDest[i] = static_cast<uint16_t>(out | forcedMaskBit);
+    }
+}
+
+
+#if _SIMD_SSE2
+/// @brief Blend 4 RGBA pixels
+template <typename BlendOp, bool IsTextured, bool IsBlended>
+static inline void blendBlock4x32(uint32_t* pDest, const uint32_t* pSource, const __m128i forcedMaskBit, const bool isMaskChecked) noexcept
+{
+    const __m128i colorBits = _mm_set1_epi32(BLEND_KERNEL32_COLOR_BITS);
+    __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDest));
+    __m128i front = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource));
+    __m128i frontColor = _mm_and_si128(front, colorBits);
+
+    __m128i out = (IsBlended) ? _mm_and_si128(BlendOp::apply(back, frontColor), colorBits) : frontColor;
+    __m128i keptPixels = _mm_setzero_si128();
+    if (IsTextured)
+    {
+        if (IsBlended) // only blend texels with mask bit
+        {
+            __m128i semiTransparentTexels = _mm_srai_epi32(front, 31);
+            out = _mm_or_si128(_mm_and_si128(semiTransparentTexels, out), _mm_andnot_si128(semiTransparentTexels, frontColor));
+        }
+        out = _mm_or_si128(out, _mm_and_si128(front, _mm_set1_epi32(static_cast<int32_t>(BLEND_KERNEL32_MASK_BIT)))); // keep texel mask bit
+        keptPixels = _mm_cmpeq_epi32(front, keptPixels); // transparent texels
+    }
+    out = _mm_or_si128(out, forcedMaskBit);
+    if (isMaskChecked)
+        keptPixels = _mm_or_si128(keptPixels, _mm_srai_epi32(back, 31));
+
+    out = _mm_or_si128(_mm_and_si128(keptPixels, back), _mm_andnot_si128(keptPixels, out));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDest), out);
+}
+#endif
+
+/// @brief Blend row of RGBA pixels (8 pixels per iteration, then 4, then remaining pixels)
+template <typename BlendOp, bool IsTextured, bool IsBlended>
+static void blendRow32(uint32_t* pDest, const uint32_t* pSource, const size_t length, const uint32_t forcedMaskBit, const bool isMaskChecked)
+{
+    size_t i = 0;
+    #if _SIMD_SSE2
+    const __m128i forcedMaskBits = _mm_set1_epi32(static_cast<int32_t>(forcedMaskBit));
+    for (; i + 8u <= length; i += 8u)
+    {
+        blendBlock4x32<BlendOp, IsTextured, IsBlended>(pDest + i, pSource + i, forcedMaskBits, isMaskChecked);
+        blendBlock4x32<BlendOp, IsTextured, IsBlended>(pDest + i + 4u, pSource + i + 4u, forcedMaskBits, isMaskChecked);
+    }
+    if (i + 4u <= length)
+    {
+        blendBlock4x32<BlendOp, IsTextured, IsBlended>(pDest + i, pSource + i, forcedMaskBits, isMaskChecked);
+        i += 4u;
+    }
+    #endif
+
+    // remaining pixels
+    for (; i < length; ++i)
+    {
+        uint32_t back = pDest[i];
+        uint32_t front = pSource[i];
+        if ((isMaskChecked && (back & BLEND_KERNEL32_MASK_BIT)) || (IsTextured && front == 0u))
+            continue;
+
+        uint32_t out;
+        if (IsBlended && (!IsTextured || (front & BLEND_KERNEL32_MASK_BIT)))
+            out = BlendOp::apply(back, front & BLEND_KERNEL32_COLOR_BITS) & BLEND_KERNEL32_COLOR_BITS;
+        else
+            out = front & BLEND_KERNEL32_COLOR_BITS;
+        if (IsTextured)
+            out |= (front & BLEND_KERNEL32_MASK_BIT);
+        pDest[i] = out | forcedMaskBit;
+    }
+}
+
+
+/// @brief Select semi-transparency kernel for a primitive
+/// @param[in] mode        Semi-transparency mode
+/// @param[in] isTextured  Textured primitive (only texels with mask bit are blended, 0x0000 texels are skipped)
+/// @returns Kernel function
+blend_kernel_t BlendKernels::getKernel(const stp_t mode, const bool isTextured) noexcept
+{
+    switch (mode)
+    {
+        case stp_t::mean:   return (isTextured) ? blendRow<blend_mean_op_t, true, true> : blendRow<blend_mean_op_t, false, true>;
+        case stp_t::add:    return (isTextured) ? blendRow<blend_add_op_t, true, true> : blendRow<blend_add_op_t, false, true>;
+        case stp_t::sub:    return (isTextured) ? blendRow<blend_sub_op_t, true, true> : blendRow<blend_sub_op_t, false, true>;
+        case stp_t::addPart:return (isTextured) ? blendRow<blend_add_part_op_t, true, true> : blendRow<blend_add_part_op_t, false, true>;
+    }
+    return getOpaqueKernel(isTextured);
+}
+
+/// @brief Select opaque kernel for a primitive (copy with mask handling)
+/// @param[in] isTextured  Textured primitive (0x0000 texels are skipped)
+/// @returns Kernel function
+blend_kernel_t BlendKernels::getOpaqueKernel(const bool isTextured) noexcept
+{
+    return (isTextured) ? blendRow<blend_opaque_op_t, true, false> : blendRow<blend_opaque_op_t, false, false>;
+}
+
+/// @brief Select semi-transparency kernel for a primitive - RGBA pixels (high resolution buffers)
+/// @param[in] mode        Semi-transparency mode
+/// @param[in] isTextured  Textured primitive (only texels with mask bit are blended, 0 texels are skipped)
+/// @returns Kernel function
+blend_kernel32_t BlendKernels::getKernel32(const stp_t mode, const bool isTextured) noexcept
+{
+    switch (mode)
+    {
+        case stp_t::mean:   return (isTextured) ? blendRow32<blend_mean_op32_t, true, true> : blendRow32<blend_mean_op32_t, false, true>;
+        case stp_t::add:    return (isTextured) ? blendRow32<blend_add_op32_t, true, true> : blendRow32<blend_add_op32_t, false, true>;
+        case stp_t::sub:    return (isTextured) ? blendRow32<blend_sub_op32_t, true, true> : blendRow32<blend_sub_op32_t, false, true>;
+        case stp_t::addPart:return (isTextured) ? blendRow32<blend_add_part_op32_t, true, true> : blendRow32<blend_add_part_op32_t, false, true>;
+    }
+    return getOpaqueKernel32(isTextured);
+}
+
+/// @brief Select opaque kernel for a primitive - RGBA pixels (high resolution buffers)
+/// @param[in] isTextured  Textured primitive (0 texels are skipped)
+/// @returns Kernel function
+blend_kernel32_t BlendKernels::getOpaqueKernel32(const bool isTextured) noexcept
+{
+    return (isTextured) ? blendRow32<blend_opaque_op_t, true, false> : blendRow32<blend_opaque_op_t, false, false>;
+}
+
+
+// -- scalar reference -- ------------------------------------------------------
+
+/// @brief Blend single pixel (per-channel reference implementation)
+/// @param[in] back   Destination pixel
+/// @param[in] front  Source pixel
+/// @param[in] mode   Semi-transparency mode
+/// @returns Blended color (without mask bit)
+uint16_t BlendKernels::blendPixel(const uint16_t back, const uint16_t front, const stp_t mode) noexcept
+{
+    uint16_t out = 0u;
+    for (uint32_t shift = 0u; shift < 15u; shift += 5u)
+    {
+        int32_t b = static_cast<int32_t>((back >> shift) & 0x1Fu);
+        int32_t f = static_cast<int32_t>((front >> shift) & 0x1Fu);
+        int32_t channel;
+        switch (mode)
+        {
+            case stp_t::mean:    channel = (b >> 1) + (f >> 1); break;
+            case stp_t::add:     channel = b + f; break;
+            case stp_t::sub:     channel = b - f; break;
+            case stp_t::addPart: channel = b + (f >> 2); break;
+            default:             channel = f; break;
+        }
+        if (channel < 0)
+            channel = 0;
+        else if (channel > 0x1F)
+            channel = 0x1F;
+        out |= static_cast<uint16_t>(channel << shift);
+    }
+    return out;
+}
+
+/// @brief Blend a row of pixels (per-channel reference implementation)
+/// @param[in,out] pDest  Destination pixels
+/// @param[in] pSource    Source pixels
+/// @param[in] length     Number of pixels
+/// @param[in] mode       Semi-transparency mode
+/// @param[in] isTextured Textured primitive
+/// @param[in] forcedMaskBit  Mask bit to add to every written pixel
+/// @param[in] isMaskChecked  Preserve destination pixels with mask bit
+void BlendKernels::blendReference(uint16_t* pDest, const uint16_t* pSource, const size_t length, const stp_t mode,
+                                  const bool isTextured, const uint16_t forcedMaskBit, const bool isMaskChecked) noexcept
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        uint16_t back = pDest[i];
+        uint16_t front = pSource[i];
+        if (isMaskChecked && (back & BLEND_KERNEL_MASK_BIT))
+            continue;
+
+        if (isTextured)
+        {
+            if (front == 0u) // transparent texel
+                continue;
+            uint16_t color = (front & BLEND_KERNEL_MASK_BIT) ? blendPixel(back, front, mode) : (front & BLEND_KERNEL_COLOR_BITS);
+            pDest[i] = color | (front & BLEND_KERNEL_MASK_BIT) | forcedMaskBit;
+        }
+        else
+        {
+            pDest[i] = blendPixel(back, front, mode) | forcedMaskBit;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - packed 15-bit semi-transparency kernels
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "../../command/primitive/primitive_common.h"
+
+#define BLEND_KERNEL_MASK_BIT   0x8000u // mask bit (bit 15)
+#define BLEND_KERNEL_COLOR_BITS 0x7FFFu // packed color bits (5:5:5)
+#define BLEND_KERNEL32_MASK_BIT   0x80000000u // mask bit (RGBA: alpha high bit)
+#define BLEND_KERNEL32_COLOR_BITS 0x00FFFFFFu // RGB color bits (8:8:8)
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.software
+    /// Software rendering
+    namespace software
+    {
+        /// @brief Blending kernel - blends a row of source pixels into destination pixels (packed 15-bit format)
+        /// @param[in,out] pDest  Destination pixels (back buffer, VRAM format)
+        /// @param[in] pSource    Source pixels (front color or shaded texels, VRAM format - 0x0000 = transparent texel)
+        /// @param[in] length     Number of pixels
+        /// @param[in] forcedMaskBit  Mask bit to add to every written pixel (0 or 0x8000)
+        /// @param[in] isMaskChecked  Preserve destination pixels with mask bit
+        typedef void(*blend_kernel_t)(uint16_t* pDest, const uint16_t* pSource, const size_t length, const uint16_t forcedMaskBit, const bool isMaskChecked);
+        /// @brief Blending kernel - blends a row of source pixels into destination pixels (RGBA 8-bit format - mask bit in alpha)
+        typedef void(*blend_kernel32_t)(uint32_t* pDest, const uint32_t* pSource, const size_t length, const uint32_t forcedMaskBit, const bool isMaskChecked);
+
+
+        /// @class BlendKernels
+        /// @brief Semi-transparency kernels - work directly on packed 15-bit pixels (8/16 pixels at once with SSE2)
+        class BlendKernels
+        {
+        public:
+            /// @brief Select semi-transparency kernel for a primitive
+            /// @param[in] mode        Semi-transparency mode
+            /// @param[in] isTextured  Textured primitive (only texels with mask bit are blended, 0x0000 texels are skipped)
+            /// @returns Kernel function
+            static blend_kernel_t getKernel(const command::primitive::stp_t mode, const bool isTextured) noexcept;
+
+            /// @brief Select opaque kernel for a primitive (copy with mask handling)
+            /// @param[in] isTextured  Textured primitive (0x0000 texels are skipped)
+            /// @returns Kernel function
+            static blend_kernel_t getOpaqueKernel(const bool isTextured) noexcept;
+
+            /// @brief Select semi-transparency kernel for a primitive - RGBA pixels (high resolution buffers)
+            /// @param[in] mode        Semi-transparency mode
+            /// @param[in] isTextured  Textured primitive (only texels with mask bit are blended, 0 texels are skipped)
+            /// @returns Kernel function
+            static blend_kernel32_t getKernel32(const command::primitive::stp_t mode, const bool isTextured) noexcept;
+
+            /// @brief Select opaque kernel for a primitive - RGBA pixels (high resolution buffers)
+            /// @param[in] isTextured  Textured primitive (0 texels are skipped)
+            /// @returns Kernel function
+            static blend_kernel32_t getOpaqueKernel32(const bool isTextured) noexcept;
+
+
+            // -- scalar reference -- ------------------------------------------
+
+            /// @brief Blend single pixel (per-channel reference implementation)
+            /// @param[in] back   Destination pixel
+            /// @param[in] front  Source pixel
+            /// @param[in] mode   Semi-transparency mode
+            /// @returns Blended color (without mask bit)
+            static uint16_t blendPixel(const uint16_t back, const uint16_t front, const command::primitive::stp_t mode) noexcept;
+
+            /// @brief Blend a row of pixels (per-channel reference implementation)
+            /// @param[in,out] pDest  Destination pixels
+            /// @param[in] pSource    Source pixels
+            /// @param[in] length     Number of pixels
+            /// @param[in] mode       Semi-transparency mode
+            /// @param[in] isTextured Textured primitive
+            /// @param[in] forcedMaskBit  Mask bit to add to every written pixel
+            /// @param[in] isMaskChecked  Preserve destination pixels with mask bit
+            static void blendReference(uint16_t* pDest, const uint16_t* pSource, const size_t length, const command::primitive::stp_t mode,
+                                       const bool isTextured, const uint16_t forcedMaskBit, const bool isMaskChecked) noexcept;
+        };
+    }
+}
@@ -0,0 +1,542 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - dual frame buffer (native VRAM + upscaled RGBA buffer)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+#include "../../utils/thread/thread_pool.h"
+#include "rasterizer.h"
+#include "palette_registry.h"
+#include "texture_cache.h"
+#include "dual_frame_buffer.h"
+using namespace display::software;
+
+#define TEXTURE_PAGE_COLUMNS 16 // number of 64-pixel texture page columns in VRAM
+
+
+/// @brief Create dual frame buffer
+/// @param[in] pVram        Native VRAM image (1024 x 512 pixels)
+/// @param[in] scaleX       Horizontal internal resolution factor
+/// @param[in] scaleY       Vertical internal resolution factor
+/// @param[in] threadCount  Number of worker threads (0 = one per hardware thread)
+/// @throws invalid_argument  Invalid VRAM or factors
+DualFrameBuffer::DualFrameBuffer(uint16_t* pVram, const uint32_t scaleX, const uint32_t scaleY, const uint32_t threadCount)
+    : m_pVram(pVram), m_scaleX(scaleX), m_scaleY(scaleY), m_queueTop(INT_MAX), m_queueBottom(INT_MIN), m_textureReadMask(0u), m_threadPool(threadCount),
+      m_fieldMismatchCount(0uLL), m_fieldSkippedPixelCount(0uLL)
+{
+    if (pVram == nullptr)
+        throw std::invalid_argument("DualFrameBuffer: VRAM image must not be null");
+    if (scaleX == 0u || scaleY == 0u || scaleX > 16u || scaleY > 16u)
+        throw std::invalid_argument("DualFrameBuffer: invalid internal resolution factor");
+
+    m_highResBuffer.resize(static_cast<size_t>(getHighResWidth()) * static_cast<size_t>(getHighResHeight()));
+    m_queue.reserve(DUAL_FRAME_BUFFER_MAX_QUEUE_LENGTH);
+    onVramWrite(0, 0, RASTER_VRAM_WIDTH, RASTER_VRAM_HEIGHT); // initial copy of native image
+}
+
+
+// -- drawing -- ---------------------------------------------------------------
+
+/// @brief Draw triangle
+/// @param[in] pVertices  Triangle vertices (3)
+/// @param[in] state      Rendering state
+void DualFrameBuffer::drawTriangle(const raster_vertex_t* pVertices, const raster_state_t& state)
+{
+    queued_primitive_t primitive;
+    primitive.type = queued_type_t::triangle;
+    primitive.vertices[0] = pVertices[0];
+    primitive.vertices[1] = pVertices[1];
+    primitive.vertices[2] = pVertices[2];
+    primitive.width = primitive.height = 0;
+    primitive.top = pVertices[0].y;
+    primitive.bottom = pVertices[0].y;
+    int32_t left = pVertices[0].x, right = pVertices[0].x;
+    for (int i = 1; i < 3; ++i)
+    {
+        if (pVertices[i].y < primitive.top)    primitive.top = pVertices[i].y;
+        if (pVertices[i].y > primitive.bottom) primitive.bottom = pVertices[i].y;
+        if (pVertices[i].x < left)  left = pVertices[i].x;
+        if (pVertices[i].x > right) right = pVertices[i].x;
+    }
+    clampRows(state, primitive.top, primitive.bottom);
+    if (primitive.top > primitive.bottom)
+        return;
+    primitive.state = state;
+    submitPrimitive(primitive, left, right);
+}
+
+/// @brief Draw line (end points included)
+/// @param[in] v0     First end point
+/// @param[in] v1     Second end point
+/// @param[in] state  Rendering state
+void DualFrameBuffer::drawLine(const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state)
+{
+    queued_primitive_t primitive;
+    primitive.type = queued_type_t::line;
+    primitive.vertices[0] = v0;
+    primitive.vertices[1] = v1;
+    primitive.width = primitive.height = 0;
+    primitive.top = (v0.y < v1.y) ? v0.y : v1.y;
+    primitive.bottom = (v0.y < v1.y) ? v1.y : v0.y;
+    clampRows(state, primitive.top, primitive.bottom);
+    if (primitive.top > primitive.bottom)
+        return;
+    primitive.state = state;
+    submitPrimitive(primitive, (v0.x < v1.x) ? v0.x : v1.x, (v0.x < v1.x) ? v1.x : v0.x);
+}
+
+/// @brief Draw rectangle (tile / sprite)
+/// @param[in] topLeft  Top-left vertex
+/// @param[in] width    Rectangle width
+/// @param[in] height   Rectangle height
+/// @param[in] state    Rendering state
+void DualFrameBuffer::drawRectangle(const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    queued_primitive_t primitive;
+    primitive.type = queued_type_t::rectangle;
+    primitive.vertices[0] = topLeft;
+    primitive.width = width;
+    primitive.height = height;
+    primitive.top = topLeft.y;
+    primitive.bottom = topLeft.y + height - 1;
+    clampRows(state, primitive.top, primitive.bottom);
+    if (primitive.top > primitive.bottom)
+        return;
+    primitive.state = state;
+    submitPrimitive(primitive, topLeft.x, topLeft.x + width - 1);
+}
+
+/// @brief Fill area with color (no drawing area, no mask)
+/// @param[in] x       Left position
+/// @param[in] y       Top position
+/// @param[in] width   Area width
+/// @param[in] height  Area height
+/// @param[in] color   Fill color (00BbGgRr)
+void DualFrameBuffer::fillArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    queued_primitive_t primitive{}; // untextured
+    primitive.type = queued_type_t::fill;
+    primitive.vertices[0].x = x;
+    primitive.vertices[0].y = y;
+    primitive.vertices[0].color = color;
+    primitive.width = width;
+    primitive.height = height;
+    if (y + height > RASTER_VRAM_HEIGHT) // wrapped
+    {
+        primitive.top = 0;
+        primitive.bottom = RASTER_VRAM_HEIGHT - 1;
+    }
+    else
+    {
+        primitive.top = y;
+        primitive.bottom = y + height - 1;
+    }
+    submitPrimitive(primitive, x, x + width - 1);
+}
+
+/// @brief Copy a row of pixels with VRAM wrapping (source row already stored in line buffer)
+template <typename T>
+static inline void writeWrappedRow(T* pDestRow, const T* pLine, const int32_t destX, const int32_t width, const int32_t rowWidth) noexcept
+{
+    for (int32_t i = 0; i < width; ++i)
+        pDestRow[(destX + i) % rowWidth] = pLine[i];
+}
+/// @brief Copy VRAM area with wrapping (rows processed in overlap-safe order)
+template <typename T>
+static void copyWrappedArea(T* pBuffer, const int32_t rowWidth, const int32_t rowCount, const int32_t sourceX, const int32_t sourceY,
+                            const int32_t destX, const int32_t destY, const int32_t width, const int32_t height)
+{
+    std::vector<T> line(width);
+    const bool isBottomUp = (destY > sourceY);
+    for (int32_t i = 0; i < height; ++i)
+    {
+        int32_t row = (isBottomUp) ? height - 1 - i : i;
+        const T* pSourceRow = pBuffer + static_cast<size_t>((sourceY + row) % rowCount) * rowWidth;
+        for (int32_t col = 0; col < width; ++col)
+            line[col] = pSourceRow[(sourceX + col) % rowWidth];
+        writeWrappedRow(pBuffer + static_cast<size_t>((destY + row) % rowCount) * rowWidth, line.data(), destX, width, rowWidth);
+    }
+}
+
+/// @brief Copy VRAM area (native + high resolution)
+/// @param[in] sourceX  Source left position
+/// @param[in] sourceY  Source top position
+/// @param[in] destX    Destination left position
+/// @param[in] destY    Destination top position
+/// @param[in] width    Area width
+/// @param[in] height   Area height
+void DualFrameBuffer::copyArea(const int32_t sourceX, const int32_t sourceY, const int32_t destX, const int32_t destY, const int32_t width, const int32_t height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    flush(); // source may be modified by pending primitives
+
+    copyWrappedArea(m_pVram, RASTER_VRAM_WIDTH, RASTER_VRAM_HEIGHT, sourceX, sourceY, destX, destY, width, height);
+    invalidateTextureSources(destX, destY, destX + width - 1, destY + height - 1);
+    copyWrappedArea(m_highResBuffer.data(), static_cast<int32_t>(getHighResWidth()), static_cast<int32_t>(getHighResHeight()),
+                    sourceX * static_cast<int32_t>(m_scaleX), sourceY * static_cast<int32_t>(m_scaleY), destX * static_cast<int32_t>(m_scaleX),
+                    destY * static_cast<int32_t>(m_scaleY), width * static_cast<int32_t>(m_scaleX), height * static_cast<int32_t>(m_scaleY));
+}
+
+
+// -- synchronization -- -------------------------------------------------------
+
+/// @brief Native VRAM area about to be written by CPU transfer - render pending primitives that read it
+/// @param[in] x       Left position
+/// @param[in] y       Top position
+/// @param[in] width   Area width
+/// @param[in] height  Area height
+void DualFrameBuffer::beforeVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    if (width > 0 && height > 0)
+        checkTextureDependency(x, y, x + width - 1, y + height - 1);
+}
+
+/// @brief Native VRAM area written by CPU transfer - copy it into high resolution buffer
+/// @param[in] x       Left position
+/// @param[in] y       Top position
+/// @param[in] width   Area width
+/// @param[in] height  Area height
+void DualFrameBuffer::onVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    flush(); // pending primitives must be drawn below new data
+    invalidateTextureSources(x, y, x + width - 1, y + height - 1);
+
+    high_res_target_t target{ m_highResBuffer.data(), static_cast<int32_t>(m_scaleX), static_cast<int32_t>(m_scaleY), 0, static_cast<int32_t>(getHighResHeight()) };
+    Rasterizer::uploadArea(target, m_pVram, x, y, width, height);
+}
+
+/// @brief Write pixels in native VRAM area (CPU transfer, with VRAM wrapping) + copy them into high resolution buffer
+/// @param[in] x        Left position
+/// @param[in] y        Top position
+/// @param[in] width    Area width
+/// @param[in] height   Area height
+/// @param[in] pPixels  Transferred pixels (width * height, row by row)
+void DualFrameBuffer::uploadArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint16_t* pPixels)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    beforeVramWrite(x, y, width, height);
+    for (int32_t row = 0; row < height; ++row)
+    {
+        uint16_t* pRow = m_pVram + static_cast<size_t>((y + row) & (RASTER_VRAM_HEIGHT - 1)) * RASTER_VRAM_WIDTH;
+        for (int32_t col = 0; col < width; ++col, ++pPixels)
+            pRow[(x + col) & (RASTER_VRAM_WIDTH - 1)] = *pPixels;
+    }
+    onVramWrite(x, y, width, height);
+}
+
+/// @brief Render all pending high resolution primitives (parallel bands)
+void DualFrameBuffer::flush()
+{
+    if (m_queue.empty())
+        return;
+
+    // split affected rows into bands
+    const int32_t scaleX = static_cast<int32_t>(m_scaleX);
+    const int32_t scaleY = static_cast<int32_t>(m_scaleY);
+    const int32_t rowBegin = m_queueTop * scaleY;
+    const int32_t rowEnd = (m_queueBottom + 1) * scaleY;
+    const int32_t maxBandCount = static_cast<int32_t>(m_threadPool.concurrency()) * DUAL_FRAME_BUFFER_BANDS_PER_THREAD;
+    int32_t rowsPerBand = (rowEnd - rowBegin + maxBandCount - 1) / maxBandCount;
+    if (rowsPerBand < scaleY)
+        rowsPerBand = scaleY;
+    const int32_t bandCount = (rowEnd - rowBegin + rowsPerBand - 1) / rowsPerBand;
+
+    // render bands (each band processes every primitive in order -> no synchronization needed)
+    uint32_t* pHighResBuffer = m_highResBuffer.data();
+    const std::vector<queued_primitive_t>& queue = m_queue;
+    m_threadPool.parallelFor(static_cast<uint32_t>(bandCount), [&](const uint32_t band)
+    {
+        high_res_target_t target{ pHighResBuffer, scaleX, scaleY, rowBegin + static_cast<int32_t>(band) * rowsPerBand, 0 };
+        target.rowEnd = (target.rowBegin + rowsPerBand < rowEnd) ? target.rowBegin + rowsPerBand : rowEnd;
+        const int32_t nativeTop = target.rowBegin / scaleY;
+        const int32_t nativeBottom = (target.rowEnd - 1) / scaleY;
+
+        for (const queued_primitive_t& primitive : queue)
+        {
+            if (primitive.bottom < nativeTop || primitive.top > nativeBottom)
+                continue;
+            switch (primitive.type)
+            {
+                case queued_type_t::triangle:  Rasterizer::drawTriangle(target, primitive.vertices, primitive.state); break;
+                case queued_type_t::line:      Rasterizer::drawLine(target, primitive.vertices[0], primitive.vertices[1], primitive.state); break;
+                case queued_type_t::rectangle: Rasterizer::drawRectangle(target, primitive.vertices[0], primitive.width, primitive.height, primitive.state); break;
+                case queued_type_t::fill:
+                    Rasterizer::fillArea(target, primitive.vertices[0].x, primitive.vertices[0].y, primitive.width, primitive.height, primitive.vertices[0].color); break;
+            }
+        }
+    });
+
+    m_queue.clear();
+    m_queueTop = INT_MAX;
+    m_queueBottom = INT_MIN;
+    m_textureReadMask = 0u;
+}
+
+/// @brief Remove all decoded texture pages (explicit texture cache flush)
+void DualFrameBuffer::clearTextureCache()
+{
+    flush(); // pending primitives may use decoded pages
+    m_textureCache.clear(); // palettes and upscaled pages are keyed on content: still valid
+}
+
+/// @brief End of frame: render pending primitives, swap completed upscaled textures in
+void DualFrameBuffer::endFrame()
+{
+    flush(); // upscaled pages may be replaced/removed
+    if (m_pTextureUpscaler != nullptr)
+        m_pTextureUpscaler->endFrame();
+}
+
+
+// -- texture upscaling -- -----------------------------------------------------
+
+/// @brief Enable/disable background texture upscaling (CLUT textures, high resolution rendering)
+/// @param[in] mode    Upscaling type (native = disabled)
+/// @param[in] factor  Upscaling factor (1 = disabled)
+/// @param[in] pTextureStore  Persistent cache of current game (see TextureUpscaler::openPersistentCache) - nullptr = no persistent cache
+void DualFrameBuffer::setTextureUpscaling(const config::upscaling_mode_t mode, const uint32_t factor, std::unique_ptr<scaling::UpscaledTextureStore> pTextureStore)
+{
+    flush(); // pending primitives may use upscaled pages
+    if (mode == config::upscaling_mode_t::native || factor <= 1u)
+        m_pTextureUpscaler.reset();
+    else
+    {
+        m_pTextureUpscaler.reset(new scaling::TextureUpscaler(mode, factor));
+        if (pTextureStore != nullptr)
+            m_pTextureUpscaler->setPersistentCache(std::move(pTextureStore)); // incompatible: upscaled pages only kept in memory
+    }
+}
+
+
+// -- interlaced field validation -- -------------------------------------------
+
+/// @brief Enable/disable interlaced field validation: primitives drawn with skipped field rows are also rendered at full height and compared
+/// @param[in] isEnabled  Validation mode
+void DualFrameBuffer::setFieldValidation(const bool isEnabled)
+{
+    if (isEnabled)
+        m_fieldValidationBuffer.resize(static_cast<size_t>(RASTER_VRAM_WIDTH) * RASTER_VRAM_HEIGHT);
+    else
+        std::vector<uint16_t>().swap(m_fieldValidationBuffer);
+    resetFieldValidationCounters();
+}
+
+/// @brief Render primitive in native VRAM, with full-height reference rendering and comparison of field rows
+void DualFrameBuffer::drawNativeWithValidation(const queued_primitive_t& primitive)
+{
+    // reference: same primitive without skipped rows, drawn over a copy of affected rows (textures still read from VRAM)
+    const size_t rowsOffset = static_cast<size_t>(primitive.top) * RASTER_VRAM_WIDTH;
+    const size_t rowsLength = static_cast<size_t>(primitive.bottom - primitive.top + 1) * RASTER_VRAM_WIDTH;
+    memcpy(m_fieldValidationBuffer.data() + rowsOffset, m_pVram + rowsOffset, rowsLength * sizeof(uint16_t));
+    queued_primitive_t reference = primitive;
+    reference.state.isFieldSkipped = false;
+    drawNative(native_target_t{ m_fieldValidationBuffer.data() }, reference);
+
+    drawNative(native_target_t{ m_pVram }, primitive);
+
+    // drawn field rows must be identical - skipped field rows are left unchanged in VRAM
+    for (int32_t row = primitive.top; row <= primitive.bottom; ++row)
+    {
+        const uint16_t* pRow = m_pVram + static_cast<size_t>(row) * RASTER_VRAM_WIDTH;
+        const uint16_t* pReferenceRow = m_fieldValidationBuffer.data() + static_cast<size_t>(row) * RASTER_VRAM_WIDTH;
+        uint64_t& counter = ((row & 0x1) == primitive.state.skippedFieldParity) ? m_fieldSkippedPixelCount : m_fieldMismatchCount;
+        for (int32_t col = 0; col < RASTER_VRAM_WIDTH; ++col)
+        {
+            if (pRow[col] != pReferenceRow[col])
+                ++counter;
+        }
+    }
+}
+
+
+// -- queue management -- ------------------------------------------------------
+
+/// @brief Render primitive in native VRAM and queue its high resolution version
+/// @param[in] primitive  Primitive to render
+/// @param[in] left       Left limit of affected area (native units)
+/// @param[in] right      Right limit of affected area (native units)
+void DualFrameBuffer::submitPrimitive(queued_primitive_t& primitive, const int32_t left, const int32_t right)
+{
+    // pending primitives reading the destination area must be rendered before it's modified
+    const uint32_t destinationMask = getTexturePageMask(left, primitive.top, right, primitive.bottom);
+    if ((m_textureReadMask & destinationMask) != 0u)
+        flush();
+
+    // primitive drawing into its own texture source: high resolution version must read textures before native rendering
+    const bool isSelfDependent = ((getTextureSourceMask(primitive.state) & destinationMask) != 0u);
+    if (primitive.state.isTextured) // decoded page can't be used if texels are modified during rendering
+        attachTexturePage(primitive.state, isSelfDependent);
+    if (isSelfDependent)
+    {
+        queuePrimitive(primitive);
+        flush();
+    }
+
+    if (primitive.state.isFieldSkipped && isFieldValidation())
+        drawNativeWithValidation(primitive);
+    else
+        drawNative(native_target_t{ m_pVram }, primitive);
+    invalidateTextureSources(left, primitive.top, right, primitive.bottom); // pending readers already flushed (same destination mask)
+
+    if (isSelfDependent == false)
+        queuePrimitive(primitive);
+}
+
+/// @brief Attach decoded texture page to primitive (CLUT textures) + upscaled page (if available)
+/// @param[in] state            Primitive raster state
+/// @param[in] isSelfDependent  Primitive draws into its own texture source (native VRAM read directly)
+void DualFrameBuffer::attachTexturePage(raster_state_t& state, const bool isSelfDependent)
+{
+    state.texture.pDecodedPage = nullptr;
+    state.texture.pUpscaledPage = nullptr;
+    if (isSelfDependent || TextureCache::isCacheable(state.texture.colorDepth) == false)
+        return;
+
+    if (m_paletteRegistry.isFull()) // palette IDs reset -> pages keyed on old IDs must be removed
+    {
+        flush();
+        m_textureCache.clear();
+        m_paletteRegistry.clear();
+        if (m_pTextureUpscaler != nullptr)
+            m_pTextureUpscaler->clear();
+    }
+    palette_id_t paletteId = m_paletteRegistry.getPaletteId(m_pVram, state.texture.clutX, state.texture.clutY, state.texture.colorDepth);
+
+    texture_page_key_t key{ state.texture.texpageX, state.texture.texpageY, paletteId, state.texture.colorDepth };
+    state.texture.pDecodedPage = m_textureCache.find(key);
+    if (state.texture.pDecodedPage == nullptr)
+    {
+        if (m_textureCache.isFull()) // evicted page may be used by pending primitives
+            flush();
+        state.texture.pDecodedPage = m_textureCache.insert(key, m_pVram, m_paletteRegistry.getPalette(paletteId));
+    }
+
+    // upscaled page (high resolution rendering) - native texels until upscaling is complete
+    if (m_pTextureUpscaler != nullptr)
+    {
+        state.texture.upscalingFactor = m_pTextureUpscaler->factor();
+        state.texture.pUpscaledPage = m_pTextureUpscaler->find(key.hash());
+        if (state.texture.pUpscaledPage == nullptr)
+        {
+            const int32_t texelAreaWidth = (state.texture.colorDepth == command::primitive::colordepth_t::clut_4bit) ? 64 : 128;
+            m_pTextureUpscaler->request(key.hash(), state.texture.pDecodedPage, static_cast<int32_t>(state.texture.texpageX),
+                                        static_cast<int32_t>(state.texture.texpageY), texelAreaWidth);
+        }
+    }
+}
+
+/// @brief Invalidate decoded/upscaled textures and known palettes in a written native area
+void DualFrameBuffer::invalidateTextureSources(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept
+{
+    m_textureCache.invalidateArea(left, top, right, bottom);
+    m_paletteRegistry.invalidateArea(left, top, right, bottom);
+    if (m_pTextureUpscaler != nullptr)
+        m_pTextureUpscaler->invalidateArea(left, top, right, bottom);
+}
+
+/// @brief Render primitive in native target
+void DualFrameBuffer::drawNative(const native_target_t& target, const queued_primitive_t& primitive)
+{
+    switch (primitive.type)
+    {
+        case queued_type_t::triangle:  Rasterizer::drawTriangle(target, primitive.vertices, primitive.state); break;
+        case queued_type_t::line:      Rasterizer::drawLine(target, primitive.vertices[0], primitive.vertices[1], primitive.state); break;
+        case queued_type_t::rectangle: Rasterizer::drawRectangle(target, primitive.vertices[0], primitive.width, primitive.height, primitive.state); break;
+        case queued_type_t::fill:
+            Rasterizer::fillArea(target, primitive.vertices[0].x, primitive.vertices[0].y, primitive.width, primitive.height, primitive.vertices[0].color); break;
+    }
+}
+
+/// @brief Append high resolution primitive in queue (+ track its texture sources)
+void DualFrameBuffer::queuePrimitive(const queued_primitive_t& primitive)
+{
+    if (m_queue.size() >= DUAL_FRAME_BUFFER_MAX_QUEUE_LENGTH)
+        flush();
+
+    m_queue.push_back(primitive);
+    if (primitive.top < m_queueTop)
+        m_queueTop = primitive.top;
+    if (primitive.bottom > m_queueBottom)
+        m_queueBottom = primitive.bottom;
+    m_textureReadMask |= getTextureSourceMask(primitive.state);
+}
+
+/// @brief Flush pending primitives if native area overlaps their texture sources
+void DualFrameBuffer::checkTextureDependency(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom)
+{
+    if (m_textureReadMask != 0u && (m_textureReadMask & getTexturePageMask(left, top, right, bottom)) != 0u)
+        flush();
+}
+
+/// @brief Get mask of 64x256 texture pages touched by a native area (with VRAM wrapping)
+uint32_t DualFrameBuffer::getTexturePageMask(int32_t left, int32_t top, int32_t right, int32_t bottom) noexcept
+{
+    uint32_t columnMask = 0u;
+    if (right - left >= RASTER_VRAM_WIDTH - 1)
+        columnMask = 0xFFFFu;
+    else
+    {
+        for (int32_t column = (left >> 6); column <= (right >> 6); ++column)
+            columnMask |= (1u << (column & (TEXTURE_PAGE_COLUMNS - 1)));
+    }
+
+    uint32_t pageMask = 0u;
+    if (bottom - top >= RASTER_VRAM_HEIGHT - 1)
+        pageMask = columnMask | (columnMask << TEXTURE_PAGE_COLUMNS);
+    else
+    {
+        for (int32_t row = (top >> 8); row <= (bottom >> 8); ++row)
+            pageMask |= columnMask << ((row & 0x1) * TEXTURE_PAGE_COLUMNS);
+    }
+    return pageMask;
+}
+
+/// @brief Get mask of texture pages read by a primitive (texels + CLUT)
+uint32_t DualFrameBuffer::getTextureSourceMask(const raster_state_t& state) noexcept
+{
+    if (state.isTextured == false)
+        return 0u;
+
+    const raster_texture_t& texture = state.texture;
+    const int32_t texpageX = static_cast<int32_t>(texture.texpageX);
+    const int32_t texpageY = static_cast<int32_t>(texture.texpageY);
+    switch (texture.colorDepth)
+    {
+        case command::primitive::colordepth_t::clut_4bit:
+            return getTexturePageMask(texpageX, texpageY, texpageX + 63, texpageY + 255)
+                 | getTexturePageMask(texture.clutX, texture.clutY, texture.clutX + 15, texture.clutY);
+        case command::primitive::colordepth_t::clut_8bit:
+            return getTexturePageMask(texpageX, texpageY, texpageX + 127, texpageY + 255)
+                 | getTexturePageMask(texture.clutX, texture.clutY, texture.clutX + 255, texture.clutY);
+        default:
+            return getTexturePageMask(texpageX, texpageY, texpageX + 255, texpageY + 255);
+    }
+}
+
+/// @brief Clamp native row range of a primitive to its drawing area
+void DualFrameBuffer::clampRows(const raster_state_t& state, int32_t& top, int32_t& bottom) noexcept
+{
+    int32_t clipTop = (state.clipTop > 0) ? state.clipTop : 0;
+    int32_t clipBottom = (state.clipBottom < RASTER_VRAM_HEIGHT - 1) ? state.clipBottom : RASTER_VRAM_HEIGHT - 1;
+    if (top < clipTop)
+        top = clipTop;
+    if (bottom > clipBottom)
+        bottom = clipBottom;
+}
@@ -0,0 +1,233 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - dual frame buffer (native VRAM + upscaled RGBA buffer)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "../../utils/thread/thread_pool.h"
+#include "../../config/config_common.h"
+#include "../scaling/texture_upscaler.h"
+#include "rasterizer.h"
+#include "palette_registry.h"
+#include "texture_cache.h"
+
+#define DUAL_FRAME_BUFFER_MAX_QUEUE_LENGTH 4096 // max number of queued high resolution primitives (flushed when full)
+#define DUAL_FRAME_BUFFER_BANDS_PER_THREAD 2    // number of row bands per rendering thread
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.software
+    /// Software rendering
+    namespace software
+    {
+        /// @class DualFrameBuffer
+        /// @brief Software frame buffer - every primitive is rendered into native VRAM (immediately) and into an upscaled RGBA buffer (deferred, threaded)
+        /// @details VRAM reads and texture sources always come from the native buffer. Display output comes from the high resolution buffer.
+        ///          The high resolution pass is split into bands of rows, rendered in parallel: each band processes every queued primitive in order.
+        class DualFrameBuffer
+        {
+        public:
+            /// @brief Create dual frame buffer
+            /// @param[in] pVram        Native VRAM image (1024 x 512 pixels)
+            /// @param[in] scaleX       Horizontal internal resolution factor
+            /// @param[in] scaleY       Vertical internal resolution factor
+            /// @param[in] threadCount  Number of worker threads (0 = one per hardware thread)
+            /// @throws invalid_argument  Invalid VRAM or factors
+            DualFrameBuffer(uint16_t* pVram, const uint32_t scaleX, const uint32_t scaleY, const uint32_t threadCount = 0u);
+            /// @brief Destroy frame buffer
+            ~DualFrameBuffer() {}
+            // no copy allowed
+            DualFrameBuffer(const DualFrameBuffer& other) = delete;
+            DualFrameBuffer& operator=(const DualFrameBuffer& other) = delete;
+
+
+            // -- drawing -- ---------------------------------------------------
+
+            /// @brief Draw triangle
+            /// @param[in] pVertices  Triangle vertices (3)
+            /// @param[in] state      Rendering state
+            void drawTriangle(const raster_vertex_t* pVertices, const raster_state_t& state);
+            /// @brief Draw line (end points included)
+            /// @param[in] v0     First end point
+            /// @param[in] v1     Second end point
+            /// @param[in] state  Rendering state
+            void drawLine(const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state);
+            /// @brief Draw rectangle (tile / sprite)
+            /// @param[in] topLeft  Top-left vertex
+            /// @param[in] width    Rectangle width
+            /// @param[in] height   Rectangle height
+            /// @param[in] state    Rendering state
+            void drawRectangle(const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state);
+            /// @brief Fill area with color (no drawing area, no mask)
+            /// @param[in] x       Left position
+            /// @param[in] y       Top position
+            /// @param[in] width   Area width
+            /// @param[in] height  Area height
+            /// @param[in] color   Fill color (00BbGgRr)
+            void fillArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color);
+            /// @brief Copy VRAM area (native + high resolution)
+            /// @param[in] sourceX  Source left position
+            /// @param[in] sourceY  Source top position
+            /// @param[in] destX    Destination left position
+            /// @param[in] destY    Destination top position
+            /// @param[in] width    Area width
+            /// @param[in] height   Area height
+            void copyArea(const int32_t sourceX, const int32_t sourceY, const int32_t destX, const int32_t destY, const int32_t width, const int32_t height);
+
+
+            // -- synchronization -- -------------------------------------------
+
+            /// @brief Native VRAM area about to be written by CPU transfer - render pending primitives that read it
+            /// @param[in] x       Left position
+            /// @param[in] y       Top position
+            /// @param[in] width   Area width
+            /// @param[in] height  Area height
+            void beforeVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height);
+            /// @brief Native VRAM area written by CPU transfer - copy it into high resolution buffer
+            /// @param[in] x       Left position
+            /// @param[in] y       Top position
+            /// @param[in] width   Area width
+            /// @param[in] height  Area height
+            void onVramWrite(const int32_t x, const int32_t y, const int32_t width, const int32_t height);
+            /// @brief Write pixels in native VRAM area (CPU transfer, with VRAM wrapping) + copy them into high resolution buffer
+            /// @param[in] x        Left position
+            /// @param[in] y        Top position
+            /// @param[in] width    Area width
+            /// @param[in] height   Area height
+            /// @param[in] pPixels  Transferred pixels (width * height, row by row)
+            void uploadArea(const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint16_t* pPixels);
+            /// @brief Render all pending high resolution primitives (parallel bands)
+            void flush();
+            /// @brief Remove all decoded texture pages (explicit texture cache flush)
+            void clearTextureCache();
+            /// @brief End of frame: render pending primitives, swap completed upscaled textures in
+            void endFrame();
+
+
+            // -- texture upscaling -- -----------------------------------------
+
+            /// @brief Enable/disable background texture upscaling (CLUT textures, high resolution rendering)
+            /// @param[in] mode    Upscaling type (native = disabled)
+            /// @param[in] factor  Upscaling factor (1 = disabled)
+            /// @param[in] pTextureStore  Persistent cache of current game (see TextureUpscaler::openPersistentCache) - nullptr = no persistent cache
+            void setTextureUpscaling(const config::upscaling_mode_t mode, const uint32_t factor, std::unique_ptr<scaling::UpscaledTextureStore> pTextureStore = nullptr);
+            /// @brief Get texture upscaler (statistics) - nullptr if disabled
+            inline const scaling::TextureUpscaler* getTextureUpscaler() const noexcept { return m_pTextureUpscaler.get(); }
+
+
+            // -- interlaced field validation -- -------------------------------
+
+            /// @brief Enable/disable interlaced field validation: primitives drawn with skipped field rows are also rendered at full height and compared
+            /// @param[in] isEnabled  Validation mode
+            void setFieldValidation(const bool isEnabled);
+            /// @brief Check if interlaced field validation is enabled
+            inline bool isFieldValidation() const noexcept { return !m_fieldValidationBuffer.empty(); }
+            /// @brief Get number of drawn field pixels different from full-height rendering (should always be 0)
+            inline uint64_t getFieldMismatchCount() const noexcept { return m_fieldMismatchCount; }
+            /// @brief Get number of pixels of skipped field rows that full-height rendering would have modified
+            inline uint64_t getFieldSkippedPixelCount() const noexcept { return m_fieldSkippedPixelCount; }
+            /// @brief Reset interlaced field validation counters
+            inline void resetFieldValidationCounters() noexcept
+            {
+                m_fieldMismatchCount = m_fieldSkippedPixelCount = 0uLL;
+            }
+
+
+            // -- getters -- ---------------------------------------------------
+
+            /// @brief Get native VRAM image
+            inline const uint16_t* getNativeBuffer() const noexcept { return m_pVram; }
+            /// @brief Get high resolution image (flush() must be called first)
+            inline const uint32_t* getHighResBuffer() const noexcept { return m_highResBuffer.data(); }
+            /// @brief Get high resolution image width (pixels)
+            inline uint32_t getHighResWidth() const noexcept  { return RASTER_VRAM_WIDTH * m_scaleX; }
+            /// @brief Get high resolution image height (pixels)
+            inline uint32_t getHighResHeight() const noexcept { return RASTER_VRAM_HEIGHT * m_scaleY; }
+            /// @brief Get horizontal internal resolution factor
+            inline uint32_t getScaleX() const noexcept { return m_scaleX; }
+            /// @brief Get vertical internal resolution factor
+            inline uint32_t getScaleY() const noexcept { return m_scaleY; }
+            /// @brief Get number of pending high resolution primitives
+            inline size_t getQueueLength() const noexcept { return m_queue.size(); }
+            /// @brief Get decoded texture page cache (statistics)
+            inline const TextureCache& getTextureCache() const noexcept { return m_textureCache; }
+            /// @brief Get CLUT palette registry (statistics)
+            inline const PaletteRegistry& getPaletteRegistry() const noexcept { return m_paletteRegistry; }
+
+
+        private:
+            /// @enum queued_type_t
+            /// @brief Queued primitive type
+            enum class queued_type_t : uint32_t
+            {
+                triangle = 0u,
+                line = 1u,
+                rectangle = 2u,
+                fill = 3u
+            };
+            /// @struct queued_primitive_t
+            /// @brief Pending high resolution primitive
+            struct queued_primitive_t
+            {
+                queued_type_t type;
+                raster_vertex_t vertices[3];
+                int32_t width;  ///< Rectangle/fill width
+                int32_t height; ///< Rectangle/fill height
+                int32_t top;    ///< First affected native row
+                int32_t bottom; ///< Last affected native row
+                raster_state_t state;
+            };
+
+            /// @brief Render primitive in native VRAM and queue its high resolution version (with texture dependency checks)
+            void submitPrimitive(queued_primitive_t& primitive, const int32_t left, const int32_t right);
+            /// @brief Attach decoded texture page to primitive (CLUT textures) + upscaled page (if available)
+            void attachTexturePage(raster_state_t& state, const bool isSelfDependent);
+            /// @brief Invalidate decoded/upscaled textures and known palettes in a written native area
+            void invalidateTextureSources(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept;
+            /// @brief Render primitive in native target
+            static void drawNative(const native_target_t& target, const queued_primitive_t& primitive);
+            /// @brief Render primitive in native VRAM, with full-height reference rendering and comparison of field rows
+            void drawNativeWithValidation(const queued_primitive_t& primitive);
+            /// @brief Append high resolution primitive in queue (+ track its texture sources)
+            void queuePrimitive(const queued_primitive_t& primitive);
+            /// @brief Flush pending primitives if native area overlaps their texture sources
+            void checkTextureDependency(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom);
+            /// @brief Get mask of 64x256 texture pages touched by a native area (with VRAM wrapping)
+            static uint32_t getTexturePageMask(int32_t left, int32_t top, int32_t right, int32_t bottom) noexcept;
+            /// @brief Get mask of texture pages read by a primitive (texels + CLUT)
+            static uint32_t getTextureSourceMask(const raster_state_t& state) noexcept;
+            /// @brief Clamp native row range of a primitive to its drawing area
+            static void clampRows(const raster_state_t& state, int32_t& top, int32_t& bottom) noexcept;
+
+
+        private:
+            uint16_t* m_pVram;                        ///< Native VRAM image (15-bit)
+            std::vector<uint32_t> m_highResBuffer;    ///< Upscaled VRAM image (RGBA)
+            uint32_t m_scaleX;                        ///< Horizontal internal resolution factor
+            uint32_t m_scaleY;                        ///< Vertical internal resolution factor
+
+            std::vector<queued_primitive_t> m_queue;  ///< Pending high resolution primitives
+            int32_t m_queueTop;                       ///< First native row affected by pending primitives
+            int32_t m_queueBottom;                    ///< Last native row affected by pending primitives
+            uint32_t m_textureReadMask;               ///< Texture pages read by pending primitives (bit = 64x256 page)
+            ::utils::thread::ThreadPool m_threadPool; ///< High resolution rendering threads
+            TextureCache m_textureCache;              ///< Decoded CLUT texture pages (shared by native and high resolution rendering)
+            PaletteRegistry m_paletteRegistry;        ///< Unique CLUT palettes (texture cache keys)
+            std::unique_ptr<scaling::TextureUpscaler> m_pTextureUpscaler; ///< Background texture upscaling (nullptr if disabled)
+
+            std::vector<uint16_t> m_fieldValidationBuffer; ///< Full-height reference rendering (empty if field validation disabled)
+            uint64_t m_fieldMismatchCount;            ///< Drawn field pixels different from reference
+            uint64_t m_fieldSkippedPixelCount;        ///< Skipped field pixels modified in reference
+        };
+    }
+}
@@ -0,0 +1,148 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - CLUT palette registry (content deduplication)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include "rasterizer.h"
+#include "palette_registry.h"
+using namespace display::software;
+using command::primitive::colordepth_t;
+
+
+/// @brief Create palette registry
+/// @param[in] maxPalettes  Max number of unique palettes
+PaletteRegistry::PaletteRegistry(const size_t maxPalettes) : m_capacity((maxPalettes > 0u) ? maxPalettes : 1u)
+{
+    m_entries.reserve(m_capacity * 16u);
+    m_palettes.reserve(m_capacity);
+    m_paletteIds.reserve(m_capacity);
+    m_positionIds.resize(PALETTE_POSITION_COUNT, PALETTE_ID_NONE);
+    memset(m_pRowPositionCount, 0, sizeof(m_pRowPositionCount));
+    resetStats();
+}
+
+
+// -- palettes -- --------------------------------------------------------------
+
+/// @brief Compute palette content hash (FNV-1a)
+/// @param[in] pEntries  Palette entries
+/// @param[in] length    Number of entries
+uint64_t PaletteRegistry::computeHash(const uint16_t* pEntries, const uint32_t length) noexcept
+{
+    uint64_t hash = 14695981039346656037uLL ^ length;
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ (pEntries[i] & 0xFFu)) * 1099511628211uLL;
+        hash = (hash ^ (pEntries[i] >> 8)) * 1099511628211uLL;
+    }
+    return hash;
+}
+
+/// @brief Get identifier of the palette stored at a CLUT position (registered if new)
+/// @param[in] pVram       Native VRAM image
+/// @param[in] clutX       CLUT X position (multiple of 16)
+/// @param[in] clutY       CLUT Y position
+/// @param[in] colorDepth  Texel color depth (CLUT modes only)
+/// @returns Palette identifier
+palette_id_t PaletteRegistry::getPaletteId(const uint16_t* pVram, const uint32_t clutX, const uint32_t clutY, const colordepth_t colorDepth)
+{
+    ++m_stats.lookups;
+    const uint32_t positionIndex = toPositionIndex(clutX, clutY, colorDepth);
+    if (m_positionIds[positionIndex] != PALETTE_ID_NONE)
+        return m_positionIds[positionIndex];
+
+    // read CLUT row (with VRAM wrapping)
+    ++m_stats.reads;
+    const uint32_t length = (colorDepth == colordepth_t::clut_8bit) ? 256u : 16u;
+    const uint16_t* pClutRow = pVram + ((clutY & 0x1FFu) << 10);
+    uint16_t pPalette[256];
+    for (uint32_t i = 0; i < length; ++i)
+        pPalette[i] = pClutRow[(clutX + i) & 0x3FFu];
+
+    // find identical palette
+    palette_id_t id = PALETTE_ID_NONE;
+    const uint64_t hash = computeHash(pPalette, length);
+    auto range = m_paletteIds.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const palette_t& palette = m_palettes[it->second];
+        if (palette.length == length && memcmp(&m_entries[palette.offset], pPalette, length * sizeof(uint16_t)) == 0)
+        {
+            id = it->second;
+            ++m_stats.duplicates;
+            break;
+        }
+    }
+    // new palette
+    if (id == PALETTE_ID_NONE)
+    {
+        id = static_cast<palette_id_t>(m_palettes.size());
+        m_palettes.push_back(palette_t{ m_entries.size(), length });
+        m_entries.insert(m_entries.end(), pPalette, pPalette + length);
+        m_paletteIds.emplace(hash, id);
+    }
+
+    m_positionIds[positionIndex] = id;
+    ++m_pRowPositionCount[clutY & 0x1FFu];
+    return id;
+}
+
+
+// -- invalidation -- ----------------------------------------------------------
+
+/// @brief Forget palettes known at CLUT positions overlapping a written VRAM area (palette IDs remain valid)
+/// @param[in] left    Left limit of written area (inclusive)
+/// @param[in] top     Top limit of written area (inclusive)
+/// @param[in] right   Right limit of written area (inclusive)
+/// @param[in] bottom  Bottom limit of written area (inclusive)
+void PaletteRegistry::invalidateArea(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept
+{
+    if (right < left || bottom < top)
+        return;
+    const int32_t areaX = left & (RASTER_VRAM_WIDTH - 1);
+    const int32_t areaWidth = (right - left + 1 < RASTER_VRAM_WIDTH) ? right - left + 1 : RASTER_VRAM_WIDTH;
+    const int32_t rowCount = (bottom - top + 1 < RASTER_VRAM_HEIGHT) ? bottom - top + 1 : RASTER_VRAM_HEIGHT;
+
+    for (int32_t row = 0; row < rowCount; ++row)
+    {
+        const uint32_t y = static_cast<uint32_t>(top + row) & 0x1FFu;
+        if (m_pRowPositionCount[y] == 0u)
+            continue;
+
+        palette_id_t* pRowIds = &m_positionIds[y << 7];
+        for (uint32_t i = 0; i < 128u && m_pRowPositionCount[y] != 0u; ++i)
+        {
+            if (pRowIds[i] == PALETTE_ID_NONE)
+                continue;
+            // CLUT range: 16 entries (4-bit) or 256 entries (8-bit), with wrapping
+            const int32_t clutX = static_cast<int32_t>((i & 0x3Fu) << 4);
+            const int32_t clutLength = (i & 0x40u) ? 256 : 16;
+            if (((clutX - areaX) & (RASTER_VRAM_WIDTH - 1)) < areaWidth || ((areaX - clutX) & (RASTER_VRAM_WIDTH - 1)) < clutLength)
+            {
+                pRowIds[i] = PALETTE_ID_NONE;
+                --m_pRowPositionCount[y];
+                ++m_stats.invalidations;
+            }
+        }
+    }
+}
+
+/// @brief Remove all palettes (all palette IDs become invalid)
+void PaletteRegistry::clear() noexcept
+{
+    m_entries.clear();
+    m_palettes.clear();
+    m_paletteIds.clear();
+    for (auto it = m_positionIds.begin(); it != m_positionIds.end(); ++it)
+        *it = PALETTE_ID_NONE;
+    memset(m_pRowPositionCount, 0, sizeof(m_pRowPositionCount));
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - CLUT palette registry (content deduplication)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "../../command/primitive/primitive_common.h"
+
+#define PALETTE_REGISTRY_DEFAULT_CAPACITY 4096u        // default max number of unique palettes
+#define PALETTE_ID_NONE                   0xFFFFFFFFu  // invalid palette identifier
+#define PALETTE_POSITION_COUNT            (64u * 2u * 512u) // CLUT positions: X (16-halfword units) * color depth * Y
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.software
+    /// Software rendering
+    namespace software
+    {
+        /// @brief Palette identifier (same ID for identical palette content)
+        typedef uint32_t palette_id_t;
+
+        /// @struct palette_registry_stats_t
+        /// @brief Palette registry counters
+        struct palette_registry_stats_t
+        {
+            uint64_t lookups;       ///< Palette requests
+            uint64_t reads;         ///< CLUT rows read and hashed (position unknown or written since last read)
+            uint64_t duplicates;    ///< CLUT rows matching an existing palette (same content at another position, or re-uploaded)
+            uint64_t invalidations; ///< CLUT positions written (palette re-read at next request)
+        };
+
+
+        /// @class PaletteRegistry
+        /// @brief Registry of unique CLUT palettes (16 or 256 entries) - stable ID for each palette content
+        /// @details Identical palettes stored at different positions (or uploaded again) share the same ID:
+        ///          caches keyed on palette ID aren't affected by CLUT uploads unless the content really changes.
+        class PaletteRegistry
+        {
+        public:
+            /// @brief Create palette registry
+            /// @param[in] maxPalettes  Max number of unique palettes
+            PaletteRegistry(const size_t maxPalettes = PALETTE_REGISTRY_DEFAULT_CAPACITY);
+            // no copy allowed
+            PaletteRegistry(const PaletteRegistry& other) = delete;
+            PaletteRegistry& operator=(const PaletteRegistry& other) = delete;
+
+
+            // -- palettes -- --------------------------------------------------
+
+            /// @brief Get identifier of the palette stored at a CLUT position (registered if new)
+            /// @param[in] pVram       Native VRAM image
+            /// @param[in] clutX       CLUT X position (multiple of 16)
+            /// @param[in] clutY       CLUT Y position
+            /// @param[in] colorDepth  Texel color depth (CLUT modes only)
+            /// @returns Palette identifier
+            palette_id_t getPaletteId(const uint16_t* pVram, const uint32_t clutX, const uint32_t clutY, const command::primitive::colordepth_t colorDepth);
+            /// @brief Get palette entries
+            /// @param[in] id  Palette identifier
+            inline const uint16_t* getPalette(const palette_id_t id) const noexcept { return &m_entries[m_palettes[id].offset]; }
+            /// @brief Get number of palette entries (16 or 256)
+            /// @param[in] id  Palette identifier
+            inline uint32_t getPaletteLength(const palette_id_t id) const noexcept { return m_palettes[id].length; }
+
+            /// @brief Compute palette content hash (FNV-1a)
+            /// @param[in] pEntries  Palette entries
+            /// @param[in] length    Number of entries
+            static uint64_t computeHash(const uint16_t* pEntries, const uint32_t length) noexcept;
+
+
+            // -- invalidation -- ----------------------------------------------
+
+            /// @brief Forget palettes known at CLUT positions overlapping a written VRAM area (palette IDs remain valid)
+            /// @param[in] left    Left limit of written area (inclusive)
+            /// @param[in] top     Top limit of written area (inclusive)
+            /// @param[in] right   Right limit of written area (inclusive)
+            /// @param[in] bottom  Bottom limit of written area (inclusive)
+            void invalidateArea(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept;
+            /// @brief Remove all palettes (all palette IDs become invalid)
+            void clear() noexcept;
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Check if registry is full (must be cleared before next unknown palette)
+            inline bool isFull() const noexcept { return (m_palettes.size() >= m_capacity); }
+            /// @brief Get number of unique palettes
+            inline size_t size() const noexcept { return m_palettes.size(); }
+            /// @brief Get registry counters
+            inline const palette_registry_stats_t& getStats() const noexcept { return m_stats; }
+            /// @brief Reset registry counters
+            inline void resetStats() noexcept { m_stats = palette_registry_stats_t{ 0uLL, 0uLL, 0uLL, 0uLL }; }
+
+
+        private:
+            /// @struct palette_t
+            /// @brief Registered palette
+            struct palette_t
+            {
+                size_t offset;   ///< Position of entries in storage
+                uint32_t length; ///< Number of entries (16 or 256)
+            };
+
+            /// @brief Get index of a CLUT position
+            static inline uint32_t toPositionIndex(const uint32_t clutX, const uint32_t clutY, const command::primitive::colordepth_t colorDepth) noexcept
+            {
+                return ((clutY & 0x1FFu) << 7) | ((colorDepth == command::primitive::colordepth_t::clut_8bit) ? 0x40u : 0u) | ((clutX >> 4) & 0x3Fu);
+            }
+
+
+        private:
+            std::vector<uint16_t> m_entries;    ///< Palette entries storage
+            std::vector<palette_t> m_palettes;  ///< Registered palettes (by ID)
+            std::unordered_multimap<uint64_t, palette_id_t> m_paletteIds; ///< Palette IDs (by content hash)
+            std::vector<palette_id_t> m_positionIds; ///< Palette ID currently known at each CLUT position (or PALETTE_ID_NONE)
+            uint32_t m_pRowPositionCount[512];  ///< Number of known CLUT positions in each VRAM row
+            size_t m_capacity;                  ///< Max number of unique palettes
+            palette_registry_stats_t m_stats;   ///< Registry counters
+        };
+    }
+}
@@ -0,0 +1,785 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - primitive rasterizer (native / high resolution targets)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "../../utils/logic/fixed_point.h"
+#include "../../command/primitive/primitive_common.h"
+#include "blend_kernels.h"
+#include "rasterizer.h"
+using namespace display::software;
+using command::primitive::colordepth_t;
+using ::utils::algorithm::GradientSetup16;
+using ::utils::algorithm::gradient_t;
+
+/// @brief Dithering matrix (offsets added to 8-bit components before 5-bit truncation)
+static const int32_t c_pDitherMatrix[4][4] =
+{
+    { -4,  0, -3,  1 },
+    {  2, -2,  3, -1 },
+    { -3,  1, -4,  0 },
+    {  3, -1,  2, -2 }
+};
+
+/// @brief Clamp color component
+static inline int32_t clampComponent(const int32_t value) noexcept
+{
+    return (value < 0) ? 0 : ((value > 0xFF) ? 0xFF : value);
+}
+
+
+// -- target traits -- ---------------------------------------------------------
+
+/// @struct native_traits_t
+/// @brief Native target: 15-bit pixels, dithering, no upscaling
+struct native_traits_t
+{
+    typedef uint16_t pixel_t;
+    typedef native_target_t target_t;
+    typedef blend_kernel_t kernel_t;
+    static const bool isDitherable = true;
+    static const bool isUpscalingAllowed = false; // native texels only
+
+    static inline kernel_t getKernel(const raster_state_t& state) noexcept
+    {
+        return (state.isSemiTransparent) ? BlendKernels::getKernel(state.semiTransparency, state.isTextured) : BlendKernels::getOpaqueKernel(state.isTextured);
+    }
+    static inline pixel_t getForcedMaskBit(const raster_state_t& state) noexcept
+    {
+        return (state.isMaskBitForced) ? BLEND_KERNEL_MASK_BIT : 0u;
+    }
+
+    // pixel conversion
+    static inline pixel_t fromColor(const int32_t r, const int32_t g, const int32_t b, const int32_t dither) noexcept
+    {
+        return static_cast<pixel_t>((clampComponent(r + dither) >> 3) | ((clampComponent(g + dither) >> 3) << 5) | ((clampComponent(b + dither) >> 3) << 10));
+    }
+    static inline pixel_t fromTexel(const uint16_t texel) noexcept
+    {
+        return texel;
+    }
+    static inline pixel_t modulate(const uint16_t texel, const int32_t r, const int32_t g, const int32_t b, const int32_t dither) noexcept
+    {
+        int32_t outR = clampComponent(((static_cast<int32_t>(texel & 0x1Fu) << 3) * r >> 7) + dither) >> 3;
+        int32_t outG = clampComponent(((static_cast<int32_t>((texel >> 5) & 0x1Fu) << 3) * g >> 7) + dither) >> 3;
+        int32_t outB = clampComponent(((static_cast<int32_t>((texel >> 10) & 0x1Fu) << 3) * b >> 7) + dither) >> 3;
+        return static_cast<pixel_t>(outR | (outG << 5) | (outB << 10) | (texel & BLEND_KERNEL_MASK_BIT));
+    }
+
+    // target geometry
+    static inline int32_t scaleX(const target_t&) noexcept { return 1; }
+    static inline int32_t scaleY(const target_t&) noexcept { return 1; }
+    static inline int32_t width(const target_t&) noexcept  { return RASTER_VRAM_WIDTH; }
+    static inline pixel_t* row(const target_t& target, const int32_t y) noexcept
+    {
+        return target.pBuffer + (y * RASTER_VRAM_WIDTH);
+    }
+    static inline void getClipping(const target_t&, const raster_state_t& state, int32_t& outLeft, int32_t& outTop, int32_t& outRight, int32_t& outBottom) noexcept
+    {
+        outLeft = (state.clipLeft > 0) ? state.clipLeft : 0;
+        outTop = (state.clipTop > 0) ? state.clipTop : 0;
+        outRight = (state.clipRight < RASTER_VRAM_WIDTH - 1) ? state.clipRight : RASTER_VRAM_WIDTH - 1;
+        outBottom = (state.clipBottom < RASTER_VRAM_HEIGHT - 1) ? state.clipBottom : RASTER_VRAM_HEIGHT - 1;
+    }
+};
+
+/// @struct high_res_traits_t
+/// @brief High resolution target: RGBA pixels, upscaling, no dithering
+struct high_res_traits_t
+{
+    typedef uint32_t pixel_t;
+    typedef high_res_target_t target_t;
+    typedef blend_kernel32_t kernel_t;
+    static const bool isDitherable = false;
+    static const bool isUpscalingAllowed = true;
+
+    static inline kernel_t getKernel(const raster_state_t& state) noexcept
+    {
+        return (state.isSemiTransparent) ? BlendKernels::getKernel32(state.semiTransparency, state.isTextured) : BlendKernels::getOpaqueKernel32(state.isTextured);
+    }
+    static inline pixel_t getForcedMaskBit(const raster_state_t& state) noexcept
+    {
+        return (state.isMaskBitForced) ? BLEND_KERNEL32_MASK_BIT : 0u;
+    }
+
+    // pixel conversion
+    static inline pixel_t fromColor(const int32_t r, const int32_t g, const int32_t b, const int32_t) noexcept
+    {
+        return static_cast<pixel_t>(clampComponent(r) | (clampComponent(g) << 8) | (clampComponent(b) << 16));
+    }
+    static inline pixel_t fromTexel(const uint16_t texel) noexcept
+    {
+        return Rasterizer::toRgba(texel);
+    }
+    static inline pixel_t modulate(const uint16_t texel, const int32_t r, const int32_t g, const int32_t b, const int32_t) noexcept
+    {
+        uint32_t rgba = Rasterizer::toRgba(texel);
+        int32_t outR = clampComponent(static_cast<int32_t>(rgba & 0xFFu) * r >> 7);
+        int32_t outG = clampComponent(static_cast<int32_t>((rgba >> 8) & 0xFFu) * g >> 7);
+        int32_t outB = clampComponent(static_cast<int32_t>((rgba >> 16) & 0xFFu) * b >> 7);
+        return static_cast<pixel_t>(outR | (outG << 8) | (outB << 16)) | (rgba & BLEND_KERNEL32_MASK_BIT);
+    }
+
+    // target geometry
+    static inline int32_t scaleX(const target_t& target) noexcept { return target.scaleX; }
+    static inline int32_t scaleY(const target_t& target) noexcept { return target.scaleY; }
+    static inline int32_t width(const target_t& target) noexcept  { return target.width(); }
+    static inline pixel_t* row(const target_t& target, const int32_t y) noexcept
+    {
+        return target.pBuffer + (static_cast<size_t>(y) * static_cast<size_t>(target.width()));
+    }
+    static inline void getClipping(const target_t& target, const raster_state_t& state, int32_t& outLeft, int32_t& outTop, int32_t& outRight, int32_t& outBottom) noexcept
+    {
+        native_traits_t::getClipping(native_target_t{ nullptr }, state, outLeft, outTop, outRight, outBottom);
+        outLeft *= target.scaleX;
+        outRight = (outRight + 1) * target.scaleX - 1;
+        outTop *= target.scaleY;
+        outBottom = (outBottom + 1) * target.scaleY - 1;
+        // limit to current band
+        if (outTop < target.rowBegin)
+            outTop = target.rowBegin;
+        if (outBottom >= target.rowEnd)
+            outBottom = target.rowEnd - 1;
+    }
+};
+
+
+// -- texture sources -- -------------------------------------------------------
+
+/// @struct no_texture_t
+/// @brief Untextured primitives
+struct no_texture_t
+{
+    static const bool isTextured = false;
+    static const bool isUpscaled = false;
+    static inline uint16_t fetch(const raster_texture_t&, const uint32_t, const uint32_t, const uint32_t, const uint32_t) noexcept { return 0u; }
+};
+
+/// @struct texture_4bit_t
+/// @brief 4-bit CLUT texture (4 texels per VRAM pixel)
+struct texture_4bit_t
+{
+    static const bool isTextured = true;
+    static const bool isUpscaled = false;
+    static inline uint16_t fetch(const raster_texture_t& texture, const uint32_t u, const uint32_t v, const uint32_t, const uint32_t) noexcept
+    {
+        uint16_t indexes = texture.pVram[(((texture.texpageY + v) & 0x1FFu) << 10) + ((texture.texpageX + (u >> 2)) & 0x3FFu)];
+        uint32_t index = (indexes >> ((u & 0x3u) << 2)) & 0xFu;
+        return texture.pVram[(texture.clutY << 10) + ((texture.clutX + index) & 0x3FFu)];
+    }
+};
+
+/// @struct texture_8bit_t
+/// @brief 8-bit CLUT texture (2 texels per VRAM pixel)
+struct texture_8bit_t
+{
+    static const bool isTextured = true;
+    static const bool isUpscaled = false;
+    static inline uint16_t fetch(const raster_texture_t& texture, const uint32_t u, const uint32_t v, const uint32_t, const uint32_t) noexcept
+    {
+        uint16_t indexes = texture.pVram[(((texture.texpageY + v) & 0x1FFu) << 10) + ((texture.texpageX + (u >> 1)) & 0x3FFu)];
+        uint32_t index = (indexes >> ((u & 0x1u) << 3)) & 0xFFu;
+        return texture.pVram[(texture.clutY << 10) + ((texture.clutX + index) & 0x3FFu)];
+    }
+};
+
+/// @struct texture_15bit_t
+/// @brief 15-bit direct color texture
+struct texture_15bit_t
+{
+    static const bool isTextured = true;
+    static const bool isUpscaled = false;
+    static inline uint16_t fetch(const raster_texture_t& texture, const uint32_t u, const uint32_t v, const uint32_t, const uint32_t) noexcept
+    {
+        return texture.pVram[(((texture.texpageY + v) & 0x1FFu) << 10) + ((texture.texpageX + u) & 0x3FFu)];
+    }
+};
+
+
+/// @struct texture_decoded_t
+/// @brief CLUT texture already decoded in texture cache (256 x 256 texels)
+struct texture_decoded_t
+{
+    static const bool isTextured = true;
+    static const bool isUpscaled = false;
+    static inline uint16_t fetch(const raster_texture_t& texture, const uint32_t u, const uint32_t v, const uint32_t, const uint32_t) noexcept
+    {
+        return texture.pDecodedPage[(v << 8) + u];
+    }
+};
+
+/// @struct texture_upscaled_t
+/// @brief Upscaled texture page (high resolution target only): texel + sub-position in upscaled texel block
+struct texture_upscaled_t
+{
+    static const bool isTextured = true;
+    static const bool isUpscaled = true;
+    static inline uint16_t fetch(const raster_texture_t& texture, const uint32_t u, const uint32_t v, const uint32_t subU, const uint32_t subV) noexcept
+    {
+        const uint32_t factor = texture.upscalingFactor;
+        return texture.pUpscaledPage[(v * factor + subV) * (factor << 8) + u * factor + subU];
+    }
+};
+
+
+/// @brief Compute pixel value (shading + texture mapping)
+/// @returns Source pixel (0 = transparent texel)
+template <typename Traits, typename Texture>
+static inline typename Traits::pixel_t shadePixel(const raster_state_t& state, const uint32_t u, const uint32_t v, const uint32_t subU, const uint32_t subV,
+                                                  const int32_t r, const int32_t g, const int32_t b, const int32_t dither) noexcept
+{
+    if (Texture::isTextured)
+    {
+        uint16_t texel = Texture::fetch(state.texture, ((u & state.texture.windowMaskU) | state.texture.windowOffsetU) & 0xFFu,
+                                                       ((v & state.texture.windowMaskV) | state.texture.windowOffsetV) & 0xFFu, subU, subV);
+        if (texel == 0u)
+            return 0u;
+        return (state.isModulated) ? Traits::modulate(texel, r, g, b, dither) : Traits::fromTexel(texel);
+    }
+    return Traits::fromColor(r, g, b, dither);
+}
+
+/// @brief Check if target row belongs to skipped interlaced field (parity of native row)
+template <typename Traits>
+static inline bool isSkippedRow(const typename Traits::target_t& target, const raster_state_t& state, const int32_t y) noexcept
+{
+    return (state.isFieldSkipped && ((y / Traits::scaleY(target)) & 0x1) == state.skippedFieldParity);
+}
+
+
+// -- triangle rasterization -- ------------------------------------------------
+
+/// @struct attribute_gradient_t
+/// @brief Linear attribute interpolation (16.16 fixed-point)
+struct attribute_gradient_t
+{
+    int64_t origin; ///< Value at first vertex (with rounding)
+    int32_t dx;     ///< Horizontal gradient
+    int32_t dy;     ///< Vertical gradient
+
+    /// @brief Compute gradients from 3 vertex values
+    inline void init(const int32_t a0, const int32_t a1, const int32_t a2, const GradientSetup16& setup) noexcept
+    {
+        origin = (static_cast<int64_t>(a0) << 16) + 0x8000;
+        gradient_t gradient = setup.compute(a0, a1, a2);
+        dx = gradient.dx;
+        dy = gradient.dy;
+    }
+    /// @brief Compute gradients of 2 attributes from 3 vertex values each (shared divisions)
+    static inline void init2(attribute_gradient_t& first, attribute_gradient_t& second, const int32_t* pA0, const int32_t* pA1, const int32_t* pA2,
+                             const GradientSetup16& setup) noexcept
+    {
+        gradient_t pGradients[2];
+        setup.compute2(pA0, pA1, pA2, pGradients);
+        first.origin = (static_cast<int64_t>(pA0[0]) << 16) + 0x8000;
+        first.dx = pGradients[0].dx;
+        first.dy = pGradients[0].dy;
+        second.origin = (static_cast<int64_t>(pA0[1]) << 16) + 0x8000;
+        second.dx = pGradients[1].dx;
+        second.dy = pGradients[1].dy;
+    }
+    /// @brief Get value at specific position (relative to first vertex)
+    inline int32_t at(const int32_t offsetX, const int32_t offsetY) const noexcept
+    {
+        return static_cast<int32_t>(origin + static_cast<int64_t>(offsetX) * dx + static_cast<int64_t>(offsetY) * dy);
+    }
+};
+
+/// @brief Compute edge X position at specific row (16.16 fixed-point)
+static inline int64_t getEdgeX(const int32_t xa, const int32_t ya, const int32_t xb, const int32_t yb, const int32_t y) noexcept
+{
+    if (yb == ya)
+        return static_cast<int64_t>(xa) << 16;
+    return (static_cast<int64_t>(xa) << 16) + ((static_cast<int64_t>(xb - xa) * (y - ya)) << 16) / (yb - ya);
+}
+
+/// @brief Rasterize triangle - top/left edges included, bottom/right edges excluded
+template <typename Traits, typename Texture, bool IsShaded>
+static void rasterizeTriangle(const typename Traits::target_t& target, const raster_vertex_t* pVertices, const raster_state_t& state)
+{
+    typedef typename Traits::pixel_t pixel_t;
+    const int32_t scaleX = Traits::scaleX(target);
+    const int32_t scaleY = Traits::scaleY(target);
+
+    // sort vertices (top to bottom)
+    const raster_vertex_t* pV0 = &pVertices[0];
+    const raster_vertex_t* pV1 = &pVertices[1];
+    const raster_vertex_t* pV2 = &pVertices[2];
+    if (pV1->y < pV0->y)
+        std::swap(pV0, pV1);
+    if (pV2->y < pV1->y)
+        std::swap(pV1, pV2);
+    if (pV1->y < pV0->y)
+        std::swap(pV0, pV1);
+    const int32_t x0 = pV0->x * scaleX, y0 = pV0->y * scaleY;
+    const int32_t x1 = pV1->x * scaleX, y1 = pV1->y * scaleY;
+    const int32_t x2 = pV2->x * scaleX, y2 = pV2->y * scaleY;
+
+    int64_t determinant = static_cast<int64_t>(x1 - x0) * (y2 - y0) - static_cast<int64_t>(x2 - x0) * (y1 - y0);
+    if (determinant == 0) // degenerate
+        return;
+    bool isLongEdgeLeft = (determinant > 0);
+
+    // clipping
+    int32_t clipLeft, clipTop, clipRight, clipBottom;
+    Traits::getClipping(target, state, clipLeft, clipTop, clipRight, clipBottom);
+    int32_t yBegin = (y0 > clipTop) ? y0 : clipTop;
+    int32_t yEnd = (y2 <= clipBottom) ? y2 : clipBottom + 1;
+    if (yBegin >= yEnd)
+        return;
+
+    // attribute gradients (one reciprocal of determinant shared by all attributes)
+    const GradientSetup16 gradientSetup(x1 - x0, y1 - y0, x2 - x0, y2 - y0, determinant);
+    attribute_gradient_t gradientR, gradientG, gradientB, gradientU, gradientV;
+    int32_t flatR = 0, flatG = 0, flatB = 0;
+    if (IsShaded)
+    {
+        const int32_t pRG0[2] = { static_cast<int32_t>(pV0->color & 0xFF), static_cast<int32_t>((pV0->color >> 8) & 0xFF) };
+        const int32_t pRG1[2] = { static_cast<int32_t>(pV1->color & 0xFF), static_cast<int32_t>((pV1->color >> 8) & 0xFF) };
+        const int32_t pRG2[2] = { static_cast<int32_t>(pV2->color & 0xFF), static_cast<int32_t>((pV2->color >> 8) & 0xFF) };
+        attribute_gradient_t::init2(gradientR, gradientG, pRG0, pRG1, pRG2, gradientSetup);
+        gradientB.init((pV0->color >> 16) & 0xFF, (pV1->color >> 16) & 0xFF, (pV2->color >> 16) & 0xFF, gradientSetup);
+    }
+    else // flat: color of first vertex
+    {
+        flatR = pVertices[0].color & 0xFF;
+        flatG = (pVertices[0].color >> 8) & 0xFF;
+        flatB = (pVertices[0].color >> 16) & 0xFF;
+    }
+    int32_t minU = 0, maxU = 0, minV = 0, maxV = 0;
+    if (Texture::isTextured)
+    {
+        const int32_t pUV0[2] = { static_cast<int32_t>(pV0->u), static_cast<int32_t>(pV0->v) };
+        const int32_t pUV1[2] = { static_cast<int32_t>(pV1->u), static_cast<int32_t>(pV1->v) };
+        const int32_t pUV2[2] = { static_cast<int32_t>(pV2->u), static_cast<int32_t>(pV2->v) };
+        attribute_gradient_t::init2(gradientU, gradientV, pUV0, pUV1, pUV2, gradientSetup);
+        minU = static_cast<int32_t>((pV0->u < pV1->u) ? ((pV0->u < pV2->u) ? pV0->u : pV2->u) : ((pV1->u < pV2->u) ? pV1->u : pV2->u));
+        maxU = static_cast<int32_t>((pV0->u > pV1->u) ? ((pV0->u > pV2->u) ? pV0->u : pV2->u) : ((pV1->u > pV2->u) ? pV1->u : pV2->u));
+        minV = static_cast<int32_t>((pV0->v < pV1->v) ? ((pV0->v < pV2->v) ? pV0->v : pV2->v) : ((pV1->v < pV2->v) ? pV1->v : pV2->v));
+        maxV = static_cast<int32_t>((pV0->v > pV1->v) ? ((pV0->v > pV2->v) ? pV0->v : pV2->v) : ((pV1->v > pV2->v) ? pV1->v : pV2->v));
+    }
+    const bool isDithering = (Traits::isDitherable && state.isDithered && (IsShaded || (Texture::isTextured && state.isModulated)));
+    const uint32_t upscalingFactor = (Texture::isUpscaled) ? state.texture.upscalingFactor : 1u;
+
+    typename Traits::kernel_t kernel = Traits::getKernel(state);
+    const pixel_t forcedMaskBit = Traits::getForcedMaskBit(state);
+    pixel_t pSpan[RASTER_SPAN_MAX_LENGTH];
+
+    for (int32_t y = yBegin; y < yEnd; ++y)
+    {
+        if (isSkippedRow<Traits>(target, state, y))
+            continue;
+        // span limits
+        int64_t longEdgeX = getEdgeX(x0, y0, x2, y2, y);
+        int64_t shortEdgeX = (y < y1) ? getEdgeX(x0, y0, x1, y1, y) : getEdgeX(x1, y1, x2, y2, y);
+        int32_t xBegin = static_cast<int32_t>((((isLongEdgeLeft) ? longEdgeX : shortEdgeX) + 0xFFFF) >> 16);
+        int32_t xEnd = static_cast<int32_t>((((isLongEdgeLeft) ? shortEdgeX : longEdgeX) + 0xFFFF) >> 16);
+        if (xBegin < clipLeft)
+            xBegin = clipLeft;
+        if (xEnd > clipRight + 1)
+            xEnd = clipRight + 1;
+        if (xBegin >= xEnd)
+            continue;
+
+        // attributes at beginning of span
+        int32_t r = flatR << 16, g = flatG << 16, b = flatB << 16, u = 0, v = 0;
+        if (IsShaded)
+        {
+            r = gradientR.at(xBegin - x0, y - y0);
+            g = gradientG.at(xBegin - x0, y - y0);
+            b = gradientB.at(xBegin - x0, y - y0);
+        }
+        if (Texture::isTextured)
+        {
+            u = gradientU.at(xBegin - x0, y - y0);
+            v = gradientV.at(xBegin - x0, y - y0);
+        }
+        const int32_t* pDitherRow = c_pDitherMatrix[y & 0x3];
+        pixel_t* pRow = Traits::row(target, y);
+
+        for (int32_t x = xBegin; x < xEnd; )
+        {
+            int32_t length = (xEnd - x < RASTER_SPAN_MAX_LENGTH) ? xEnd - x : RASTER_SPAN_MAX_LENGTH;
+            for (int32_t i = 0; i < length; ++i)
+            {
+                int32_t texU = 0, texV = 0;
+                uint32_t subU = 0u, subV = 0u;
+                if (Texture::isTextured)
+                {
+                    texU = u >> 16;
+                    texV = v >> 16;
+                    if (Texture::isUpscaled) // sub-position in upscaled texel block (fractional part of coordinates)
+                    {
+                        subU = (texU < minU) ? 0u : ((texU > maxU) ? upscalingFactor - 1u : ((static_cast<uint32_t>(u) & 0xFFFFu) * upscalingFactor) >> 16);
+                        subV = (texV < minV) ? 0u : ((texV > maxV) ? upscalingFactor - 1u : ((static_cast<uint32_t>(v) & 0xFFFFu) * upscalingFactor) >> 16);
+                    }
+                    texU = (texU < minU) ? minU : ((texU > maxU) ? maxU : texU);
+                    texV = (texV < minV) ? minV : ((texV > maxV) ? maxV : texV);
+                    u += gradientU.dx;
+                    v += gradientV.dx;
+                }
+                pSpan[i] = shadePixel<Traits, Texture>(state, texU, texV, subU, subV, r >> 16, g >> 16, b >> 16, (isDithering) ? pDitherRow[(x + i) & 0x3] : 0);
+                if (IsShaded)
+                {
+                    r += gradientR.dx;
+                    g += gradientG.dx;
+                    b += gradientB.dx;
+                }
+            }
+            kernel(pRow + x, pSpan, length, forcedMaskBit, state.isMaskBitChecked);
+            x += length;
+        }
+    }
+}
+
+/// @brief Select triangle rasterizer for current state
+template <typename Traits>
+static inline void selectTriangleRasterizer(const typename Traits::target_t& target, const raster_vertex_t* pVertices, const raster_state_t& state)
+{
+    if (Traits::isUpscalingAllowed && state.isTextured && state.texture.pUpscaledPage != nullptr)
+    {
+        if (state.isShaded) rasterizeTriangle<Traits, texture_upscaled_t, true>(target, pVertices, state);
+        else                rasterizeTriangle<Traits, texture_upscaled_t, false>(target, pVertices, state);
+    }
+    else if (state.isTextured && state.texture.pDecodedPage != nullptr && state.texture.colorDepth != colordepth_t::rgb_15bit)
+    {
+        if (state.isShaded) rasterizeTriangle<Traits, texture_decoded_t, true>(target, pVertices, state);
+        else                rasterizeTriangle<Traits, texture_decoded_t, false>(target, pVertices, state);
+    }
+    else if (state.isTextured)
+    {
+        switch (state.texture.colorDepth)
+        {
+            case colordepth_t::clut_4bit:
+                if (state.isShaded) rasterizeTriangle<Traits, texture_4bit_t, true>(target, pVertices, state);
+                else                rasterizeTriangle<Traits, texture_4bit_t, false>(target, pVertices, state);
+                break;
+            case colordepth_t::clut_8bit:
+                if (state.isShaded) rasterizeTriangle<Traits, texture_8bit_t, true>(target, pVertices, state);
+                else                rasterizeTriangle<Traits, texture_8bit_t, false>(target, pVertices, state);
+                break;
+            default:
+                if (state.isShaded) rasterizeTriangle<Traits, texture_15bit_t, true>(target, pVertices, state);
+                else                rasterizeTriangle<Traits, texture_15bit_t, false>(target, pVertices, state);
+                break;
+        }
+    }
+    else
+    {
+        if (state.isShaded) rasterizeTriangle<Traits, no_texture_t, true>(target, pVertices, state);
+        else                rasterizeTriangle<Traits, no_texture_t, false>(target, pVertices, state);
+    }
+}
+
+/// @brief Draw triangle
+/// @param[in] target     Rendering target
+/// @param[in] pVertices  Triangle vertices (3)
+/// @param[in] state      Rendering state
+void Rasterizer::drawTriangle(const native_target_t& target, const raster_vertex_t* pVertices, const raster_state_t& state)
+{
+    selectTriangleRasterizer<native_traits_t>(target, pVertices, state);
+}
+void Rasterizer::drawTriangle(const high_res_target_t& target, const raster_vertex_t* pVertices, const raster_state_t& state)
+{
+    selectTriangleRasterizer<high_res_traits_t>(target, pVertices, state);
+}
+
+
+// -- line rasterization -- ----------------------------------------------------
+
+/// @brief Rasterize line - end points included, one target pixel block per native step
+template <typename Traits>
+static void rasterizeLine(const typename Traits::target_t& target, const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state)
+{
+    typedef typename Traits::pixel_t pixel_t;
+    const int32_t scaleX = Traits::scaleX(target);
+    const int32_t scaleY = Traits::scaleY(target);
+    int32_t clipLeft, clipTop, clipRight, clipBottom;
+    Traits::getClipping(target, state, clipLeft, clipTop, clipRight, clipBottom);
+
+    // main axis
+    int32_t deltaX = v1.x - v0.x;
+    int32_t deltaY = v1.y - v0.y;
+    const bool isXMajor = (((deltaX < 0) ? -deltaX : deltaX) >= ((deltaY < 0) ? -deltaY : deltaY));
+    const int32_t majorScale = (isXMajor) ? scaleX : scaleY;
+    const int32_t minorScale = (isXMajor) ? scaleY : scaleX;
+    const int32_t majorOrigin = (isXMajor) ? v0.x : v0.y;
+    const int32_t minorOrigin = (isXMajor) ? v0.y : v0.x;
+    const int32_t majorDelta = (isXMajor) ? deltaX : deltaY;
+    const int32_t minorDelta = (isXMajor) ? deltaY : deltaX;
+    const int32_t nativeLength = (majorDelta < 0) ? -majorDelta : majorDelta;
+    const int32_t length = nativeLength * majorScale; // target steps between end point blocks
+
+    // colors
+    const int32_t r0 = v0.color & 0xFF, g0 = (v0.color >> 8) & 0xFF, b0 = (v0.color >> 16) & 0xFF;
+    const int32_t deltaR = (state.isShaded) ? static_cast<int32_t>(v1.color & 0xFF) - r0 : 0;
+    const int32_t deltaG = (state.isShaded) ? static_cast<int32_t>((v1.color >> 8) & 0xFF) - g0 : 0;
+    const int32_t deltaB = (state.isShaded) ? static_cast<int32_t>((v1.color >> 16) & 0xFF) - b0 : 0;
+    const bool isDithering = (Traits::isDitherable && state.isDithered && state.isShaded);
+
+    typename Traits::kernel_t kernel = Traits::getKernel(state);
+    const pixel_t forcedMaskBit = Traits::getForcedMaskBit(state);
+    pixel_t pRun[RASTER_SPAN_MAX_LENGTH];
+
+    for (int32_t step = 0; step < length + majorScale; ++step)
+    {
+        // progress along the line (16.16)
+        int64_t progress = (length > 0) ? ((static_cast<int64_t>((step < length) ? step : length) << 16) / length) : 0;
+        int32_t majorPos = (majorDelta >= 0) ? majorOrigin * majorScale + step : majorOrigin * majorScale + (majorScale - 1) - step;
+        int32_t minorPos = minorOrigin * minorScale + static_cast<int32_t>((static_cast<int64_t>(minorDelta) * minorScale * progress + 0x8000) >> 16);
+        int32_t x = (isXMajor) ? majorPos : minorPos;
+        int32_t y = (isXMajor) ? minorPos : majorPos;
+
+        int32_t r = r0 + static_cast<int32_t>((deltaR * progress + 0x8000) >> 16);
+        int32_t g = g0 + static_cast<int32_t>((deltaG * progress + 0x8000) >> 16);
+        int32_t b = b0 + static_cast<int32_t>((deltaB * progress + 0x8000) >> 16);
+
+        if (isXMajor) // vertical run of pixels
+        {
+            if (x < clipLeft || x > clipRight)
+                continue;
+            for (int32_t runY = y; runY < y + scaleY; ++runY)
+            {
+                if (runY < clipTop || runY > clipBottom || isSkippedRow<Traits>(target, state, runY))
+                    continue;
+                pRun[0] = Traits::fromColor(r, g, b, (isDithering) ? c_pDitherMatrix[runY & 0x3][x & 0x3] : 0);
+                kernel(Traits::row(target, runY) + x, pRun, 1u, forcedMaskBit, state.isMaskBitChecked);
+            }
+        }
+        else // horizontal run of pixels
+        {
+            if (y < clipTop || y > clipBottom || isSkippedRow<Traits>(target, state, y))
+                continue;
+            int32_t runBegin = (x > clipLeft) ? x : clipLeft;
+            int32_t runEnd = (x + scaleX <= clipRight + 1) ? x + scaleX : clipRight + 1;
+            if (runBegin >= runEnd)
+                continue;
+            for (int32_t runX = runBegin; runX < runEnd; ++runX)
+                pRun[runX - runBegin] = Traits::fromColor(r, g, b, (isDithering) ? c_pDitherMatrix[y & 0x3][runX & 0x3] : 0);
+            kernel(Traits::row(target, y) + runBegin, pRun, runEnd - runBegin, forcedMaskBit, state.isMaskBitChecked);
+        }
+    }
+}
+
+/// @brief Draw line (end points included)
+/// @param[in] target  Rendering target
+/// @param[in] v0      First end point
+/// @param[in] v1      Second end point
+/// @param[in] state   Rendering state
+void Rasterizer::drawLine(const native_target_t& target, const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state)
+{
+    rasterizeLine<native_traits_t>(target, v0, v1, state);
+}
+void Rasterizer::drawLine(const high_res_target_t& target, const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state)
+{
+    rasterizeLine<high_res_traits_t>(target, v0, v1, state);
+}
+
+
+// -- rectangle rasterization -- -----------------------------------------------
+
+/// @brief Rasterize rectangle (never dithered)
+template <typename Traits, typename Texture>
+static void rasterizeRectangle(const typename Traits::target_t& target, const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state)
+{
+    typedef typename Traits::pixel_t pixel_t;
+    const int32_t scaleX = Traits::scaleX(target);
+    const int32_t scaleY = Traits::scaleY(target);
+    int32_t clipLeft, clipTop, clipRight, clipBottom;
+    Traits::getClipping(target, state, clipLeft, clipTop, clipRight, clipBottom);
+
+    const int32_t originX = topLeft.x * scaleX;
+    const int32_t originY = topLeft.y * scaleY;
+    int32_t xBegin = (originX > clipLeft) ? originX : clipLeft;
+    int32_t xEnd = (originX + width * scaleX <= clipRight + 1) ? originX + width * scaleX : clipRight + 1;
+    int32_t yBegin = (originY > clipTop) ? originY : clipTop;
+    int32_t yEnd = (originY + height * scaleY <= clipBottom + 1) ? originY + height * scaleY : clipBottom + 1;
+    if (xBegin >= xEnd || yBegin >= yEnd)
+        return;
+
+    const int32_t r = topLeft.color & 0xFF, g = (topLeft.color >> 8) & 0xFF, b = (topLeft.color >> 16) & 0xFF;
+    const int32_t stepU = (state.isRectXFlip) ? -1 : 1;
+    const int32_t stepV = (state.isRectYFlip) ? -1 : 1;
+    typename Traits::kernel_t kernel = Traits::getKernel(state);
+    const pixel_t forcedMaskBit = Traits::getForcedMaskBit(state);
+    pixel_t pSpan[RASTER_SPAN_MAX_LENGTH];
+
+    for (int32_t y = yBegin; y < yEnd; ++y)
+    {
+        if (isSkippedRow<Traits>(target, state, y))
+            continue;
+        uint32_t v = static_cast<uint32_t>(static_cast<int32_t>(topLeft.v) + stepV * ((y - originY) / scaleY)) & 0xFFu;
+        uint32_t subV = 0u;
+        if (Texture::isUpscaled)
+        {
+            subV = static_cast<uint32_t>((y - originY) % scaleY) * state.texture.upscalingFactor / static_cast<uint32_t>(scaleY);
+            if (state.isRectYFlip)
+                subV = state.texture.upscalingFactor - 1u - subV;
+        }
+        pixel_t* pRow = Traits::row(target, y);
+
+        for (int32_t x = xBegin; x < xEnd; )
+        {
+            int32_t length = (xEnd - x < RASTER_SPAN_MAX_LENGTH) ? xEnd - x : RASTER_SPAN_MAX_LENGTH;
+            if (Texture::isTextured)
+            {
+                // texel coordinate + sub-position in upscaled texel
+                int32_t texelOffset = (x - originX) / scaleX;
+                int32_t subPosition = (x - originX) - texelOffset * scaleX;
+                uint32_t u = static_cast<uint32_t>(static_cast<int32_t>(topLeft.u) + stepU * texelOffset);
+                for (int32_t i = 0; i < length; ++i)
+                {
+                    uint32_t subU = 0u;
+                    if (Texture::isUpscaled)
+                    {
+                        subU = static_cast<uint32_t>(subPosition) * state.texture.upscalingFactor / static_cast<uint32_t>(scaleX);
+                        if (state.isRectXFlip)
+                            subU = state.texture.upscalingFactor - 1u - subU;
+                    }
+                    pSpan[i] = shadePixel<Traits, Texture>(state, u & 0xFFu, v, subU, subV, r, g, b, 0);
+                    if (++subPosition == scaleX)
+                    {
+                        subPosition = 0;
+                        u += stepU;
+                    }
+                }
+            }
+            else
+            {
+                const pixel_t color = Traits::fromColor(r, g, b, 0);
+                for (int32_t i = 0; i < length; ++i)
+                    pSpan[i] = color;
+            }
+            kernel(pRow + x, pSpan, length, forcedMaskBit, state.isMaskBitChecked);
+            x += length;
+        }
+    }
+}
+
+/// @brief Select rectangle rasterizer for current state
+template <typename Traits>
+static inline void selectRectangleRasterizer(const typename Traits::target_t& target, const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    if (Traits::isUpscalingAllowed && state.isTextured && state.texture.pUpscaledPage != nullptr)
+        rasterizeRectangle<Traits, texture_upscaled_t>(target, topLeft, width, height, state);
+    else if (state.isTextured && state.texture.pDecodedPage != nullptr && state.texture.colorDepth != colordepth_t::rgb_15bit)
+        rasterizeRectangle<Traits, texture_decoded_t>(target, topLeft, width, height, state);
+    else if (state.isTextured)
+    {
+        switch (state.texture.colorDepth)
+        {
+            case colordepth_t::clut_4bit: rasterizeRectangle<Traits, texture_4bit_t>(target, topLeft, width, height, state); break;
+            case colordepth_t::clut_8bit: rasterizeRectangle<Traits, texture_8bit_t>(target, topLeft, width, height, state); break;
+            default:                      rasterizeRectangle<Traits, texture_15bit_t>(target, topLeft, width, height, state); break;
+        }
+    }
+    else
+        rasterizeRectangle<Traits, no_texture_t>(target, topLeft, width, height, state);
+}
+
+/// @brief Draw rectangle (tile / sprite)
+/// @param[in] target   Rendering target
+/// @param[in] topLeft  Top-left vertex (position, color, texture coordinates)
+/// @param[in] width    Rectangle width
+/// @param[in] height   Rectangle height
+/// @param[in] state    Rendering state
+void Rasterizer::drawRectangle(const native_target_t& target, const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state)
+{
+    selectRectangleRasterizer<native_traits_t>(target, topLeft, width, height, state);
+}
+void Rasterizer::drawRectangle(const high_res_target_t& target, const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state)
+{
+    selectRectangleRasterizer<high_res_traits_t>(target, topLeft, width, height, state);
+}
+
+
+// -- fill / synchronization -- ------------------------------------------------
+
+/// @brief Fill area with color (no drawing area, no mask, VRAM wrapping)
+/// @param[in] target  Rendering target
+/// @param[in] x       Left position (native units)
+/// @param[in] y       Top position (native units)
+/// @param[in] width   Area width (native units)
+/// @param[in] height  Area height (native units)
+/// @param[in] color   Fill color (00BbGgRr)
+void Rasterizer::fillArea(const native_target_t& target, const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color)
+{
+    const uint16_t pixel = toNative(color);
+    for (int32_t row = y; row < y + height; ++row)
+    {
+        uint16_t* pRow = target.pBuffer + ((row & (RASTER_VRAM_HEIGHT - 1)) * RASTER_VRAM_WIDTH);
+        for (int32_t col = x; col < x + width; ++col)
+            pRow[col & (RASTER_VRAM_WIDTH - 1)] = pixel;
+    }
+}
+void Rasterizer::fillArea(const high_res_target_t& target, const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color)
+{
+    const int32_t targetWidth = target.width();
+    const int32_t targetHeight = target.height();
+    const uint32_t pixel = color & BLEND_KERNEL32_COLOR_BITS;
+    for (int32_t row = y * target.scaleY; row < (y + height) * target.scaleY; ++row)
+    {
+        int32_t wrappedRow = row % targetHeight;
+        if (wrappedRow < target.rowBegin || wrappedRow >= target.rowEnd)
+            continue;
+        uint32_t* pRow = target.pBuffer + static_cast<size_t>(wrappedRow) * targetWidth;
+        for (int32_t col = x * target.scaleX; col < (x + width) * target.scaleX; ++col)
+            pRow[col % targetWidth] = pixel;
+    }
+}
+
+/// @brief Copy native VRAM area into high resolution target (pixel duplication, VRAM wrapping)
+/// @param[in] target  High resolution target
+/// @param[in] pVram   Native VRAM image
+/// @param[in] x       Left position (native units)
+/// @param[in] y       Top position (native units)
+/// @param[in] width   Area width (native units)
+/// @param[in] height  Area height (native units)
+void Rasterizer::uploadArea(const high_res_target_t& target, const uint16_t* pVram, const int32_t x, const int32_t y, const int32_t width, const int32_t height)
+{
+    const int32_t targetWidth = target.width();
+    for (int32_t row = y; row < y + height; ++row)
+    {
+        const int32_t nativeRow = row & (RASTER_VRAM_HEIGHT - 1);
+        if ((nativeRow + 1) * target.scaleY <= target.rowBegin || nativeRow * target.scaleY >= target.rowEnd)
+            continue;
+        const uint16_t* pSource = pVram + nativeRow * RASTER_VRAM_WIDTH;
+
+        // first upscaled row
+        uint32_t* pFirstRow = target.pBuffer + static_cast<size_t>(nativeRow * target.scaleY) * targetWidth;
+        for (int32_t col = x; col < x + width; ++col)
+        {
+            const int32_t nativeCol = col & (RASTER_VRAM_WIDTH - 1);
+            const uint32_t pixel = toRgba(pSource[nativeCol]);
+            uint32_t* pDest = pFirstRow + nativeCol * target.scaleX;
+            for (int32_t i = 0; i < target.scaleX; ++i)
+                pDest[i] = pixel;
+        }
+        // duplicated rows (copy of contiguous segments)
+        for (int32_t sub = 1; sub < target.scaleY; ++sub)
+        {
+            uint32_t* pDestRow = pFirstRow + static_cast<size_t>(sub) * targetWidth;
+            const int32_t begin = (x & (RASTER_VRAM_WIDTH - 1)) * target.scaleX;
+            const int32_t end = begin + width * target.scaleX;
+            if (end <= targetWidth)
+            {
+                memcpy(pDestRow + begin, pFirstRow + begin, (end - begin) * sizeof(uint32_t));
+            }
+            else // wrapped
+            {
+                memcpy(pDestRow + begin, pFirstRow + begin, (targetWidth - begin) * sizeof(uint32_t));
+                memcpy(pDestRow, pFirstRow, (end - targetWidth) * sizeof(uint32_t));
+            }
+        }
+    }
+}
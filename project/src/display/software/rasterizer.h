@@ -0,0 +1,174 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - primitive rasterizer (native / high resolution targets)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "../../command/primitive/primitive_common.h"
+
+#define RASTER_VRAM_WIDTH  1024 // native VRAM width (pixels)
+#define RASTER_VRAM_HEIGHT 512  // native VRAM height (pixels)
+#define RASTER_SPAN_MAX_LENGTH 512 // max length of source pixel row processed at once
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.software
+    /// Software rendering
+    namespace software
+    {
+        /// @struct raster_vertex_t
+        /// @brief Decoded vertex (drawing offset already applied)
+        struct raster_vertex_t
+        {
+            int32_t x;      ///< X coordinate (native VRAM units)
+            int32_t y;      ///< Y coordinate (native VRAM units)
+            uint32_t color; ///< Vertex color (00BbGgRr)
+            uint32_t u;     ///< Texture U coordinate (0 - 255)
+            uint32_t v;     ///< Texture V coordinate (0 - 255)
+        };
+
+        /// @struct raster_texture_t
+        /// @brief Texture source (read from native VRAM)
+        struct raster_texture_t
+        {
+            const uint16_t* pVram;  ///< Native VRAM image (texels + CLUT)
+            uint32_t texpageX;      ///< Texture page X base: 0, 64, ...
+            uint32_t texpageY;      ///< Texture page Y base: 0 or 256
+            uint32_t clutX;         ///< CLUT X position: 0, 16, ...
+            uint32_t clutY;         ///< CLUT Y position: 0 - 511
+            command::primitive::colordepth_t colorDepth; ///< Texel color depth
+            uint32_t windowMaskU;   ///< Texture window - preserved coordinate bits
+            uint32_t windowMaskV;   ///< Texture window - preserved coordinate bits
+            uint32_t windowOffsetU; ///< Texture window - forced coordinate bits
+            uint32_t windowOffsetV; ///< Texture window - forced coordinate bits
+            const uint16_t* pDecodedPage; ///< Decoded CLUT texture page (256 x 256 texels) - nullptr: texels read from VRAM
+            const uint16_t* pUpscaledPage; ///< Upscaled texture page (256*factor x 256*factor texels, high resolution target only) - nullptr: native texels
+            uint32_t upscalingFactor;      ///< Upscaled texture page factor
+        };
+
+        /// @struct raster_state_t
+        /// @brief Primitive rendering state
+        struct raster_state_t
+        {
+            int32_t clipLeft;   ///< Drawing area - left limit (native units, inclusive)
+            int32_t clipTop;    ///< Drawing area - top limit (native units, inclusive)
+            int32_t clipRight;  ///< Drawing area - right limit (native units, inclusive)
+            int32_t clipBottom; ///< Drawing area - bottom limit (native units, inclusive)
+            raster_texture_t texture; ///< Texture source (if textured)
+            command::primitive::stp_t semiTransparency; ///< Semi-transparency mode
+            bool isTextured;        ///< Texture mapping
+            bool isShaded;          ///< Gouraud shading (otherwise: flat color of first vertex)
+            bool isModulated;       ///< Texture blending with vertex color (otherwise: raw texture)
+            bool isSemiTransparent; ///< Semi-transparency
+            bool isDithered;        ///< Dithering (native target only)
+            bool isMaskBitForced;   ///< Set mask bit on written pixels
+            bool isMaskBitChecked;  ///< Preserve pixels with mask bit
+            bool isRectXFlip;       ///< Rectangle texture X-flip
+            bool isRectYFlip;       ///< Rectangle texture Y-flip
+            bool isFieldSkipped;        ///< Interlaced field drawing: native rows of one field are not drawn
+            int32_t skippedFieldParity; ///< Interlaced field drawing: parity of skipped native rows (0 = even, 1 = odd)
+        };
+
+
+        /// @struct native_target_t
+        /// @brief Native target (15-bit VRAM)
+        struct native_target_t
+        {
+            uint16_t* pBuffer; ///< VRAM image (1024 x 512)
+        };
+
+        /// @struct high_res_target_t
+        /// @brief High resolution target (RGBA, upscaled VRAM) - can be limited to a band of rows
+        struct high_res_target_t
+        {
+            uint32_t* pBuffer; ///< Upscaled VRAM image (1024*scaleX x 512*scaleY)
+            int32_t scaleX;    ///< Horizontal upscaling factor
+            int32_t scaleY;    ///< Vertical upscaling factor
+            int32_t rowBegin;  ///< First row of band (target units)
+            int32_t rowEnd;    ///< Row after band (target units)
+
+            inline int32_t width() const noexcept  { return RASTER_VRAM_WIDTH * scaleX; }
+            inline int32_t height() const noexcept { return RASTER_VRAM_HEIGHT * scaleY; }
+        };
+
+
+        /// @class Rasterizer
+        /// @brief Primitive rasterizer - same rasterization rules for native and high resolution targets
+        class Rasterizer
+        {
+        public:
+            // -- primitives -- ------------------------------------------------
+
+            /// @brief Draw triangle
+            /// @param[in] target     Rendering target
+            /// @param[in] pVertices  Triangle vertices (3)
+            /// @param[in] state      Rendering state
+            static void drawTriangle(const native_target_t& target, const raster_vertex_t* pVertices, const raster_state_t& state);
+            static void drawTriangle(const high_res_target_t& target, const raster_vertex_t* pVertices, const raster_state_t& state);
+
+            /// @brief Draw line (end points included)
+            /// @param[in] target  Rendering target
+            /// @param[in] v0      First end point
+            /// @param[in] v1      Second end point
+            /// @param[in] state   Rendering state
+            static void drawLine(const native_target_t& target, const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state);
+            static void drawLine(const high_res_target_t& target, const raster_vertex_t& v0, const raster_vertex_t& v1, const raster_state_t& state);
+
+            /// @brief Draw rectangle (tile / sprite)
+            /// @param[in] target   Rendering target
+            /// @param[in] topLeft  Top-left vertex (position, color, texture coordinates)
+            /// @param[in] width    Rectangle width
+            /// @param[in] height   Rectangle height
+            /// @param[in] state    Rendering state
+            static void drawRectangle(const native_target_t& target, const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state);
+            static void drawRectangle(const high_res_target_t& target, const raster_vertex_t& topLeft, const int32_t width, const int32_t height, const raster_state_t& state);
+
+            /// @brief Fill area with color (no drawing area, no mask, VRAM wrapping - coordinates must be aligned)
+            /// @param[in] target  Rendering target
+            /// @param[in] x       Left position (native units)
+            /// @param[in] y       Top position (native units)
+            /// @param[in] width   Area width (native units)
+            /// @param[in] height  Area height (native units)
+            /// @param[in] color   Fill color (00BbGgRr)
+            static void fillArea(const native_target_t& target, const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color);
+            static void fillArea(const high_res_target_t& target, const int32_t x, const int32_t y, const int32_t width, const int32_t height, const uint32_t color);
+
+
+            // -- native / high resolution synchronization -- ------------------
+
+            /// @brief Copy native VRAM area into high resolution target (pixel duplication, VRAM wrapping)
+            /// @param[in] target  High resolution target
+            /// @param[in] pVram   Native VRAM image
+            /// @param[in] x       Left position (native units)
+            /// @param[in] y       Top position (native units)
+            /// @param[in] width   Area width (native units)
+            /// @param[in] height  Area height (native units)
+            static void uploadArea(const high_res_target_t& target, const uint16_t* pVram, const int32_t x, const int32_t y, const int32_t width, const int32_t height);
+
+            /// @brief Convert native VRAM pixel to RGBA pixel (mask bit -> alpha high bit)
+            /// @param[in] pixel  Native pixel (mBbb-bbGg-gggR-rrrr)
+            /// @returns RGBA pixel (m000000BbGgRr)
+            static inline uint32_t toRgba(const uint16_t pixel) noexcept
+            {
+                uint32_t r = pixel & 0x1Fu, g = (pixel >> 5) & 0x1Fu, b = (pixel >> 10) & 0x1Fu;
+                return ((r << 3) | (r >> 2)) | (((g << 3) | (g >> 2)) << 8) | (((b << 3) | (b >> 2)) << 16)
+                     | (static_cast<uint32_t>(pixel & 0x8000u) << 16);
+            }
+            /// @brief Convert 24-bit color to native VRAM pixel (without mask bit)
+            /// @param[in] color  24-bit color (00BbGgRr)
+            /// @returns Native pixel (0Bbb-bbGg-gggR-rrrr)
+            static inline uint16_t toNative(const uint32_t color) noexcept
+            {
+                return static_cast<uint16_t>(((color >> 3) & 0x1Fu) | ((color >> 6) & 0x3E0u) | ((color >> 9) & 0x7C00u));
+            }
+        };
+    }
+}
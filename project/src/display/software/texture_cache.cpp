@@ -0,0 +1,183 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - decoded texture page cache (CLUT textures)
+*******************************************************************************/
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "rasterizer.h"
+#include "texture_cache.h"
+using namespace display::software;
+using command::primitive::colordepth_t;
+
+
+/// @brief Create texture cache
+/// @param[in] memoryBudget  Max memory used by decoded pages (bytes - at least one page)
+TextureCache::TextureCache(const size_t memoryBudget) : m_tick(0uLL)
+{
+    m_capacity = memoryBudget / TEXTURE_CACHE_PAGE_BYTES;
+    if (m_capacity == 0u)
+        m_capacity = 1u;
+
+    m_pageData.resize(m_capacity * TEXTURE_CACHE_PAGE_SIZE * TEXTURE_CACHE_PAGE_SIZE);
+    m_slots.resize(m_capacity, page_slot_t{ texture_page_key_t{ 0u, 0u, PALETTE_ID_NONE, colordepth_t::clut_4bit }, 0uLL, false });
+    m_freeSlots.reserve(m_capacity);
+    for (size_t i = m_capacity; i > 0u; --i)
+        m_freeSlots.push_back(i - 1u);
+    m_slotIndexes.reserve(m_capacity);
+    resetStats();
+}
+
+
+// -- pages -- -----------------------------------------------------------------
+
+/// @brief Find decoded texture page
+/// @param[in] key  Page identifier
+/// @returns Decoded page (or nullptr if not in cache)
+const uint16_t* TextureCache::find(const texture_page_key_t& key) noexcept
+{
+    auto it = m_slotIndexes.find(key.hash());
+    if (it == m_slotIndexes.end())
+        return nullptr;
+
+    ++m_stats.hits;
+    m_slots[it->second].lastUse = ++m_tick;
+    return &m_pageData[it->second * TEXTURE_CACHE_PAGE_SIZE * TEXTURE_CACHE_PAGE_SIZE];
+}
+
+/// @brief Decode texture page and store it in cache (least recently used page evicted if cache is full)
+/// @param[in] key       Page identifier
+/// @param[in] pVram     Native VRAM image (texels)
+/// @param[in] pPalette  Palette entries (16 or 256)
+/// @returns Decoded page (256 x 256 15-bit texels, row by row)
+const uint16_t* TextureCache::insert(const texture_page_key_t& key, const uint16_t* pVram, const uint16_t* pPalette)
+{
+    auto it = m_slotIndexes.find(key.hash());
+    if (it != m_slotIndexes.end()) // already decoded
+        releaseSlot(it->second);
+
+    if (m_freeSlots.empty()) // evict least recently used page
+    {
+        size_t oldestSlot = 0u;
+        for (size_t i = 1u; i < m_slots.size(); ++i)
+        {
+            if (m_slots[i].lastUse < m_slots[oldestSlot].lastUse)
+                oldestSlot = i;
+        }
+        releaseSlot(oldestSlot);
+        ++m_stats.evictions;
+    }
+    size_t slotIndex = m_freeSlots.back();
+    m_freeSlots.pop_back();
+
+    page_slot_t& slot = m_slots[slotIndex];
+    slot.key = key;
+    slot.lastUse = ++m_tick;
+    slot.isUsed = true;
+    m_slotIndexes[key.hash()] = slotIndex;
+
+    uint16_t* pTexels = &m_pageData[slotIndex * TEXTURE_CACHE_PAGE_SIZE * TEXTURE_CACHE_PAGE_SIZE];
+    decodePage(key, pVram, pPalette, pTexels);
+    ++m_stats.misses;
+    return pTexels;
+}
+
+/// @brief Decode texture page into slot storage
+void TextureCache::decodePage(const texture_page_key_t& key, const uint16_t* pVram, const uint16_t* pPalette, uint16_t* pOutTexels) const noexcept
+{
+    for (uint32_t v = 0; v < TEXTURE_CACHE_PAGE_SIZE; ++v)
+    {
+        const uint16_t* pRow = pVram + (((key.texpageY + v) & 0x1FFu) << 10);
+        uint16_t* pOutRow = pOutTexels + (v << 8);
+        if (key.colorDepth == colordepth_t::clut_4bit)
+        {
+            for (uint32_t u = 0; u < TEXTURE_CACHE_PAGE_SIZE; u += 4u)
+            {
+                uint16_t indexes = pRow[(key.texpageX + (u >> 2)) & 0x3FFu];
+                pOutRow[u]      = pPalette[indexes & 0xFu];
+                pOutRow[u + 1u] = pPalette[(indexes >> 4) & 0xFu];
+                pOutRow[u + 2u] = pPalette[(indexes >> 8) & 0xFu];
+                pOutRow[u + 3u] = pPalette[indexes >> 12];
+            }
+        }
+        else
+        {
+            for (uint32_t u = 0; u < TEXTURE_CACHE_PAGE_SIZE; u += 2u)
+            {
+                uint16_t indexes = pRow[(key.texpageX + (u >> 1)) & 0x3FFu];
+                pOutRow[u]      = pPalette[indexes & 0xFFu];
+                pOutRow[u + 1u] = pPalette[indexes >> 8];
+            }
+        }
+    }
+}
+
+/// @brief Remove page from slot
+void TextureCache::releaseSlot(const size_t slotIndex) noexcept
+{
+    page_slot_t& slot = m_slots[slotIndex];
+    if (slot.isUsed)
+    {
+        m_slotIndexes.erase(slot.key.hash());
+        slot.isUsed = false;
+        m_freeSlots.push_back(slotIndex);
+    }
+}
+
+
+// -- invalidation -- ----------------------------------------------------------
+
+/// @brief Check if two ranges overlap on a circular axis
+/// @param[in] firstBegin    First range position (normalized)
+/// @param[in] firstLength   First range length (max: axis size)
+/// @param[in] secondBegin   Second range position (normalized)
+/// @param[in] secondLength  Second range length (max: axis size)
+/// @param[in] axisSize      Axis size (power of 2)
+static inline bool isOverlappingRange(const int32_t firstBegin, const int32_t firstLength, const int32_t secondBegin, const int32_t secondLength, const int32_t axisSize) noexcept
+{
+    return (((secondBegin - firstBegin) & (axisSize - 1)) < firstLength || ((firstBegin - secondBegin) & (axisSize - 1)) < secondLength);
+}
+
+/// @brief Invalidate pages whose texels are in a written VRAM area (with VRAM wrapping)
+/// @param[in] left    Left limit of written area (inclusive)
+/// @param[in] top     Top limit of written area (inclusive)
+/// @param[in] right   Right limit of written area (inclusive)
+/// @param[in] bottom  Bottom limit of written area (inclusive)
+void TextureCache::invalidateArea(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept
+{
+    if (m_slotIndexes.empty() || right < left || bottom < top)
+        return;
+    const int32_t areaX = left & (RASTER_VRAM_WIDTH - 1);
+    const int32_t areaY = top & (RASTER_VRAM_HEIGHT - 1);
+    const int32_t areaWidth = (right - left + 1 < RASTER_VRAM_WIDTH) ? right - left + 1 : RASTER_VRAM_WIDTH;
+    const int32_t areaHeight = (bottom - top + 1 < RASTER_VRAM_HEIGHT) ? bottom - top + 1 : RASTER_VRAM_HEIGHT;
+
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        if (m_slots[i].isUsed == false)
+            continue;
+        const texture_page_key_t& key = m_slots[i].key;
+        const int32_t texelAreaWidth = (key.colorDepth == colordepth_t::clut_4bit) ? 64 : 128;
+
+        if (isOverlappingRange(areaX, areaWidth, static_cast<int32_t>(key.texpageX), texelAreaWidth, RASTER_VRAM_WIDTH)
+        &&  isOverlappingRange(areaY, areaHeight, static_cast<int32_t>(key.texpageY), TEXTURE_CACHE_PAGE_SIZE, RASTER_VRAM_HEIGHT))
+        {
+            releaseSlot(i);
+            ++m_stats.invalidations;
+        }
+    }
+}
+
+/// @brief Remove all pages (explicit flush)
+void TextureCache::clear() noexcept
+{
+    for (size_t i = 0; i < m_slots.size(); ++i)
+        releaseSlot(i);
+    ++m_stats.clears;
+}
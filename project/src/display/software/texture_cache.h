@@ -0,0 +1,145 @@
+/*******************************************************************************
+PANDORAGS project - PS1 GPU driver
+------------------------------------------------------------------------
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : software renderer - decoded texture page cache (CLUT textures)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "../../command/primitive/primitive_common.h"
+#include "palette_registry.h"
+
+#define TEXTURE_CACHE_PAGE_SIZE      256 // decoded page width/height (texels)
+#define TEXTURE_CACHE_PAGE_BYTES     (TEXTURE_CACHE_PAGE_SIZE * TEXTURE_CACHE_PAGE_SIZE * sizeof(uint16_t))
+#define TEXTURE_CACHE_DEFAULT_BUDGET (8u * 1024u * 1024u) // default memory budget (bytes): 64 pages
+
+/// @namespace display
+/// Display management
+namespace display
+{
+    /// @namespace display.software
+    /// Software rendering
+    namespace software
+    {
+        /// @struct texture_page_key_t
+        /// @brief Decoded texture page identifier (texture page position, palette content, color depth)
+        struct texture_page_key_t
+        {
+            uint32_t texpageX;      ///< Texture page X base: 0, 64, ...
+            uint32_t texpageY;      ///< Texture page Y base: 0 or 256
+            palette_id_t paletteId; ///< Palette identifier (content-based: CLUT position doesn't matter)
+            command::primitive::colordepth_t colorDepth; ///< Texel color depth (CLUT modes only)
+
+            /// @brief Get packed key value
+            inline uint64_t hash() const noexcept
+            {
+                return static_cast<uint64_t>(((texpageX >> 6) & 0xFu) | (((texpageY >> 8) & 0x1u) << 4) | ((static_cast<uint32_t>(colorDepth) & 0x3u) << 5))
+                     | (static_cast<uint64_t>(paletteId) << 7);
+            }
+        };
+
+        /// @struct texture_cache_stats_t
+        /// @brief Texture cache counters
+        struct texture_cache_stats_t
+        {
+            uint64_t hits;          ///< Decoded pages found in cache
+            uint64_t misses;        ///< Pages decoded from VRAM
+            uint64_t invalidations; ///< Pages removed because their texels were written
+            uint64_t evictions;     ///< Pages removed to stay in memory budget (least recently used)
+            uint64_t clears;        ///< Explicit cache flushes
+        };
+
+
+        /// @class TextureCache
+        /// @brief Cache of CLUT texture pages decoded to 15-bit texels (256 x 256) - LRU eviction under a memory budget
+        /// @details Pages are keyed on palette content (see PaletteRegistry): CLUT uploads never invalidate decoded pages.
+        ///          Pages are invalidated precisely: only if a VRAM write overlaps their texel area.
+        class TextureCache
+        {
+        public:
+            /// @brief Create texture cache
+            /// @param[in] memoryBudget  Max memory used by decoded pages (bytes - at least one page)
+            TextureCache(const size_t memoryBudget = TEXTURE_CACHE_DEFAULT_BUDGET);
+            // no copy allowed
+            TextureCache(const TextureCache& other) = delete;
+            TextureCache& operator=(const TextureCache& other) = delete;
+
+
+            // -- pages -- -----------------------------------------------------
+
+            /// @brief Find decoded texture page
+            /// @param[in] key  Page identifier
+            /// @returns Decoded page (or nullptr if not in cache)
+            const uint16_t* find(const texture_page_key_t& key) noexcept;
+            /// @brief Decode texture page and store it in cache (least recently used page evicted if cache is full)
+            /// @param[in] key       Page identifier
+            /// @param[in] pVram     Native VRAM image (texels)
+            /// @param[in] pPalette  Palette entries (16 or 256)
+            /// @returns Decoded page (256 x 256 15-bit texels, row by row)
+            const uint16_t* insert(const texture_page_key_t& key, const uint16_t* pVram, const uint16_t* pPalette);
+            /// @brief Check if cache is full (next insertion will evict a page)
+            inline bool isFull() const noexcept { return (m_slotIndexes.size() >= m_capacity); }
+            /// @brief Check if texture mode can be cached (CLUT textures only)
+            static inline bool isCacheable(const command::primitive::colordepth_t colorDepth) noexcept
+            {
+                return (colorDepth == command::primitive::colordepth_t::clut_4bit || colorDepth == command::primitive::colordepth_t::clut_8bit);
+            }
+
+
+            // -- invalidation -- ----------------------------------------------
+
+            /// @brief Invalidate pages whose texels are in a written VRAM area (with VRAM wrapping)
+            /// @param[in] left    Left limit of written area (inclusive)
+            /// @param[in] top     Top limit of written area (inclusive)
+            /// @param[in] right   Right limit of written area (inclusive)
+            /// @param[in] bottom  Bottom limit of written area (inclusive)
+            void invalidateArea(const int32_t left, const int32_t top, const int32_t right, const int32_t bottom) noexcept;
+            /// @brief Remove all pages (explicit flush)
+            void clear() noexcept;
+
+
+            // -- statistics -- ------------------------------------------------
+
+            /// @brief Get number of pages in cache
+            inline size_t size() const noexcept { return m_slotIndexes.size(); }
+            /// @brief Get max number of pages in cache
+            inline size_t capacity() const noexcept { return m_capacity; }
+            /// @brief Get cache counters
+            inline const texture_cache_stats_t& getStats() const noexcept { return m_stats; }
+            /// @brief Reset cache counters
+            inline void resetStats() noexcept { m_stats = texture_cache_stats_t{ 0uLL, 0uLL, 0uLL, 0uLL, 0uLL }; }
+
+
+        private:
+            /// @struct page_slot_t
+            /// @brief Cache slot (decoded page storage)
+            struct page_slot_t
+            {
+                texture_page_key_t key; ///< Page identifier
+                uint64_t lastUse;       ///< Last access tick (LRU)
+                bool isUsed;            ///< Slot contains a valid page
+            };
+
+            /// @brief Decode texture page into slot storage
+            void decodePage(const texture_page_key_t& key, const uint16_t* pVram, const uint16_t* pPalette, uint16_t* pOutTexels) const noexcept;
+            /// @brief Remove page from slot
+            void releaseSlot(const size_t slotIndex) noexcept;
+
+
+        private:
+            std::vector<uint16_t> m_pageData;   ///< Decoded pages storage (capacity * page size)
+            std::vector<page_slot_t> m_slots;   ///< Cache slots
+            std::vector<size_t> m_freeSlots;    ///< Available slots
+            std::unordered_map<uint64_t, size_t> m_slotIndexes; ///< Slot of each cached page (by key hash)
+            size_t m_capacity;                  ///< Max number of cached pages
+            uint64_t m_tick;                    ///< Access counter (LRU)
+            texture_cache_stats_t m_stats;      ///< Cache counters
+        };
+    }
+}
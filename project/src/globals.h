@@ -49,6 +49,14 @@ Description : global constants and settings
 // compilation settings - trace psemu calls
 #define _TRACE_CALLS     0 // 0 - disabled / 1 - enabled
 #define _UNITTEST_APP_NAME "UNITTEST.001"
+// compilation settings - software renderer: compare interlaced field rendering with full-height rendering
+#define _FIELD_VALIDATION 0 // 0 - disabled / 1 - enabled
+// compilation settings - SIMD instructions (SSE2 always available on x86_64)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _SIMD_SSE2       1
+#else
+#define _SIMD_SSE2       0
+#endif
 
 
 // -- SYSTEM COMPATIBILITY - WINDOWS -- ----------------------------------------
@@ -8,19 +8,84 @@ Description : PSEmu GPU library interface
 *******************************************************************************/
 #include "globals.h"
 #include <cstdlib>
+#include <cstring>
+#include <cstdint>
 #include <string>
+#include <memory>
+#include <thread>
 using namespace std::literals::string_literals;
 #include "pandoraGS.h"
 #include "config/config.h"
+#include "config/config_io.h"
 #include "config/dialog/config_dialog.h"
 #include "events/listener.h"
 #include "events/menu.h"
 #include "events/utils/logger.h"
 #include "command/dispatcher.h"
+#include "command/primitive/primitive_facade.h"
 #include "display/engine.h"
+#include "display/output/headless_output.h"
+#include "display/output/display_kernels.h"
+#include "display/output/snapshot_writer.h"
+#include "display/output/frame_dump_writer.h"
 #include "psemu_main.h"
 using namespace std;
 
+#define GAME_PREFETCH_TEXTURE_PAGES 64u // max number of upscaled texture pages preloaded from persistent cache
+
+
+// -- game prefetch -- ---------------------------------------------------------
+
+/// @struct game_prefetch_t
+/// @brief Game data prepared in background thread (between GPUsetExeName and GPUopen)
+struct game_prefetch_t
+{
+    std::string gameId;  ///< Game executable ID
+    uint32_t profileId;  ///< Associated config profile
+    bool isProfileReady; ///< Associated profile loaded
+    std::unique_ptr<display::scaling::UpscaledTextureStore> pTextureStore; ///< Persistent cache of upscaled textures (or nullptr)
+};
+static game_prefetch_t g_gamePrefetch{ ""s, 0u, false, nullptr }; ///< Prefetch result (only accessed by prefetch thread until joined)
+static std::thread g_gamePrefetchThread;                          ///< Prefetch thread
+static std::unique_ptr<display::output::SnapshotWriter> g_pSnapshotWriter; ///< Asynchronous snapshot writer (while driver is open)
+static std::unique_ptr<display::output::FrameDumpWriter> g_pFrameDump;     ///< Streaming dump of presented frames (if enabled)
+
+/// @brief Prefetch game data (background thread): profile association, profile, per-game persistent caches
+/// @param[in] pData          Prefetch data (game ID set)
+/// @param[in] renderingMode  Rendering mode (copy of display settings: config not read by prefetch thread)
+static void prefetchGameData(game_prefetch_t* pData, const config::rendering_mode_t renderingMode) noexcept
+{
+    try
+    {
+        pData->profileId = config::ConfigIO::getGameAssociation(pData->gameId);
+        config::ConfigProfile* pProfile = config::Config::getProfile(pData->profileId);
+        pData->isProfileReady = (pProfile != nullptr);
+
+        // software rendering mode: open + preload persistent texture cache
+        if (pProfile != nullptr && renderingMode == config::rendering_mode_t::software
+         && pProfile->scaling.textureScaling.mode != config::upscaling_mode_t::native && pProfile->scaling.textureScaling.factor > 1u)
+        {
+            std::string directoryPath = display::scaling::UpscaledTextureStore::getGameDirectoryPath(pData->gameId);
+            pData->pTextureStore = display::scaling::TextureUpscaler::openPersistentCache(directoryPath, pProfile->scaling.textureScaling.mode,
+                                                                                        pProfile->scaling.textureScaling.factor);
+            if (pData->pTextureStore != nullptr)
+                pData->pTextureStore->warmUp(GAME_PREFETCH_TEXTURE_PAGES);
+        }
+    }
+    catch (...) // not available: default profile, no persistent cache
+    {
+        pData->isProfileReady = false;
+        pData->pTextureStore.reset();
+    }
+}
+
+/// @brief Wait for the end of game prefetch
+static inline void joinGamePrefetch()
+{
+    if (g_gamePrefetchThread.joinable())
+        g_gamePrefetchThread.join();
+}
+
 
 // -- driver base interface -- -------------------------------------------------
 
@@ -35,7 +100,7 @@ long CALLBACK GPUinit()
 
         // apply settings
         //...lang
-        //...memory + status
+        command::Dispatcher::init();
         //...timer
 
         // open debug window
@@ -63,6 +128,9 @@ long CALLBACK GPUinit()
 /// @returns Success indicator
 long CALLBACK GPUshutdown()
 {
+    joinGamePrefetch();
+    g_gamePrefetch.pTextureStore.reset();
+
     // close debug window
     if (config::Config::events.isDebugMode)
     {
@@ -71,7 +139,7 @@ long CALLBACK GPUshutdown()
 
     // close renderer
     //...engine
-    //...memory + status
+    command::Dispatcher::close();
     //...lang
 
     // close config
@@ -97,9 +165,62 @@ long CALLBACK GPUopen(unsigned long* pDisplayId, char* pCaption, char* pConfigFi
 {
     try
     {
+        // use game data prefetched since GPUsetExeName
+        joinGamePrefetch();
+        command::primitive::PrimitiveCulling::resetCounters();
+        if (g_gamePrefetch.isProfileReady)
+            config::Config::useProfile(g_gamePrefetch.profileId);
+        std::unique_ptr<display::scaling::UpscaledTextureStore> pTextureStore = std::move(g_gamePrefetch.pTextureStore);
 
         //...
 
+        // headless output: frames converted in memory (no window)
+        if (config::Config::display.isHeadless)
+        {
+            display::output::HeadlessOutput* pOutput = new display::output::HeadlessOutput();
+            config::ConfigProfile* pProfile = config::Config::getCurrentProfile();
+            if (pProfile != nullptr)
+            {
+                pOutput->setScreenScaling(pProfile->scaling.screenScaling.mode, pProfile->scaling.screenScaling.factor);
+                pOutput->setScreenEffects(pProfile->display, pProfile->scaling);
+            }
+            display::Engine::setOutputBackend(pOutput);
+        }
+
+        // software rendering mode: native VRAM + upscaled buffer
+        if (config::Config::display.renderingMode == config::rendering_mode_t::software)
+        {
+            config::ConfigProfile* pProfile = config::Config::getCurrentProfile();
+            uint32_t scaleX = (pProfile != nullptr) ? pProfile->display.internalRes.x : 1u;
+            uint32_t scaleY = (pProfile != nullptr) ? pProfile->display.internalRes.y : 1u;
+            display::software::DualFrameBuffer* pRenderer = display::Engine::initSoftwareRenderer(command::Dispatcher::getVram().rend(), scaleX, scaleY);
+            if (pProfile != nullptr)
+                pRenderer->setTextureUpscaling(pProfile->scaling.textureScaling.mode, pProfile->scaling.textureScaling.factor, std::move(pTextureStore));
+            command::primitive::PrimitiveFacade::setSoftwareRenderer(pRenderer);
+        }
+        else // hardware rendering mode: decoded primitives grouped in draw batches (cleared at the end of each frame)
+            command::primitive::PrimitiveFacade::setCommandBuffer(&command::Dispatcher::getCommandBuffer());
+        // debug mode: decoded frames recorded in display lists (last complete frame kept)
+        command::Dispatcher::setFrameRecording(config::Config::events.isDebugMode);
+
+        // snapshots: buffer pool + writer thread ready before first request (nothing allocated/started on vsync)
+        g_pSnapshotWriter.reset(new display::output::SnapshotWriter(display::output::SnapshotWriter::getDefaultDirectoryPath()));
+        // frame dump: ring + writer thread (file created on first frame)
+        if (config::Config::display.frameDump != config::frame_dump_format_t::disabled)
+        {
+            // slots sized for frames presented by headless output (internal resolution + screen upscaling) -> fewer slots for bigger frames
+            uint32_t frameScale = 1u;
+            config::ConfigProfile* pProfile = config::Config::getCurrentProfile();
+            if (pProfile != nullptr && config::Config::display.isHeadless)
+            {
+                const uint32_t factor = display::scaling::ScreenUpscaler::getOutputFactor(pProfile->scaling.screenScaling.mode, pProfile->scaling.screenScaling.factor);
+                frameScale = factor * factor;
+                if (config::Config::display.renderingMode == config::rendering_mode_t::software)
+                    frameScale *= pProfile->display.internalRes.x * pProfile->display.internalRes.y;
+            }
+            g_pFrameDump.reset(new display::output::FrameDumpWriter(display::output::FrameDumpWriter::getDefaultBasePath(), config::Config::display.frameDump,
+                                                                    FRAME_DUMP_RING_SIZE / frameScale, FRAME_DUMP_MAX_PIXELS * frameScale));
+        }
     }
     catch (const std::runtime_error& runExc)
     {
@@ -121,6 +242,47 @@ long CALLBACK GPUopen(unsigned long* pDisplayId, char* pCaption, char* pConfigFi
 /// @returns Success indicator
 long CALLBACK GPUclose()
 {
+    command::primitive::PrimitiveFacade::setSoftwareRenderer(nullptr);
+    command::primitive::PrimitiveFacade::setCommandBuffer(nullptr);
+    const command::DisplayList& lastFrame = command::Dispatcher::getLastFrameDisplayList();
+    if (lastFrame.empty() == false)
+    {
+        command::display_list_stats_t stats = lastFrame.getStats();
+        events::utils::Logger::getInstance()->writeEntry("GPUclose"s, "display list"s, "last frame: commands="s + std::to_string(stats.commands)
+                                                         + ", states="s + std::to_string(stats.states) + ", vertices="s + std::to_string(stats.vertices)
+                                                         + ", pixels="s + std::to_string(stats.pixels) + ", bytes="s + std::to_string(stats.bytes));
+    }
+    command::Dispatcher::setFrameRecording(false);
+    display::Engine::closeSoftwareRenderer();
+    display::Engine::closeOutputBackend();
+    g_pSnapshotWriter.reset(); // pending snapshots written before closing
+    if (g_pFrameDump)
+    {
+        g_pFrameDump->waitIdle(); // queued frames written before closing
+        display::output::frame_dump_stats_t stats = g_pFrameDump->getStats();
+        events::utils::Logger::getInstance()->writeEntry("GPUclose"s, "frame dump"s, g_pFrameDump->filePath() + ": written="s + std::to_string(stats.writtenFrames)
+                                                         + ", dropped="s + std::to_string(stats.droppedFrames) + ", failed="s + std::to_string(stats.failedFrames)
+                                                         + ", max queued="s + std::to_string(stats.maxQueuedFrames));
+        g_pFrameDump.reset();
+    }
+    // early rejection statistics (since GPUopen)
+    using command::primitive::PrimitiveCulling;
+    using command::primitive::reject_reason_t;
+    if (PrimitiveCulling::getCounter(reject_reason_t::none) + PrimitiveCulling::getRejectedCount() != 0u)
+    {
+        events::utils::Logger::getInstance()->writeEntry("GPUclose"s, "primitive culling"s, "accepted="s + std::to_string(PrimitiveCulling::getCounter(reject_reason_t::none))
+                                                         + ", degenerate="s + std::to_string(PrimitiveCulling::getCounter(reject_reason_t::degenerate))
+                                                         + ", outside="s + std::to_string(PrimitiveCulling::getCounter(reject_reason_t::outsideArea))
+                                                         + ", oversized="s + std::to_string(PrimitiveCulling::getCounter(reject_reason_t::oversized)));
+    }
+    // per-frame memory (since GPUinit)
+    const ::utils::memory::FrameArena& frameArena = command::Dispatcher::getFrameArena();
+    if (frameArena.highWaterMark() != 0u)
+    {
+        events::utils::Logger::getInstance()->writeEntry("GPUclose"s, "frame arena"s, "high-water mark="s + std::to_string(frameArena.highWaterMark())
+                                                         + " bytes, capacity="s + std::to_string(frameArena.capacity())
+                                                         + " bytes, overflowed frames="s + std::to_string(frameArena.overflowCount()));
+    }
 
     return PSE_SUCCESS;
 }
@@ -129,7 +291,23 @@ long CALLBACK GPUclose()
 /// @brief Activity update (called on every vsync)
 void CALLBACK GPUupdateLace()
 {
-
+    if (command::memory::StatusRegister::getStatus(GPUSTATUS_INTERLACED))
+        command::Dispatcher::getDisplayState().toggleOddFrame();
+    display::Engine::render(command::Dispatcher::getVram().rend(), command::Dispatcher::getDisplayState(), command::Dispatcher::getVramWrites());
+    if (g_pSnapshotWriter && g_pSnapshotWriter->isRequested()) // copy only: encoded/written by writer thread
+        g_pSnapshotWriter->captureDisplayArea(command::Dispatcher::getVram().rend(), command::Dispatcher::getDisplayState());
+    if (g_pFrameDump) // copy to ring only: never waits for disk
+    {
+        // frame presented by output backend (internal resolution + screen stages) -> native display area if no processed frame exists
+        uint32_t width = 0u, height = 0u;
+        display::output::IOutputBackend* pOutput = display::Engine::getOutputBackend();
+        const uint32_t* pFrame = (pOutput != nullptr) ? pOutput->getPresentedFrame(width, height) : nullptr;
+        if (pFrame != nullptr)
+            g_pFrameDump->captureFrame(pFrame, width, height, width, command::memory::StatusRegister::getStatus(GPUSTATUS_PAL));
+        else
+            g_pFrameDump->captureDisplayArea(command::Dispatcher::getVram().rend(), command::Dispatcher::getDisplayState());
+    }
+    command::Dispatcher::endFrame();
 }
 
 
@@ -149,7 +327,24 @@ unsigned long CALLBACK GPUreadStatus()
 /// @param gdata  Status register command
 void CALLBACK GPUwriteStatus(unsigned long gdata)
 {
-
+    switch ((gdata >> 24) & 0xFFuL)
+    {
+        case 0x08uL: // display mode
+            command::DisplayState::setDisplayMode(static_cast<uint32_t>(gdata));
+            if (command::memory::StatusRegister::getStatus(GPUSTATUS_INTERLACED) == false)
+                command::Dispatcher::getDisplayState().setOddFrame(false);
+            break;
+        case 0x05uL: // display area start
+            command::Dispatcher::getDisplayState().setDisplayAreaStart(static_cast<uint32_t>(gdata));
+            break;
+        case 0x06uL: // horizontal display range
+            command::Dispatcher::getDisplayState().setHorizontalRange(static_cast<uint32_t>(gdata));
+            break;
+        case 0x07uL: // vertical display range
+            command::Dispatcher::getDisplayState().setVerticalRange(static_cast<uint32_t>(gdata));
+            break;
+    }
+    //...
 }
 
 
@@ -337,7 +532,26 @@ void CALLBACK GPUsetfix(unsigned long fixBits)
 /// @param pGameId  Newly started game identifier
 void CALLBACK GPUsetExeName(char* pGameId)
 {
+    joinGamePrefetch();
+    config::Config::gameId = (pGameId != nullptr) ? std::string(pGameId) : std::string();
 
+    // start game data prefetch (joined by GPUopen)
+    g_gamePrefetch.gameId = config::Config::gameId;
+    g_gamePrefetch.profileId = 0u;
+    g_gamePrefetch.isProfileReady = false;
+    g_gamePrefetch.pTextureStore.reset();
+    if (g_gamePrefetch.gameId.empty() == false)
+    {
+        const config::rendering_mode_t renderingMode = config::Config::display.renderingMode; // settings copied before thread start
+        try
+        {
+            g_gamePrefetchThread = std::thread(prefetchGameData, &g_gamePrefetch, renderingMode);
+        }
+        catch (const std::exception&) // no thread available: prefetch now
+        {
+            prefetchGameData(&g_gamePrefetch, renderingMode);
+        }
+    }
 }
 
 
@@ -347,7 +561,8 @@ void CALLBACK GPUsetExeName(char* pGameId)
 /// @brief Request snapshot (on next display)
 void CALLBACK GPUmakeSnapshot()
 {
-
+    if (g_pSnapshotWriter)
+        g_pSnapshotWriter->request();
 }
 
 
@@ -355,7 +570,16 @@ void CALLBACK GPUmakeSnapshot()
 /// @param pMem  allocated screen picture container 128x96 px (24b/px: 8-8-8 bit BGR, no header)
 void CALLBACK GPUgetScreenPic(unsigned char* pMem)
 {
-
+    if (pMem == nullptr)
+        return;
+    const command::DisplayState& displayState = command::Dispatcher::getDisplayState();
+    if (command::DisplayState::isDisplayEnabled() == false || command::Dispatcher::getVram().rend() == nullptr)
+    {
+        memset(pMem, 0, DISPLAY_THUMBNAIL_WIDTH * DISPLAY_THUMBNAIL_HEIGHT * 3u); // black picture
+        return;
+    }
+    display::output::DisplayKernels::createThumbnail(command::Dispatcher::getVram().rend(), displayState.displayX(), displayState.displayY(),
+                                                     displayState.displayWidth(), displayState.displayHeight(), command::DisplayState::isRgb24(), pMem);
 }
 
 /// @brief Store and display screen picture
@@ -392,3 +616,11 @@ void CALLBACK GPUvisualVibration(unsigned long smallRumble, unsigned long bigRum
 {
 
 }
+
+/// @brief Set callback receiving every frame in headless output mode (RGB888, display area size)
+/// @param callback   Frame callback (or NULL to disable it)
+/// @param pUserData  User data sent to callback
+void CALLBACK GPUsetFrameCallback(void (CALLBACK* callback)(const unsigned char* pRgb, long width, long height, void* pUserData), void* pUserData)
+{
+    display::output::HeadlessOutput::setFrameCallback(callback, pUserData);
+}
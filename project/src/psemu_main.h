@@ -206,6 +206,10 @@ void CALLBACK GPUcursor(int player, int x, int y);
 /// @param smallRumble  Small rumble value
 /// @param bigRumble    Big rumble value (if != 0, 'small' will be ignored)
 void CALLBACK GPUvisualVibration(unsigned long smallRumble, unsigned long bigRumble);
+/// @brief Set callback receiving every frame in headless output mode (RGB888, display area size)
+/// @param callback   Frame callback (or NULL to disable it)
+/// @param pUserData  User data sent to callback
+void CALLBACK GPUsetFrameCallback(void (CALLBACK* callback)(const unsigned char* pRgb, long width, long height, void* pUserData), void* pUserData);
 
 
 // -- unit testing -- ----------------------------------------------------------
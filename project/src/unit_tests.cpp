@@ -7,13 +7,2248 @@ License :     GPLv2
 Description : unit testing utility
 *******************************************************************************/
 #include "globals.h"
+#include <cstdint>
+#include <cmath>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 using namespace std::literals::string_literals;
 #include "psemu_main.h"
 #include "pandoraGS.h"
+#include "events/utils/logger.h"
+#include "command/memory/status_register.h"
+#include "command/memory/video_memory.h"
+#include "command/memory/vertex_buffer.h"
+#include "command/memory/vram_write_tracker.h"
+#include "command/command_buffer.h"
+#include "command/display_list.h"
+#include "command/frame_buffer_settings.h"
+#include "command/primitive/primitive_culling.h"
+#include "command/primitive/primitive_facade.h"
+#include "command/primitive/vertex_decoder.h"
+#include "command/display_state.h"
+#include "display/software/blend_kernels.h"
+#include "display/software/dual_frame_buffer.h"
+#include "display/software/palette_registry.h"
+#include "display/software/texture_cache.h"
+#include "display/output/display_kernels.h"
+#include "display/output/remap_table.h"
+#include "display/output/post_processing.h"
+#include "display/output/snapshot_writer.h"
+#include "display/output/frame_dump_writer.h"
+#include "display/output/headless_output.h"
+#include "display/scaling/pixel_scalers.h"
+#include "display/scaling/screen_upscaler.h"
+#include "display/scaling/screen_resampler.h"
+#include "display/scaling/upscaled_texture_store.h"
+#include "utils/logic/fixed_point.h"
+#include "utils/memory/frame_arena.h"
 #include "unit_tests.h"
 using namespace std;
 
+#define BENCHMARK_PIXEL_COUNT  (1024 * 512) // full VRAM
+#define BENCHMARK_ITERATIONS   32
+#define BENCHMARK_QUAD_COUNT   7500 // full polygon buffer
+#define BENCHMARK_SCREEN_FRAMES 8   // upscaled/resampled frames (640x480)
+
+
+// -- test utilities -- --------------------------------------------------------
+
+/// @brief Simple pseudo-random generator (reproducible test data)
+/// @param[in,out] seed  Generator state
+/// @returns Pseudo-random value
+static inline uint32_t nextTestValue(uint32_t& seed) noexcept
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8);
+}
+
+/// @brief Measure execution time of an operation
+/// @param[in] operation  Operation to measure
+/// @returns Duration (milliseconds)
+template <typename Operation>
+static double measureDuration(Operation operation)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    operation();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+/// @brief Write test result in log
+/// @param[in] testName  Test name
+/// @param[in] message   Result message
+static inline void logTestResult(const std::string testName, const std::string message) noexcept
+{
+    events::utils::Logger::getInstance()->writeEntry("GPUtestUnits"s, testName, message);
+}
+
+
+// -- software renderer -- -----------------------------------------------------
+
+/// @brief Semi-transparency kernels - compare with scalar reference + benchmark
+/// @returns Success
+static bool testBlendKernels()
+{
+    using display::software::BlendKernels;
+    using command::primitive::stp_t;
+    bool isSuccess = true;
+
+    std::vector<uint16_t> source(BENCHMARK_PIXEL_COUNT);
+    std::vector<uint16_t> back(BENCHMARK_PIXEL_COUNT);
+    std::vector<uint16_t> dest(BENCHMARK_PIXEL_COUNT);
+    std::vector<uint16_t> reference(BENCHMARK_PIXEL_COUNT);
+    uint32_t seed = 0x5EEDu;
+    for (size_t i = 0; i < BENCHMARK_PIXEL_COUNT; ++i)
+    {
+        source[i] = static_cast<uint16_t>(nextTestValue(seed));
+        back[i] = static_cast<uint16_t>(nextTestValue(seed));
+        if ((i % 13u) == 0u)
+            source[i] = 0u; // transparent texels
+    }
+
+    const char* modeNames[] = { "mean", "add", "sub", "addPart" };
+    for (int mode = 0; mode < 4; ++mode)
+    {
+        for (int isTextured = 0; isTextured <= 1; ++isTextured)
+        {
+            // exactness (odd row length -> test remaining pixels too)
+            const stp_t stp = static_cast<stp_t>(mode);
+            display::software::blend_kernel_t kernel = BlendKernels::getKernel(stp, isTextured != 0);
+            for (int isMaskChecked = 0; isMaskChecked <= 1; ++isMaskChecked)
+            {
+                dest = back;
+                reference = back;
+                for (size_t row = 0; row + 1021u <= BENCHMARK_PIXEL_COUNT; row += 1021u)
+                {
+                    kernel(&dest[row], &source[row], 1021u, 0x8000u, isMaskChecked != 0);
+                    BlendKernels::blendReference(&reference[row], &source[row], 1021u, stp, isTextured != 0, 0x8000u, isMaskChecked != 0);
+                }
+                if (dest != reference)
+                {
+                    logTestResult("blend kernels"s, "mismatch with scalar reference: mode="s + modeNames[mode] + ((isTextured) ? " (textured)"s : ""s));
+                    isSuccess = false;
+                }
+            }
+
+            // benchmark
+            double kernelTime = measureDuration([&]()
+            {
+                for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+                    kernel(&dest[0], &source[0], BENCHMARK_PIXEL_COUNT, 0u, false);
+            });
+            double referenceTime = measureDuration([&]()
+            {
+                for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+                    BlendKernels::blendReference(&reference[0], &source[0], BENCHMARK_PIXEL_COUNT, stp, isTextured != 0, 0u, false);
+            });
+            logTestResult("blend kernels"s, "mode="s + modeNames[mode] + ((isTextured) ? " (textured)"s : ""s)
+                          + ": packed="s + std::to_string(kernelTime) + "ms, reference="s + std::to_string(referenceTime) + "ms"s);
+        }
+    }
+    return isSuccess;
+}
+
+/// @brief Fixed-point division by reciprocal - compare with 64-bit division (scalar + SIMD, boundary numerators, negative divisors)
+///        and gradient setup with hardware interpolation formulas + setup benchmark
+/// @returns Success
+static bool testFixedPoint()
+{
+    using ::utils::algorithm::GradientSetup12;
+    using ::utils::algorithm::GradientSetup16;
+    using ::utils::algorithm::gradient_t;
+    using divider_t = GradientSetup16::divider_t;
+    bool isSuccess = true;
+    uint32_t seed = 0xF1ADu;
+
+    // exact division: table divisors, computed divisors, negative divisors
+    const int32_t maxNumerator = static_cast<int32_t>(divider_t::maxNumerator);
+    int32_t numerators[16] = { 0, 1, -1, maxNumerator, -maxNumerator, maxNumerator + 1, -maxNumerator - 1, INT32_MAX, INT32_MIN, INT32_MIN + 1 };
+    for (uint32_t i = 0; i < 20000u && isSuccess; ++i)
+    {
+        int64_t divisor;
+        switch (i % 4u)
+        {
+            case 0u: divisor = static_cast<int64_t>(nextTestValue(seed) % 4095u) + 1; break;
+            case 1u: divisor = -(static_cast<int64_t>(nextTestValue(seed) % 4095u) + 1); break;
+            case 2u: divisor = static_cast<int64_t>(nextTestValue(seed) % (1u << 24)) + 4096; break;
+            default: divisor = (i < 4000u) ? static_cast<int64_t>(i) : -static_cast<int64_t>(nextTestValue(seed) & 0xFFFFFFu) - 1; break;
+        }
+        if (divisor == 0)
+            divisor = 1;
+        const divider_t divider(divisor);
+        for (uint32_t n = 10u; n < 16u; ++n)
+            numerators[n] = (n & 1u) ? static_cast<int32_t>(nextTestValue(seed) % (2u * static_cast<uint32_t>(maxNumerator) + 1u)) - maxNumerator
+                                     : static_cast<int32_t>(nextTestValue(seed));
+        const int32_t absDivisor = static_cast<int32_t>((divisor < 0) ? -divisor : divisor);
+        if (absDivisor <= maxNumerator) // largest multiple of divisor minus 1 (largest remainder)
+            numerators[15] = -((maxNumerator / absDivisor) * absDivisor - 1);
+
+        for (uint32_t n = 0; n < 16u; n += 4u)
+        {
+            int32_t results[4];
+            divider.divide4(&numerators[n], results);
+            for (uint32_t k = 0; k < 4u; ++k)
+            {
+                const int32_t reference = static_cast<int32_t>((static_cast<int64_t>(numerators[n + k]) * 65536LL) / divisor);
+                if (divider.divide(numerators[n + k]) != reference || results[k] != reference)
+                {
+                    logTestResult("fixed point"s, "division mismatch: "s + std::to_string(numerators[n + k]) + " / "s + std::to_string(divisor));
+                    isSuccess = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // gradient setup: PS1 coordinate range (1023 x 511), 8-bit attributes
+    struct test_triangle_t { int32_t x1, y1, x2, y2; int32_t a[3][2]; };
+    std::vector<test_triangle_t> triangles;
+    triangles.reserve(BENCHMARK_QUAD_COUNT * 2u);
+    while (triangles.size() < BENCHMARK_QUAD_COUNT * 2u)
+    {
+        test_triangle_t triangle;
+        const uint32_t size = (triangles.size() % 3u == 0u) ? 1024u : 32u; // large and small triangles
+        triangle.x1 = static_cast<int32_t>(nextTestValue(seed) % size) - static_cast<int32_t>(size / 2u);
+        triangle.y1 = static_cast<int32_t>(nextTestValue(seed) % (size / 2u)) - static_cast<int32_t>(size / 4u);
+        triangle.x2 = static_cast<int32_t>(nextTestValue(seed) % size) - static_cast<int32_t>(size / 2u);
+        triangle.y2 = static_cast<int32_t>(nextTestValue(seed) % (size / 2u)) - static_cast<int32_t>(size / 4u);
+        for (uint32_t v = 0; v < 3u; ++v)
+            for (uint32_t c = 0; c < 2u; ++c)
+                triangle.a[v][c] = static_cast<int32_t>(nextTestValue(seed) & 0xFFu);
+        if (static_cast<int64_t>(triangle.x1) * triangle.y2 - static_cast<int64_t>(triangle.x2) * triangle.y1 != 0)
+            triangles.push_back(triangle);
+    }
+    auto referenceGradient = [](const test_triangle_t& t, const uint32_t c, const uint32_t fractionBits) -> gradient_t
+    {
+        const int64_t determinant = static_cast<int64_t>(t.x1) * t.y2 - static_cast<int64_t>(t.x2) * t.y1;
+        const int64_t da1 = t.a[1][c] - t.a[0][c], da2 = t.a[2][c] - t.a[0][c];
+        gradient_t gradient;
+        gradient.dx = static_cast<int32_t>(((da1 * t.y2 - da2 * t.y1) * (1LL << fractionBits)) / determinant);
+        gradient.dy = static_cast<int32_t>(((da2 * t.x1 - da1 * t.x2) * (1LL << fractionBits)) / determinant);
+        return gradient;
+    };
+    for (auto it = triangles.begin(); it != triangles.end() && isSuccess; ++it)
+    {
+        const int64_t determinant = static_cast<int64_t>(it->x1) * it->y2 - static_cast<int64_t>(it->x2) * it->y1;
+        const GradientSetup16 setup16(it->x1, it->y1, it->x2, it->y2, determinant);
+        const GradientSetup12 setup12(it->x1, it->y1, it->x2, it->y2, determinant);
+        const int32_t a0[2] = { it->a[0][0], it->a[0][1] }, a1[2] = { it->a[1][0], it->a[1][1] }, a2[2] = { it->a[2][0], it->a[2][1] };
+        gradient_t pair16[2];
+        setup16.compute2(a0, a1, a2, pair16);
+        for (uint32_t c = 0; c < 2u; ++c)
+        {
+            const gradient_t reference16 = referenceGradient(*it, c, 16u), reference12 = referenceGradient(*it, c, 12u);
+            const gradient_t single16 = setup16.compute(a0[c], a1[c], a2[c]), single12 = setup12.compute(a0[c], a1[c], a2[c]);
+            if (single16.dx != reference16.dx || single16.dy != reference16.dy || pair16[c].dx != reference16.dx || pair16[c].dy != reference16.dy
+            ||  single12.dx != reference12.dx || single12.dy != reference12.dy)
+            {
+                logTestResult("fixed point"s, "gradient mismatch: triangle "s + std::to_string(it - triangles.begin()));
+                isSuccess = false;
+                break;
+            }
+        }
+    }
+
+    // benchmark: gradients of 5 attributes (RGB + UV) per triangle - small (table reciprocals) and large triangles
+    std::vector<test_triangle_t> groups[2];
+    for (auto it = triangles.begin(); it != triangles.end(); ++it)
+    {
+        const int64_t determinant = static_cast<int64_t>(it->x1) * it->y2 - static_cast<int64_t>(it->x2) * it->y1;
+        groups[(determinant > -4096 && determinant < 4096) ? 0 : 1].push_back(*it);
+    }
+    volatile int32_t sink = 0;
+    for (uint32_t group = 0; group < 2u; ++group)
+    {
+        double setupTime = measureDuration([&]()
+        {
+            int32_t sum = 0;
+            for (int iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+                for (auto it = groups[group].begin(); it != groups[group].end(); ++it)
+                {
+                    const GradientSetup16 setup(it->x1, it->y1, it->x2, it->y2, static_cast<int64_t>(it->x1) * it->y2 - static_cast<int64_t>(it->x2) * it->y1);
+                    const int32_t a0[2] = { it->a[0][0], it->a[0][1] }, a1[2] = { it->a[1][0], it->a[1][1] }, a2[2] = { it->a[2][0], it->a[2][1] };
+                    gradient_t pair[2];
+                    setup.compute2(a0, a1, a2, pair); // R, G
+                    sum += pair[0].dx + pair[0].dy + pair[1].dx + pair[1].dy;
+                    setup.compute2(a2, a0, a1, pair); // U, V
+                    sum += pair[0].dx + pair[0].dy + pair[1].dx + pair[1].dy;
+                    const gradient_t last = setup.compute(a1[0], a2[1], a0[0]); // B
+                    sum += last.dx + last.dy;
+                }
+            sink = sum;
+        });
+        double divisionTime = measureDuration([&]()
+        {
+            int32_t sum = 0;
+            for (int iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+                for (auto it = groups[group].begin(); it != groups[group].end(); ++it)
+                {
+                    const int64_t determinant = static_cast<int64_t>(it->x1) * it->y2 - static_cast<int64_t>(it->x2) * it->y1;
+                    const int32_t attributes[5][3] = { { it->a[0][0], it->a[1][0], it->a[2][0] }, { it->a[0][1], it->a[1][1], it->a[2][1] },
+                                                       { it->a[2][0], it->a[0][0], it->a[1][0] }, { it->a[2][1], it->a[0][1], it->a[1][1] },
+                                                       { it->a[1][0], it->a[2][1], it->a[0][0] } };
+                    for (uint32_t i = 0; i < 5u; ++i)
+                    {
+                        const int64_t da1 = attributes[i][1] - attributes[i][0], da2 = attributes[i][2] - attributes[i][0];
+                        sum += static_cast<int32_t>(((da1 * it->y2 - da2 * it->y1) * 65536LL) / determinant)
+                             + static_cast<int32_t>(((da2 * it->x1 - da1 * it->x2) * 65536LL) / determinant);
+                    }
+                }
+            sink = sum;
+        });
+        logTestResult("fixed point"s, "gradient setup (5 attributes, "s + std::to_string(groups[group].size()) + ((group == 0u) ? " small"s : " large"s)
+                                    + " triangles): reciprocal="s + std::to_string(setupTime) + "ms, division="s + std::to_string(divisionTime) + "ms"s);
+    }
+    return isSuccess;
+}
+
+
+/// @brief Texture cache - check decoded texels, LRU eviction under memory budget, counters, invalidation of overlapping pages only
+/// @returns Success
+static bool testTextureCache()
+{
+    using namespace display::software;
+    using command::primitive::colordepth_t;
+    bool isSuccess = true;
+
+    std::vector<uint16_t> vram(1024u * 512u);
+    uint32_t seed = 0x7C4Eu;
+    for (size_t i = 0; i < vram.size(); ++i)
+        vram[i] = static_cast<uint16_t>(nextTestValue(seed));
+    uint16_t palette[256];
+    for (uint32_t i = 0; i < 256u; ++i)
+        palette[i] = static_cast<uint16_t>((i * 0x81u) & 0x7FFFu);
+
+    // budget of 3 pages (+ remainder smaller than a page)
+    TextureCache cache(3u * TEXTURE_CACHE_PAGE_BYTES + TEXTURE_CACHE_PAGE_BYTES / 2u);
+    if (cache.capacity() != 3u)
+    {
+        logTestResult("texture cache"s, "invalid capacity: "s + std::to_string(cache.capacity()) + " (expected 3)"s);
+        return false;
+    }
+    const texture_page_key_t keys[] = {
+        texture_page_key_t{ 0u,   0u,   0u, colordepth_t::clut_4bit }, // texels: X 0-63,     Y 0-255
+        texture_page_key_t{ 64u,  0u,   0u, colordepth_t::clut_8bit }, // texels: X 64-191,   Y 0-255
+        texture_page_key_t{ 960u, 256u, 1u, colordepth_t::clut_4bit }, // texels: X 960-1023, Y 256-511
+        texture_page_key_t{ 192u, 256u, 0u, colordepth_t::clut_8bit }  // texels: X 192-319,  Y 256-511
+    };
+
+    // decoded texels (compared with direct palette lookup)
+    for (int k = 0; k < 3; ++k)
+    {
+        const uint16_t* pPage = cache.insert(keys[k], &vram[0], palette);
+        bool isDecoded = true;
+        for (uint32_t v = 0; v < 256u && isDecoded; v += 7u)
+        {
+            for (uint32_t u = 0; u < 256u; ++u)
+            {
+                const uint16_t* pRow = &vram[static_cast<size_t>(keys[k].texpageY + v) << 10];
+                const uint32_t index = (keys[k].colorDepth == colordepth_t::clut_4bit)
+                                     ? (pRow[keys[k].texpageX + (u >> 2)] >> ((u & 0x3u) * 4u)) & 0xFu
+                                     : (pRow[keys[k].texpageX + (u >> 1)] >> ((u & 0x1u) * 8u)) & 0xFFu;
+                if (pPage[(v << 8) + u] != palette[index])
+                {
+                    isDecoded = false;
+                    break;
+                }
+            }
+        }
+        if (isDecoded == false)
+        {
+            logTestResult("texture cache"s, "decoded page mismatch with palette lookup: page "s + std::to_string(k));
+            isSuccess = false;
+        }
+    }
+
+    // LRU eviction: page 0 used again -> page 1 is the least recently used page when page 3 is inserted
+    if (cache.isFull() == false || cache.find(keys[0]) == nullptr || cache.find(keys[3]) != nullptr)
+    {
+        logTestResult("texture cache"s, "invalid content before eviction"s);
+        isSuccess = false;
+    }
+    cache.insert(keys[3], &vram[0], palette);
+    if (cache.size() != 3u || cache.find(keys[1]) != nullptr || cache.find(keys[0]) == nullptr
+    ||  cache.find(keys[2]) == nullptr || cache.find(keys[3]) == nullptr)
+    {
+        logTestResult("texture cache"s, "least recently used page not evicted"s);
+        isSuccess = false;
+    }
+
+    // invalidation: only pages with texels in the written area
+    cache.invalidateArea(64, 0, 191, 255);    // next to page 0, above page 3 -> nothing
+    cache.invalidateArea(320, 256, 959, 511); // between page 3 and page 2 -> nothing
+    if (cache.size() != 3u)
+    {
+        logTestResult("texture cache"s, "page invalidated by adjacent write"s);
+        isSuccess = false;
+    }
+    cache.invalidateArea(1020, 300, 1030, 301); // wrapped write: X 1020-1023 + 0-6 -> page 2 only (page 0 rows not written)
+    if (cache.size() != 2u || cache.find(keys[2]) != nullptr || cache.find(keys[0]) == nullptr || cache.find(keys[3]) == nullptr)
+    {
+        logTestResult("texture cache"s, "wrapped write: invalid pages invalidated"s);
+        isSuccess = false;
+    }
+    cache.invalidateArea(319, 511, 319, 511); // last texel of page 3
+    if (cache.size() != 1u || cache.find(keys[3]) != nullptr || cache.find(keys[0]) == nullptr)
+    {
+        logTestResult("texture cache"s, "single texel write: invalid pages invalidated"s);
+        isSuccess = false;
+    }
+
+    // counters
+    const texture_cache_stats_t& stats = cache.getStats();
+    if (stats.hits != 7uLL || stats.misses != 4uLL || stats.evictions != 1uLL || stats.invalidations != 2uLL || stats.clears != 0uLL)
+    {
+        logTestResult("texture cache"s, "invalid counters: hits="s + std::to_string(stats.hits) + " misses="s + std::to_string(stats.misses)
+                      + " evictions="s + std::to_string(stats.evictions) + " invalidations="s + std::to_string(stats.invalidations));
+        isSuccess = false;
+    }
+    cache.clear();
+    if (cache.size() != 0u || cache.find(keys[0]) != nullptr || cache.getStats().clears != 1uLL)
+    {
+        logTestResult("texture cache"s, "pages remaining after clear"s);
+        isSuccess = false;
+    }
+    return isSuccess;
+}
+
+
+/// @brief Palette registry - identical palettes share the same ID (other position, re-upload), CLUT writes keep decoded texture pages
+/// @returns Success
+static bool testPaletteRegistry()
+{
+    using namespace display::software;
+    using command::primitive::colordepth_t;
+    bool isSuccess = true;
+
+    std::vector<uint16_t> vram(1024u * 512u, 0u);
+    uint16_t palette4[16];
+    uint16_t palette8[256];
+    for (uint32_t i = 0; i < 16u; ++i)
+        palette4[i] = static_cast<uint16_t>(0x0421u * (i + 1u));
+    for (uint32_t i = 0; i < 256u; ++i)
+        palette8[i] = static_cast<uint16_t>(0x1000u + i);
+    memcpy(&vram[480u * 1024u], palette4, sizeof(palette4));               // 4-bit CLUT (0,480)
+    memcpy(&vram[481u * 1024u + 32u], palette4, sizeof(palette4));         // same content at (32,481)
+    memcpy(&vram[482u * 1024u], palette8, sizeof(palette8));               // 8-bit CLUT (0,482)
+
+    // identical content at another position -> same ID
+    PaletteRegistry registry;
+    const palette_id_t id4 = registry.getPaletteId(&vram[0], 0u, 480u, colordepth_t::clut_4bit);
+    const palette_id_t idCopy = registry.getPaletteId(&vram[0], 32u, 481u, colordepth_t::clut_4bit);
+    const palette_id_t id8 = registry.getPaletteId(&vram[0], 0u, 482u, colordepth_t::clut_8bit);
+    if (id4 != idCopy || id8 == id4 || registry.size() != 2u || registry.getPaletteLength(id4) != 16u || registry.getPaletteLength(id8) != 256u
+    ||  memcmp(registry.getPalette(id4), palette4, sizeof(palette4)) != 0 || memcmp(registry.getPalette(id8), palette8, sizeof(palette8)) != 0)
+    {
+        logTestResult("palette registry"s, "invalid palette IDs/content for identical and different palettes"s);
+        isSuccess = false;
+    }
+    // known position -> no CLUT read
+    if (registry.getPaletteId(&vram[0], 0u, 480u, colordepth_t::clut_4bit) != id4 || registry.getStats().reads != 3uLL)
+    {
+        logTestResult("palette registry"s, "known CLUT position read again"s);
+        isSuccess = false;
+    }
+
+    // adjacent write -> position still known / identical re-upload -> read again, same ID
+    registry.invalidateArea(16, 480, 31, 480);
+    registry.invalidateArea(0, 479, 1023, 479);
+    if (registry.getStats().invalidations != 0uLL)
+    {
+        logTestResult("palette registry"s, "CLUT position forgotten after adjacent write"s);
+        isSuccess = false;
+    }
+    registry.invalidateArea(8, 480, 8, 480);
+    if (registry.getStats().invalidations != 1uLL || registry.getPaletteId(&vram[0], 0u, 480u, colordepth_t::clut_4bit) != id4 || registry.size() != 2u)
+    {
+        logTestResult("palette registry"s, "identical CLUT re-upload: palette ID changed"s);
+        isSuccess = false;
+    }
+    // 8-bit CLUT partially written (last entry, wrapped write) -> new content = new ID, previous ID still valid
+    vram[482u * 1024u + 255u] = 0x7FFFu;
+    registry.invalidateArea(255, 482, 1024 + 10, 482);
+    const palette_id_t id8Modified = registry.getPaletteId(&vram[0], 0u, 482u, colordepth_t::clut_8bit);
+    if (id8Modified == id8 || id8Modified == id4 || registry.size() != 3u || memcmp(registry.getPalette(id8), palette8, sizeof(palette8)) != 0)
+    {
+        logTestResult("palette registry"s, "modified CLUT: invalid palette ID"s);
+        isSuccess = false;
+    }
+    const palette_registry_stats_t& stats = registry.getStats();
+    if (stats.lookups != 6uLL || stats.reads != 5uLL || stats.duplicates != 2uLL || stats.invalidations != 2uLL)
+    {
+        logTestResult("palette registry"s, "invalid counters: lookups="s + std::to_string(stats.lookups) + " reads="s + std::to_string(stats.reads)
+                      + " duplicates="s + std::to_string(stats.duplicates) + " invalidations="s + std::to_string(stats.invalidations));
+        isSuccess = false;
+    }
+
+    // renderer: CLUT uploads keep the decoded page unless the palette content changes
+    std::vector<uint16_t> rendererVram(1024u * 512u, 0u);
+    for (uint32_t row = 0; row < 256u; ++row)
+    {
+        for (uint32_t col = 64u; col < 128u; ++col)
+            rendererVram[row * 1024u + col] = 0x3210u; // 4-bit texels: 0,1,2,3,...
+    }
+    memcpy(&rendererVram[480u * 1024u], palette4, sizeof(palette4));
+    DualFrameBuffer renderer(&rendererVram[0], 1u, 1u, 1u);
+
+    raster_state_t state{};
+    state.clipRight = 1023;
+    state.clipBottom = 511;
+    state.isTextured = true;
+    state.texture.pVram = &rendererVram[0];
+    state.texture.texpageX = 64u;
+    state.texture.clutY = 480u;
+    state.texture.colorDepth = colordepth_t::clut_4bit;
+    state.texture.windowMaskU = state.texture.windowMaskV = 0xFFu;
+    const raster_vertex_t topLeft{ 300, 300, 0x808080u, 0u, 0u };
+    auto uploadClut = [&](const uint16_t* pEntries)
+    {
+        renderer.beforeVramWrite(0, 480, 16, 1);
+        memcpy(&rendererVram[480u * 1024u], pEntries, 16u * sizeof(uint16_t));
+        renderer.onVramWrite(0, 480, 16, 1);
+    };
+
+    renderer.drawRectangle(topLeft, 4, 4, state);
+    uploadClut(palette4); // identical content
+    rendererVram[300u * 1024u + 303u] = 0u; // must be drawn again
+    renderer.drawRectangle(topLeft, 4, 4, state);
+    if (renderer.getTextureCache().getStats().misses != 1uLL || renderer.getTextureCache().getStats().hits != 1uLL
+    ||  renderer.getPaletteRegistry().size() != 1u || rendererVram[300u * 1024u + 303u] != palette4[3])
+    {
+        logTestResult("palette registry"s, "identical CLUT re-upload: decoded page not reused"s);
+        isSuccess = false;
+    }
+    uint16_t modifiedPalette[16];
+    memcpy(modifiedPalette, palette4, sizeof(palette4));
+    modifiedPalette[3] = 0x7C1Fu;
+    uploadClut(modifiedPalette); // different content
+    renderer.drawRectangle(topLeft, 4, 4, state);
+    if (renderer.getTextureCache().getStats().misses != 2uLL || renderer.getPaletteRegistry().size() != 2u
+    ||  rendererVram[300u * 1024u + 303u] != 0x7C1Fu || rendererVram[300u * 1024u + 302u] != palette4[2])
+    {
+        logTestResult("palette registry"s, "modified CLUT: stale decoded page used"s);
+        isSuccess = false;
+    }
+    return isSuccess;
+}
+
+/// @brief Persistent upscaled texture cache - file extended when slots are needed, exact page copies, LRU eviction, reopened file
+/// @returns Success
+static bool testUpscaledTextureStore()
+{
+    using display::scaling::UpscaledTextureStore;
+    bool isSuccess = true;
+    const std::string directoryPath = UpscaledTextureStore::getGameDirectoryPath(_UNITTEST_APP_NAME);
+    const std::string filePath = directoryPath + "textures_"s + std::to_string(static_cast<uint32_t>(config::upscaling_mode_t::xbr)) + "_x1.cache"s;
+    std::remove(filePath.c_str());
+    auto getFileSize = [&filePath]() -> size_t
+    {
+        std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+        return (file.is_open()) ? static_cast<size_t>(file.tellg()) : 0u;
+    };
+
+    // page size not aligned on file sections (padded slots), room for 20 slots
+    const size_t pageBytes = 256u * 256u * sizeof(uint16_t) + 100u;
+    const size_t slotBytes = 135168u, dataOffset = 8192u;
+    std::vector<uint8_t> page(pageBytes), loaded(pageBytes + 16u);
+    auto fillPage = [&page](const uint32_t id) { for (size_t i = 0; i < page.size(); ++i) page[i] = static_cast<uint8_t>(i * 7u + id); };
+
+    std::unique_ptr<UpscaledTextureStore> pStore(new UpscaledTextureStore());
+    if (pStore->open(directoryPath, config::upscaling_mode_t::xbr, 1u, pageBytes, 4096u + 20u * (slotBytes + 24u)) == false || pStore->capacity() != 20u)
+    {
+        logTestResult("upscaled texture store"s, "open failure"s);
+        return false;
+    }
+    if (pStore->allocatedSlots() != 0u || getFileSize() != dataOffset)
+    {
+        logTestResult("upscaled texture store"s, "new file not empty: "s + std::to_string(getFileSize()) + " bytes"s);
+        isSuccess = false;
+    }
+    for (uint32_t id = 0; id < 3u; ++id)
+    {
+        fillPage(id);
+        pStore->store(static_cast<uint64_t>(id) + 1uLL, &page[0]);
+    }
+    if (pStore->size() != 3u || pStore->allocatedSlots() != UPSCALED_TEXTURE_STORE_GROWTH || getFileSize() != dataOffset + UPSCALED_TEXTURE_STORE_GROWTH * slotBytes)
+    {
+        logTestResult("upscaled texture store"s, "file not extended: "s + std::to_string(getFileSize()) + " bytes"s);
+        isSuccess = false;
+    }
+
+    // exact page copy (no padding written after destination)
+    fillPage(1u);
+    memset(&loaded[0], 0xCD, loaded.size());
+    if (pStore->load(2uLL, &loaded[0]) == false || memcmp(&loaded[0], &page[0], pageBytes) != 0 || loaded[pageBytes] != 0xCDu || loaded[pageBytes + 15u] != 0xCDu)
+    {
+        logTestResult("upscaled texture store"s, "invalid loaded page"s);
+        isSuccess = false;
+    }
+
+    // size limit reached -> least recently used pages replaced (page 2 used by load: kept)
+    for (uint32_t id = 3u; id < 21u; ++id)
+    {
+        fillPage(id);
+        pStore->store(static_cast<uint64_t>(id) + 1uLL, &page[0]);
+    }
+    if (pStore->size() != 20u || pStore->allocatedSlots() != 20u || pStore->getStats().evictions != 1uLL || pStore->load(1uLL, &loaded[0]) || !pStore->load(2uLL, &loaded[0]))
+    {
+        logTestResult("upscaled texture store"s, "invalid eviction: "s + std::to_string(pStore->getStats().evictions));
+        isSuccess = false;
+    }
+
+    // reopened file: allocated slots + index kept
+    pStore.reset(new UpscaledTextureStore());
+    fillPage(20u);
+    if (pStore->open(directoryPath, config::upscaling_mode_t::xbr, 1u, pageBytes, 4096u + 20u * (slotBytes + 24u)) == false || pStore->size() != 20u
+    ||  pStore->allocatedSlots() != 20u || pStore->load(21uLL, &loaded[0]) == false || memcmp(&loaded[0], &page[0], pageBytes) != 0)
+    {
+        logTestResult("upscaled texture store"s, "reopened file: pages not found"s);
+        isSuccess = false;
+    }
+    pStore.reset();
+    std::remove(filePath.c_str());
+    return isSuccess;
+}
+
+
+// -- command buffers -- -------------------------------------------------------
+
+/// @brief Interleaved vertex buffer - check quad indices + benchmark (compared with split vertex arrays, with quads expanded as triangles)
+/// @returns Success
+static bool testVertexBuffer()
+{
+    static command::memory::VertexBuffer<BENCHMARK_QUAD_COUNT * 4> buffer; // large object -> not on stack
+    bool isSuccess = true;
+
+    std::vector<command::vertex_t> quads(BENCHMARK_QUAD_COUNT * 4);
+    uint32_t seed = 0x5EEDu;
+    for (auto it = quads.begin(); it != quads.end(); ++it)
+    {
+        it->coords = command::vertex_pos_t{ static_cast<float>(nextTestValue(seed) & 0x3FFu), static_cast<float>(nextTestValue(seed) & 0x1FFu), 0.0f };
+        it->color = nextTestValue(seed);
+        it->texture = nextTestValue(seed);
+    }
+
+    // exactness: each quad -> POLY0_* + POLY1_* triangles
+    buffer.clear();
+    if (buffer.pushQuads(&quads[0], BENCHMARK_QUAD_COUNT) == false || buffer.pushQuad(&quads[0]) || buffer.size() != quads.size()
+    ||  buffer.indexCount() != BENCHMARK_QUAD_COUNT * 6u)
+    {
+        logTestResult("vertex buffer"s, "invalid capacity check"s);
+        isSuccess = false;
+    }
+    const uint32_t expectedOrder[6] = { 0u, 1u, 2u, 2u, 1u, 3u };
+    for (uint32_t i = 0; isSuccess && i < buffer.indexCount(); ++i)
+    {
+        const command::vertex_t& vertex = buffer.vertices()[buffer.indices()[i]];
+        const command::vertex_t& expected = quads[(i / 6u) * 4u + expectedOrder[i % 6u]];
+        if (vertex.color != expected.color || vertex.texture != expected.texture || vertex.coords.x != expected.coords.x || vertex.coords.y != expected.coords.y)
+        {
+            logTestResult("vertex buffer"s, "invalid quad index list"s);
+            isSuccess = false;
+        }
+    }
+
+    // benchmark
+    double interleavedTime = measureDuration([&]()
+    {
+        for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+        {
+            buffer.clear();
+            for (uint32_t quad = 0; quad < BENCHMARK_QUAD_COUNT; ++quad)
+                buffer.pushQuad(&quads[quad * 4u]);
+        }
+    });
+    std::vector<float> coords;
+    std::vector<uint32_t> colors;
+    std::vector<uint32_t> textures;
+    coords.reserve(BENCHMARK_QUAD_COUNT * 6 * 3);
+    colors.reserve(BENCHMARK_QUAD_COUNT * 6);
+    textures.reserve(BENCHMARK_QUAD_COUNT * 6);
+    double splitTime = measureDuration([&]()
+    {
+        for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+        {
+            coords.clear();
+            colors.clear();
+            textures.clear();
+            for (uint32_t quad = 0; quad < BENCHMARK_QUAD_COUNT; ++quad)
+            {
+                for (uint32_t i = 0; i < 6u; ++i)
+                {
+                    const command::vertex_t& vertex = quads[quad * 4u + expectedOrder[i]];
+                    coords.push_back(vertex.coords.x);
+                    coords.push_back(vertex.coords.y);
+                    coords.push_back(vertex.coords.z);
+                    colors.push_back(vertex.color);
+                    textures.push_back(vertex.texture);
+                }
+            }
+        }
+    });
+    logTestResult("vertex buffer"s, "push quads: interleaved="s + std::to_string(interleavedTime) + "ms, split arrays="s + std::to_string(splitTime) + "ms"s);
+    return isSuccess;
+}
+
+/// @brief Command buffer - batch merging (overlap with other states, barriers), merge ratio, primitives batched by decoding output
+/// @returns Success
+static bool testCommandBuffer()
+{
+    using namespace command;
+    bool isSuccess = true;
+
+    // opaque / semi-transparent states - triangle at position (one 11x11 area per position)
+    render_state_t stateA{ 0u, 0u, 0u, 0u, RENDER_STATE_OPAQUE, 0u, 0, 0, 1023, 511, 0u };
+    render_state_t stateB = stateA;
+    stateB.semiTransparency = 1u;
+    auto pushTriangle = [](CommandBuffer& buffer, const int32_t x, const int32_t y, const render_state_t& state)
+    {
+        vertex_t pVertices[3];
+        for (uint32_t i = 0; i < 3u; ++i)
+        {
+            pVertices[i].coords = vertex_pos_t{ static_cast<float>(x + ((i == 1u) ? 10 : 0)), static_cast<float>(y + ((i == 2u) ? 10 : 0)), 0.0f };
+            pVertices[i].color = 0x808080u;
+            pVertices[i].texture = 0u;
+        }
+        return buffer.pushTriangle(pVertices, state);
+    };
+
+    ::utils::memory::FrameArena arena(256u); // small blocks: batch arrays grown in chained blocks
+    std::unique_ptr<CommandBuffer> pBuffer(new CommandBuffer(arena)); // large object -> not on stack
+    CommandBuffer& buffer = *pBuffer;
+    pushTriangle(buffer, 0, 0, stateA);       // batch 0 (A)
+    pushTriangle(buffer, 100, 100, stateB);   // batch 1 (B)
+    pushTriangle(buffer, 200, 200, stateA);   // no overlap with batch 1 -> moved to batch 0
+    pushTriangle(buffer, 300, 300, stateB);   // batch 1 (last batch)
+    pushTriangle(buffer, 400, 400, stateA);   // no overlap with batch 1 -> moved to batch 0
+    const float mergeRatio = buffer.getFrameStats().mergeRatio();
+    pushTriangle(buffer, 105, 105, stateA);   // same state as last primitive, but overlaps batch 1 (drawn after batch 0) -> batch 2 (A)
+    buffer.pushBarrier();
+    pushTriangle(buffer, 600, 600, stateB);   // no overlap, but previous batches closed -> batch 3 (B)
+
+    const command_buffer_stats_t& stats = buffer.getFrameStats();
+    const draw_batch_t* pBatches = buffer.batches();
+    if (buffer.batchCount() != 4u || stats.batches != 4u || stats.primitives != 7u || stats.stateChanges != 6u || stats.merged != 2u
+    ||  pBatches[0].state != stateA || pBatches[1].state != stateB || pBatches[2].state != stateA || pBatches[3].state != stateB)
+    {
+        logTestResult("command buffer"s, "invalid batches: count="s + std::to_string(buffer.batchCount()) + " merged="s + std::to_string(stats.merged)
+                      + " state changes="s + std::to_string(stats.stateChanges));
+        return false;
+    }
+    // index ranges of batches (in submission order): A = triangles 0,2,4 / B = 1,3 / A = 5 / B = 6
+    if (pBatches[0].rangeCount != 3u || pBatches[0].pRanges[0].first != 0u || pBatches[0].pRanges[1].first != 6u || pBatches[0].pRanges[2].first != 12u
+    ||  pBatches[1].rangeCount != 2u || pBatches[1].pRanges[1].first != 9u || pBatches[2].pRanges[0].first != 15u || pBatches[3].pRanges[0].first != 18u
+    ||  pBatches[0].area.left != 0 || pBatches[0].area.right != 410 || pBatches[1].area.top != 100 || pBatches[1].area.bottom != 310)
+    {
+        logTestResult("command buffer"s, "invalid batch ranges/areas"s);
+        isSuccess = false;
+    }
+    if (mergeRatio != 2.5f || stats.mergeRatio() != 1.5f)
+    {
+        logTestResult("command buffer"s, "invalid merge ratio: "s + std::to_string(mergeRatio) + " / "s + std::to_string(stats.mergeRatio()));
+        isSuccess = false;
+    }
+    buffer.clear();
+    arena.reset();
+    if (buffer.batchCount() != 0u || buffer.getFrameStats().primitives != 0u || buffer.polyBuffer().size() != 0u)
+    {
+        logTestResult("command buffer"s, "content remaining after clear"s);
+        isSuccess = false;
+    }
+
+    // decoding output: primitives batched by facade (fill = own state, copy = barrier, quad = 4 vertices)
+    using command::primitive::PrimitiveFacade;
+    display::software::raster_state_t state{};
+    state.clipRight = 1023;
+    state.clipBottom = 511;
+    const display::software::raster_vertex_t pVertices[3] = { { 0, 0, 0x10u, 0u, 0u }, { 10, 0, 0x20u, 0u, 0u }, { 0, 10, 0x30u, 0u, 0u } };
+    const display::software::raster_vertex_t pQuad[4] = { { 200, 200, 0x10u, 0u, 0u }, { 220, 200, 0x20u, 0u, 0u }, { 200, 220, 0x30u, 0u, 0u }, { 220, 220, 0x40u, 0u, 0u } };
+    PrimitiveFacade::setCommandBuffer(&buffer);
+    PrimitiveFacade::drawTriangle(pVertices, state);
+    PrimitiveFacade::fillArea(500, 0, 16, 16, 0xFFu);
+    PrimitiveFacade::drawRectangle(display::software::raster_vertex_t{ 100, 100, 0x10u, 0u, 0u }, 8, 8, state); // joins triangle batch
+    PrimitiveFacade::copyArea(0, 0, 700, 0, 8, 8);
+    PrimitiveFacade::drawLine(pVertices[0], pVertices[1], state);
+    PrimitiveFacade::drawTriangle(pVertices, state); // after barrier -> new batch
+    PrimitiveFacade::drawQuad(pQuad, state); // joins last batch (contiguous range)
+    PrimitiveFacade::setCommandBuffer(nullptr);
+    if (buffer.batchCount() != 4u || buffer.getFrameStats().primitives != 6u || buffer.getFrameStats().merged != 1u
+    ||  (buffer.batches()[1].state.flags & RENDER_STATE_FILL) == 0u || (buffer.batches()[2].state.flags & RENDER_STATE_LINE) == 0u
+    ||  buffer.batches()[0].rangeCount != 2u || buffer.batches()[0].pRanges[1].count != 6u || buffer.polyBuffer().size() != 3u + 4u + 4u + 3u + 4u
+    ||  buffer.batches()[3].rangeCount != 1u || buffer.batches()[3].pRanges[0].count != 3u + 6u || buffer.batches()[3].area.right != 220
+    ||  buffer.polyBuffer().vertices()[17].coords.x != 220.0f || buffer.polyBuffer().vertices()[17].color != 0x10u
+    ||  buffer.batches()[0].area.right != 107 || buffer.polyBuffer().vertices()[0].color != 0x10u || buffer.polyBuffer().vertices()[1].color != 0x10u)
+    {
+        logTestResult("command buffer"s, "invalid batches of decoded primitives: count="s + std::to_string(buffer.batchCount()));
+        isSuccess = false;
+    }
+    buffer.clear();
+    return isSuccess;
+}
+
+/// @brief Frame arena - alignment, block chaining on overflow, high-water mark, chained blocks merged on reset (+ command buffer batches)
+/// @returns Success
+static bool testFrameArena()
+{
+    using ::utils::memory::FrameArena;
+    bool isSuccess = true;
+
+    // first frame: 3 x 400 bytes in 1024-byte blocks -> 2 blocks chained
+    FrameArena arena(1024u);
+    uint8_t* pFirst = static_cast<uint8_t*>(arena.allocate(400u, 64u));
+    uint8_t* pSecond = static_cast<uint8_t*>(arena.allocate(400u, 64u));
+    uint8_t* pThird = static_cast<uint8_t*>(arena.allocate(400u, 64u));
+    if ((reinterpret_cast<uintptr_t>(pFirst) & 63u) != 0u || (reinterpret_cast<uintptr_t>(pSecond) & 63u) != 0u || (reinterpret_cast<uintptr_t>(pThird) & 63u) != 0u
+    ||  pSecond < pFirst + 400u || arena.blockCount() != 2u || arena.capacity() != 2048u || arena.usedBytes() < 1200u)
+    {
+        logTestResult("frame arena"s, "invalid allocations: blocks="s + std::to_string(arena.blockCount()) + " used="s + std::to_string(arena.usedBytes()));
+        isSuccess = false;
+    }
+    memset(pFirst, 0x11, 400u); // no overlap between allocations
+    memset(pSecond, 0x22, 400u);
+    memset(pThird, 0x33, 400u);
+    if (pFirst[399] != 0x11u || pSecond[0] != 0x22u || pSecond[399] != 0x22u || pThird[0] != 0x33u)
+    {
+        logTestResult("frame arena"s, "overlapping allocations"s);
+        isSuccess = false;
+    }
+    // allocation bigger than a block -> dedicated block
+    arena.allocate(3000u);
+    const size_t frameBytes = arena.usedBytes();
+    if (arena.blockCount() != 3u || frameBytes < 4200u)
+    {
+        logTestResult("frame arena"s, "big allocation: invalid block chain"s);
+        isSuccess = false;
+    }
+
+    // reset: chained blocks merged into one block sized with the high-water mark
+    arena.reset();
+    if (arena.blockCount() != 1u || arena.capacity() < frameBytes || (arena.capacity() % 1024u) != 0u || arena.usedBytes() != 0u
+    ||  arena.highWaterMark() != frameBytes || arena.overflowCount() != 1u)
+    {
+        logTestResult("frame arena"s, "reset: blocks not merged: blocks="s + std::to_string(arena.blockCount()) + " capacity="s + std::to_string(arena.capacity())
+                      + " high-water mark="s + std::to_string(arena.highWaterMark()));
+        isSuccess = false;
+    }
+    // same frame again: no new block, memory reused
+    uint8_t* pPreviousFrame = nullptr;
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        uint8_t* pReused = static_cast<uint8_t*>(arena.allocate(400u, 64u));
+        arena.allocate(400u, 64u);
+        arena.allocate(400u, 64u);
+        arena.allocate(3000u);
+        if (arena.blockCount() != 1u || (pPreviousFrame != nullptr && pReused != pPreviousFrame))
+        {
+            logTestResult("frame arena"s, "steady state: new block chained or memory not reused"s);
+            isSuccess = false;
+        }
+        pPreviousFrame = pReused;
+        arena.reset();
+    }
+    // smaller frame: high-water mark kept
+    arena.allocate(100u);
+    arena.reset();
+    if (arena.highWaterMark() != frameBytes || arena.overflowCount() != 1u)
+    {
+        logTestResult("frame arena"s, "invalid high-water mark after smaller frame: "s + std::to_string(arena.highWaterMark()));
+        isSuccess = false;
+    }
+
+    // command buffer batch records (dispatcher frame arena): overflow on first frame only
+    FrameArena batchArena(512u);
+    std::unique_ptr<command::CommandBuffer> pBuffer(new command::CommandBuffer(batchArena)); // large object -> not on stack
+    command::render_state_t state{ 0u, 0u, 0u, 0u, RENDER_STATE_OPAQUE, 0u, 0, 0, 1023, 511, 0u };
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        for (uint32_t i = 0; i < 64u; ++i)
+        {
+            command::vertex_t pVertices[3];
+            for (uint32_t v = 0; v < 3u; ++v)
+            {
+                pVertices[v].coords = command::vertex_pos_t{ static_cast<float>(i * 16u + v * 4u), static_cast<float>(i * 4u), 0.0f };
+                pVertices[v].color = pVertices[v].texture = 0u;
+            }
+            state.clutId = static_cast<uint16_t>(i); // different states: 64 batches
+            pBuffer->pushTriangle(pVertices, state);
+        }
+        const size_t blockCount = batchArena.blockCount();
+        pBuffer->clear(); // Dispatcher::endFrame
+        batchArena.reset();
+        if ((frame == 0 && blockCount < 2u) || (frame > 0 && blockCount != 1u) || batchArena.overflowCount() != 1u)
+        {
+            logTestResult("frame arena"s, "command buffer frame "s + std::to_string(frame) + ": blocks="s + std::to_string(blockCount)
+                          + " overflows="s + std::to_string(batchArena.overflowCount()));
+            isSuccess = false;
+        }
+    }
+    return isSuccess;
+}
+
+/// @brief Display list - frame recorded through primitive facade, then replayed: identical native VRAM and high resolution buffer
+/// @returns Success
+static bool testDisplayList()
+{
+    using command::primitive::PrimitiveFacade;
+    using command::primitive::colordepth_t;
+    using command::primitive::stp_t;
+    using display::software::DualFrameBuffer;
+    using display::software::raster_state_t;
+    using display::software::raster_vertex_t;
+    bool isSuccess = true;
+
+    // random VRAM content (texels, CLUT, existing image)
+    command::memory::VideoMemory vram;
+    vram.init();
+    uint16_t* pVram = vram.rend();
+    uint32_t seed = 0x5EEDu;
+    for (uint32_t i = 0; i < 1024u * 512u; ++i)
+        pVram[i] = static_cast<uint16_t>(nextTestValue(seed) & 0x7FFFu);
+    const std::vector<uint16_t> initialVram(pVram, pVram + 1024u * 512u);
+
+    command::FrameBufferSettings settings;
+    settings.reset();
+    settings.setDrawAreaTopLeft(0, 0);
+    settings.setDrawAreaBottomRight(1023, 511);
+    command::DisplayState displayState;
+    displayState.reset();
+    command::memory::VramWriteTracker tracker;
+    PrimitiveFacade::init(vram, settings, displayState, tracker);
+
+    // direct drawing + recording
+    DualFrameBuffer direct(pVram, 2u, 2u, 1u);
+    command::DisplayList list;
+    PrimitiveFacade::setSoftwareRenderer(&direct);
+    PrimitiveFacade::setDisplayList(&list);
+
+    const raster_vertex_t pTriangle[3]{ { 20, 20, 0x0000FFu, 0u, 0u }, { 200, 40, 0x00FF00u, 0u, 0u }, { 60, 180, 0xFF0000u, 0u, 0u } };
+    PrimitiveFacade::drawTriangle(pTriangle, PrimitiveFacade::createRasterState(false, true, false, false));
+    settings.setTexturePage(64u, 0u, colordepth_t::clut_4bit, stp_t::add);
+    raster_state_t textured = PrimitiveFacade::createRasterState(true, false, true, false);
+    textured.texture.clutY = 480u;
+    PrimitiveFacade::drawRectangle(raster_vertex_t{ 300, 40, 0x808080u, 8u, 8u }, 64, 48, textured);
+    PrimitiveFacade::drawTriangle(pTriangle, PrimitiveFacade::createRasterState(false, false, false, true)); // semi-transparent over gouraud
+    PrimitiveFacade::fillArea(400, 200, 32, 32, 0x00336699u);
+    PrimitiveFacade::copyArea(300, 40, 500, 300, 64, 48);
+    PrimitiveFacade::drawLine(pTriangle[0], pTriangle[1], PrimitiveFacade::createRasterState(false, true, false, false));
+    // CPU -> VRAM transfer: modified CLUT
+    PrimitiveFacade::beforeVramWrite(0, 480, 16, 1);
+    for (uint32_t i = 0; i < 16u; ++i)
+        pVram[480u * 1024u + i] = static_cast<uint16_t>(0x1000u + i * 0x0421u);
+    PrimitiveFacade::onVramWrite(0, 480, 16, 1);
+    PrimitiveFacade::drawRectangle(raster_vertex_t{ 600, 40, 0x808080u, 8u, 8u }, 64, 48, textured);
+    PrimitiveFacade::clearTextureCache();
+    PrimitiveFacade::drawRectangle(raster_vertex_t{ 700, 40, 0x808080u, 0u, 0u }, 32, 32, textured);
+    direct.endFrame();
+
+    PrimitiveFacade::setSoftwareRenderer(nullptr);
+    PrimitiveFacade::setDisplayList(nullptr);
+    PrimitiveFacade::close();
+    const command::display_list_stats_t stats = list.getStats();
+    if (stats.commands != 10u || stats.pixels != 16u || list.commands()[6].op != command::display_op_t::upload)
+    {
+        logTestResult("display list"s, "invalid recorded frame: commands="s + std::to_string(stats.commands) + " pixels="s + std::to_string(stats.pixels));
+        isSuccess = false;
+    }
+
+    // replay from initial VRAM content: same scale, then native only
+    std::vector<uint16_t> replayVram(initialVram);
+    DualFrameBuffer replayed(&replayVram[0], 2u, 2u, 1u);
+    list.replay(replayed, &replayVram[0]);
+    replayed.endFrame();
+    if (memcmp(&replayVram[0], pVram, 1024u * 512u * sizeof(uint16_t)) != 0)
+    {
+        logTestResult("display list"s, "replay: native VRAM differs from direct drawing"s);
+        isSuccess = false;
+    }
+    if (memcmp(replayed.getHighResBuffer(), direct.getHighResBuffer(), static_cast<size_t>(direct.getHighResWidth()) * direct.getHighResHeight() * sizeof(uint32_t)) != 0)
+    {
+        logTestResult("display list"s, "replay: high resolution buffer differs from direct drawing"s);
+        isSuccess = false;
+    }
+    std::vector<uint16_t> nativeVram(initialVram);
+    DualFrameBuffer nativeReplayed(&nativeVram[0], 1u, 1u, 1u);
+    list.replay(nativeReplayed, &nativeVram[0]);
+    nativeReplayed.endFrame();
+    if (memcmp(&nativeVram[0], pVram, 1024u * 512u * sizeof(uint16_t)) != 0)
+    {
+        logTestResult("display list"s, "replay (native scale): VRAM differs from direct drawing"s);
+        isSuccess = false;
+    }
+
+    // state deduplication: field comparison (padding content ignored)
+    raster_state_t state{};
+    state.clipRight = 1023;
+    state.clipBottom = 511;
+    state.texture.windowMaskU = state.texture.windowMaskV = 0xFFu;
+    raster_state_t dirtyState;
+    memset(&dirtyState, 0xAB, sizeof(dirtyState));
+    dirtyState.clipLeft = state.clipLeft;
+    dirtyState.clipTop = state.clipTop;
+    dirtyState.clipRight = state.clipRight;
+    dirtyState.clipBottom = state.clipBottom;
+    dirtyState.texture.pVram = state.texture.pVram;
+    dirtyState.texture.texpageX = state.texture.texpageX;
+    dirtyState.texture.texpageY = state.texture.texpageY;
+    dirtyState.texture.clutX = state.texture.clutX;
+    dirtyState.texture.clutY = state.texture.clutY;
+    dirtyState.texture.colorDepth = state.texture.colorDepth;
+    dirtyState.texture.windowMaskU = state.texture.windowMaskU;
+    dirtyState.texture.windowMaskV = state.texture.windowMaskV;
+    dirtyState.texture.windowOffsetU = state.texture.windowOffsetU;
+    dirtyState.texture.windowOffsetV = state.texture.windowOffsetV;
+    dirtyState.texture.pDecodedPage = state.texture.pDecodedPage;
+    dirtyState.texture.pUpscaledPage = state.texture.pUpscaledPage;
+    dirtyState.texture.upscalingFactor = state.texture.upscalingFactor;
+    dirtyState.semiTransparency = state.semiTransparency;
+    dirtyState.isTextured = state.isTextured;
+    dirtyState.isShaded = state.isShaded;
+    dirtyState.isModulated = state.isModulated;
+    dirtyState.isSemiTransparent = state.isSemiTransparent;
+    dirtyState.isDithered = state.isDithered;
+    dirtyState.isMaskBitForced = state.isMaskBitForced;
+    dirtyState.isMaskBitChecked = state.isMaskBitChecked;
+    dirtyState.isRectXFlip = state.isRectXFlip;
+    dirtyState.isRectYFlip = state.isRectYFlip;
+    dirtyState.isFieldSkipped = state.isFieldSkipped;
+    dirtyState.skippedFieldParity = state.skippedFieldParity;
+    command::DisplayList stateList;
+    stateList.recordRectangle(raster_vertex_t{ 0, 0, 0u, 0u, 0u }, 4, 4, state);
+    stateList.recordRectangle(raster_vertex_t{ 8, 0, 0u, 0u, 0u }, 4, 4, dirtyState);
+    if (stateList.getStats().states != 1u)
+    {
+        logTestResult("display list"s, "identical states with different padding not merged"s);
+        isSuccess = false;
+    }
+    vram.close();
+    return isSuccess;
+}
+
+/// @brief Batched vertex decoder - compare with primitive accessors (every geometry type) + benchmark
+/// @returns Success
+static bool testVertexDecoder()
+{
+    static command::primitive::VertexDecoder decoder; // large object -> not on stack
+    const int32_t offsetX = -37, offsetY = 21;
+    bool isSuccess = true;
+
+    std::vector<command::cmd_block_t> packets(VERTEX_DECODER_CAPACITY * 12u);
+    uint32_t seed = 0xDEC0u;
+    for (auto it = packets.begin(); it != packets.end(); ++it)
+        *it = static_cast<command::cmd_block_t>(nextTestValue(seed));
+
+    // exactness: every geometry type (except poly-lines)
+    for (command::cmd_block_t commandId = PRIMITIVE_GEOMETRY_FIRST_ID; commandId <= PRIMITIVE_GEOMETRY_LAST_ID; ++commandId)
+    {
+        command::primitive::packet_layout_t layout;
+        if (command::primitive::VertexDecoder::getPacketLayout(commandId, layout) == false)
+            continue;
+        if (layout.packetSize != command::primitive::c_pPrimitiveIndex[commandId].size)
+        {
+            logTestResult("vertex decoder"s, "invalid packet size: command "s + std::to_string(commandId));
+            isSuccess = false;
+            continue;
+        }
+
+        size_t packetCount = decoder.decode(commandId, &packets[0], packets.size() / layout.packetSize, offsetX, offsetY);
+        for (size_t packet = 0; packet < packetCount; ++packet)
+        {
+            const command::cmd_block_t* pPacket = &packets[packet * layout.packetSize];
+            for (uint32_t i = 0; i < layout.vertexCount; ++i)
+            {
+                const size_t index = packet * layout.vertexCount + i;
+                command::primitive::coord16_t coord{ pPacket[1u + i * layout.vertexStride] };
+                command::primitive::rgb24_t color{ pPacket[(layout.isShaded) ? i * layout.vertexStride : 0u] };
+                command::primitive::coord8_tx_t texture{ (layout.isTextured) ? pPacket[2u + i * layout.vertexStride] : 0uL };
+                display::software::raster_vertex_t vertex;
+                decoder.getRasterVertex(index, vertex);
+                if (vertex.x != coord.signedX() + offsetX || vertex.y != coord.signedY() + offsetY || vertex.color != static_cast<uint32_t>(color.rgb24())
+                ||  vertex.u != static_cast<uint32_t>(texture.x()) || vertex.v != static_cast<uint32_t>(texture.y()))
+                {
+                    logTestResult("vertex decoder"s, "invalid vertex: command "s + std::to_string(commandId) + ", index "s + std::to_string(index));
+                    isSuccess = false;
+                    packet = packetCount;
+                    break;
+                }
+            }
+        }
+    }
+
+    // benchmark: textured gouraud-shaded quads (batches of 64 packets)
+    const command::cmd_block_t benchmarkId = 0x3C;
+    const size_t batchPackets = VERTEX_DECODER_CAPACITY / 4u;
+    int32_t checksum = 0;
+    double batchTime = measureDuration([&]()
+    {
+        for (int it = 0; it < BENCHMARK_ITERATIONS * 64; ++it)
+        {
+            for (size_t packet = 0; packet + batchPackets <= packets.size() / 12u; packet += batchPackets)
+            {
+                decoder.decode(benchmarkId, &packets[packet * 12u], batchPackets, offsetX, offsetY);
+                checksum += decoder.x()[it & 0xFF];
+            }
+        }
+    });
+    std::vector<display::software::raster_vertex_t> vertices(VERTEX_DECODER_CAPACITY);
+    double accessorTime = measureDuration([&]()
+    {
+        for (int it = 0; it < BENCHMARK_ITERATIONS * 64; ++it)
+        {
+            for (size_t packet = 0; packet + batchPackets <= packets.size() / 12u; packet += batchPackets)
+            {
+                for (size_t i = 0; i < VERTEX_DECODER_CAPACITY; ++i)
+                {
+                    const command::cmd_block_t* pVertex = &packets[(packet + (i >> 2)) * 12u + (i & 0x3u) * 3u];
+                    command::primitive::rgb24_t color{ pVertex[0] };
+                    command::primitive::coord16_t coord{ pVertex[1] };
+                    command::primitive::coord8_tx_t texture{ pVertex[2] };
+                    vertices[i].x = coord.signedX() + offsetX;
+                    vertices[i].y = coord.signedY() + offsetY;
+                    vertices[i].color = static_cast<uint32_t>(color.rgb24());
+                    vertices[i].u = static_cast<uint32_t>(texture.x());
+                    vertices[i].v = static_cast<uint32_t>(texture.y());
+                }
+                checksum += vertices[it & 0xFF].x;
+            }
+        }
+    });
+    logTestResult("vertex decoder"s, "decode quads: batched="s + std::to_string(batchTime) + "ms, accessors="s + std::to_string(accessorTime) + "ms ("s + std::to_string(checksum & 0x1) + ")"s);
+    return isSuccess;
+}
+
+
+
+/// @brief Encode raw vertex coordinates (11-bit values, optional garbage in unused high bits)
+static inline command::cmd_block_t encodeTestVertex(const int32_t x, const int32_t y, const uint32_t highBits = 0u) noexcept
+{
+    return ((static_cast<uint32_t>(y) & 0x7FFu) << 16) | (static_cast<uint32_t>(x) & 0x7FFu) | highBits;
+}
+
+/// @brief Primitive early rejection - rejection reason of each category (+ counters), run of packets decoded and filtered by primitive facade
+/// @returns Success
+static bool testPrimitiveCulling()
+{
+    using command::primitive::PrimitiveCulling;
+    using command::primitive::PrimitiveFacade;
+    using command::primitive::reject_reason_t;
+    static command::primitive::VertexDecoder decoder; // large object -> not on stack
+    bool isSuccess = true;
+    command::FrameBufferSettings settings;
+    settings.setDrawAreaTopLeft(0, 0);
+    settings.setDrawAreaBottomRight(319, 239);
+
+    struct culling_case_t
+    {
+        const char* name;
+        command::cmd_block_t commandId;
+        command::cmd_block_t data[5];
+        int32_t offsetX, offsetY;
+        reject_reason_t expected;
+    };
+    const culling_case_t cases[] =
+    {
+        { "triangle visible",        0x20u, { 0u, encodeTestVertex(10, 10, 0x18001800u), encodeTestVertex(100, 10), encodeTestVertex(10, 100), 0u }, 0, 0, reject_reason_t::none },
+        { "triangle degenerate",     0x20u, { 0u, encodeTestVertex(10, 10), encodeTestVertex(20, 20), encodeTestVertex(30, 30), 0u }, 0, 0, reject_reason_t::degenerate },
+        { "triangle outside",        0x20u, { 0u, encodeTestVertex(400, 10), encodeTestVertex(450, 10), encodeTestVertex(400, 50), 0u }, 0, 0, reject_reason_t::outsideArea },
+        { "triangle oversized",      0x20u, { 0u, encodeTestVertex(-100, 0), encodeTestVertex(1000, 0), encodeTestVertex(0, 50), 0u }, 0, 0, reject_reason_t::oversized },
+        { "triangle oversized (Y)",  0x20u, { 0u, encodeTestVertex(0, -300), encodeTestVertex(10, 300), encodeTestVertex(0, 50), 0u }, 0, 0, reject_reason_t::oversized },
+        { "quad second half visible",0x28u, { 0u, encodeTestVertex(500, 10), encodeTestVertex(330, 10), encodeTestVertex(330, 50), encodeTestVertex(100, 50) }, 0, 0, reject_reason_t::none },
+        { "quad first half flat",    0x28u, { 0u, encodeTestVertex(10, 10), encodeTestVertex(20, 20), encodeTestVertex(30, 30), encodeTestVertex(10, 100) }, 0, 0, reject_reason_t::none },
+        { "quad both halves outside",0x28u, { 0u, encodeTestVertex(500, 10), encodeTestVertex(330, 10), encodeTestVertex(330, 50), encodeTestVertex(500, 50) }, 0, 0, reject_reason_t::outsideArea },
+        { "quad both halves flat",   0x28u, { 0u, encodeTestVertex(10, 10), encodeTestVertex(20, 20), encodeTestVertex(30, 30), encodeTestVertex(40, 40) }, 0, 0, reject_reason_t::degenerate },
+        { "negative, no offset",     0x20u, { 0u, encodeTestVertex(-50, -50), encodeTestVertex(-20, -50), encodeTestVertex(-50, -20), 0u }, 0, 0, reject_reason_t::outsideArea },
+        { "negative + offset",       0x20u, { 0u, encodeTestVertex(-50, -50), encodeTestVertex(-20, -50), encodeTestVertex(-50, -20), 0u }, 30, 30, reject_reason_t::none },
+        { "positive - offset",       0x20u, { 0u, encodeTestVertex(1000, 10), encodeTestVertex(1020, 10), encodeTestVertex(1000, 40), 0u }, -800, 0, reject_reason_t::none },
+        { "line visible",            0x40u, { 0u, encodeTestVertex(-10, 5), encodeTestVertex(10, 5), 0u, 0u }, 0, 0, reject_reason_t::none },
+        { "line outside",            0x40u, { 0u, encodeTestVertex(400, 0), encodeTestVertex(500, 10), 0u, 0u }, 0, 0, reject_reason_t::outsideArea },
+        { "line oversized",          0x40u, { 0u, encodeTestVertex(-600, 0), encodeTestVertex(600, 0), 0u, 0u }, 0, 0, reject_reason_t::oversized },
+        { "rectangle degenerate",    0x60u, { 0u, encodeTestVertex(10, 10), 0x00100000u, 0u, 0u }, 0, 0, reject_reason_t::degenerate },
+        { "rectangle outside",       0x60u, { 0u, encodeTestVertex(320, 0), 0x00100010u, 0u, 0u }, 0, 0, reject_reason_t::outsideArea },
+        { "sprite 16 negative",      0x7Cu, { 0u, encodeTestVertex(-10, -10), 0u, 0u, 0u }, 0, 0, reject_reason_t::none }
+    };
+
+    uint32_t expectedCounters[PRIMITIVE_REJECT_REASON_LENGTH] = { 0u, 0u, 0u, 0u };
+    PrimitiveCulling::resetCounters();
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i)
+    {
+        settings.setDrawOffset(cases[i].offsetX, cases[i].offsetY);
+        decoder.decode(cases[i].commandId, cases[i].data, 1u, cases[i].offsetX, cases[i].offsetY);
+        const reject_reason_t reason = PrimitiveCulling::checkPrimitive(cases[i].commandId, cases[i].data, decoder.x(), decoder.y(), settings);
+        if (reason != cases[i].expected)
+        {
+            logTestResult("primitive culling"s, cases[i].name + ": invalid rejection reason "s + std::to_string(static_cast<uint32_t>(reason)));
+            isSuccess = false;
+        }
+        if (PrimitiveCulling::isRejected(cases[i].commandId, cases[i].data, decoder.x(), decoder.y(), settings) != (cases[i].expected != reject_reason_t::none))
+        {
+            logTestResult("primitive culling"s, cases[i].name + ": invalid rejection"s);
+            isSuccess = false;
+        }
+        ++expectedCounters[static_cast<uint32_t>(cases[i].expected)];
+    }
+
+    for (uint32_t i = 0; i < PRIMITIVE_REJECT_REASON_LENGTH; ++i)
+    {
+        if (PrimitiveCulling::getCounter(static_cast<reject_reason_t>(i)) != expectedCounters[i])
+        {
+            logTestResult("primitive culling"s, "invalid counter "s + std::to_string(i) + ": "s + std::to_string(PrimitiveCulling::getCounter(static_cast<reject_reason_t>(i))));
+            isSuccess = false;
+        }
+    }
+    if (PrimitiveCulling::getRejectedCount() != expectedCounters[1] + expectedCounters[2] + expectedCounters[3])
+    {
+        logTestResult("primitive culling"s, "invalid rejected count"s);
+        isSuccess = false;
+    }
+
+    // run of flat triangles: decoded once, rejected packets not recorded
+    command::memory::VideoMemory vram;
+    vram.init();
+    command::DisplayState displayState;
+    displayState.reset();
+    command::memory::VramWriteTracker tracker;
+    command::DisplayList list;
+    settings.setDrawOffset(10, 0);
+    PrimitiveFacade::init(vram, settings, displayState, tracker);
+    PrimitiveFacade::setDisplayList(&list);
+    command::cmd_block_t run[] =
+    {
+        0x200000FFu, encodeTestVertex(10, 10), encodeTestVertex(100, 10), encodeTestVertex(10, 100),   // visible
+        0x2000FF00u, encodeTestVertex(400, 10), encodeTestVertex(450, 10), encodeTestVertex(400, 50),  // outside
+        0x20FF0000u, encodeTestVertex(10, 10), encodeTestVertex(20, 20), encodeTestVertex(30, 30),     // degenerate
+        0x20123456u, encodeTestVertex(-20, 5), encodeTestVertex(-5, 5), encodeTestVertex(-20, 30)      // visible (offset)
+    };
+    PrimitiveCulling::resetCounters();
+    PrimitiveFacade::createPrimitives(0x20u, run, 4u);
+    const std::vector<display::software::raster_vertex_t>& vertices = list.vertices();
+    if (vertices.size() != 6u || vertices[0].x != 20 || vertices[2].y != 100 || vertices[0].color != 0xFFu
+    ||  vertices[3].x != -10 || vertices[4].x != 5 || vertices[5].y != 30 || vertices[5].color != 0x123456u)
+    {
+        logTestResult("primitive culling"s, "invalid decoded run: "s + std::to_string(vertices.size()) + " vertices"s);
+        isSuccess = false;
+    }
+    if (PrimitiveCulling::getCounter(reject_reason_t::none) != 2u || PrimitiveCulling::getRejectedCount() != 2u)
+    {
+        logTestResult("primitive culling"s, "invalid decoded run counters"s);
+        isSuccess = false;
+    }
+    PrimitiveFacade::setDisplayList(nullptr);
+    PrimitiveFacade::close();
+    PrimitiveCulling::resetCounters();
+    return isSuccess;
+}
+
+// -- output -- ----------------------------------------------------------------
+
+/// @brief Display area conversion kernels - compare with scalar reference (row wrap, odd widths) + benchmark
+/// @returns Success
+static bool testDisplayKernels()
+{
+    using display::output::DisplayKernels;
+    bool isSuccess = true;
+
+    std::vector<uint16_t> vram(BENCHMARK_PIXEL_COUNT);
+    uint32_t seed = 0xD15Bu;
+    for (auto it = vram.begin(); it != vram.end(); ++it)
+        *it = static_cast<uint16_t>(nextTestValue(seed));
+    std::vector<uint32_t> output(1024u * 512u);
+    std::vector<uint32_t> reference(1024u * 512u);
+
+    // exactness: aligned/odd widths, areas wrapping around VRAM rows and bottom
+    struct { uint32_t x, y, width, height; } areas[] = { { 0u, 0u, 640u, 480u }, { 1000u, 300u, 320u, 240u }, { 3u, 511u, 368u, 17u },
+                                                         { 1021u, 7u, 253u, 5u }, { 681u, 40u, 682u, 3u }, { 0u, 0u, 1u, 1u } };
+    for (int isRgb24 = 0; isRgb24 <= 1; ++isRgb24)
+    {
+        for (size_t i = 0; i < sizeof(areas) / sizeof(*areas); ++i)
+        {
+            const uint32_t pitch = areas[i].width + 3u;
+            if (isRgb24)
+                DisplayKernels::convertRgb24(&vram[0], areas[i].x, areas[i].y, areas[i].width, areas[i].height, &output[0], pitch);
+            else
+                DisplayKernels::convertRgb15(&vram[0], areas[i].x, areas[i].y, areas[i].width, areas[i].height, &output[0], pitch);
+            DisplayKernels::convertReference(&vram[0], areas[i].x, areas[i].y, areas[i].width, areas[i].height, isRgb24 != 0, &reference[0], pitch);
+
+            for (uint32_t row = 0; row < areas[i].height; ++row)
+            {
+                if (memcmp(&output[row * pitch], &reference[row * pitch], areas[i].width * sizeof(uint32_t)) != 0)
+                {
+                    logTestResult("display kernels"s, "mismatch with scalar reference: "s + ((isRgb24) ? "24-bit"s : "15-bit"s) + ", area "s + std::to_string(i));
+                    isSuccess = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // benchmark (640x480 display area)
+    for (int isRgb24 = 0; isRgb24 <= 1; ++isRgb24)
+    {
+        double kernelTime = measureDuration([&]()
+        {
+            for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+            {
+                if (isRgb24)
+                    DisplayKernels::convertRgb24(&vram[0], 0u, 0u, 640u, 480u, &output[0], 640u);
+                else
+                    DisplayKernels::convertRgb15(&vram[0], 0u, 0u, 640u, 480u, &output[0], 640u);
+            }
+        });
+        double referenceTime = measureDuration([&]()
+        {
+            for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+                DisplayKernels::convertReference(&vram[0], 0u, 0u, 640u, 480u, isRgb24 != 0, &reference[0], 640u);
+        });
+        logTestResult("display kernels"s, ((isRgb24) ? "24-bit"s : "15-bit"s) + " to RGBA8: kernel="s + std::to_string(kernelTime) + "ms, reference="s + std::to_string(referenceTime) + "ms"s);
+    }
+    return isSuccess;
+}
+
+/// @brief Screen picture thumbnail - compare with floating-point area average of converted display area (both color modes)
+/// @returns Success
+static bool testDisplayThumbnail()
+{
+    using display::output::DisplayKernels;
+    bool isSuccess = true;
+
+    std::vector<uint16_t> vram(BENCHMARK_PIXEL_COUNT);
+    uint32_t seed = 0x7B1Cu;
+    for (auto it = vram.begin(); it != vram.end(); ++it)
+        *it = static_cast<uint16_t>(nextTestValue(seed));
+    std::vector<uint8_t> thumbnail(DISPLAY_THUMBNAIL_WIDTH * DISPLAY_THUMBNAIL_HEIGHT * 3u);
+    std::vector<uint32_t> area(1024u * 512u);
+
+    // exactness: common/odd sizes, areas wrapping around VRAM, display smaller than thumbnail
+    struct { uint32_t x, y, width, height; } areas[] = { { 0u, 0u, 640u, 480u }, { 900u, 400u, 320u, 240u }, { 5u, 17u, 368u, 239u },
+                                                         { 0u, 0u, 1024u, 512u }, { 681u, 0u, 682u, 480u }, { 1000u, 505u, 100u, 64u } };
+    for (int isRgb24 = 0; isRgb24 <= 1; ++isRgb24)
+    {
+        for (size_t i = 0; i < sizeof(areas) / sizeof(*areas); ++i)
+        {
+            const uint32_t width = (isRgb24 && areas[i].width > 682u) ? 682u : areas[i].width, height = areas[i].height;
+            DisplayKernels::createThumbnail(&vram[0], areas[i].x, areas[i].y, width, height, isRgb24 != 0, &thumbnail[0]);
+            DisplayKernels::convertReference(&vram[0], areas[i].x, areas[i].y, width, height, isRgb24 != 0, &area[0], width);
+
+            const double scaleX = static_cast<double>(width) / DISPLAY_THUMBNAIL_WIDTH, scaleY = static_cast<double>(height) / DISPLAY_THUMBNAIL_HEIGHT;
+            bool isMatching = true;
+            for (uint32_t row = 0; row < DISPLAY_THUMBNAIL_HEIGHT && isMatching; ++row)
+            {
+                for (uint32_t col = 0; col < DISPLAY_THUMBNAIL_WIDTH && isMatching; ++col)
+                {
+                    double sums[3] = { 0.0, 0.0, 0.0 };
+                    const double top = row * scaleY, bottom = (row + 1u) * scaleY, left = col * scaleX, right = (col + 1u) * scaleX;
+                    for (uint32_t sourceY = static_cast<uint32_t>(top); sourceY < height && static_cast<double>(sourceY) < bottom; ++sourceY)
+                    {
+                        const double coverY = ((sourceY + 1.0 < bottom) ? sourceY + 1.0 : bottom) - ((sourceY > top) ? sourceY : top);
+                        for (uint32_t sourceX = static_cast<uint32_t>(left); sourceX < width && static_cast<double>(sourceX) < right; ++sourceX)
+                        {
+                            const double cover = coverY * (((sourceX + 1.0 < right) ? sourceX + 1.0 : right) - ((sourceX > left) ? sourceX : left));
+                            const uint32_t pixel = area[sourceY * width + sourceX];
+                            for (uint32_t component = 0; component < 3u; ++component)
+                                sums[component] += cover * ((pixel >> (component * 8u)) & 0xFFu);
+                        }
+                    }
+                    const uint8_t* pThumbnailPixel = &thumbnail[(row * DISPLAY_THUMBNAIL_WIDTH + col) * 3u];
+                    for (uint32_t component = 0; component < 3u; ++component)
+                    {
+                        const double expected = sums[component] / (scaleX * scaleY);
+                        if (std::fabs(expected - pThumbnailPixel[2u - component]) > 0.5001) // BGR
+                        {
+                            logTestResult("display thumbnail"s, "mismatch with area average: "s + ((isRgb24) ? "24-bit"s : "15-bit"s) + ", area "s + std::to_string(i)
+                                                                + " at "s + std::to_string(col) + ","s + std::to_string(row));
+                            isSuccess = isMatching = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // benchmark (640x480 display area)
+    for (int isRgb24 = 0; isRgb24 <= 1; ++isRgb24)
+    {
+        double thumbnailTime = measureDuration([&]()
+        {
+            for (int it = 0; it < BENCHMARK_ITERATIONS; ++it)
+                DisplayKernels::createThumbnail(&vram[0], 0u, 0u, 640u, 480u, isRgb24 != 0, &thumbnail[0]);
+        });
+        logTestResult("display thumbnail"s, ((isRgb24) ? "24-bit"s : "15-bit"s) + " 640x480 to 128x96: "s + std::to_string(thumbnailTime / BENCHMARK_ITERATIONS) + "ms/picture"s);
+    }
+    return isSuccess;
+}
+
+/// @brief VRAM write tracker - compare modified areas with per-tile reference (areas wrapping around VRAM edges)
+/// @returns Success
+static bool testVramWriteTracker()
+{
+    bool isSuccess = true;
+    command::memory::VramWriteTracker tracker;
+    if (tracker.isAreaModified(0u, 0u, 1u, 1u) == false) // new tracker: everything modified
+    {
+        logTestResult("VRAM write tracker"s, "new tracker not fully modified"s);
+        isSuccess = false;
+    }
+
+    uint32_t seed = 0x7AC4u;
+    for (int it = 0; isSuccess && it < 64; ++it)
+    {
+        // random written areas (reference: tiles of each written pixel)
+        bool referenceTiles[VRAM_WRITE_TRACKER_ROWS][VRAM_WRITE_TRACKER_COLUMNS] = {};
+        tracker.clear();
+        for (uint32_t area = nextTestValue(seed) % 4u; area > 0u; --area)
+        {
+            const int32_t x = static_cast<int32_t>(nextTestValue(seed) & 0x3FFu), y = static_cast<int32_t>(nextTestValue(seed) & 0x1FFu);
+            const int32_t width = static_cast<int32_t>(nextTestValue(seed) % 700u), height = static_cast<int32_t>(nextTestValue(seed) % 300u);
+            tracker.markArea(x, y, width, height);
+            for (int32_t row = y; row < y + height; ++row)
+                for (int32_t col = x; col < x + width; ++col)
+                    referenceTiles[(row & 0x1FF) >> VRAM_WRITE_TRACKER_TILE_SHIFT][(col & 0x3FF) >> VRAM_WRITE_TRACKER_TILE_SHIFT] = true;
+        }
+
+        // random display areas
+        for (int check = 0; check < 32; ++check)
+        {
+            const uint32_t x = nextTestValue(seed) & 0x3FFu, y = nextTestValue(seed) & 0x1FFu;
+            const uint32_t width = 1u + nextTestValue(seed) % 1024u, height = 1u + nextTestValue(seed) % 512u;
+            bool isExpected = false;
+            for (uint32_t row = y; row < y + height && !isExpected; row = (row | 0x1Fu) + 1u) // next tile
+                for (uint32_t col = x; col < x + width && !isExpected; col = (col | 0x1Fu) + 1u)
+                    isExpected = referenceTiles[(row & 0x1FFu) >> VRAM_WRITE_TRACKER_TILE_SHIFT][(col & 0x3FFu) >> VRAM_WRITE_TRACKER_TILE_SHIFT];
+            if (tracker.isAreaModified(x, y, width, height) != isExpected)
+            {
+                logTestResult("VRAM write tracker"s, "invalid modified status: area "s + std::to_string(x) + ","s + std::to_string(y)
+                                                   + " "s + std::to_string(width) + "x"s + std::to_string(height));
+                isSuccess = false;
+                break;
+            }
+        }
+    }
+    return isSuccess;
+}
+
+
+/// @brief Pixel-art test image (blocks and lines of a small palette: equal/different neighbours for scaler patterns)
+/// @param[in] width   Image width
+/// @param[in] height  Image height
+/// @param[in] seed    Generator state
+/// @returns RGBA8 image
+static std::vector<uint32_t> createPixelArtImage(const uint32_t width, const uint32_t height, uint32_t seed)
+{
+    const uint32_t palette[] = { 0xFF000000u, 0xFFFFFFFFu, 0xFF2040E0u, 0xFF30C060u, 0xFFE08020u, 0xFF808080u, 0xFF8A8A86u };
+    std::vector<uint32_t> image(static_cast<size_t>(width) * height);
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t block = ((x >> 2) * 7u + (y >> 3) * 13u + (x + y) / 5u) % 7u; // diagonal/stair-step edges
+            image[static_cast<size_t>(y) * width + x] = ((nextTestValue(seed) & 0xFu) == 0u) ? palette[nextTestValue(seed) % 7u] : palette[block];
+        }
+    return image;
+}
+
+/// @brief Screen upscaler - compare multithreaded strips with single-threaded scaling of whole image + 4x benchmark
+/// @returns Success
+static bool testScreenUpscaler()
+{
+    bool isSuccess = true;
+    const uint32_t width = 203u, height = 77u; // not a multiple of strip rows
+    std::vector<uint32_t> source = createPixelArtImage(width, height, 0x51A7u);
+
+    const config::upscaling_mode_t modes[] = { config::upscaling_mode_t::sai, config::upscaling_mode_t::xbr,
+                                               config::upscaling_mode_t::xbrz, config::upscaling_mode_t::xbrzEnhanced };
+    const char* modeNames[] = { "2xSaI", "xBR", "xBRZ", "xBRZ-enhanced" };
+    for (uint32_t m = 0; m < sizeof(modes) / sizeof(*modes); ++m)
+    {
+        for (uint32_t requested = 2u; requested <= PIXEL_SCALERS_MAX_FACTOR; ++requested)
+        {
+            display::scaling::ScreenUpscaler upscaler(modes[m], requested, 3u);
+            const uint32_t factor = upscaler.factor();
+            std::vector<uint32_t> output(source.size() * factor * factor);
+            upscaler.upscale(&source[0], width, height, &output[0]);
+
+            // single-threaded reference (2xSaI: repeated 2x passes)
+            std::vector<uint32_t> reference = source;
+            uint32_t refWidth = width, refHeight = height;
+            display::scaling::scaling_buffer_t buffer;
+            for (uint32_t passFactor = (modes[m] == config::upscaling_mode_t::sai) ? 2u : factor; refWidth < width * factor; refWidth *= passFactor, refHeight *= passFactor)
+            {
+                std::vector<uint32_t> scaled(reference.size() * passFactor * passFactor);
+                display::scaling::PixelScalers::scaleStrip(modes[m], passFactor, &reference[0], refWidth, refHeight, 0u, refHeight, &scaled[0], buffer);
+                reference.swap(scaled);
+            }
+
+            if (reference.size() != output.size() || memcmp(&output[0], &reference[0], output.size() * sizeof(uint32_t)) != 0)
+            {
+                logTestResult("screen upscaler"s, "mismatch with single-threaded scaling: "s + modeNames[m] + " "s + std::to_string(factor) + "x"s);
+                isSuccess = false;
+            }
+        }
+    }
+
+    // benchmark (4x, 640x480 display area)
+    std::vector<uint32_t> screen = createPixelArtImage(640u, 480u, 0x3C5Eu);
+    std::vector<uint32_t> upscaled(screen.size() * 16u);
+    for (uint32_t m = 0; m < 3u; ++m)
+    {
+        display::scaling::ScreenUpscaler upscaler(modes[m], 4u);
+        double duration = measureDuration([&]()
+        {
+            for (int it = 0; it < BENCHMARK_SCREEN_FRAMES; ++it)
+                upscaler.upscale(&screen[0], 640u, 480u, &upscaled[0]);
+        });
+        logTestResult("screen upscaler"s, std::string(modeNames[m]) + " 4x (640x480, "s + std::to_string(upscaler.concurrency()) + " threads): "s
+                                        + std::to_string(duration / BENCHMARK_SCREEN_FRAMES) + "ms/frame"s);
+    }
+    return isSuccess;
+}
+
+
+/// @brief Screen resampler - identity at native size, constant images, thread independence, geometry + 1080p benchmark
+/// @returns Success
+static bool testScreenResampler()
+{
+    bool isSuccess = true;
+    const uint32_t width = 227u, height = 91u;
+    std::vector<uint32_t> source = createPixelArtImage(width, height, 0x62D1u);
+    const config::interpolation_mode_t modes[] = { config::interpolation_mode_t::nearest, config::interpolation_mode_t::bilinear,
+                                                   config::interpolation_mode_t::bilinearEnhanced, config::interpolation_mode_t::bicubic,
+                                                   config::interpolation_mode_t::lanczos };
+    const char* modeNames[] = { "nearest", "bilinear", "bilinear-enhanced", "bicubic", "lanczos" };
+
+    display::scaling::screen_target_t native = { width, height, width, height, 0u, 0u, width, height, 0, 0, width, height };
+    const uint32_t sizes[][2] = { { width * 3u, height * 2u + 1u }, { width / 2u + 3u, height / 3u }, { width + 40u, height - 11u } };
+    display::scaling::ScreenResampler resampler(3u), singleThread(0u);
+    for (uint32_t m = 0; m < sizeof(modes) / sizeof(*modes); ++m)
+    {
+        // native size: interpolating filters -> identical image
+        std::vector<uint32_t> output(source.size());
+        resampler.setTarget(modes[m], native);
+        resampler.resample(&source[0], &output[0]);
+        if (output != source)
+        {
+            logTestResult("screen resampler"s, "native size not identical: "s + modeNames[m]);
+            isSuccess = false;
+        }
+        if (resampler.setTarget(modes[m], native))
+        {
+            logTestResult("screen resampler"s, "weight tables recomputed with same geometry: "s + modeNames[m]);
+            isSuccess = false;
+        }
+
+        for (uint32_t i = 0; i < sizeof(sizes) / sizeof(*sizes); ++i)
+        {
+            // cropped/black sides target (4 pixel borders)
+            display::scaling::screen_target_t target = { width, height, sizes[i][0] + 8u, sizes[i][1] + 8u, 4u, 4u, sizes[i][0], sizes[i][1],
+                                                         -3, 7, sizes[i][0] + 6u, sizes[i][1] - 6u };
+            std::vector<uint32_t> threaded(static_cast<size_t>(target.windowWidth) * target.windowHeight), reference(threaded.size());
+            resampler.setTarget(modes[m], target);
+            resampler.resample(&source[0], &threaded[0]);
+            singleThread.setTarget(modes[m], target);
+            singleThread.resample(&source[0], &reference[0]);
+            if (threaded != reference)
+            {
+                logTestResult("screen resampler"s, "mismatch with single-threaded resampling: "s + modeNames[m] + ", size "s + std::to_string(i));
+                isSuccess = false;
+            }
+
+            // constant image -> constant visible area, black borders
+            std::vector<uint32_t> uniform(source.size(), 0xFF3C82D7u);
+            resampler.resample(&uniform[0], &threaded[0]);
+            for (uint32_t y = 0; y < target.windowHeight && isSuccess; ++y)
+                for (uint32_t x = 0; x < target.windowWidth; ++x)
+                {
+                    const bool isVisible = (x >= 4u && x < target.windowWidth - 4u && static_cast<int32_t>(x) < target.x + static_cast<int32_t>(target.width)
+                                        && y >= 7u && y < 7u + target.height && y < target.windowHeight - 4u);
+                    if (threaded[y * target.windowWidth + x] != ((isVisible) ? 0xFF3C82D7u : SCREEN_RESAMPLER_BLACK))
+                    {
+                        logTestResult("screen resampler"s, "invalid constant image: "s + modeNames[m] + ", size "s + std::to_string(i)
+                                                         + ", pixel "s + std::to_string(x) + ","s + std::to_string(y));
+                        isSuccess = false;
+                        break;
+                    }
+                }
+        }
+    }
+
+    // geometry: keep ratio (black sides) / full stretch / cropped
+    config::config_screen_t settings = {};
+    settings.pixelRatio = config::pixel_ratio_mode_t::nonSquare;
+    display::scaling::screen_target_t fit = display::scaling::ScreenResampler::computeTarget(settings, true, 320u, 240u, 1920u, 1080u);
+    settings.ratioStretch = SCREEN_RATIO_MAX_VAL;
+    display::scaling::screen_target_t stretched = display::scaling::ScreenResampler::computeTarget(settings, true, 320u, 240u, 1920u, 1080u);
+    settings.ratioStretch = 0u;
+    settings.ratioCrop = SCREEN_RATIO_MAX_VAL;
+    display::scaling::screen_target_t cropped = display::scaling::ScreenResampler::computeTarget(settings, true, 320u, 240u, 1920u, 1080u);
+    if (fit.width != 1440u || fit.height != 1080u || fit.x != 240 || stretched.width != 1920u || stretched.height != 1080u
+    ||  cropped.width != 1920u || cropped.height != 1440u || cropped.y != -180)
+    {
+        logTestResult("screen resampler"s, "invalid screen geometry"s);
+        isSuccess = false;
+    }
+
+    // benchmark (640x480 -> 1080p window)
+    std::vector<uint32_t> screen = createPixelArtImage(640u, 480u, 0x3C5Eu);
+    std::vector<uint32_t> window(1920u * 1080u);
+    settings.ratioCrop = 0u;
+    const display::scaling::screen_target_t target = display::scaling::ScreenResampler::computeTarget(settings, false, 640u, 480u, 1920u, 1080u);
+    display::scaling::ScreenResampler benchResampler;
+    for (uint32_t m = 0; m < sizeof(modes) / sizeof(*modes); ++m)
+    {
+        double setupTime = measureDuration([&]() { benchResampler.setTarget(modes[m], target); });
+        double duration = measureDuration([&]()
+        {
+            for (int it = 0; it < BENCHMARK_SCREEN_FRAMES; ++it)
+                benchResampler.resample(&screen[0], &window[0]);
+        });
+        logTestResult("screen resampler"s, std::string(modeNames[m]) + " 640x480 to 1080p ("s + std::to_string(benchResampler.concurrency()) + " threads): weights="s
+                                         + std::to_string(setupTime) + "ms, "s + std::to_string(duration / BENCHMARK_SCREEN_FRAMES) + "ms/frame"s);
+    }
+    return isSuccess;
+}
+
+
+/// @brief Headless output frame callback - copy of last received frame
+struct headless_frame_t
+{
+    std::vector<uint8_t> pixels; ///< Received frame (RGB888)
+    long width;                  ///< Received frame width
+    long height;                 ///< Received frame height
+    uint32_t count;              ///< Number of received frames
+};
+static void CALLBACK receiveHeadlessFrame(const unsigned char* pRgb, long width, long height, void* pUserData)
+{
+    headless_frame_t* pFrame = static_cast<headless_frame_t*>(pUserData);
+    pFrame->pixels.assign(pRgb, pRgb + width * height * 3);
+    pFrame->width = width;
+    pFrame->height = height;
+    ++(pFrame->count);
+}
+
+/// @brief Headless output - display area presented from high resolution image (internal resolution size) and from native VRAM (15-bit/24-bit), wrapping + screen stages
+/// @returns Success
+static bool testHeadlessOutput()
+{
+    using display::output::HeadlessOutput;
+    bool isSuccess = true;
+    const uint32_t previousStatus = command::memory::StatusRegister::getStatusRegister();
+    headless_frame_t received{};
+    HeadlessOutput::setFrameCallback(receiveHeadlessFrame, &received);
+
+    // 320x240 display (15-bit), starting near right edge of VRAM (wrapped area)
+    command::DisplayState displayState;
+    command::DisplayState::setDisplayMode(0x01u);
+    command::memory::StatusRegister::unsetStatus(GPUSTATUS_DISPLAYDISABLED);
+    displayState.setHorizontalRange(0x260u | ((0x260u + 320u * 8u) << 12));
+    displayState.setVerticalRange(16u | ((16u + 240u) << 10));
+    displayState.setDisplayAreaStart(900u | (100u << 10));
+
+    const uint32_t scale = 2u;
+    std::vector<uint16_t> vram(1024u * 512u, 0u);
+    display::software::DualFrameBuffer renderer(&vram[0], scale, scale, 1u);
+    renderer.fillArea(0, 0, 1024, 512, 0x00203040u);
+    renderer.fillArea(960, 150, 120, 60, 0x00F0C080u); // wrapped fill
+    renderer.endFrame();
+    for (auto it = vram.begin(); it != vram.end(); ++it) // native image differs: output must not be converted from it
+        *it = 0x7FFFu;
+
+    HeadlessOutput output;
+    output.presentHighRes(renderer.getHighResBuffer(), renderer.getScaleX(), renderer.getScaleY(), displayState);
+    if (received.count != 1u || received.width != 640 || received.height != 480)
+    {
+        logTestResult("headless output"s, "high resolution: invalid frame size: "s + std::to_string(received.width) + "x"s + std::to_string(received.height));
+        isSuccess = false;
+    }
+    else
+    {
+        const uint32_t highResWidth = renderer.getHighResWidth(), highResHeight = renderer.getHighResHeight();
+        for (uint32_t y = 0; y < 480u && isSuccess; ++y)
+            for (uint32_t x = 0; x < 640u; ++x)
+            {
+                const uint32_t source = renderer.getHighResBuffer()[((100u * scale + y) % highResHeight) * highResWidth + (900u * scale + x) % highResWidth];
+                const uint8_t* pPixel = &received.pixels[(y * 640u + x) * 3u];
+                if (pPixel[0] != (source & 0xFFu) || pPixel[1] != ((source >> 8) & 0xFFu) || pPixel[2] != ((source >> 16) & 0xFFu))
+                {
+                    logTestResult("headless output"s, "high resolution: invalid pixel: "s + std::to_string(x) + ","s + std::to_string(y));
+                    isSuccess = false;
+                    break;
+                }
+            }
+        if (isSuccess && memcmp(&received.pixels[(100u * 640u + 200u) * 3u], &received.pixels[0], 3u) == 0) // wrapped fill (x=960+, y=150+)
+        {
+            logTestResult("headless output"s, "high resolution: wrapped area not presented"s);
+            isSuccess = false;
+        }
+    }
+    // native 15-bit display area (software renderer disabled / hardware readback): random VRAM, wrapped area
+    uint32_t seed = 0x41u;
+    for (auto it = vram.begin(); it != vram.end(); ++it)
+        *it = static_cast<uint16_t>(nextTestValue(seed));
+    output.present(&vram[0], displayState);
+    if (received.count != 2u || received.width != 320 || received.height != 240)
+    {
+        logTestResult("headless output"s, "native 15-bit: invalid frame size: "s + std::to_string(received.width) + "x"s + std::to_string(received.height));
+        isSuccess = false;
+    }
+    else
+    {
+        for (uint32_t y = 0; y < 240u && isSuccess; ++y)
+            for (uint32_t x = 0; x < 320u; ++x)
+            {
+                const uint16_t source = vram[((100u + y) & 511u) * 1024u + ((900u + x) & 1023u)];
+                const uint32_t r = source & 0x1Fu, g = (source >> 5) & 0x1Fu, b = (source >> 10) & 0x1Fu;
+                const uint8_t* pPixel = &received.pixels[(y * 320u + x) * 3u];
+                if (pPixel[0] != ((r << 3) | (r >> 2)) || pPixel[1] != ((g << 3) | (g >> 2)) || pPixel[2] != ((b << 3) | (b >> 2)))
+                {
+                    logTestResult("headless output"s, "native 15-bit: invalid pixel: "s + std::to_string(x) + ","s + std::to_string(y));
+                    isSuccess = false;
+                    break;
+                }
+            }
+    }
+
+    // native 24-bit display area: 320 pixels = 960 bytes from x=800 (wrapped row, pixel straddling row end)
+    command::DisplayState::setDisplayMode(0x01u | 0x10u);
+    displayState.setDisplayAreaStart(800u | (400u << 10));
+    output.present(&vram[0], displayState);
+    if (received.count != 3u || received.width != 320 || received.height != 240 || output.width() != 320u || output.frameCount() != 3uLL)
+    {
+        logTestResult("headless output"s, "native 24-bit: invalid frame size: "s + std::to_string(received.width) + "x"s + std::to_string(received.height));
+        isSuccess = false;
+    }
+    else
+    {
+        for (uint32_t y = 0; y < 240u && isSuccess; ++y)
+        {
+            const uint8_t* pRow = reinterpret_cast<const uint8_t*>(&vram[((400u + y) & 511u) * 1024u]);
+            for (uint32_t byte = 0; byte < 320u * 3u; ++byte)
+            {
+                if (received.pixels[y * 320u * 3u + byte] != pRow[(800u * 2u + byte) & 2047u])
+                {
+                    logTestResult("headless output"s, "native 24-bit: invalid pixel: "s + std::to_string(byte / 3u) + ","s + std::to_string(y));
+                    isSuccess = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // screen stages: mirroring (fused post-processing), then resampling to fixed output size, then black borders
+    auto expectRgb15 = [&](const uint32_t vramX, const uint32_t vramY, const uint8_t* pPixel) -> bool
+    {
+        const uint16_t source = vram[(vramY & 511u) * 1024u + (vramX & 1023u)];
+        const uint32_t r = source & 0x1Fu, g = (source >> 5) & 0x1Fu, b = (source >> 10) & 0x1Fu;
+        return (pPixel[0] == ((r << 3) | (r >> 2)) && pPixel[1] == ((g << 3) | (g >> 2)) && pPixel[2] == ((b << 3) | (b >> 2)));
+    };
+    command::DisplayState::setDisplayMode(0x01u);
+    displayState.setDisplayAreaStart(900u | (100u << 10));
+    config::config_screen_t screen = {};
+    screen.pixelRatio = config::pixel_ratio_mode_t::square;
+    screen.isMirrored = true;
+    config::config_scaling_t scaling = {};
+    scaling.screenSmoothing = config::screen_smooth_mode_t::none;
+    output.setScreenEffects(screen, scaling);
+    output.present(&vram[0], displayState);
+    for (uint32_t y = 0; y < 240u && isSuccess; ++y)
+        for (uint32_t x = 0; x < 320u; ++x)
+        {
+            if (received.width != 320 || expectRgb15(900u + 319u - x, 100u + y, &received.pixels[(y * 320u + x) * 3u]) == false)
+            {
+                logTestResult("headless output"s, "mirrored: invalid pixel: "s + std::to_string(x) + ","s + std::to_string(y));
+                isSuccess = false;
+                break;
+            }
+        }
+
+    screen.isMirrored = false;
+    output.setScreenEffects(screen, scaling);
+    output.setOutputSize(640u, 480u, config::interpolation_mode_t::nearest);
+    output.present(&vram[0], displayState);
+    if (received.width != 640 || received.height != 480)
+    {
+        logTestResult("headless output"s, "resampled: invalid frame size: "s + std::to_string(received.width) + "x"s + std::to_string(received.height));
+        isSuccess = false;
+    }
+    for (uint32_t y = 0; y < 480u && isSuccess; ++y)
+        for (uint32_t x = 0; x < 640u; ++x)
+        {
+            if (expectRgb15(900u + x / 2u, 100u + y / 2u, &received.pixels[(y * 640u + x) * 3u]) == false)
+            {
+                logTestResult("headless output"s, "resampled: invalid pixel: "s + std::to_string(x) + ","s + std::to_string(y));
+                isSuccess = false;
+                break;
+            }
+        }
+
+    screen.blackBorders.x = 16u;
+    output.setScreenEffects(screen, scaling);
+    output.present(&vram[0], displayState);
+    const uint8_t black[3] = { 0u, 0u, 0u };
+    if (received.width != 640 || received.height != 480 || memcmp(&received.pixels[(240u * 640u + 15u) * 3u], black, 3u) != 0
+    ||  memcmp(&received.pixels[(240u * 640u + 624u) * 3u], black, 3u) != 0 || received.count != 6u)
+    {
+        logTestResult("headless output"s, "resampled with black borders: invalid frame"s);
+        isSuccess = false;
+    }
+    uint32_t presentedWidth = 0u, presentedHeight = 0u; // processed frame captured by frame dump
+    const uint32_t* pPresented = output.getPresentedFrame(presentedWidth, presentedHeight);
+    if (pPresented == nullptr || presentedWidth != 640u || presentedHeight != 480u || (pPresented[240u * 640u + 15u] & 0xFFFFFFu) != 0u
+    ||  memcmp(&received.pixels[(240u * 640u + 320u) * 3u], &pPresented[240u * 640u + 320u], 3u) != 0)
+    {
+        logTestResult("headless output"s, "invalid presented frame"s);
+        isSuccess = false;
+    }
+    output.setOutputSize(0u, 0u, config::interpolation_mode_t::nearest);
+    screen.blackBorders.x = 0u;
+    output.setScreenEffects(screen, scaling);
+    output.present(&vram[0], displayState);
+    if (received.width != 320 || received.height != 240 || expectRgb15(900u, 100u, &received.pixels[0]) == false)
+    {
+        logTestResult("headless output"s, "screen stages not disabled"s);
+        isSuccess = false;
+    }
+    command::memory::StatusRegister::setStatus(GPUSTATUS_DISPLAYDISABLED);
+    output.present(&vram[0], displayState);
+    if (output.getPresentedFrame(presentedWidth, presentedHeight) != nullptr) // black frame: native display area captured instead
+    {
+        logTestResult("headless output"s, "presented frame not reset (black frame)"s);
+        isSuccess = false;
+    }
+
+    HeadlessOutput::setFrameCallback(nullptr, nullptr);
+    command::memory::StatusRegister::setStatusRegister(previousStatus);
+    return isSuccess;
+}
+
+
+/// @brief Post-processing - compare fused tile pass with separate full-frame passes + 1080p stage costs
+/// @returns Success
+static bool testPostProcessing()
+{
+    bool isSuccess = true;
+    const uint32_t width = 211u, height = 150u; // partial tiles
+    std::vector<uint32_t> source = createPixelArtImage(width, height, 0x7E21u);
+    const config::screen_smooth_mode_t smoothModes[] = { config::screen_smooth_mode_t::none, config::screen_smooth_mode_t::slight, config::screen_smooth_mode_t::blur };
+
+    for (uint32_t m = 0; m < sizeof(smoothModes) / sizeof(*smoothModes); ++m)
+    {
+        for (int isMirrored = 0; isMirrored <= 1; ++isMirrored)
+        {
+            display::output::post_processing_settings_t settings = { smoothModes[m], isMirrored != 0, config::screen_curvature_t::none, 5u, 70u, 190u, 71u, 120u, 4u };
+            display::output::PostProcessing pipeline(3u);
+            pipeline.configure(settings, width, height);
+            std::vector<uint32_t> output(source.size());
+            pipeline.process(&source[0], &output[0]);
+
+            // reference: separate passes (mirroring -> smoothing -> gamma/scanlines -> borders)
+            std::vector<uint32_t> mirrored(source.size()), reference(source.size());
+            for (uint32_t y = 0; y < height; ++y)
+                for (uint32_t x = 0; x < width; ++x)
+                    mirrored[y * width + x] = source[y * width + ((isMirrored) ? width - 1u - x : x)];
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    uint32_t color = 0u;
+                    for (uint32_t shift = 0; shift < 32u; shift += 8u)
+                    {
+                        uint32_t weighted = 0u, total = 0u;
+                        for (int32_t dy = -1; dy <= 1; ++dy)
+                            for (int32_t dx = -1; dx <= 1; ++dx)
+                            {
+                                const uint32_t weight = (smoothModes[m] == config::screen_smooth_mode_t::blur) ? (2u - (dx != 0)) * (2u - (dy != 0))
+                                                      : ((dx == 0 && dy == 0) ? 4u : ((dx == 0 || dy == 0) && smoothModes[m] == config::screen_smooth_mode_t::slight));
+                                const int32_t sx = static_cast<int32_t>(x) + dx, sy = static_cast<int32_t>(y) + dy;
+                                const uint32_t px = (sx < 0) ? 0u : ((sx >= static_cast<int32_t>(width)) ? width - 1u : sx);
+                                const uint32_t py = (sy < 0) ? 0u : ((sy >= static_cast<int32_t>(height)) ? height - 1u : sy);
+                                weighted += weight * ((mirrored[py * width + px] >> shift) & 0xFFu);
+                                total += weight;
+                            }
+                        uint32_t value = (weighted + total / 2u) / total;
+                        if (shift < 24u)
+                        {
+                            value = static_cast<uint32_t>(255.0 * std::pow(static_cast<double>(value) / 255.0, 100.0 / 120.0) + 0.5);
+                            if (y & 0x1u)
+                                value = (value * 12u + 8u) >> 4;
+                        }
+                        color |= value << shift;
+                    }
+                    const bool isVisible = (x >= 5u && x < 195u && y >= 70u && y < 141u);
+                    reference[y * width + x] = (isVisible) ? color : POST_PROCESSING_BLACK;
+                }
+            }
+            if (output != reference)
+            {
+                logTestResult("post-processing"s, "mismatch with separate passes: smoothing="s + std::to_string(m) + ((isMirrored) ? ", mirrored"s : ""s));
+                isSuccess = false;
+            }
+        }
+    }
+
+    // noise: same output with any number of threads
+    display::output::post_processing_settings_t noiseSettings = { config::screen_smooth_mode_t::noise, false, config::screen_curvature_t::none, 0u, 0u, width, height, 100u, 0u };
+    display::output::PostProcessing threaded(3u), singleThread(0u);
+    threaded.configure(noiseSettings, width, height);
+    singleThread.configure(noiseSettings, width, height);
+    std::vector<uint32_t> noiseOutput(source.size()), noiseReference(source.size());
+    threaded.process(&source[0], &noiseOutput[0]);
+    singleThread.process(&source[0], &noiseReference[0]);
+    if (noiseOutput != noiseReference)
+    {
+        logTestResult("post-processing"s, "noise depends on threads"s);
+        isSuccess = false;
+    }
+
+    // benchmark (1080p, all stages)
+    std::vector<uint32_t> frame = createPixelArtImage(1920u, 1080u, 0x1F3Du), processed(frame.size());
+    display::output::post_processing_settings_t settings = { config::screen_smooth_mode_t::blur, true, config::screen_curvature_t::none, 16u, 8u, 1888u, 1064u, 110u, 6u };
+    display::output::PostProcessing pipeline;
+    pipeline.configure(settings, 1920u, 1080u);
+    pipeline.setProfiling(true);
+    double duration = measureDuration([&]()
+    {
+        for (int it = 0; it < BENCHMARK_SCREEN_FRAMES; ++it)
+            pipeline.process(&frame[0], &processed[0]);
+    });
+    std::string stageCosts;
+    for (uint32_t stage = 0; stage < POST_PROCESSING_STAGE_COUNT; ++stage)
+        stageCosts += ", "s + display::output::PostProcessing::getStageName(static_cast<display::output::post_processing_stage_t>(stage)) + "="s
+                    + std::to_string(pipeline.getStageCost(static_cast<display::output::post_processing_stage_t>(stage))) + "us"s;
+    logTestResult("post-processing"s, "1080p fused pass ("s + std::to_string(pipeline.concurrency()) + " threads): "s
+                                    + std::to_string(duration / BENCHMARK_SCREEN_FRAMES) + "ms/frame"s + stageCosts);
+    return isSuccess;
+}
+
+
+/// @brief Remap table - mirroring identity, SIMD blend vs scalar reference, curvature in fused pass + 1080p/4K benchmark
+/// @returns Success
+static bool testRemapTable()
+{
+    bool isSuccess = true;
+    const uint32_t width = 173u, height = 98u;
+    std::vector<uint32_t> source = createPixelArtImage(width, height, 0x4A93u);
+    std::vector<uint32_t> row(width);
+
+    // no curvature + mirroring: exact reversed rows
+    display::output::RemapTable table;
+    table.build(config::screen_curvature_t::none, true, width, height);
+    for (uint32_t y = 0; y < height && isSuccess; ++y)
+    {
+        table.sampleRow(&source[0], static_cast<size_t>(y) * width, width, &row[0]);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            if (row[x] != source[y * width + (width - 1u - x)])
+            {
+                logTestResult("remap table"s, "invalid mirrored pixel "s + std::to_string(x) + ","s + std::to_string(y));
+                isSuccess = false;
+                break;
+            }
+        }
+    }
+
+    // curvature: blend of each pixel vs scalar reference (same table)
+    const config::screen_curvature_t curvatures[] = { config::screen_curvature_t::fisheye, config::screen_curvature_t::curvedShape };
+    for (uint32_t c = 0; c < 2u; ++c)
+    {
+        table.build(curvatures[c], c == 0u, width, height);
+        if (table.offsets()[(height / 2u) * width + width / 2u] == REMAP_TABLE_OUTSIDE || table.offsets()[0] != REMAP_TABLE_OUTSIDE
+        ||  table.offsets()[width / 2u] == REMAP_TABLE_OUTSIDE) // center/edges visible, corners outside
+        {
+            logTestResult("remap table"s, "invalid curved screen shape: "s + std::to_string(c));
+            isSuccess = false;
+        }
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            table.sampleRow(&source[0], static_cast<size_t>(y) * width, width, &row[0]);
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const size_t index = static_cast<size_t>(y) * width + x;
+                uint32_t expected = REMAP_TABLE_BLACK;
+                if (table.offsets()[index] != REMAP_TABLE_OUTSIDE)
+                {
+                    const uint32_t* pQuad = &source[table.offsets()[index]];
+                    const uint64_t weights = table.weights()[index];
+                    const uint32_t corners[4] = { pQuad[0], pQuad[1], pQuad[width], pQuad[width + 1u] };
+                    uint32_t totalWeight = 0u;
+                    expected = 0u;
+                    for (uint32_t shift = 0; shift < 32u; shift += 8u)
+                    {
+                        uint32_t value = 0u;
+                        totalWeight = 0u;
+                        for (uint32_t corner = 0; corner < 4u; ++corner)
+                        {
+                            const uint32_t weight = static_cast<uint32_t>(weights >> (corner * 16u)) & 0xFFFFu;
+                            value += weight * ((corners[corner] >> shift) & 0xFFu);
+                            totalWeight += weight;
+                        }
+                        expected |= ((value + 8192u) >> 14) << shift;
+                    }
+                    if (totalWeight != (1u << 14))
+                        expected = ~expected; // invalid weights
+                }
+                if (row[x] != expected)
+                {
+                    logTestResult("remap table"s, "blend mismatch: curvature "s + std::to_string(c) + ", pixel "s + std::to_string(x) + ","s + std::to_string(y));
+                    isSuccess = false;
+                    y = height;
+                    break;
+                }
+            }
+        }
+    }
+
+    // fused pass with curvature: same output with any number of threads
+    display::output::post_processing_settings_t settings = { config::screen_smooth_mode_t::slight, true, config::screen_curvature_t::fisheye,
+                                                             0u, 0u, width, height, 100u, 3u };
+    display::output::PostProcessing threaded(3u), singleThread(0u);
+    threaded.configure(settings, width, height);
+    singleThread.configure(settings, width, height);
+    std::vector<uint32_t> output(source.size()), reference(source.size());
+    threaded.process(&source[0], &output[0]);
+    singleThread.process(&source[0], &reference[0]);
+    if (output != reference)
+    {
+        logTestResult("remap table"s, "curvature depends on threads"s);
+        isSuccess = false;
+    }
+
+    // benchmark (1080p / 4K): table computed once, then sampled every frame
+    const uint32_t sizes[][2] = { { 1920u, 1080u }, { 3840u, 2160u } };
+    for (uint32_t i = 0; i < 2u; ++i)
+    {
+        std::vector<uint32_t> frame = createPixelArtImage(sizes[i][0], sizes[i][1], 0x2B7Fu), processed(frame.size());
+        display::output::post_processing_settings_t curved = { config::screen_smooth_mode_t::none, false, config::screen_curvature_t::curvedShape,
+                                                               0u, 0u, sizes[i][0], sizes[i][1], 100u, 0u };
+        display::output::PostProcessing pipeline;
+        double setupTime = measureDuration([&]() { pipeline.configure(curved, sizes[i][0], sizes[i][1]); });
+        pipeline.setProfiling(true);
+        double duration = measureDuration([&]()
+        {
+            for (int it = 0; it < BENCHMARK_SCREEN_FRAMES; ++it)
+                pipeline.process(&frame[0], &processed[0]);
+        });
+        logTestResult("remap table"s, "curvature "s + std::to_string(sizes[i][0]) + "x"s + std::to_string(sizes[i][1]) + " ("s + std::to_string(pipeline.concurrency())
+                                    + " threads): table="s + std::to_string(setupTime) + "ms, "s + std::to_string(duration / BENCHMARK_SCREEN_FRAMES) + "ms/frame (remap="s
+                                    + std::to_string(pipeline.getStageCost(display::output::post_processing_stage_t::source)) + "us)"s);
+    }
+    return isSuccess;
+}
+
+/// @brief Snapshot writer - written bitmaps, capture cost on vsync, bursts absorbed by queue (or counted as dropped)
+/// @returns Success
+static bool testSnapshotWriter()
+{
+    using display::output::SnapshotWriter;
+    bool isSuccess = true;
+    const uint32_t width = 640u, height = 480u;
+    std::vector<uint32_t> frame = createPixelArtImage(width, height, 0x5A4Bu);
+    std::vector<std::string> writtenFiles;
+    {
+        SnapshotWriter writer(SnapshotWriter::getDefaultDirectoryPath() + "_test"s);
+        if (writer.captureFrame(&frame[0], width, height, width))
+        {
+            logTestResult("snapshot writer"s, "frame captured without request"s);
+            isSuccess = false;
+        }
+
+        // written file: 24-bit bottom-up BMP
+        writer.request();
+        writer.captureFrame(&frame[0], width - 3u, height, width); // odd width -> padded rows
+        writer.waitIdle();
+        if (writer.writtenCount() != 1uLL)
+        {
+            logTestResult("snapshot writer"s, "snapshot not written: "s + writer.lastFilePath());
+            return false;
+        }
+        writtenFiles.push_back(writer.lastFilePath());
+        std::ifstream file(writer.lastFilePath(), std::ios::binary);
+        std::vector<uint8_t> bitmap((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const uint32_t rowBytes = ((width - 3u) * 3u + 3u) & ~0x3u;
+        if (bitmap.size() != 54u + rowBytes * height || bitmap[0] != 'B' || bitmap[1] != 'M' || bitmap[28] != 24u)
+        {
+            logTestResult("snapshot writer"s, "invalid bitmap header"s);
+            isSuccess = false;
+        }
+        else
+        {
+            for (uint32_t y = 0; y < height && isSuccess; ++y)
+                for (uint32_t x = 0; x < width - 3u; ++x)
+                {
+                    const uint8_t* pPixel = &bitmap[54u + (height - 1u - y) * rowBytes + x * 3u];
+                    const uint32_t color = 0xFF000000u | pPixel[2] | (pPixel[1] << 8) | (pPixel[0] << 16);
+                    if (color != (frame[y * width + x] | 0xFF000000u))
+                    {
+                        logTestResult("snapshot writer"s, "invalid bitmap pixel: "s + std::to_string(x) + ","s + std::to_string(y));
+                        isSuccess = false;
+                        break;
+                    }
+                }
+        }
+
+        // burst of snapshots (one per frame): capture never waits for writer (full queue -> dropped)
+        double maxCaptureTime = 0.0;
+        for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; ++i)
+        {
+            writer.request();
+            double captureTime = measureDuration([&]() { writer.captureFrame(&frame[0], width, height, width); });
+            maxCaptureTime = (captureTime > maxCaptureTime) ? captureTime : maxCaptureTime;
+        }
+        writer.waitIdle();
+        if (writer.writtenCount() + writer.droppedCount() + writer.failedCount() != BENCHMARK_ITERATIONS + 1u || writer.writtenCount() < SNAPSHOT_QUEUE_SIZE + 1u)
+        {
+            logTestResult("snapshot writer"s, "burst: unexpected counters: written="s + std::to_string(writer.writtenCount()) + ", dropped="s
+                                            + std::to_string(writer.droppedCount()) + ", failed="s + std::to_string(writer.failedCount()));
+            isSuccess = false;
+        }
+        logTestResult("snapshot writer"s, "640x480 burst: max capture="s + std::to_string(maxCaptureTime) + "ms, written="s + std::to_string(writer.writtenCount())
+                                        + ", dropped="s + std::to_string(writer.droppedCount()));
+
+        // remove test files (indexes follow the first one)
+        unsigned int firstIndex = 0u;
+        const size_t prefixPosition = writtenFiles[0].rfind(SNAPSHOT_FILE_PREFIX);
+        if (prefixPosition != std::string::npos && sscanf(writtenFiles[0].c_str() + prefixPosition, SNAPSHOT_FILE_PREFIX "%05u", &firstIndex) == 1)
+        {
+            const std::string basePath = writtenFiles[0].substr(0, prefixPosition);
+            for (uint64_t i = 1u; i < writer.writtenCount(); ++i)
+            {
+                char fileName[32];
+                snprintf(fileName, sizeof(fileName), SNAPSHOT_FILE_PREFIX "%05u.bmp", static_cast<unsigned int>(firstIndex + i));
+                writtenFiles.push_back(basePath + fileName);
+            }
+        }
+    }
+    for (auto it = writtenFiles.begin(); it != writtenFiles.end(); ++it)
+        std::remove(it->c_str());
+    std::remove((SnapshotWriter::getDefaultDirectoryPath() + "_test"s).c_str());
+    return isSuccess;
+}
+
+
+/// @brief Frame dump - raw RGB / Y4M streams (content, size changes, padding), capture cost and drops when writer falls behind
+/// @returns Success
+static bool testFrameDumpWriter()
+{
+    using display::output::FrameDumpWriter;
+    bool isSuccess = true;
+    const std::string basePath = FrameDumpWriter::getDefaultBasePath() + "_test"s;
+    const uint32_t width = 64u, height = 48u, frameCount = 12u;
+    std::vector<uint32_t> frames[frameCount];
+    for (uint32_t i = 0; i < frameCount; ++i)
+        frames[i] = createPixelArtImage(width, height, 0xD0u + i);
+
+    // raw RGB: every frame written in order (smaller frame padded with black, bigger frame cropped)
+    std::string rawFilePath;
+    {
+        FrameDumpWriter dump(basePath, config::frame_dump_format_t::rawRgb, 4u);
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            const uint32_t frameWidth = (i == 5u) ? width - 8u : ((i == 6u) ? width + 16u : width);
+            std::vector<uint32_t> resized(static_cast<size_t>(frameWidth) * height, 0xFFFFFFFFu);
+            for (uint32_t y = 0; y < height; ++y)
+                for (uint32_t x = 0; x < frameWidth && x < width; ++x)
+                    resized[y * frameWidth + x] = frames[i][y * width + x];
+            dump.captureFrame(&resized[0], frameWidth, height, frameWidth, false);
+            dump.waitIdle();
+        }
+        display::output::frame_dump_stats_t stats = dump.getStats();
+        rawFilePath = dump.filePath();
+        if (stats.writtenFrames != frameCount || stats.droppedFrames != 0u || stats.writtenBytes != static_cast<uint64_t>(frameCount) * width * height * 3u)
+        {
+            logTestResult("frame dump"s, "raw RGB: unexpected counters: written="s + std::to_string(stats.writtenFrames) + ", dropped="s + std::to_string(stats.droppedFrames));
+            isSuccess = false;
+        }
+    }
+    std::ifstream rawFile(rawFilePath, std::ios::binary);
+    std::vector<uint8_t> rawData((std::istreambuf_iterator<char>(rawFile)), std::istreambuf_iterator<char>());
+    rawFile.close();
+    if (rawData.size() != static_cast<size_t>(frameCount) * width * height * 3u)
+    {
+        logTestResult("frame dump"s, "raw RGB: invalid file size: "s + rawFilePath);
+        isSuccess = false;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < frameCount && isSuccess; ++i)
+            for (uint32_t pixel = 0; pixel < width * height; ++pixel)
+            {
+                const uint8_t* pRgb = &rawData[(static_cast<size_t>(i) * width * height + pixel) * 3u];
+                const uint32_t expected = (i == 5u && pixel % width >= width - 8u) ? 0u : (frames[i][pixel] & 0xFFFFFFu);
+                if ((pRgb[0] | (pRgb[1] << 8) | (pRgb[2] << 16)) != expected)
+                {
+                    logTestResult("frame dump"s, "raw RGB: invalid pixel in frame "s + std::to_string(i));
+                    isSuccess = false;
+                    break;
+                }
+            }
+    }
+    std::remove(rawFilePath.c_str());
+
+    // Y4M: odd size padded to even size, black/white levels
+    std::string y4mFilePath;
+    {
+        FrameDumpWriter dump(basePath, config::frame_dump_format_t::y4m, 4u);
+        std::vector<uint32_t> blackWhite(static_cast<size_t>(width - 1u) * (height - 1u), 0xFF000000u);
+        for (size_t i = 0; i < blackWhite.size(); i += 2u)
+            blackWhite[i] = 0xFFFFFFFFu; // odd width: rows alternate first color
+        for (uint32_t i = 0; i < 3u; ++i)
+            dump.captureFrame(&blackWhite[0], width - 1u, height - 1u, width - 1u, true);
+        dump.waitIdle();
+        y4mFilePath = dump.filePath();
+    }
+    std::ifstream y4mFile(y4mFilePath, std::ios::binary);
+    std::vector<uint8_t> y4mData((std::istreambuf_iterator<char>(y4mFile)), std::istreambuf_iterator<char>());
+    y4mFile.close();
+    const std::string expectedHeader = "YUV4MPEG2 W64 H48 F50:1 Ip A1:1 C420jpeg\n"s;
+    const size_t frameBytes = 6u + width * height * 3u / 2u;
+    if (y4mData.size() != expectedHeader.size() + 3u * frameBytes || memcmp(&y4mData[0], expectedHeader.c_str(), expectedHeader.size()) != 0)
+    {
+        logTestResult("frame dump"s, "Y4M: invalid header or file size: "s + y4mFilePath);
+        isSuccess = false;
+    }
+    else
+    {
+        const uint8_t* pLuma = &y4mData[expectedHeader.size() + 6u];
+        if (pLuma[0] != 235u || pLuma[1] != 16u || pLuma[width - 1u] != 16u || pLuma[(height - 1u) * width] != 16u
+         || pLuma[width * height] != 128u || pLuma[width * height * 5u / 4u] != 128u)
+        {
+            logTestResult("frame dump"s, "Y4M: invalid luma/chroma levels"s);
+            isSuccess = false;
+        }
+    }
+    std::remove(y4mFilePath.c_str());
+
+    // 640x480 stream: capture cost on vsync, ring overflow counted as dropped (never waits)
+    {
+        const uint32_t burstFrames = 64u;
+        std::vector<uint32_t> frame = createPixelArtImage(640u, 480u, 0x640u);
+        FrameDumpWriter dump(basePath, config::frame_dump_format_t::rawRgb);
+        double maxCaptureTime = 0.0;
+        double totalTime = measureDuration([&]()
+        {
+            for (uint32_t i = 0; i < burstFrames; ++i)
+            {
+                double captureTime = measureDuration([&]() { dump.captureFrame(&frame[0], 640u, 480u, 640u, false); });
+                maxCaptureTime = (captureTime > maxCaptureTime) ? captureTime : maxCaptureTime;
+            }
+        });
+        dump.waitIdle();
+        display::output::frame_dump_stats_t stats = dump.getStats();
+        if (stats.capturedFrames + stats.droppedFrames != burstFrames || stats.writtenFrames != stats.capturedFrames || stats.maxQueuedFrames > FRAME_DUMP_RING_SIZE)
+        {
+            logTestResult("frame dump"s, "burst: unexpected counters: captured="s + std::to_string(stats.capturedFrames) + ", written="s + std::to_string(stats.writtenFrames)
+                                       + ", dropped="s + std::to_string(stats.droppedFrames));
+            isSuccess = false;
+        }
+        logTestResult("frame dump"s, "640x480 burst: "s + std::to_string(totalTime / burstFrames) + "ms/frame, max capture="s + std::to_string(maxCaptureTime) + "ms, written="s
+                                   + std::to_string(stats.writtenFrames) + ", dropped="s + std::to_string(stats.droppedFrames) + ", max queued="s + std::to_string(stats.maxQueuedFrames));
+        std::remove(dump.filePath().c_str());
+    }
+    return isSuccess;
+}
+
+
 
 #ifdef _WINDOWS
 /// @brief Plugin - full unit testing
@@ -29,8 +2264,29 @@ long CALLBACK GPUtestUnits(HWND hWindow)
 long CALLBACK GPUtestUnits(unsigned long* pDisplayId, char* pCaption, char* pConfigFile)
 #endif
 {
-
-    return PSE_SUCCESS;
+    bool isSuccess = true;
+    isSuccess &= testBlendKernels();
+    isSuccess &= testTextureCache();
+    isSuccess &= testPaletteRegistry();
+    isSuccess &= testUpscaledTextureStore();
+    isSuccess &= testVertexBuffer();
+    isSuccess &= testCommandBuffer();
+    isSuccess &= testFrameArena();
+    isSuccess &= testDisplayList();
+    isSuccess &= testVertexDecoder();
+    isSuccess &= testPrimitiveCulling();
+    isSuccess &= testFixedPoint();
+    isSuccess &= testDisplayKernels();
+    isSuccess &= testDisplayThumbnail();
+    isSuccess &= testVramWriteTracker();
+    isSuccess &= testScreenUpscaler();
+    isSuccess &= testScreenResampler();
+    isSuccess &= testPostProcessing();
+    isSuccess &= testRemapTable();
+    isSuccess &= testSnapshotWriter();
+    isSuccess &= testFrameDumpWriter();
+    isSuccess &= testHeadlessOutput();
+    return (isSuccess) ? PSE_SUCCESS : PSE_ERR_FATAL;
 }
 
 /// @brief Plugin - primitive testing
@@ -0,0 +1,239 @@
+/*******************************************************************************
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : memory-mapped file (read/write, shared with file on disk)
+*******************************************************************************/
+#pragma once
+
+#include "../../globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <string>
+#ifdef _WINDOWS
+#include <Windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+/// @namespace utils
+/// General utilities
+namespace utils
+{
+    /// @namespace utils.io
+    /// Input/output utilities
+    namespace io
+    {
+        /// @class MappedFile
+        /// @brief Memory-mapped file - file pages are only loaded from disk when accessed
+        class MappedFile
+        {
+        public:
+            /// @brief Create closed mapped file
+            MappedFile() noexcept : m_pData(nullptr), m_size(0u), m_isCreated(false)
+            #ifdef _WINDOWS
+                , m_fileHandle(INVALID_HANDLE_VALUE), m_mappingHandle(NULL)
+            #else
+                , m_fileDescriptor(-1)
+            #endif
+            {}
+            /// @brief Unmap and close file
+            ~MappedFile() { close(); }
+            // no copy allowed
+            MappedFile(const MappedFile& other) = delete;
+            MappedFile& operator=(const MappedFile& other) = delete;
+
+
+            // -- Getters --
+
+            /// @brief Check if file is mapped
+            inline bool isOpen() const noexcept { return (m_pData != nullptr); }
+            /// @brief Check if file was created or resized when opened (new content is zero-filled)
+            inline bool isCreated() const noexcept { return m_isCreated; }
+            /// @brief Get mapped memory
+            inline uint8_t* data() const noexcept { return m_pData; }
+            /// @brief Get mapped size (bytes)
+            inline size_t size() const noexcept { return m_size; }
+
+
+            // -- Operations --
+
+            /// @brief Open (or create) file and map it in memory - file is resized if necessary
+            /// @param[in] path         File path
+            /// @param[in] size         Mapped size (bytes)
+            /// @param[in] isExtendOnly Bigger files are kept and mapped entirely (only smaller files are resized)
+            /// @returns Success
+            bool open(const std::string& path, const size_t size, const bool isExtendOnly = false) noexcept
+            {
+                close();
+                if (size == 0u)
+                    return false;
+
+                #ifdef _WINDOWS
+                m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+                if (m_fileHandle == INVALID_HANDLE_VALUE)
+                    return false;
+                LARGE_INTEGER fileSize;
+                if (GetFileSizeEx(m_fileHandle, &fileSize) == FALSE)
+                {
+                    close();
+                    return false;
+                }
+                const uint64_t currentSize = static_cast<uint64_t>(fileSize.QuadPart);
+                #else
+                m_fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+                if (m_fileDescriptor < 0)
+                    return false;
+                struct stat fileInfo;
+                if (fstat(m_fileDescriptor, &fileInfo) != 0)
+                {
+                    close();
+                    return false;
+                }
+                const uint64_t currentSize = static_cast<uint64_t>(fileInfo.st_size);
+                #endif
+
+                size_t mappedSize = size;
+                if (currentSize != static_cast<uint64_t>(size))
+                {
+                    if (isExtendOnly && currentSize > static_cast<uint64_t>(size))
+                        mappedSize = static_cast<size_t>(currentSize);
+                    else
+                        m_isCreated = true;
+                }
+                if (mapFile(mappedSize) == false)
+                {
+                    close();
+                    return false;
+                }
+                return true;
+            }
+
+            /// @brief Resize file and map it again (previous mapped memory becomes invalid) - new content is zero-filled
+            /// @param[in] size  New mapped size (bytes)
+            /// @returns Success (on failure, file is closed)
+            bool resize(const size_t size) noexcept
+            {
+                if (m_pData == nullptr || size == 0u)
+                    return false;
+                unmapFile();
+                if (mapFile(size) == false)
+                {
+                    close();
+                    return false;
+                }
+                return true;
+            }
+
+            /// @brief Write modified pages to disk
+            /// @returns Success
+            bool flush() noexcept
+            {
+                if (m_pData == nullptr)
+                    return false;
+                #ifdef _WINDOWS
+                return (FlushViewOfFile(m_pData, 0) != FALSE);
+                #else
+                return (msync(m_pData, m_size, MS_SYNC) == 0);
+                #endif
+            }
+
+            /// @brief Unmap and close file (modified pages are written by the system)
+            void close() noexcept
+            {
+                unmapFile();
+                #ifdef _WINDOWS
+                if (m_fileHandle != INVALID_HANDLE_VALUE)
+                    CloseHandle(m_fileHandle);
+                m_fileHandle = INVALID_HANDLE_VALUE;
+                #else
+                if (m_fileDescriptor >= 0)
+                    ::close(m_fileDescriptor);
+                m_fileDescriptor = -1;
+                #endif
+                m_isCreated = false;
+            }
+
+            /// @brief Create directory (if it doesn't exist)
+            /// @param[in] path  Directory path
+            /// @returns Success (or already existing)
+            static bool createDirectory(const std::string& path) noexcept
+            {
+                #ifdef _WINDOWS
+                return (_mkdir(path.c_str()) == 0 || errno == EEXIST);
+                #else
+                return (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST);
+                #endif
+            }
+
+
+        private:
+            /// @brief Set size of open file (if different) and map it in memory
+            bool mapFile(const size_t size) noexcept
+            {
+                #ifdef _WINDOWS
+                LARGE_INTEGER fileSize;
+                if (GetFileSizeEx(m_fileHandle, &fileSize) == FALSE)
+                    return false;
+                if (static_cast<uint64_t>(fileSize.QuadPart) != static_cast<uint64_t>(size)) // resize
+                {
+                    LARGE_INTEGER newSize;
+                    newSize.QuadPart = static_cast<LONGLONG>(size);
+                    if (SetFilePointerEx(m_fileHandle, newSize, NULL, FILE_BEGIN) == FALSE || SetEndOfFile(m_fileHandle) == FALSE)
+                        return false;
+                }
+                m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                                     static_cast<DWORD>(size & 0xFFFFFFFFu), NULL);
+                if (m_mappingHandle != NULL)
+                    m_pData = static_cast<uint8_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+
+                #else
+                struct stat fileInfo;
+                if (fstat(m_fileDescriptor, &fileInfo) != 0)
+                    return false;
+                if (static_cast<uint64_t>(fileInfo.st_size) != static_cast<uint64_t>(size) && ftruncate(m_fileDescriptor, static_cast<off_t>(size)) != 0) // resize
+                    return false;
+                void* pMapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fileDescriptor, 0);
+                if (pMapping != MAP_FAILED)
+                    m_pData = static_cast<uint8_t*>(pMapping);
+                #endif
+
+                m_size = (m_pData != nullptr) ? size : 0u;
+                return (m_pData != nullptr);
+            }
+            /// @brief Unmap file memory (file kept open)
+            void unmapFile() noexcept
+            {
+                #ifdef _WINDOWS
+                if (m_pData != nullptr)
+                    UnmapViewOfFile(m_pData);
+                if (m_mappingHandle != NULL)
+                    CloseHandle(m_mappingHandle);
+                m_mappingHandle = NULL;
+                #else
+                if (m_pData != nullptr)
+                    munmap(m_pData, m_size);
+                #endif
+                m_pData = nullptr;
+                m_size = 0u;
+            }
+
+        private:
+            uint8_t* m_pData;  ///< Mapped memory
+            size_t m_size;     ///< Mapped size
+            bool m_isCreated;  ///< File created/resized when opened
+            #ifdef _WINDOWS
+            HANDLE m_fileHandle;    ///< File handle
+            HANDLE m_mappingHandle; ///< File mapping handle
+            #else
+            int m_fileDescriptor;   ///< File descriptor
+            #endif
+        };
+    }
+}
@@ -0,0 +1,314 @@
+/*******************************************************************************
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : fixed-point toolset - exact division by reciprocals, gradient setup
+*******************************************************************************/
+#pragma once
+
+#ifndef _FIXED_POINT__USE_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _FIXED_POINT__USE_SSE2  1
+#else
+#define _FIXED_POINT__USE_SSE2  0
+#endif
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#if _FIXED_POINT__USE_SSE2
+#include <emmintrin.h>
+#endif
+
+/// @namespace utils
+/// General utilities
+namespace utils
+{
+    /// @namespace algorithm
+    /// Algorithms
+    namespace algorithm
+    {
+        /// @class FixedPoint
+        /// @brief Fixed-point value helpers (signed 32-bit values with FractionBits fractional bits)
+        template <uint32_t FractionBits>
+        class FixedPoint
+        {
+        public:
+            static_assert(FractionBits > 0u && FractionBits < 31u, "Fraction bits must be between 1 and 30");
+            static constexpr int32_t one = (1 << FractionBits);              ///< Value 1.0
+            static constexpr int32_t half = (1 << (FractionBits - 1u));      ///< Value 0.5
+            static constexpr int32_t fractionMask = (1 << FractionBits) - 1; ///< Mask of fractional bits
+
+            /// @brief Convert integer to fixed-point value
+            static constexpr int32_t fromInt(const int32_t value) noexcept { return value * one; }
+            /// @brief Get integer part of fixed-point value (rounded down)
+            static constexpr int32_t floor(const int32_t value) noexcept { return (value >> FractionBits); }
+            /// @brief Get integer part of fixed-point value (rounded up)
+            static constexpr int32_t ceil(const int32_t value) noexcept { return ((value + fractionMask) >> FractionBits); }
+            /// @brief Get integer part of fixed-point value (rounded to nearest, half up)
+            static constexpr int32_t round(const int32_t value) noexcept { return ((value + half) >> FractionBits); }
+            /// @brief Multiply fixed-point values (result rounded down)
+            static constexpr int32_t multiply(const int32_t lhs, const int32_t rhs) noexcept
+            {
+                return static_cast<int32_t>((static_cast<int64_t>(lhs) * static_cast<int64_t>(rhs)) >> FractionBits);
+            }
+        };
+        using Fixed12 = FixedPoint<12u>; ///< 20.12 values (PS1 GTE format)
+        using Fixed16 = FixedPoint<16u>; ///< 16.16 values (rasterizer attributes)
+
+
+        // ---------------------------------------------------------------------
+
+        /// @struct reciprocal_t
+        /// @brief Reciprocal of a divisor: trunc((n << fraction) / divisor) == (|n| * multiplier) >> (shift - fraction)
+        struct reciprocal_t
+        {
+            uint64_t multiplier; ///< ceil(2^shift / divisor) - 0 if division can't be replaced
+            uint32_t shift;      ///< Reciprocal precision
+        };
+
+        /// @class Reciprocal
+        /// @brief Reciprocal computation for exact division by multiplication
+        /// @details With e = multiplier*d - 2^shift (0 <= e < d) and n' < 2^PrecisionBits, the error n'*e/2^shift stays below 1/d:
+        ///          floor(n' * multiplier / 2^shift) == floor(n' / d).
+        /// @tparam PrecisionBits  Max bit length of dividends (numerator bits + fraction bits)
+        template <uint32_t PrecisionBits>
+        class Reciprocal
+        {
+        public:
+            static constexpr uint32_t maxDivisorBits = 63u - PrecisionBits; ///< Max bit length of divisors (shift < 64)
+
+            /// @brief Compute bit length of a value
+            static constexpr uint32_t bitLength(const uint64_t value) noexcept
+            {
+                return (value == 0uLL) ? 0u : 1u + bitLength(value >> 1);
+            }
+            /// @brief Compute reciprocal of a divisor (absolute value) - multiplier 0 if not supported
+            static constexpr reciprocal_t compute(const uint64_t divisor) noexcept
+            {
+                return (divisor == 0uLL || bitLength(divisor) > maxDivisorBits)
+                       ? reciprocal_t{ 0uLL, 0u }
+                       : reciprocal_t{ ((1uLL << (PrecisionBits + bitLength(divisor))) + divisor - 1uLL) / divisor, PrecisionBits + bitLength(divisor) };
+            }
+
+            /// @struct table_t
+            /// @brief Precomputed reciprocals
+            template <uint32_t TableSize>
+            struct table_t
+            {
+                reciprocal_t values[TableSize];
+            };
+            /// @brief Create table of reciprocals (divisors 0 to sizeof...(Indexes)-1)
+            template <size_t ... Indexes>
+            static constexpr table_t<sizeof...(Indexes)> createTable(std::index_sequence<Indexes...>) noexcept
+            {
+                return table_t<sizeof...(Indexes)>{ { compute(static_cast<uint64_t>(Indexes))... } };
+            }
+        };
+
+
+        /// @class ExactDivider
+        /// @brief Exact truncating division of fixed-point numerators by a shared divisor: trunc((n << FractionBits) / divisor)
+        /// @details The division is replaced by a multiplication with a reciprocal (precomputed constexpr table for small divisors).
+        ///          Results are identical to a 64-bit integer division. Numerators out of range and divisors beyond the table use
+        ///          a real division (computing a reciprocal needs a slow 64-bit division: only worth it with precomputed values).
+        /// @tparam FractionBits   Fractional bits of results
+        /// @tparam NumeratorBits  Max magnitude of fast-path numerators (|n| < 2^NumeratorBits)
+        /// @tparam TableSize      Number of precomputed reciprocals (divisors 0 to TableSize-1)
+        template <uint32_t FractionBits, uint32_t NumeratorBits, uint32_t TableSize = 4096u>
+        class ExactDivider
+        {
+        public:
+            using reciprocal = Reciprocal<NumeratorBits + FractionBits>;
+            static_assert(2u * NumeratorBits + FractionBits + 1u <= 64u, "Numerator * multiplier must fit in 64 bits");
+            static_assert(TableSize > 1u && TableSize <= (1uLL << reciprocal::maxDivisorBits), "Table too large for divisor limit");
+            static constexpr typename reciprocal::template table_t<TableSize> table = reciprocal::createTable(std::make_index_sequence<TableSize>{}); ///< Reciprocals of small divisors
+            static constexpr uint64_t maxNumerator = (1uLL << NumeratorBits) - 1uLL; ///< Largest fast-path numerator (absolute value)
+
+        public:
+            /// @brief Create divider
+            /// @param[in] divisor  Divisor (must not be 0)
+            explicit ExactDivider(const int64_t divisor) noexcept
+            {
+                m_divisor = divisor;
+                m_divisorSign = static_cast<int32_t>(divisor >> 63); // branchless: determinant sign depends on vertex order
+                const uint64_t absDivisor = (static_cast<uint64_t>(divisor) ^ static_cast<uint64_t>(divisor >> 63)) - static_cast<uint64_t>(divisor >> 63);
+                m_reciprocal = (absDivisor < TableSize) ? table.values[absDivisor] : reciprocal_t{ 0uLL, 0u }; // large divisor: real division
+            }
+
+            /// @brief Divide numerator: trunc((numerator << FractionBits) / divisor)
+            inline int32_t divide(const int64_t numerator) const noexcept
+            {
+                // branchless signs (random signs of attribute deltas would cause mispredictions)
+                const uint64_t numeratorSign = static_cast<uint64_t>(numerator >> 63);
+                const uint64_t absNumerator = (static_cast<uint64_t>(numerator) ^ numeratorSign) - numeratorSign;
+                if (absNumerator > maxNumerator || m_reciprocal.multiplier == 0uLL)
+                    return static_cast<int32_t>((numerator * (1LL << FractionBits)) / m_divisor);
+
+                const uint32_t quotient = static_cast<uint32_t>((absNumerator * m_reciprocal.multiplier) >> (m_reciprocal.shift - FractionBits));
+                const uint32_t resultSign = static_cast<uint32_t>(numeratorSign) ^ static_cast<uint32_t>(m_divisorSign);
+                return static_cast<int32_t>((quotient ^ resultSign) - resultSign);
+            }
+
+            /// @brief Divide 4 numerators at once (SIMD if available)
+            /// @param[in] pNumerators  Numerators (4)
+            /// @param[out] pOutValues  Results (4)
+            inline void divide4(const int32_t* pNumerators, int32_t* pOutValues) const noexcept
+            {
+                #if _FIXED_POINT__USE_SSE2
+                __m128i numerators = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pNumerators));
+                __m128i signs = _mm_srai_epi32(numerators, 31);
+                __m128i absNumerators = _mm_sub_epi32(_mm_xor_si128(numerators, signs), signs); // INT_MIN stays 0x80000000 (unsigned magnitude)
+                __m128i outOfRange = _mm_and_si128(absNumerators, _mm_set1_epi32(static_cast<int32_t>(~static_cast<uint32_t>(maxNumerator))));
+                if (m_reciprocal.multiplier == 0uLL || _mm_movemask_epi8(_mm_cmpeq_epi32(outOfRange, _mm_setzero_si128())) != 0xFFFF)
+                {
+                    for (uint32_t i = 0; i < 4u; ++i)
+                        pOutValues[i] = divide(pNumerators[i]);
+                    return;
+                }
+
+                // 64-bit products (|n| * multiplier) of even and odd lanes: multiplier split in 32-bit halves
+                const __m128i multiplierLow = _mm_set1_epi32(static_cast<int32_t>(m_reciprocal.multiplier & 0xFFFFFFFFuLL));
+                const __m128i multiplierHigh = _mm_set1_epi32(static_cast<int32_t>(m_reciprocal.multiplier >> 32));
+                const __m128i shift = _mm_cvtsi32_si128(static_cast<int32_t>(m_reciprocal.shift - FractionBits));
+                __m128i oddNumerators = _mm_srli_epi64(absNumerators, 32);
+                __m128i even = _mm_add_epi64(_mm_mul_epu32(absNumerators, multiplierLow), _mm_slli_epi64(_mm_mul_epu32(absNumerators, multiplierHigh), 32));
+                __m128i odd = _mm_add_epi64(_mm_mul_epu32(oddNumerators, multiplierLow), _mm_slli_epi64(_mm_mul_epu32(oddNumerators, multiplierHigh), 32));
+                even = _mm_srl_epi64(even, shift);
+                odd = _mm_srl_epi64(odd, shift);
+                __m128i quotients = _mm_or_si128(_mm_and_si128(even, _mm_set_epi32(0, -1, 0, -1)), _mm_slli_epi64(odd, 32));
+
+                // restore signs
+                __m128i resultSigns = _mm_xor_si128(signs, _mm_set1_epi32(m_divisorSign));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutValues), _mm_sub_epi32(_mm_xor_si128(quotients, resultSigns), resultSigns));
+                #else
+                for (uint32_t i = 0; i < 4u; ++i)
+                    pOutValues[i] = divide(pNumerators[i]);
+                #endif
+            }
+
+            /// @brief Check fast path of a divisor against real division: reciprocal rounded up, error of the largest dividend below 1/divisor,
+            ///        results of boundary numerators (largest values, largest multiple of divisor minus 1)
+            static constexpr bool isExact(const uint64_t divisor) noexcept
+            {
+                return isExactReciprocal(divisor, reciprocal::compute(divisor));
+            }
+            /// @brief Check fast path of a range of divisors [first; last[ (binary recursion: limited depth)
+            static constexpr bool isExactRange(const uint64_t first, const uint64_t last) noexcept
+            {
+                return (last - first <= 1uLL) ? isExact(first) : (isExactRange(first, first + (last - first) / 2uLL) && isExactRange(first + (last - first) / 2uLL, last));
+            }
+
+            /// @brief Get divisor
+            inline int64_t divisor() const noexcept { return m_divisor; }
+            /// @brief Get reciprocal of divisor (multiplier == 0: real division)
+            inline reciprocal_t divisorReciprocal() const noexcept { return m_reciprocal; }
+
+        private:
+            /// @brief Compare fast path with real division for a numerator (absolute values)
+            static constexpr bool isExactNumerator(const uint64_t absNumerator, const uint64_t divisor, const reciprocal_t values) noexcept
+            {
+                return (((absNumerator * values.multiplier) >> (values.shift - FractionBits)) == ((absNumerator << FractionBits) / divisor));
+            }
+            /// @brief Check reciprocal of a divisor (multiplier 0: real division, always exact)
+            static constexpr bool isExactReciprocal(const uint64_t divisor, const reciprocal_t values) noexcept
+            {
+                return (values.multiplier == 0uLL)
+                    || (values.multiplier * divisor >= (1uLL << values.shift) // rounded up
+                        && values.multiplier * divisor - (1uLL << values.shift) <= ((1uLL << values.shift) - 1uLL) / (maxNumerator << FractionBits) // max error: (n << fraction) * e < 2^shift
+                        && isExactNumerator(maxNumerator, divisor, values) && isExactNumerator(maxNumerator - 1uLL, divisor, values)
+                        && (maxNumerator < divisor || isExactNumerator((maxNumerator / divisor) * divisor - 1uLL, divisor, values)));
+            }
+
+        private:
+            int64_t m_divisor;         ///< Divisor
+            int32_t m_divisorSign;     ///< Divisor sign mask (0 or -1)
+            reciprocal_t m_reciprocal; ///< Reciprocal of divisor (absolute value)
+        };
+
+        template <uint32_t FractionBits, uint32_t NumeratorBits, uint32_t TableSize>
+        constexpr typename ExactDivider<FractionBits, NumeratorBits, TableSize>::reciprocal::template table_t<TableSize> ExactDivider<FractionBits, NumeratorBits, TableSize>::table;
+
+
+        // ---------------------------------------------------------------------
+
+        /// @struct gradient_t
+        /// @brief Attribute gradient along X and Y axes (fixed-point)
+        struct gradient_t
+        {
+            int32_t dx; ///< Horizontal gradient
+            int32_t dy; ///< Vertical gradient
+        };
+
+        /// @class GradientSetup
+        /// @brief Triangle attribute gradients (plane equation) - one shared reciprocal of the determinant for all attributes
+        /// @details dx = ((a1-a0)*(y2-y0) - (a2-a0)*(y1-y0)) / det,  dy = ((a2-a0)*(x1-x0) - (a1-a0)*(x2-x0)) / det
+        ///          with det = (x1-x0)*(y2-y0) - (x2-x0)*(y1-y0), results truncated toward zero (same as integer division).
+        /// @tparam FractionBits   Fractional bits of gradients (12 or 16 for PS1 formats)
+        /// @tparam NumeratorBits  Max magnitude of fast-path numerators: 8-bit attributes * coordinate deltas
+        template <uint32_t FractionBits, uint32_t NumeratorBits = 23u>
+        class GradientSetup
+        {
+        public:
+            using divider_t = ExactDivider<FractionBits, NumeratorBits>;
+
+            /// @brief Prepare gradient setup for a triangle (vertex coordinates relative to first vertex)
+            /// @param[in] x1  Second vertex X - first vertex X
+            /// @param[in] y1  Second vertex Y - first vertex Y
+            /// @param[in] x2  Third vertex X - first vertex X
+            /// @param[in] y2  Third vertex Y - first vertex Y
+            /// @param[in] determinant  Triangle determinant (must not be 0): x1*y2 - x2*y1
+            GradientSetup(const int32_t x1, const int32_t y1, const int32_t x2, const int32_t y2, const int64_t determinant) noexcept
+                : m_x1(x1), m_y1(y1), m_x2(x2), m_y2(y2), m_divider(determinant) {}
+
+            /// @brief Compute gradients of an attribute
+            /// @param[in] a0  Attribute value at first vertex
+            /// @param[in] a1  Attribute value at second vertex
+            /// @param[in] a2  Attribute value at third vertex
+            inline gradient_t compute(const int32_t a0, const int32_t a1, const int32_t a2) const noexcept
+            {
+                gradient_t gradient;
+                gradient.dx = m_divider.divide(static_cast<int64_t>(a1 - a0) * m_y2 - static_cast<int64_t>(a2 - a0) * m_y1);
+                gradient.dy = m_divider.divide(static_cast<int64_t>(a2 - a0) * m_x1 - static_cast<int64_t>(a1 - a0) * m_x2);
+                return gradient;
+            }
+            /// @brief Compute gradients of 2 attributes at once (shared attribute deltas)
+            /// @remarks Scalar divisions: building SIMD numerators from 64-bit products costs more than it saves (store-to-load forwarding)
+            /// @param[in] pA0  Attribute values at first vertex (2)
+            /// @param[in] pA1  Attribute values at second vertex (2)
+            /// @param[in] pA2  Attribute values at third vertex (2)
+            /// @param[out] pOutGradients  Gradients (2)
+            inline void compute2(const int32_t* pA0, const int32_t* pA1, const int32_t* pA2, gradient_t* pOutGradients) const noexcept
+            {
+                const int64_t deltaA1[2] = { pA1[0] - pA0[0], pA1[1] - pA0[1] };
+                const int64_t deltaA2[2] = { pA2[0] - pA0[0], pA2[1] - pA0[1] };
+                for (uint32_t i = 0; i < 2u; ++i)
+                {
+                    pOutGradients[i].dx = m_divider.divide(deltaA1[i] * m_y2 - deltaA2[i] * m_y1);
+                    pOutGradients[i].dy = m_divider.divide(deltaA2[i] * m_x1 - deltaA1[i] * m_x2);
+                }
+            }
+
+            /// @brief Get divider (shared reciprocal of determinant)
+            inline const divider_t& divider() const noexcept { return m_divider; }
+
+        private:
+            int32_t m_x1; ///< Second vertex X (relative)
+            int32_t m_y1; ///< Second vertex Y (relative)
+            int32_t m_x2; ///< Third vertex X (relative)
+            int32_t m_y2; ///< Third vertex Y (relative)
+            divider_t m_divider; ///< Reciprocal of determinant
+        };
+        using GradientSetup12 = GradientSetup<12u>; ///< Gradients in 20.12 format
+        using GradientSetup16 = GradientSetup<16u>; ///< Gradients in 16.16 format
+
+        // compile-time exactness checks of precomputed tables + largest supported divisors
+        static_assert(GradientSetup16::divider_t::isExactRange(1u, 4096u), "Inexact reciprocal table (16-bit fraction)");
+        static_assert(GradientSetup12::divider_t::isExactRange(1u, 4096u), "Inexact reciprocal table (12-bit fraction)");
+        static_assert(GradientSetup16::divider_t::isExactRange((1uLL << GradientSetup16::divider_t::reciprocal::maxDivisorBits) - 16u,
+                                                               (1uLL << GradientSetup16::divider_t::reciprocal::maxDivisorBits)), "Inexact reciprocal (16-bit fraction)");
+        static_assert(GradientSetup12::divider_t::isExactRange((1uLL << GradientSetup12::divider_t::reciprocal::maxDivisorBits) - 16u,
+                                                               (1uLL << GradientSetup12::divider_t::reciprocal::maxDivisorBits)), "Inexact reciprocal (12-bit fraction)");
+    }
+}
@@ -0,0 +1,181 @@
+/*******************************************************************************
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : per-frame arena allocator (bump allocation, reset at end of frame)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#define FRAME_ARENA_DEFAULT_BLOCK_SIZE (1024u * 1024u) // default size of arena blocks (bytes)
+
+/// @namespace utils
+/// General utilities
+namespace utils
+{
+    /// @namespace utils.memory
+    /// Memory management utilities
+    namespace memory
+    {
+        /// @class FrameArena
+        /// @brief Per-frame arena allocator - memory is only released when the arena is reset (end of frame)
+        /// @details Allocations are taken from a single block. If a frame overflows it, chained blocks are added,
+        ///          then replaced by one bigger block at the next reset (sized with the high-water mark):
+        ///          no heap call in steady state. Only trivially destructible objects can be stored (no destructor called).
+        class FrameArena
+        {
+        public:
+            /// @brief Create empty arena (first block allocated on first use)
+            /// @param[in] blockSize  Min size of arena blocks (bytes)
+            explicit FrameArena(const size_t blockSize = FRAME_ARENA_DEFAULT_BLOCK_SIZE) noexcept
+                : m_blockSize((blockSize > 0u) ? blockSize : FRAME_ARENA_DEFAULT_BLOCK_SIZE), m_currentBlock(0u), m_offset(0u),
+                  m_frameBytes(0u), m_highWaterMark(0u), m_overflowCount(0u) {}
+            // no copy allowed
+            FrameArena(const FrameArena& other) = delete;
+            FrameArena& operator=(const FrameArena& other) = delete;
+
+
+            // -- Allocation --
+
+            /// @brief Allocate memory until next reset
+            /// @param[in] size       Size (bytes)
+            /// @param[in] alignment  Alignment (power of 2)
+            /// @returns Allocated memory
+            /// @throws bad_alloc  Allocation failure
+            void* allocate(const size_t size, const size_t alignment = alignof(std::max_align_t))
+            {
+                // current block
+                if (m_blocks.empty() == false)
+                {
+                    void* pData = allocateInBlock(m_blocks[m_currentBlock], size, alignment);
+                    if (pData != nullptr)
+                        return pData;
+                    // next block (chained during previous overflow)
+                    while (m_currentBlock + 1u < m_blocks.size())
+                    {
+                        m_frameBytes += m_blocks[m_currentBlock].size; // used + unusable end of block
+                        ++m_currentBlock;
+                        m_offset = 0u;
+                        if ((pData = allocateInBlock(m_blocks[m_currentBlock], size, alignment)) != nullptr)
+                            return pData;
+                    }
+                    m_frameBytes += m_blocks[m_currentBlock].size;
+                }
+
+                // overflow: chain new block
+                const size_t minSize = size + alignment;
+                block_t block{ std::unique_ptr<uint8_t[]>(new uint8_t[(minSize > m_blockSize) ? minSize : m_blockSize]), (minSize > m_blockSize) ? minSize : m_blockSize };
+                m_blocks.push_back(std::move(block));
+                m_currentBlock = m_blocks.size() - 1u;
+                m_offset = 0u;
+                return allocateInBlock(m_blocks[m_currentBlock], size, alignment);
+            }
+
+            /// @brief Allocate array of objects until next reset (default-initialized)
+            /// @param[in] count  Number of objects
+            /// @returns Allocated array
+            /// @throws bad_alloc  Allocation failure
+            template <typename T>
+            inline T* allocateArray(const size_t count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "FrameArena: objects are never destroyed");
+                T* pArray = static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+                for (size_t i = 0; i < count; ++i)
+                    new (&pArray[i]) T;
+                return pArray;
+            }
+            /// @brief Create object until next reset
+            /// @param[in] args  Constructor arguments
+            /// @returns Created object
+            /// @throws bad_alloc  Allocation failure
+            template <typename T, typename ... Args>
+            inline T* create(Args&&... args)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "FrameArena: objects are never destroyed");
+                return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            }
+
+            /// @brief Release all allocations of current frame (end of frame) - chained blocks merged if the frame overflowed
+            void reset()
+            {
+                if (m_frameBytes + m_offset > m_highWaterMark)
+                    m_highWaterMark = m_frameBytes + m_offset;
+                if (m_blocks.size() > 1u)
+                {
+                    ++m_overflowCount;
+                    size_t blockSize = ((m_highWaterMark + m_blockSize - 1u) / m_blockSize) * m_blockSize;
+                    m_blocks.clear();
+                    m_blocks.push_back(block_t{ std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]), blockSize });
+                }
+                m_currentBlock = 0u;
+                m_offset = 0u;
+                m_frameBytes = 0u;
+            }
+            /// @brief Release all blocks
+            inline void clear() noexcept
+            {
+                m_blocks.clear();
+                m_currentBlock = m_offset = m_frameBytes = 0u;
+            }
+
+
+            // -- Getters --
+
+            /// @brief Get memory used by current frame (bytes, with alignment padding)
+            inline size_t usedBytes() const noexcept { return m_frameBytes + m_offset; }
+            /// @brief Get max memory used by a frame (bytes)
+            inline size_t highWaterMark() const noexcept { return (usedBytes() > m_highWaterMark) ? usedBytes() : m_highWaterMark; }
+            /// @brief Get total size of allocated blocks (bytes)
+            inline size_t capacity() const noexcept
+            {
+                size_t total = 0u;
+                for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it)
+                    total += it->size;
+                return total;
+            }
+            /// @brief Get number of allocated blocks (more than 1: current frame overflowed)
+            inline size_t blockCount() const noexcept { return m_blocks.size(); }
+            /// @brief Get number of frames that needed chained blocks
+            inline uint32_t overflowCount() const noexcept { return m_overflowCount; }
+
+
+        private:
+            /// @struct block_t
+            /// @brief Arena memory block
+            struct block_t
+            {
+                std::unique_ptr<uint8_t[]> pData; ///< Block memory
+                size_t size;                      ///< Block size
+            };
+
+            /// @brief Allocate memory in a block (from current offset)
+            /// @returns Allocated memory (or nullptr if not enough space)
+            inline void* allocateInBlock(block_t& block, const size_t size, const size_t alignment) noexcept
+            {
+                const uintptr_t begin = reinterpret_cast<uintptr_t>(block.pData.get());
+                const uintptr_t position = (begin + m_offset + alignment - 1u) & ~static_cast<uintptr_t>(alignment - 1u);
+                const size_t end = static_cast<size_t>(position - begin) + size;
+                if (end > block.size)
+                    return nullptr;
+                m_offset = end;
+                return reinterpret_cast<void*>(position);
+            }
+
+        private:
+            std::vector<block_t> m_blocks; ///< Memory blocks (more than 1: chained blocks of an overflowing frame)
+            size_t m_blockSize;            ///< Min size of blocks
+            size_t m_currentBlock;         ///< Block used for next allocation
+            size_t m_offset;               ///< Used bytes in current block
+            size_t m_frameBytes;           ///< Used bytes in previous blocks (current frame)
+            size_t m_highWaterMark;        ///< Max bytes used by a frame
+            uint32_t m_overflowCount;      ///< Number of frames that needed chained blocks
+        };
+    }
+}
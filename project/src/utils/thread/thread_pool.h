@@ -0,0 +1,194 @@
+/*******************************************************************************
+Author  :     Romain Vinders
+License :     GPLv2
+------------------------------------------------------------------------
+Description : thread pool : fixed set of worker threads (parallel loops + background tasks)
+*******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+
+/// @namespace utils
+/// General utilities
+namespace utils
+{
+    /// @namespace utils.thread
+    /// Thread management utilities
+    namespace thread
+    {
+        /// @class ThreadPool
+        /// @brief Fixed set of worker threads
+        class ThreadPool
+        {
+        public:
+            /// @brief Create worker threads
+            /// @param[in] workerCount  Number of worker threads (0 = one per hardware thread, except caller thread)
+            explicit ThreadPool(uint32_t workerCount = 0u) : m_isRunning(true), m_pendingTaskCount(0u)
+            {
+                if (workerCount == 0u)
+                {
+                    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+                    workerCount = (hardwareThreads > 1u) ? hardwareThreads - 1u : 0u;
+                }
+                m_workers.reserve(workerCount);
+                for (uint32_t i = 0; i < workerCount; ++i)
+                    m_workers.emplace_back(&ThreadPool::runWorker, this);
+            }
+            /// @brief Stop and join worker threads (remaining tasks are processed)
+            ~ThreadPool()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(m_queueLock);
+                    m_isRunning = false;
+                }
+                m_queueCondition.notify_all();
+                for (auto& worker : m_workers)
+                    worker.join();
+            }
+            // no copy/move allowed
+            ThreadPool(const ThreadPool& other) = delete;
+            ThreadPool(ThreadPool&& other) = delete;
+            ThreadPool& operator=(const ThreadPool& other) = delete;
+            ThreadPool& operator=(ThreadPool&& other) = delete;
+
+
+            // -- Getters --
+
+            /// @brief Get number of worker threads
+            /// @returns Number of workers (without caller thread)
+            inline uint32_t workerCount() const noexcept
+            {
+                return static_cast<uint32_t>(m_workers.size());
+            }
+            /// @brief Get number of threads used by parallel loops
+            /// @returns Number of workers + caller thread
+            inline uint32_t concurrency() const noexcept
+            {
+                return static_cast<uint32_t>(m_workers.size()) + 1u;
+            }
+
+
+            // -- Task execution --
+
+            /// @brief Execute job for each index in [0; count[, using workers and caller thread - wait for completion
+            /// @param[in] count  Number of job indexes
+            /// @param[in] job    Job to execute (called with index)
+            /// @warning Must not be called from a worker thread
+            template <typename Job>
+            void parallelFor(const uint32_t count, const Job& job)
+            {
+                if (count == 0u)
+                    return;
+                if (m_workers.empty() || count == 1u)
+                {
+                    for (uint32_t i = 0; i < count; ++i)
+                        job(i);
+                    return;
+                }
+
+                // shared loop state (kept alive by helpers that may still poll the index counter after completion)
+                std::shared_ptr<parallel_loop_t> pLoop = std::make_shared<parallel_loop_t>(count);
+                auto processIndexes = [pLoop, &job]()
+                {
+                    uint32_t index;
+                    while ((index = pLoop->nextIndex.fetch_add(1u)) < pLoop->count)
+                    {
+                        job(index);
+                        if (pLoop->doneCount.fetch_add(1u) + 1u == pLoop->count)
+                        {
+                            std::lock_guard<std::mutex> guard(pLoop->lock);
+                            pLoop->condition.notify_all();
+                        }
+                    }
+                };
+                uint32_t helperCount = (count - 1u < workerCount()) ? count - 1u : workerCount();
+                for (uint32_t i = 0; i < helperCount; ++i)
+                    post(processIndexes);
+                processIndexes();
+
+                std::unique_lock<std::mutex> guard(pLoop->lock);
+                pLoop->condition.wait(guard, [&pLoop]() { return (pLoop->doneCount.load() >= pLoop->count); });
+            }
+
+            /// @brief Add background task in queue (executed by first available worker, or immediately if no worker)
+            /// @param[in] task  Task to execute
+            void post(std::function<void()> task)
+            {
+                if (m_workers.empty())
+                {
+                    task();
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> guard(m_queueLock);
+                    m_tasks.push_back(std::move(task));
+                    ++m_pendingTaskCount;
+                }
+                m_queueCondition.notify_one();
+            }
+
+            /// @brief Wait until all posted tasks are complete
+            void waitIdle()
+            {
+                std::unique_lock<std::mutex> guard(m_queueLock);
+                m_idleCondition.wait(guard, [this]() { return (m_pendingTaskCount == 0u); });
+            }
+
+
+        private:
+            /// @brief Worker thread loop
+            void runWorker()
+            {
+                while (true)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> guard(m_queueLock);
+                        m_queueCondition.wait(guard, [this]() { return (!m_tasks.empty() || !m_isRunning); });
+                        if (m_tasks.empty()) // stopped
+                            return;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+                    task();
+                    {
+                        std::lock_guard<std::mutex> guard(m_queueLock);
+                        if (--m_pendingTaskCount == 0u)
+                            m_idleCondition.notify_all();
+                    }
+                }
+            }
+
+            /// @struct parallel_loop_t
+            /// @brief Parallel loop state
+            struct parallel_loop_t
+            {
+                parallel_loop_t(const uint32_t indexCount) : count(indexCount), nextIndex(0u), doneCount(0u) {}
+                const uint32_t count;            ///< Number of indexes
+                std::atomic<uint32_t> nextIndex; ///< Next index to process
+                std::atomic<uint32_t> doneCount; ///< Number of processed indexes
+                std::mutex lock;
+                std::condition_variable condition;
+            };
+
+
+        private:
+            std::vector<std::thread> m_workers;               ///< Worker threads
+            std::deque<std::function<void()> > m_tasks;       ///< Pending tasks
+            std::mutex m_queueLock;                           ///< Task queue lock
+            std::condition_variable m_queueCondition;         ///< Task notification
+            std::condition_variable m_idleCondition;          ///< Completion notification
+            bool m_isRunning;                                 ///< Workers status
+            uint32_t m_pendingTaskCount;                      ///< Queued + running tasks
+        };
+    }
+}